@@ -1033,5 +1033,8 @@ void CG_AddPacketEntities( void ) {
 		cent = &cg_entities[ cg.snap->entities[ num ].number ];
 		CG_AddCEntity( cent );
 	}
+
+	// the lerp origins moved
+	CG_InvalidateSolidGrid();
 }
 
@@ -34,6 +34,28 @@ static	centity_t	*cg_solidEntities[MAX_ENTITIES_IN_SNAPSHOT];
 static	int			cg_numTriggerEntities;
 static	centity_t	*cg_triggerEntities[MAX_ENTITIES_IN_SNAPSHOT];
 
+/*
+Solid boxes are also hashed into a grid of x/y cells, so a trace only
+has to look at the entities near it.  The grid is built from the lerp
+origins the first time it is needed after a new snapshot or after
+CG_AddPacketEntities moved everything, and each box is padded so the
+grid stays usable for the entity movement of a frame.  Brush models
+have no bounds on this side, so they are always tested.
+*/
+#define	SOLID_GRID_CELL			256		// cell size in x and y
+#define	SOLID_GRID_HASH			256		// buckets, must be a power of two
+#define	SOLID_GRID_PAD			64
+#define	SOLID_GRID_MAX_CELLS	16		// traces covering more cells test every entity
+
+static	qboolean	cg_solidGridValid;
+static	vec3_t		cg_solidBounds[MAX_ENTITIES_IN_SNAPSHOT][2];
+static	int			cg_solidGridStart[SOLID_GRID_HASH+1];
+static	short		cg_solidGridList[MAX_ENTITIES_IN_SNAPSHOT*SOLID_GRID_MAX_CELLS];
+static	int			cg_numAlwaysSolids;
+static	short		cg_alwaysSolids[MAX_ENTITIES_IN_SNAPSHOT];
+static	int			cg_solidStamp[MAX_ENTITIES_IN_SNAPSHOT];
+static	int			cg_solidStampCount;
+
 /*
 ====================
 CG_BuildSolidList
@@ -74,6 +96,202 @@ void CG_BuildSolidList( void ) {
 			continue;
 		}
 	}
+
+	CG_InvalidateSolidGrid();
+}
+
+/*
+====================
+CG_InvalidateSolidGrid
+
+Call whenever the solid list or the entity lerp origins change
+====================
+*/
+void CG_InvalidateSolidGrid( void ) {
+	cg_solidGridValid = qfalse;
+}
+
+/*
+====================
+CG_SolidGridCell
+====================
+*/
+static int CG_SolidGridCell( float v ) {
+	return (int)floor( v * ( 1.0f / SOLID_GRID_CELL ) );
+}
+
+/*
+====================
+CG_SolidGridBucket
+====================
+*/
+static int CG_SolidGridBucket( int x, int y ) {
+	return ( x * 73856093 ^ y * 19349663 ) & ( SOLID_GRID_HASH - 1 );
+}
+
+/*
+====================
+CG_BuildSolidGrid
+====================
+*/
+static void CG_BuildSolidGrid( void ) {
+	int			i, x, y, zd, zu;
+	int			pass, bucket;
+	int			cellMins[2], cellMaxs[2];
+	int			count[SOLID_GRID_HASH];
+	qboolean	gridded[MAX_ENTITIES_IN_SNAPSHOT];
+	entityState_t	*ent;
+	centity_t	*cent;
+
+	cg_numAlwaysSolids = 0;
+	for ( i = 0 ; i < cg_numSolidEntities ; i++ ) {
+		cent = cg_solidEntities[ i ];
+		ent = &cent->currentState;
+
+		gridded[i] = qfalse;
+		if ( ent->solid == SOLID_BMODEL ) {
+			cg_alwaysSolids[ cg_numAlwaysSolids++ ] = i;
+			continue;
+		}
+
+		x = (ent->solid & 255);
+		zd = ((ent->solid>>8) & 255);
+		zu = ((ent->solid>>16) & 255) - 32;
+
+		cg_solidBounds[i][0][0] = cent->lerpOrigin[0] - x - SOLID_GRID_PAD;
+		cg_solidBounds[i][0][1] = cent->lerpOrigin[1] - x - SOLID_GRID_PAD;
+		cg_solidBounds[i][0][2] = cent->lerpOrigin[2] - zd - SOLID_GRID_PAD;
+		cg_solidBounds[i][1][0] = cent->lerpOrigin[0] + x + SOLID_GRID_PAD;
+		cg_solidBounds[i][1][1] = cent->lerpOrigin[1] + x + SOLID_GRID_PAD;
+		cg_solidBounds[i][1][2] = cent->lerpOrigin[2] + zu + SOLID_GRID_PAD;
+
+		if ( ( CG_SolidGridCell( cg_solidBounds[i][1][0] ) - CG_SolidGridCell( cg_solidBounds[i][0][0] ) + 1 )
+			* ( CG_SolidGridCell( cg_solidBounds[i][1][1] ) - CG_SolidGridCell( cg_solidBounds[i][0][1] ) + 1 )
+			> SOLID_GRID_MAX_CELLS ) {
+			cg_alwaysSolids[ cg_numAlwaysSolids++ ] = i;
+			continue;
+		}
+		gridded[i] = qtrue;
+	}
+
+	// count the entries of each bucket, then fill them in
+	memset( count, 0, sizeof( count ) );
+	for ( pass = 0 ; pass < 2 ; pass++ ) {
+		for ( i = 0 ; i < cg_numSolidEntities ; i++ ) {
+			if ( !gridded[i] ) {
+				continue;
+			}
+			cellMins[0] = CG_SolidGridCell( cg_solidBounds[i][0][0] );
+			cellMins[1] = CG_SolidGridCell( cg_solidBounds[i][0][1] );
+			cellMaxs[0] = CG_SolidGridCell( cg_solidBounds[i][1][0] );
+			cellMaxs[1] = CG_SolidGridCell( cg_solidBounds[i][1][1] );
+			for ( y = cellMins[1] ; y <= cellMaxs[1] ; y++ ) {
+				for ( x = cellMins[0] ; x <= cellMaxs[0] ; x++ ) {
+					bucket = CG_SolidGridBucket( x, y );
+					if ( pass == 0 ) {
+						count[bucket]++;
+					} else {
+						cg_solidGridList[ --cg_solidGridStart[bucket] ] = i;
+					}
+				}
+			}
+		}
+
+		if ( pass == 0 ) {
+			// start each bucket at its end, the second pass fills it backwards
+			cg_solidGridStart[0] = count[0];
+			for ( bucket = 1 ; bucket < SOLID_GRID_HASH ; bucket++ ) {
+				cg_solidGridStart[bucket] = cg_solidGridStart[bucket-1] + count[bucket];
+			}
+			cg_solidGridStart[SOLID_GRID_HASH] = cg_solidGridStart[SOLID_GRID_HASH-1];
+		}
+	}
+
+	cg_solidGridValid = qtrue;
+}
+
+/*
+====================
+CG_GatherSolids
+
+Lists the solid entities a trace can touch, in solid list order
+so the results match testing every entity
+====================
+*/
+static int CG_GatherSolids( const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, short *list ) {
+	int			i, j, k, x, y, num, bucket;
+	int			cellMins[2], cellMaxs[2];
+	vec3_t		bounds[2];
+
+	if ( !cg_solidGridValid ) {
+		CG_BuildSolidGrid();
+	}
+
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		if ( start[i] < end[i] ) {
+			bounds[0][i] = start[i] + mins[i] - 1;
+			bounds[1][i] = end[i] + maxs[i] + 1;
+		} else {
+			bounds[0][i] = end[i] + mins[i] - 1;
+			bounds[1][i] = start[i] + maxs[i] + 1;
+		}
+	}
+
+	cellMins[0] = CG_SolidGridCell( bounds[0][0] );
+	cellMins[1] = CG_SolidGridCell( bounds[0][1] );
+	cellMaxs[0] = CG_SolidGridCell( bounds[1][0] );
+	cellMaxs[1] = CG_SolidGridCell( bounds[1][1] );
+	if ( ( cellMaxs[0] - cellMins[0] + 1 ) * ( cellMaxs[1] - cellMins[1] + 1 ) > SOLID_GRID_MAX_CELLS ) {
+		// long traces just take everything
+		for ( i = 0 ; i < cg_numSolidEntities ; i++ ) {
+			list[i] = i;
+		}
+		return cg_numSolidEntities;
+	}
+
+	cg_solidStampCount++;
+	num = 0;
+	for ( y = cellMins[1] ; y <= cellMaxs[1] ; y++ ) {
+		for ( x = cellMins[0] ; x <= cellMaxs[0] ; x++ ) {
+			bucket = CG_SolidGridBucket( x, y );
+			for ( j = cg_solidGridStart[bucket] ; j < cg_solidGridStart[bucket+1] ; j++ ) {
+				k = cg_solidGridList[j];
+				if ( cg_solidStamp[k] == cg_solidStampCount ) {
+					continue;
+				}
+				cg_solidStamp[k] = cg_solidStampCount;
+
+				// also weeds out other cells hashed to the same bucket
+				if ( bounds[0][0] > cg_solidBounds[k][1][0] || bounds[1][0] < cg_solidBounds[k][0][0]
+					|| bounds[0][1] > cg_solidBounds[k][1][1] || bounds[1][1] < cg_solidBounds[k][0][1]
+					|| bounds[0][2] > cg_solidBounds[k][1][2] || bounds[1][2] < cg_solidBounds[k][0][2] ) {
+					continue;
+				}
+				list[num++] = k;
+			}
+		}
+	}
+	for ( i = 0 ; i < cg_numAlwaysSolids ; i++ ) {
+		list[num++] = cg_alwaysSolids[i];
+	}
+
+	// back into solid list order
+	for ( i = 1 ; i < num ; i++ ) {
+		k = list[i];
+		for ( j = i ; j > 0 && list[j-1] > k ; j-- ) {
+			list[j] = list[j-1];
+		}
+		list[j] = k;
+	}
+
+	return num;
 }
 
 /*
@@ -85,6 +303,8 @@ CG_ClipMoveToEntities
 static void CG_ClipMoveToEntities ( const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end,
 							int skipNumber, int mask, trace_t *tr ) {
 	int			i, x, zd, zu;
+	int			numSolids;
+	short		solids[MAX_ENTITIES_IN_SNAPSHOT];
 	trace_t		trace;
 	entityState_t	*ent;
 	clipHandle_t 	cmodel;
@@ -92,8 +312,9 @@ static void CG_ClipMoveToEntities ( const vec3_t start, const vec3_t mins, const
 	vec3_t		origin, angles;
 	centity_t	*cent;
 
-	for ( i = 0 ; i < cg_numSolidEntities ; i++ ) {
-		cent = cg_solidEntities[ i ];
+	numSolids = CG_GatherSolids( start, mins, maxs, end, solids );
+	for ( i = 0 ; i < numSolids ; i++ ) {
+		cent = cg_solidEntities[ solids[i] ];
 		ent = &cent->currentState;
 
 		if ( ent->number == skipNumber ) {
@@ -385,6 +606,155 @@ static void CG_TouchTriggerPrediction( void ) {
 
 
 
+/*
+=================
+PREDICTION CACHE
+
+The state after each predicted command is kept.  While the snapshot the
+prediction started from is still the base, or a new base snapshot agrees
+with what was predicted for its command, only the commands after the
+last cached one are run.  Other entities stay where they were when a
+command was first predicted.
+=================
+*/
+
+typedef struct {
+	int				cmdNum;
+	playerState_t	ps;				// after running cmdNum
+	qboolean		hyperspace;		// cmdNum touched a trigger_teleport
+} predictedCmd_t;
+
+static struct {
+	qboolean		valid;
+	int				baseTime;		// serverTime of the snapshot predicted from
+	int				tracemask;
+	int				pmoveFixed;
+	int				pmoveMsec;
+	int				lastCmd;
+	predictedCmd_t	cmds[CMD_BACKUP];
+
+	// reported with cg_showmiss
+	int				hits;			// frames that resumed from the cache
+	int				repredicts;		// frames that ran every command again
+	int				pmoves;
+} predictCache;
+
+/*
+=================
+CG_PredictionMatches
+
+True if a snapshot playerState is what was predicted for its command,
+ignoring the fields that are never sent
+=================
+*/
+static qboolean CG_PredictionMatches( const playerState_t *predicted, const playerState_t *snap ) {
+	playerState_t	ps;
+
+	ps = *predicted;
+	ps.ping = snap->ping;
+	ps.pmove_framecount = snap->pmove_framecount;
+	ps.jumppad_frame = snap->jumppad_frame;
+	ps.entityEventSequence = snap->entityEventSequence;
+	ps.externalEventTime = snap->externalEventTime;
+
+	return !memcmp( &ps, snap, sizeof( ps ) );
+}
+
+/*
+=================
+CG_ResumePrediction
+
+Sets cg.predictedPlayerState to the last cached prediction if it
+still holds for the base snapshot already in cg.predictedPlayerState
+=================
+*/
+static qboolean CG_ResumePrediction( int current, int baseTime ) {
+	predictedCmd_t	*last, *base;
+	int				cmdNum;
+	int				ping;
+
+	if ( !cg_predictCache.integer || !predictCache.valid ) {
+		return qfalse;
+	}
+
+	// a teleport has to reset the prediction error
+	if ( cg.thisFrameTeleport ) {
+		return qfalse;
+	}
+
+	if ( predictCache.tracemask != cg_pmove.tracemask || predictCache.pmoveFixed != cg_pmove.pmove_fixed
+		|| predictCache.pmoveMsec != cg_pmove.pmove_msec ) {
+		return qfalse;
+	}
+
+	if ( predictCache.lastCmd > current || predictCache.lastCmd <= current - CMD_BACKUP ) {
+		return qfalse;
+	}
+	last = &predictCache.cmds[ predictCache.lastCmd & CMD_MASK ];
+	if ( last->cmdNum != predictCache.lastCmd ) {
+		return qfalse;
+	}
+
+	if ( baseTime != predictCache.baseTime ) {
+		// find what was predicted for the command the new snapshot ends at
+		base = NULL;
+		for ( cmdNum = predictCache.lastCmd ; cmdNum > current - CMD_BACKUP ; cmdNum-- ) {
+			base = &predictCache.cmds[ cmdNum & CMD_MASK ];
+			if ( base->cmdNum != cmdNum ) {
+				return qfalse;
+			}
+			if ( base->ps.commandTime <= cg.predictedPlayerState.commandTime ) {
+				break;
+			}
+		}
+		if ( !base || !CG_PredictionMatches( &base->ps, &cg.predictedPlayerState ) ) {
+			return qfalse;
+		}
+		predictCache.baseTime = baseTime;
+	}
+
+	// the commands after the base snapshot are the ones a full prediction
+	// would run, and touching a teleporter in any of them sets hyperspace
+	for ( cmdNum = predictCache.lastCmd ; cmdNum > current - CMD_BACKUP ; cmdNum-- ) {
+		base = &predictCache.cmds[ cmdNum & CMD_MASK ];
+		if ( base->cmdNum != cmdNum || base->ps.commandTime <= cg.predictedPlayerState.commandTime ) {
+			break;
+		}
+		if ( base->hyperspace ) {
+			cg.hyperspace = qtrue;
+		}
+	}
+
+	ping = cg.predictedPlayerState.ping;
+	cg.predictedPlayerState = last->ps;
+	cg.predictedPlayerState.ping = ping;
+	return qtrue;
+}
+
+/*
+=================
+CG_StorePrediction
+=================
+*/
+static void CG_StorePrediction( int cmdNum, int baseTime, qboolean hyperspace ) {
+	predictedCmd_t	*cmd;
+
+	if ( !predictCache.valid || predictCache.baseTime != baseTime ) {
+		predictCache.valid = qtrue;
+		predictCache.baseTime = baseTime;
+		predictCache.tracemask = cg_pmove.tracemask;
+		predictCache.pmoveFixed = cg_pmove.pmove_fixed;
+		predictCache.pmoveMsec = cg_pmove.pmove_msec;
+	}
+
+	cmd = &predictCache.cmds[ cmdNum & CMD_MASK ];
+	cmd->cmdNum = cmdNum;
+	cmd->ps = cg.predictedPlayerState;
+	cmd->hyperspace = hyperspace;
+	predictCache.lastCmd = cmdNum;
+	predictCache.pmoves++;
+}
+
 /*
 =================
 CG_PredictPlayerState
@@ -417,6 +787,8 @@ void CG_PredictPlayerState( void ) {
 	qboolean	moved;
 	usercmd_t	oldestCmd;
 	usercmd_t	latestCmd;
+	int			baseTime;
+	qboolean	hyperspace;
 
 	cg.hyperspace = qfalse;	// will be set if touching a trigger_teleport
 
@@ -488,6 +860,7 @@ void CG_PredictPlayerState( void ) {
 		cg.predictedPlayerState = cg.snap->ps;
 		cg.physicsTime = cg.snap->serverTime;
 	}
+	baseTime = cg.physicsTime;
 
 	if ( pmove_msec.integer < 8 ) {
 		trap_Cvar_Set("pmove_msec", "8");
@@ -499,9 +872,18 @@ void CG_PredictPlayerState( void ) {
 	cg_pmove.pmove_fixed = pmove_fixed.integer;// | cg_pmove_fixed.integer;
 	cg_pmove.pmove_msec = pmove_msec.integer;
 
-	// run cmds
-	moved = qfalse;
-	for ( cmdNum = current - CMD_BACKUP + 1 ; cmdNum <= current ; cmdNum++ ) {
+	// run cmds, starting after the last cached one if the cache still holds
+	if ( CG_ResumePrediction( current, baseTime ) ) {
+		cmdNum = predictCache.lastCmd + 1;
+		moved = qtrue;
+		predictCache.hits++;
+	} else {
+		cmdNum = current - CMD_BACKUP + 1;
+		moved = qfalse;
+		predictCache.valid = qfalse;
+		predictCache.repredicts++;
+	}
+	for ( ; cmdNum <= current ; cmdNum++ ) {
 		// get the command
 		trap_GetUserCmd( cmdNum, &cg_pmove.cmd );
 
@@ -585,15 +967,23 @@ void CG_PredictPlayerState( void ) {
 
 		moved = qtrue;
 
-		// add push trigger movement effects
+		// add push trigger movement effects, noting whether this
+		// command on its own touched a teleporter
+		hyperspace = cg.hyperspace;
+		cg.hyperspace = qfalse;
 		CG_TouchTriggerPrediction();
 
+		CG_StorePrediction( cmdNum, baseTime, cg.hyperspace );
+		cg.hyperspace |= hyperspace;
+
 		// check for predictable events that changed from previous predictions
 		//CG_CheckChangedPredictableEvents(&cg.predictedPlayerState);
 	}
 
 	if ( cg_showmiss.integer > 1 ) {
 		CG_Printf( "[%i : %i] ", cg_pmove.cmd.serverTime, cg.time );
+		CG_Printf( "predict cache: %i hits, %i repredicts, %i pmoves\n",
+			predictCache.hits, predictCache.repredicts, predictCache.pmoves );
 	}
 
 	if ( !moved ) {
@@ -267,6 +267,10 @@ int		trap_R_LightForPoint( vec3_t point, vec3_t ambientLight, vec3_t directedLig
 	return syscall( CG_R_LIGHTFORPOINT, point, ambientLight, directedLight, lightDir );
 }
 
+int		trap_R_LightForPoints( int numPoints, const vec3_t *points, vec3_t *ambientLight, vec3_t *directedLight, vec3_t *lightDir ) {
+	return syscall( CG_R_LIGHTFORPOINTS, numPoints, points, ambientLight, directedLight, lightDir );
+}
+
 void	trap_R_AddLightToScene( const vec3_t org, float intensity, float r, float g, float b ) {
 	syscall( CG_R_ADDLIGHTTOSCENE, org, PASSFLOAT(intensity), PASSFLOAT(r), PASSFLOAT(g), PASSFLOAT(b) );
 }
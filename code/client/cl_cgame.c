@@ -696,6 +696,8 @@ int CL_CgameSystemCalls( int *args ) {
 		return re.GetEntityToken( VMA(1), args[2] );
 	case CG_R_INPVS:
 		return re.inPVS( VMA(1), VMA(2) );
+	case CG_R_LIGHTFORPOINTS:
+		return re.LightForPoints( args[1], VMA(2), VMA(3), VMA(4), VMA(5) );
 
 	default:
 	        assert(0); // bk010102
@@ -53,8 +53,25 @@ typedef struct {
 	int			previous_waterlevel;
 } pml_t;
 
-extern	pmove_t		*pm;
-extern	pml_t		pml;
+#define	PM_TRACE_CACHE_SIZE	32		// must be a power of two
+
+// a trace PmoveBatch can hand out again
+typedef struct {
+	qboolean	valid;
+	vec3_t		start, mins, maxs, end;
+	int			passEntityNum;
+	int			contentMask;
+	trace_t		trace;
+} pmTraceCache_t;
+
+// everything a move in progress works on, handed down to every PM_
+// function so no two moves share state and one can be predicted from
+// inside another
+typedef struct {
+	pmove_t			*pm;
+	pml_t			pml;
+	pmTraceCache_t	*traceCache;	// PM_TRACE_CACHE_SIZE entries during PmoveBatch, else NULL
+} pmoveContext_t;
 
 // movement parameters
 extern	float	pm_stopspeed;
@@ -74,10 +91,11 @@ extern	float	pm_flightfriction;
 extern	int		c_pmove;
 
 void PM_ClipVelocity( vec3_t in, vec3_t normal, vec3_t out, float overbounce );
-void PM_AddTouchEnt( int entityNum );
-void PM_AddEvent( int newEvent );
+void PM_AddTouchEnt( pmoveContext_t *pc, int entityNum );
+void PM_AddEvent( pmoveContext_t *pc, int newEvent );
+void PM_Trace( pmoveContext_t *pc, trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentMask );
 
-qboolean	PM_SlideMove( qboolean gravity );
-void		PM_StepSlideMove( qboolean gravity );
+qboolean	PM_SlideMove( pmoveContext_t *pc, qboolean gravity );
+void		PM_StepSlideMove( pmoveContext_t *pc, qboolean gravity );
 
 
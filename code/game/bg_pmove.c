@@ -27,9 +27,6 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "bg_public.h"
 #include "bg_local.h"
 
-pmove_t		*pm;
-pml_t		pml;
-
 // movement parameters
 float	pm_stopspeed = 100.0f;
 float	pm_duckScale = 0.25f;
@@ -47,6 +44,8 @@ float	pm_flightfriction = 3.0f;
 float	pm_spectatorfriction = 5.0f;
 
 int		c_pmove = 0;
+int		c_pmoveTraces;
+int		c_pmoveTraceHits;
 
 
 /*
@@ -55,8 +54,8 @@ PM_AddEvent
 
 ===============
 */
-void PM_AddEvent( int newEvent ) {
-	BG_AddPredictableEventToPlayerstate( newEvent, 0, pm->ps );
+void PM_AddEvent( pmoveContext_t *pc, int newEvent ) {
+	BG_AddPredictableEventToPlayerstate( newEvent, 0, pc->pm->ps );
 }
 
 /*
@@ -64,26 +63,26 @@ void PM_AddEvent( int newEvent ) {
 PM_AddTouchEnt
 ===============
 */
-void PM_AddTouchEnt( int entityNum ) {
+void PM_AddTouchEnt( pmoveContext_t *pc, int entityNum ) {
 	int		i;
 
 	if ( entityNum == ENTITYNUM_WORLD ) {
 		return;
 	}
-	if ( pm->numtouch == MAXTOUCH ) {
+	if ( pc->pm->numtouch == MAXTOUCH ) {
 		return;
 	}
 
 	// see if it is already added
-	for ( i = 0 ; i < pm->numtouch ; i++ ) {
-		if ( pm->touchents[ i ] == entityNum ) {
+	for ( i = 0 ; i < pc->pm->numtouch ; i++ ) {
+		if ( pc->pm->touchents[ i ] == entityNum ) {
 			return;
 		}
 	}
 
 	// add it
-	pm->touchents[pm->numtouch] = entityNum;
-	pm->numtouch++;
+	pc->pm->touchents[pc->pm->numtouch] = entityNum;
+	pc->pm->numtouch++;
 }
 
 /*
@@ -91,47 +90,47 @@ void PM_AddTouchEnt( int entityNum ) {
 PM_StartTorsoAnim
 ===================
 */
-static void PM_StartTorsoAnim( int anim ) {
-	if ( pm->ps->pm_type >= PM_DEAD ) {
+static void PM_StartTorsoAnim( pmoveContext_t *pc, int anim ) {
+	if ( pc->pm->ps->pm_type >= PM_DEAD ) {
 		return;
 	}
-	pm->ps->torsoAnim = ( ( pm->ps->torsoAnim & ANIM_TOGGLEBIT ) ^ ANIM_TOGGLEBIT )
+	pc->pm->ps->torsoAnim = ( ( pc->pm->ps->torsoAnim & ANIM_TOGGLEBIT ) ^ ANIM_TOGGLEBIT )
 		| anim;
 }
-static void PM_StartLegsAnim( int anim ) {
-	if ( pm->ps->pm_type >= PM_DEAD ) {
+static void PM_StartLegsAnim( pmoveContext_t *pc, int anim ) {
+	if ( pc->pm->ps->pm_type >= PM_DEAD ) {
 		return;
 	}
-	if ( pm->ps->legsTimer > 0 ) {
+	if ( pc->pm->ps->legsTimer > 0 ) {
 		return;		// a high priority animation is running
 	}
-	pm->ps->legsAnim = ( ( pm->ps->legsAnim & ANIM_TOGGLEBIT ) ^ ANIM_TOGGLEBIT )
+	pc->pm->ps->legsAnim = ( ( pc->pm->ps->legsAnim & ANIM_TOGGLEBIT ) ^ ANIM_TOGGLEBIT )
 		| anim;
 }
 
-static void PM_ContinueLegsAnim( int anim ) {
-	if ( ( pm->ps->legsAnim & ~ANIM_TOGGLEBIT ) == anim ) {
+static void PM_ContinueLegsAnim( pmoveContext_t *pc, int anim ) {
+	if ( ( pc->pm->ps->legsAnim & ~ANIM_TOGGLEBIT ) == anim ) {
 		return;
 	}
-	if ( pm->ps->legsTimer > 0 ) {
+	if ( pc->pm->ps->legsTimer > 0 ) {
 		return;		// a high priority animation is running
 	}
-	PM_StartLegsAnim( anim );
+	PM_StartLegsAnim( pc, anim );
 }
 
-static void PM_ContinueTorsoAnim( int anim ) {
-	if ( ( pm->ps->torsoAnim & ~ANIM_TOGGLEBIT ) == anim ) {
+static void PM_ContinueTorsoAnim( pmoveContext_t *pc, int anim ) {
+	if ( ( pc->pm->ps->torsoAnim & ~ANIM_TOGGLEBIT ) == anim ) {
 		return;
 	}
-	if ( pm->ps->torsoTimer > 0 ) {
+	if ( pc->pm->ps->torsoTimer > 0 ) {
 		return;		// a high priority animation is running
 	}
-	PM_StartTorsoAnim( anim );
+	PM_StartTorsoAnim( pc, anim );
 }
 
-static void PM_ForceLegsAnim( int anim ) {
-	pm->ps->legsTimer = 0;
-	PM_StartLegsAnim( anim );
+static void PM_ForceLegsAnim( pmoveContext_t *pc, int anim ) {
+	pc->pm->ps->legsTimer = 0;
+	PM_StartLegsAnim( pc, anim );
 }
 
 
@@ -169,16 +168,16 @@ PM_Friction
 Handles both ground friction and water friction
 ==================
 */
-static void PM_Friction( void ) {
+static void PM_Friction( pmoveContext_t *pc ) {
 	vec3_t	vec;
 	float	*vel;
 	float	speed, newspeed, control;
 	float	drop;
 	
-	vel = pm->ps->velocity;
+	vel = pc->pm->ps->velocity;
 	
 	VectorCopy( vel, vec );
-	if ( pml.walking ) {
+	if ( pc->pml.walking ) {
 		vec[2] = 0;	// ignore slope movement
 	}
 
@@ -193,28 +192,28 @@ static void PM_Friction( void ) {
 	drop = 0;
 
 	// apply ground friction
-	if ( pm->waterlevel <= 1 ) {
-		if ( pml.walking && !(pml.groundTrace.surfaceFlags & SURF_SLICK) ) {
+	if ( pc->pm->waterlevel <= 1 ) {
+		if ( pc->pml.walking && !(pc->pml.groundTrace.surfaceFlags & SURF_SLICK) ) {
 			// if getting knocked back, no friction
-			if ( ! (pm->ps->pm_flags & PMF_TIME_KNOCKBACK) ) {
+			if ( ! (pc->pm->ps->pm_flags & PMF_TIME_KNOCKBACK) ) {
 				control = speed < pm_stopspeed ? pm_stopspeed : speed;
-				drop += control*pm_friction*pml.frametime;
+				drop += control*pm_friction*pc->pml.frametime;
 			}
 		}
 	}
 
 	// apply water friction even if just wading
-	if ( pm->waterlevel ) {
-		drop += speed*pm_waterfriction*pm->waterlevel*pml.frametime;
+	if ( pc->pm->waterlevel ) {
+		drop += speed*pm_waterfriction*pc->pm->waterlevel*pc->pml.frametime;
 	}
 
 	// apply flying friction
-	if ( pm->ps->powerups[PW_FLIGHT]) {
-		drop += speed*pm_flightfriction*pml.frametime;
+	if ( pc->pm->ps->powerups[PW_FLIGHT]) {
+		drop += speed*pm_flightfriction*pc->pml.frametime;
 	}
 
-	if ( pm->ps->pm_type == PM_SPECTATOR) {
-		drop += speed*pm_spectatorfriction*pml.frametime;
+	if ( pc->pm->ps->pm_type == PM_SPECTATOR) {
+		drop += speed*pm_spectatorfriction*pc->pml.frametime;
 	}
 
 	// scale the velocity
@@ -237,24 +236,24 @@ PM_Accelerate
 Handles user intended acceleration
 ==============
 */
-static void PM_Accelerate( vec3_t wishdir, float wishspeed, float accel ) {
+static void PM_Accelerate( pmoveContext_t *pc, vec3_t wishdir, float wishspeed, float accel ) {
 #if 1
 	// q2 style
 	int			i;
 	float		addspeed, accelspeed, currentspeed;
 
-	currentspeed = DotProduct (pm->ps->velocity, wishdir);
+	currentspeed = DotProduct (pc->pm->ps->velocity, wishdir);
 	addspeed = wishspeed - currentspeed;
 	if (addspeed <= 0) {
 		return;
 	}
-	accelspeed = accel*pml.frametime*wishspeed;
+	accelspeed = accel*pc->pml.frametime*wishspeed;
 	if (accelspeed > addspeed) {
 		accelspeed = addspeed;
 	}
 	
 	for (i=0 ; i<3 ; i++) {
-		pm->ps->velocity[i] += accelspeed*wishdir[i];	
+		pc->pm->ps->velocity[i] += accelspeed*wishdir[i];	
 	}
 #else
 	// proper way (avoids strafe jump maxspeed bug), but feels bad
@@ -264,15 +263,15 @@ static void PM_Accelerate( vec3_t wishdir, float wishspeed, float accel ) {
 	float		canPush;
 
 	VectorScale( wishdir, wishspeed, wishVelocity );
-	VectorSubtract( wishVelocity, pm->ps->velocity, pushDir );
+	VectorSubtract( wishVelocity, pc->pm->ps->velocity, pushDir );
 	pushLen = VectorNormalize( pushDir );
 
-	canPush = accel*pml.frametime*wishspeed;
+	canPush = accel*pc->pml.frametime*wishspeed;
 	if (canPush > pushLen) {
 		canPush = pushLen;
 	}
 
-	VectorMA( pm->ps->velocity, canPush, pushDir, pm->ps->velocity );
+	VectorMA( pc->pm->ps->velocity, canPush, pushDir, pc->pm->ps->velocity );
 #endif
 }
 
@@ -287,7 +286,7 @@ This allows the clients to use axial -127 to 127 values for all directions
 without getting a sqrt(2) distortion in speed.
 ============
 */
-static float PM_CmdScale( usercmd_t *cmd ) {
+static float PM_CmdScale( pmoveContext_t *pc, usercmd_t *cmd ) {
 	int		max;
 	float	total;
 	float	scale;
@@ -305,7 +304,7 @@ static float PM_CmdScale( usercmd_t *cmd ) {
 
 	total = sqrt( cmd->forwardmove * cmd->forwardmove
 		+ cmd->rightmove * cmd->rightmove + cmd->upmove * cmd->upmove );
-	scale = (float)pm->ps->speed * max / ( 127.0 * total );
+	scale = (float)pc->pm->ps->speed * max / ( 127.0 * total );
 
 	return scale;
 }
@@ -319,33 +318,33 @@ Determine the rotation of the legs reletive
 to the facing dir
 ================
 */
-static void PM_SetMovementDir( void ) {
-	if ( pm->cmd.forwardmove || pm->cmd.rightmove ) {
-		if ( pm->cmd.rightmove == 0 && pm->cmd.forwardmove > 0 ) {
-			pm->ps->movementDir = 0;
-		} else if ( pm->cmd.rightmove < 0 && pm->cmd.forwardmove > 0 ) {
-			pm->ps->movementDir = 1;
-		} else if ( pm->cmd.rightmove < 0 && pm->cmd.forwardmove == 0 ) {
-			pm->ps->movementDir = 2;
-		} else if ( pm->cmd.rightmove < 0 && pm->cmd.forwardmove < 0 ) {
-			pm->ps->movementDir = 3;
-		} else if ( pm->cmd.rightmove == 0 && pm->cmd.forwardmove < 0 ) {
-			pm->ps->movementDir = 4;
-		} else if ( pm->cmd.rightmove > 0 && pm->cmd.forwardmove < 0 ) {
-			pm->ps->movementDir = 5;
-		} else if ( pm->cmd.rightmove > 0 && pm->cmd.forwardmove == 0 ) {
-			pm->ps->movementDir = 6;
-		} else if ( pm->cmd.rightmove > 0 && pm->cmd.forwardmove > 0 ) {
-			pm->ps->movementDir = 7;
+static void PM_SetMovementDir( pmoveContext_t *pc ) {
+	if ( pc->pm->cmd.forwardmove || pc->pm->cmd.rightmove ) {
+		if ( pc->pm->cmd.rightmove == 0 && pc->pm->cmd.forwardmove > 0 ) {
+			pc->pm->ps->movementDir = 0;
+		} else if ( pc->pm->cmd.rightmove < 0 && pc->pm->cmd.forwardmove > 0 ) {
+			pc->pm->ps->movementDir = 1;
+		} else if ( pc->pm->cmd.rightmove < 0 && pc->pm->cmd.forwardmove == 0 ) {
+			pc->pm->ps->movementDir = 2;
+		} else if ( pc->pm->cmd.rightmove < 0 && pc->pm->cmd.forwardmove < 0 ) {
+			pc->pm->ps->movementDir = 3;
+		} else if ( pc->pm->cmd.rightmove == 0 && pc->pm->cmd.forwardmove < 0 ) {
+			pc->pm->ps->movementDir = 4;
+		} else if ( pc->pm->cmd.rightmove > 0 && pc->pm->cmd.forwardmove < 0 ) {
+			pc->pm->ps->movementDir = 5;
+		} else if ( pc->pm->cmd.rightmove > 0 && pc->pm->cmd.forwardmove == 0 ) {
+			pc->pm->ps->movementDir = 6;
+		} else if ( pc->pm->cmd.rightmove > 0 && pc->pm->cmd.forwardmove > 0 ) {
+			pc->pm->ps->movementDir = 7;
 		}
 	} else {
 		// if they aren't actively going directly sideways,
 		// change the animation to the diagonal so they
 		// don't stop too crooked
-		if ( pm->ps->movementDir == 2 ) {
-			pm->ps->movementDir = 1;
-		} else if ( pm->ps->movementDir == 6 ) {
-			pm->ps->movementDir = 7;
+		if ( pc->pm->ps->movementDir == 2 ) {
+			pc->pm->ps->movementDir = 1;
+		} else if ( pc->pm->ps->movementDir == 6 ) {
+			pc->pm->ps->movementDir = 7;
 		} 
 	}
 }
@@ -356,37 +355,37 @@ static void PM_SetMovementDir( void ) {
 PM_CheckJump
 =============
 */
-static qboolean PM_CheckJump( void ) {
-	if ( pm->ps->pm_flags & PMF_RESPAWNED ) {
+static qboolean PM_CheckJump( pmoveContext_t *pc ) {
+	if ( pc->pm->ps->pm_flags & PMF_RESPAWNED ) {
 		return qfalse;		// don't allow jump until all buttons are up
 	}
 
-	if ( pm->cmd.upmove < 10 ) {
+	if ( pc->pm->cmd.upmove < 10 ) {
 		// not holding jump
 		return qfalse;
 	}
 
 	// must wait for jump to be released
-	if ( pm->ps->pm_flags & PMF_JUMP_HELD ) {
+	if ( pc->pm->ps->pm_flags & PMF_JUMP_HELD ) {
 		// clear upmove so cmdscale doesn't lower running speed
-		pm->cmd.upmove = 0;
+		pc->pm->cmd.upmove = 0;
 		return qfalse;
 	}
 
-	pml.groundPlane = qfalse;		// jumping away
-	pml.walking = qfalse;
-	pm->ps->pm_flags |= PMF_JUMP_HELD;
+	pc->pml.groundPlane = qfalse;		// jumping away
+	pc->pml.walking = qfalse;
+	pc->pm->ps->pm_flags |= PMF_JUMP_HELD;
 
-	pm->ps->groundEntityNum = ENTITYNUM_NONE;
-	pm->ps->velocity[2] = JUMP_VELOCITY;
-	PM_AddEvent( EV_JUMP );
+	pc->pm->ps->groundEntityNum = ENTITYNUM_NONE;
+	pc->pm->ps->velocity[2] = JUMP_VELOCITY;
+	PM_AddEvent( pc, EV_JUMP );
 
-	if ( pm->cmd.forwardmove >= 0 ) {
-		PM_ForceLegsAnim( LEGS_JUMP );
-		pm->ps->pm_flags &= ~PMF_BACKWARDS_JUMP;
+	if ( pc->pm->cmd.forwardmove >= 0 ) {
+		PM_ForceLegsAnim( pc, LEGS_JUMP );
+		pc->pm->ps->pm_flags &= ~PMF_BACKWARDS_JUMP;
 	} else {
-		PM_ForceLegsAnim( LEGS_JUMPB );
-		pm->ps->pm_flags |= PMF_BACKWARDS_JUMP;
+		PM_ForceLegsAnim( pc, LEGS_JUMPB );
+		pc->pm->ps->pm_flags |= PMF_BACKWARDS_JUMP;
 	}
 
 	return qtrue;
@@ -397,44 +396,44 @@ static qboolean PM_CheckJump( void ) {
 PM_CheckWaterJump
 =============
 */
-static qboolean	PM_CheckWaterJump( void ) {
+static qboolean	PM_CheckWaterJump( pmoveContext_t *pc ) {
 	vec3_t	spot;
 	int		cont;
 	vec3_t	flatforward;
 
-	if (pm->ps->pm_time) {
+	if (pc->pm->ps->pm_time) {
 		return qfalse;
 	}
 
 	// check for water jump
-	if ( pm->waterlevel != 2 ) {
+	if ( pc->pm->waterlevel != 2 ) {
 		return qfalse;
 	}
 
-	flatforward[0] = pml.forward[0];
-	flatforward[1] = pml.forward[1];
+	flatforward[0] = pc->pml.forward[0];
+	flatforward[1] = pc->pml.forward[1];
 	flatforward[2] = 0;
 	VectorNormalize (flatforward);
 
-	VectorMA (pm->ps->origin, 30, flatforward, spot);
+	VectorMA (pc->pm->ps->origin, 30, flatforward, spot);
 	spot[2] += 4;
-	cont = pm->pointcontents (spot, pm->ps->clientNum );
+	cont = pc->pm->pointcontents (spot, pc->pm->ps->clientNum );
 	if ( !(cont & CONTENTS_SOLID) ) {
 		return qfalse;
 	}
 
 	spot[2] += 16;
-	cont = pm->pointcontents (spot, pm->ps->clientNum );
+	cont = pc->pm->pointcontents (spot, pc->pm->ps->clientNum );
 	if ( cont ) {
 		return qfalse;
 	}
 
 	// jump out of water
-	VectorScale (pml.forward, 200, pm->ps->velocity);
-	pm->ps->velocity[2] = 350;
+	VectorScale (pc->pml.forward, 200, pc->pm->ps->velocity);
+	pc->pm->ps->velocity[2] = 350;
 
-	pm->ps->pm_flags |= PMF_TIME_WATERJUMP;
-	pm->ps->pm_time = 2000;
+	pc->pm->ps->pm_flags |= PMF_TIME_WATERJUMP;
+	pc->pm->ps->pm_time = 2000;
 
 	return qtrue;
 }
@@ -449,16 +448,16 @@ PM_WaterJumpMove
 Flying out of the water
 ===================
 */
-static void PM_WaterJumpMove( void ) {
+static void PM_WaterJumpMove( pmoveContext_t *pc ) {
 	// waterjump has no control, but falls
 
-	PM_StepSlideMove( qtrue );
+	PM_StepSlideMove( pc, qtrue );
 
-	pm->ps->velocity[2] -= pm->ps->gravity * pml.frametime;
-	if (pm->ps->velocity[2] < 0) {
+	pc->pm->ps->velocity[2] -= pc->pm->ps->gravity * pc->pml.frametime;
+	if (pc->pm->ps->velocity[2] < 0) {
 		// cancel as soon as we are falling down again
-		pm->ps->pm_flags &= ~PMF_ALL_TIMES;
-		pm->ps->pm_time = 0;
+		pc->pm->ps->pm_flags &= ~PMF_ALL_TIMES;
+		pc->pm->ps->pm_time = 0;
 	}
 }
 
@@ -468,7 +467,7 @@ PM_WaterMove
 
 ===================
 */
-static void PM_WaterMove( void ) {
+static void PM_WaterMove( pmoveContext_t *pc ) {
 	int		i;
 	vec3_t	wishvel;
 	float	wishspeed;
@@ -476,27 +475,27 @@ static void PM_WaterMove( void ) {
 	float	scale;
 	float	vel;
 
-	if ( PM_CheckWaterJump() ) {
-		PM_WaterJumpMove();
+	if ( PM_CheckWaterJump( pc ) ) {
+		PM_WaterJumpMove( pc );
 		return;
 	}
 #if 0
 	// jump = head for surface
-	if ( pm->cmd.upmove >= 10 ) {
-		if (pm->ps->velocity[2] > -300) {
-			if ( pm->watertype == CONTENTS_WATER ) {
-				pm->ps->velocity[2] = 100;
-			} else if (pm->watertype == CONTENTS_SLIME) {
-				pm->ps->velocity[2] = 80;
+	if ( pc->pm->cmd.upmove >= 10 ) {
+		if (pc->pm->ps->velocity[2] > -300) {
+			if ( pc->pm->watertype == CONTENTS_WATER ) {
+				pc->pm->ps->velocity[2] = 100;
+			} else if (pc->pm->watertype == CONTENTS_SLIME) {
+				pc->pm->ps->velocity[2] = 80;
 			} else {
-				pm->ps->velocity[2] = 50;
+				pc->pm->ps->velocity[2] = 50;
 			}
 		}
 	}
 #endif
-	PM_Friction ();
+	PM_Friction( pc );
 
-	scale = PM_CmdScale( &pm->cmd );
+	scale = PM_CmdScale( pc, &pc->pm->cmd );
 	//
 	// user intentions
 	//
@@ -506,32 +505,32 @@ static void PM_WaterMove( void ) {
 		wishvel[2] = -60;		// sink towards bottom
 	} else {
 		for (i=0 ; i<3 ; i++)
-			wishvel[i] = scale * pml.forward[i]*pm->cmd.forwardmove + scale * pml.right[i]*pm->cmd.rightmove;
+			wishvel[i] = scale * pc->pml.forward[i]*pc->pm->cmd.forwardmove + scale * pc->pml.right[i]*pc->pm->cmd.rightmove;
 
-		wishvel[2] += scale * pm->cmd.upmove;
+		wishvel[2] += scale * pc->pm->cmd.upmove;
 	}
 
 	VectorCopy (wishvel, wishdir);
 	wishspeed = VectorNormalize(wishdir);
 
-	if ( wishspeed > pm->ps->speed * pm_swimScale ) {
-		wishspeed = pm->ps->speed * pm_swimScale;
+	if ( wishspeed > pc->pm->ps->speed * pm_swimScale ) {
+		wishspeed = pc->pm->ps->speed * pm_swimScale;
 	}
 
-	PM_Accelerate (wishdir, wishspeed, pm_wateraccelerate);
+	PM_Accelerate( pc, wishdir, wishspeed, pm_wateraccelerate);
 
 	// make sure we can go up slopes easily under water
-	if ( pml.groundPlane && DotProduct( pm->ps->velocity, pml.groundTrace.plane.normal ) < 0 ) {
-		vel = VectorLength(pm->ps->velocity);
+	if ( pc->pml.groundPlane && DotProduct( pc->pm->ps->velocity, pc->pml.groundTrace.plane.normal ) < 0 ) {
+		vel = VectorLength(pc->pm->ps->velocity);
 		// slide along the ground plane
-		PM_ClipVelocity (pm->ps->velocity, pml.groundTrace.plane.normal, 
-			pm->ps->velocity, OVERCLIP );
+		PM_ClipVelocity (pc->pm->ps->velocity, pc->pml.groundTrace.plane.normal, 
+			pc->pm->ps->velocity, OVERCLIP );
 
-		VectorNormalize(pm->ps->velocity);
-		VectorScale(pm->ps->velocity, vel, pm->ps->velocity);
+		VectorNormalize(pc->pm->ps->velocity);
+		VectorScale(pc->pm->ps->velocity, vel, pc->pm->ps->velocity);
 	}
 
-	PM_SlideMove( qfalse );
+	PM_SlideMove( pc, qfalse );
 }
 
 #ifdef MISSIONPACK
@@ -542,11 +541,11 @@ PM_InvulnerabilityMove
 Only with the invulnerability powerup
 ===================
 */
-static void PM_InvulnerabilityMove( void ) {
-	pm->cmd.forwardmove = 0;
-	pm->cmd.rightmove = 0;
-	pm->cmd.upmove = 0;
-	VectorClear(pm->ps->velocity);
+static void PM_InvulnerabilityMove( pmoveContext_t *pc ) {
+	pc->pm->cmd.forwardmove = 0;
+	pc->pm->cmd.rightmove = 0;
+	pc->pm->cmd.upmove = 0;
+	VectorClear(pc->pm->ps->velocity);
 }
 #endif
 
@@ -557,7 +556,7 @@ PM_FlyMove
 Only with the flight powerup
 ===================
 */
-static void PM_FlyMove( void ) {
+static void PM_FlyMove( pmoveContext_t *pc ) {
 	int		i;
 	vec3_t	wishvel;
 	float	wishspeed;
@@ -565,9 +564,9 @@ static void PM_FlyMove( void ) {
 	float	scale;
 
 	// normal slowdown
-	PM_Friction ();
+	PM_Friction( pc );
 
-	scale = PM_CmdScale( &pm->cmd );
+	scale = PM_CmdScale( pc, &pc->pm->cmd );
 	//
 	// user intentions
 	//
@@ -577,18 +576,18 @@ static void PM_FlyMove( void ) {
 		wishvel[2] = 0;
 	} else {
 		for (i=0 ; i<3 ; i++) {
-			wishvel[i] = scale * pml.forward[i]*pm->cmd.forwardmove + scale * pml.right[i]*pm->cmd.rightmove;
+			wishvel[i] = scale * pc->pml.forward[i]*pc->pm->cmd.forwardmove + scale * pc->pml.right[i]*pc->pm->cmd.rightmove;
 		}
 
-		wishvel[2] += scale * pm->cmd.upmove;
+		wishvel[2] += scale * pc->pm->cmd.upmove;
 	}
 
 	VectorCopy (wishvel, wishdir);
 	wishspeed = VectorNormalize(wishdir);
 
-	PM_Accelerate (wishdir, wishspeed, pm_flyaccelerate);
+	PM_Accelerate( pc, wishdir, wishspeed, pm_flyaccelerate);
 
-	PM_StepSlideMove( qfalse );
+	PM_StepSlideMove( pc, qfalse );
 }
 
 
@@ -598,7 +597,7 @@ PM_AirMove
 
 ===================
 */
-static void PM_AirMove( void ) {
+static void PM_AirMove( pmoveContext_t *pc ) {
 	int			i;
 	vec3_t		wishvel;
 	float		fmove, smove;
@@ -607,25 +606,25 @@ static void PM_AirMove( void ) {
 	float		scale;
 	usercmd_t	cmd;
 
-	PM_Friction();
+	PM_Friction( pc );
 
-	fmove = pm->cmd.forwardmove;
-	smove = pm->cmd.rightmove;
+	fmove = pc->pm->cmd.forwardmove;
+	smove = pc->pm->cmd.rightmove;
 
-	cmd = pm->cmd;
-	scale = PM_CmdScale( &cmd );
+	cmd = pc->pm->cmd;
+	scale = PM_CmdScale( pc, &cmd );
 
 	// set the movementDir so clients can rotate the legs for strafing
-	PM_SetMovementDir();
+	PM_SetMovementDir( pc );
 
 	// project moves down to flat plane
-	pml.forward[2] = 0;
-	pml.right[2] = 0;
-	VectorNormalize (pml.forward);
-	VectorNormalize (pml.right);
+	pc->pml.forward[2] = 0;
+	pc->pml.right[2] = 0;
+	VectorNormalize (pc->pml.forward);
+	VectorNormalize (pc->pml.right);
 
 	for ( i = 0 ; i < 2 ; i++ ) {
-		wishvel[i] = pml.forward[i]*fmove + pml.right[i]*smove;
+		wishvel[i] = pc->pml.forward[i]*fmove + pc->pml.right[i]*smove;
 	}
 	wishvel[2] = 0;
 
@@ -634,27 +633,27 @@ static void PM_AirMove( void ) {
 	wishspeed *= scale;
 
 	// not on ground, so little effect on velocity
-	PM_Accelerate (wishdir, wishspeed, pm_airaccelerate);
+	PM_Accelerate( pc, wishdir, wishspeed, pm_airaccelerate);
 
 	// we may have a ground plane that is very steep, even
 	// though we don't have a groundentity
 	// slide along the steep plane
-	if ( pml.groundPlane ) {
-		PM_ClipVelocity (pm->ps->velocity, pml.groundTrace.plane.normal, 
-			pm->ps->velocity, OVERCLIP );
+	if ( pc->pml.groundPlane ) {
+		PM_ClipVelocity (pc->pm->ps->velocity, pc->pml.groundTrace.plane.normal, 
+			pc->pm->ps->velocity, OVERCLIP );
 	}
 
 #if 0
 	//ZOID:  If we are on the grapple, try stair-stepping
 	//this allows a player to use the grapple to pull himself
 	//over a ledge
-	if (pm->ps->pm_flags & PMF_GRAPPLE_PULL)
-		PM_StepSlideMove ( qtrue );
+	if (pc->pm->ps->pm_flags & PMF_GRAPPLE_PULL)
+		PM_StepSlideMove( pc, qtrue );
 	else
-		PM_SlideMove ( qtrue );
+		PM_SlideMove( pc, qtrue );
 #endif
 
-	PM_StepSlideMove ( qtrue );
+	PM_StepSlideMove( pc, qtrue );
 }
 
 /*
@@ -663,13 +662,13 @@ PM_GrappleMove
 
 ===================
 */
-static void PM_GrappleMove( void ) {
+static void PM_GrappleMove( pmoveContext_t *pc ) {
 	vec3_t vel, v;
 	float vlen;
 
-	VectorScale(pml.forward, -16, v);
-	VectorAdd(pm->ps->grapplePoint, v, v);
-	VectorSubtract(v, pm->ps->origin, vel);
+	VectorScale(pc->pml.forward, -16, v);
+	VectorAdd(pc->pm->ps->grapplePoint, v, v);
+	VectorSubtract(v, pc->pm->ps->origin, vel);
 	vlen = VectorLength(vel);
 	VectorNormalize( vel );
 
@@ -678,9 +677,9 @@ static void PM_GrappleMove( void ) {
 	else
 		VectorScale(vel, 800, vel);
 
-	VectorCopy(vel, pm->ps->velocity);
+	VectorCopy(vel, pc->pm->ps->velocity);
 
-	pml.groundPlane = qfalse;
+	pc->pml.groundPlane = qfalse;
 }
 
 /*
@@ -689,7 +688,7 @@ PM_WalkMove
 
 ===================
 */
-static void PM_WalkMove( void ) {
+static void PM_WalkMove( pmoveContext_t *pc ) {
 	int			i;
 	vec3_t		wishvel;
 	float		fmove, smove;
@@ -700,47 +699,47 @@ static void PM_WalkMove( void ) {
 	float		accelerate;
 	float		vel;
 
-	if ( pm->waterlevel > 2 && DotProduct( pml.forward, pml.groundTrace.plane.normal ) > 0 ) {
+	if ( pc->pm->waterlevel > 2 && DotProduct( pc->pml.forward, pc->pml.groundTrace.plane.normal ) > 0 ) {
 		// begin swimming
-		PM_WaterMove();
+		PM_WaterMove( pc );
 		return;
 	}
 
 
-	if ( PM_CheckJump () ) {
+	if ( PM_CheckJump( pc ) ) {
 		// jumped away
-		if ( pm->waterlevel > 1 ) {
-			PM_WaterMove();
+		if ( pc->pm->waterlevel > 1 ) {
+			PM_WaterMove( pc );
 		} else {
-			PM_AirMove();
+			PM_AirMove( pc );
 		}
 		return;
 	}
 
-	PM_Friction ();
+	PM_Friction( pc );
 
-	fmove = pm->cmd.forwardmove;
-	smove = pm->cmd.rightmove;
+	fmove = pc->pm->cmd.forwardmove;
+	smove = pc->pm->cmd.rightmove;
 
-	cmd = pm->cmd;
-	scale = PM_CmdScale( &cmd );
+	cmd = pc->pm->cmd;
+	scale = PM_CmdScale( pc, &cmd );
 
 	// set the movementDir so clients can rotate the legs for strafing
-	PM_SetMovementDir();
+	PM_SetMovementDir( pc );
 
 	// project moves down to flat plane
-	pml.forward[2] = 0;
-	pml.right[2] = 0;
+	pc->pml.forward[2] = 0;
+	pc->pml.right[2] = 0;
 
 	// project the forward and right directions onto the ground plane
-	PM_ClipVelocity (pml.forward, pml.groundTrace.plane.normal, pml.forward, OVERCLIP );
-	PM_ClipVelocity (pml.right, pml.groundTrace.plane.normal, pml.right, OVERCLIP );
+	PM_ClipVelocity (pc->pml.forward, pc->pml.groundTrace.plane.normal, pc->pml.forward, OVERCLIP );
+	PM_ClipVelocity (pc->pml.right, pc->pml.groundTrace.plane.normal, pc->pml.right, OVERCLIP );
 	//
-	VectorNormalize (pml.forward);
-	VectorNormalize (pml.right);
+	VectorNormalize (pc->pml.forward);
+	VectorNormalize (pc->pml.right);
 
 	for ( i = 0 ; i < 3 ; i++ ) {
-		wishvel[i] = pml.forward[i]*fmove + pml.right[i]*smove;
+		wishvel[i] = pc->pml.forward[i]*fmove + pc->pml.right[i]*smove;
 	}
 	// when going up or down slopes the wish velocity should Not be zero
 //	wishvel[2] = 0;
@@ -750,61 +749,61 @@ static void PM_WalkMove( void ) {
 	wishspeed *= scale;
 
 	// clamp the speed lower if ducking
-	if ( pm->ps->pm_flags & PMF_DUCKED ) {
-		if ( wishspeed > pm->ps->speed * pm_duckScale ) {
-			wishspeed = pm->ps->speed * pm_duckScale;
+	if ( pc->pm->ps->pm_flags & PMF_DUCKED ) {
+		if ( wishspeed > pc->pm->ps->speed * pm_duckScale ) {
+			wishspeed = pc->pm->ps->speed * pm_duckScale;
 		}
 	}
 
 	// clamp the speed lower if wading or walking on the bottom
-	if ( pm->waterlevel ) {
+	if ( pc->pm->waterlevel ) {
 		float	waterScale;
 
-		waterScale = pm->waterlevel / 3.0;
+		waterScale = pc->pm->waterlevel / 3.0;
 		waterScale = 1.0 - ( 1.0 - pm_swimScale ) * waterScale;
-		if ( wishspeed > pm->ps->speed * waterScale ) {
-			wishspeed = pm->ps->speed * waterScale;
+		if ( wishspeed > pc->pm->ps->speed * waterScale ) {
+			wishspeed = pc->pm->ps->speed * waterScale;
 		}
 	}
 
 	// when a player gets hit, they temporarily lose
 	// full control, which allows them to be moved a bit
-	if ( ( pml.groundTrace.surfaceFlags & SURF_SLICK ) || pm->ps->pm_flags & PMF_TIME_KNOCKBACK ) {
+	if ( ( pc->pml.groundTrace.surfaceFlags & SURF_SLICK ) || pc->pm->ps->pm_flags & PMF_TIME_KNOCKBACK ) {
 		accelerate = pm_airaccelerate;
 	} else {
 		accelerate = pm_accelerate;
 	}
 
-	PM_Accelerate (wishdir, wishspeed, accelerate);
+	PM_Accelerate( pc, wishdir, wishspeed, accelerate);
 
-	//Com_Printf("velocity = %1.1f %1.1f %1.1f\n", pm->ps->velocity[0], pm->ps->velocity[1], pm->ps->velocity[2]);
-	//Com_Printf("velocity1 = %1.1f\n", VectorLength(pm->ps->velocity));
+	//Com_Printf("velocity = %1.1f %1.1f %1.1f\n", pc->pm->ps->velocity[0], pc->pm->ps->velocity[1], pc->pm->ps->velocity[2]);
+	//Com_Printf("velocity1 = %1.1f\n", VectorLength(pc->pm->ps->velocity));
 
-	if ( ( pml.groundTrace.surfaceFlags & SURF_SLICK ) || pm->ps->pm_flags & PMF_TIME_KNOCKBACK ) {
-		pm->ps->velocity[2] -= pm->ps->gravity * pml.frametime;
+	if ( ( pc->pml.groundTrace.surfaceFlags & SURF_SLICK ) || pc->pm->ps->pm_flags & PMF_TIME_KNOCKBACK ) {
+		pc->pm->ps->velocity[2] -= pc->pm->ps->gravity * pc->pml.frametime;
 	} else {
 		// don't reset the z velocity for slopes
-//		pm->ps->velocity[2] = 0;
+//		pc->pm->ps->velocity[2] = 0;
 	}
 
-	vel = VectorLength(pm->ps->velocity);
+	vel = VectorLength(pc->pm->ps->velocity);
 
 	// slide along the ground plane
-	PM_ClipVelocity (pm->ps->velocity, pml.groundTrace.plane.normal, 
-		pm->ps->velocity, OVERCLIP );
+	PM_ClipVelocity (pc->pm->ps->velocity, pc->pml.groundTrace.plane.normal, 
+		pc->pm->ps->velocity, OVERCLIP );
 
 	// don't decrease velocity when going up or down a slope
-	VectorNormalize(pm->ps->velocity);
-	VectorScale(pm->ps->velocity, vel, pm->ps->velocity);
+	VectorNormalize(pc->pm->ps->velocity);
+	VectorScale(pc->pm->ps->velocity, vel, pc->pm->ps->velocity);
 
 	// don't do anything if standing still
-	if (!pm->ps->velocity[0] && !pm->ps->velocity[1]) {
+	if (!pc->pm->ps->velocity[0] && !pc->pm->ps->velocity[1]) {
 		return;
 	}
 
-	PM_StepSlideMove( qfalse );
+	PM_StepSlideMove( pc, qfalse );
 
-	//Com_Printf("velocity2 = %1.1f\n", VectorLength(pm->ps->velocity));
+	//Com_Printf("velocity2 = %1.1f\n", VectorLength(pc->pm->ps->velocity));
 
 }
 
@@ -814,22 +813,22 @@ static void PM_WalkMove( void ) {
 PM_DeadMove
 ==============
 */
-static void PM_DeadMove( void ) {
+static void PM_DeadMove( pmoveContext_t *pc ) {
 	float	forward;
 
-	if ( !pml.walking ) {
+	if ( !pc->pml.walking ) {
 		return;
 	}
 
 	// extra friction
 
-	forward = VectorLength (pm->ps->velocity);
+	forward = VectorLength (pc->pm->ps->velocity);
 	forward -= 20;
 	if ( forward <= 0 ) {
-		VectorClear (pm->ps->velocity);
+		VectorClear (pc->pm->ps->velocity);
 	} else {
-		VectorNormalize (pm->ps->velocity);
-		VectorScale (pm->ps->velocity, forward, pm->ps->velocity);
+		VectorNormalize (pc->pm->ps->velocity);
+		VectorScale (pc->pm->ps->velocity, forward, pc->pm->ps->velocity);
 	}
 }
 
@@ -839,7 +838,7 @@ static void PM_DeadMove( void ) {
 PM_NoclipMove
 ===============
 */
-static void PM_NoclipMove( void ) {
+static void PM_NoclipMove( pmoveContext_t *pc ) {
 	float	speed, drop, friction, control, newspeed;
 	int			i;
 	vec3_t		wishvel;
@@ -848,14 +847,14 @@ static void PM_NoclipMove( void ) {
 	float		wishspeed;
 	float		scale;
 
-	pm->ps->viewheight = DEFAULT_VIEWHEIGHT;
+	pc->pm->ps->viewheight = DEFAULT_VIEWHEIGHT;
 
 	// friction
 
-	speed = VectorLength (pm->ps->velocity);
+	speed = VectorLength (pc->pm->ps->velocity);
 	if (speed < 1)
 	{
-		VectorCopy (vec3_origin, pm->ps->velocity);
+		VectorCopy (vec3_origin, pc->pm->ps->velocity);
 	}
 	else
 	{
@@ -863,7 +862,7 @@ static void PM_NoclipMove( void ) {
 
 		friction = pm_friction*1.5;	// extra friction
 		control = speed < pm_stopspeed ? pm_stopspeed : speed;
-		drop += control*friction*pml.frametime;
+		drop += control*friction*pc->pml.frametime;
 
 		// scale the velocity
 		newspeed = speed - drop;
@@ -871,27 +870,27 @@ static void PM_NoclipMove( void ) {
 			newspeed = 0;
 		newspeed /= speed;
 
-		VectorScale (pm->ps->velocity, newspeed, pm->ps->velocity);
+		VectorScale (pc->pm->ps->velocity, newspeed, pc->pm->ps->velocity);
 	}
 
 	// accelerate
-	scale = PM_CmdScale( &pm->cmd );
+	scale = PM_CmdScale( pc, &pc->pm->cmd );
 
-	fmove = pm->cmd.forwardmove;
-	smove = pm->cmd.rightmove;
+	fmove = pc->pm->cmd.forwardmove;
+	smove = pc->pm->cmd.rightmove;
 	
 	for (i=0 ; i<3 ; i++)
-		wishvel[i] = pml.forward[i]*fmove + pml.right[i]*smove;
-	wishvel[2] += pm->cmd.upmove;
+		wishvel[i] = pc->pml.forward[i]*fmove + pc->pml.right[i]*smove;
+	wishvel[2] += pc->pm->cmd.upmove;
 
 	VectorCopy (wishvel, wishdir);
 	wishspeed = VectorNormalize(wishdir);
 	wishspeed *= scale;
 
-	PM_Accelerate( wishdir, wishspeed, pm_accelerate );
+	PM_Accelerate( pc, wishdir, wishspeed, pm_accelerate );
 
 	// move
-	VectorMA (pm->ps->origin, pml.frametime, pm->ps->velocity, pm->ps->origin);
+	VectorMA (pc->pm->ps->origin, pc->pml.frametime, pc->pm->ps->velocity, pc->pm->ps->origin);
 }
 
 //============================================================================
@@ -903,11 +902,11 @@ PM_FootstepForSurface
 Returns an event number apropriate for the groundsurface
 ================
 */
-static int PM_FootstepForSurface( void ) {
-	if ( pml.groundTrace.surfaceFlags & SURF_NOSTEPS ) {
+static int PM_FootstepForSurface( pmoveContext_t *pc ) {
+	if ( pc->pml.groundTrace.surfaceFlags & SURF_NOSTEPS ) {
 		return 0;
 	}
-	if ( pml.groundTrace.surfaceFlags & SURF_METALSTEPS ) {
+	if ( pc->pml.groundTrace.surfaceFlags & SURF_METALSTEPS ) {
 		return EV_FOOTSTEP_METAL;
 	}
 	return EV_FOOTSTEP;
@@ -921,7 +920,7 @@ PM_CrashLand
 Check for hard landings that generate sound events
 =================
 */
-static void PM_CrashLand( void ) {
+static void PM_CrashLand( pmoveContext_t *pc ) {
 	float		delta;
 	float		dist;
 	float		vel, acc;
@@ -929,18 +928,18 @@ static void PM_CrashLand( void ) {
 	float		a, b, c, den;
 
 	// decide which landing animation to use
-	if ( pm->ps->pm_flags & PMF_BACKWARDS_JUMP ) {
-		PM_ForceLegsAnim( LEGS_LANDB );
+	if ( pc->pm->ps->pm_flags & PMF_BACKWARDS_JUMP ) {
+		PM_ForceLegsAnim( pc, LEGS_LANDB );
 	} else {
-		PM_ForceLegsAnim( LEGS_LAND );
+		PM_ForceLegsAnim( pc, LEGS_LAND );
 	}
 
-	pm->ps->legsTimer = TIMER_LAND;
+	pc->pm->ps->legsTimer = TIMER_LAND;
 
 	// calculate the exact velocity on landing
-	dist = pm->ps->origin[2] - pml.previous_origin[2];
-	vel = pml.previous_velocity[2];
-	acc = -pm->ps->gravity;
+	dist = pc->pm->ps->origin[2] - pc->pml.previous_origin[2];
+	vel = pc->pml.previous_velocity[2];
+	acc = -pc->pm->ps->gravity;
 
 	a = acc / 2;
 	b = vel;
@@ -956,20 +955,20 @@ static void PM_CrashLand( void ) {
 	delta = delta*delta * 0.0001;
 
 	// ducking while falling doubles damage
-	if ( pm->ps->pm_flags & PMF_DUCKED ) {
+	if ( pc->pm->ps->pm_flags & PMF_DUCKED ) {
 		delta *= 2;
 	}
 
 	// never take falling damage if completely underwater
-	if ( pm->waterlevel == 3 ) {
+	if ( pc->pm->waterlevel == 3 ) {
 		return;
 	}
 
 	// reduce falling damage if there is standing water
-	if ( pm->waterlevel == 2 ) {
+	if ( pc->pm->waterlevel == 2 ) {
 		delta *= 0.25;
 	}
-	if ( pm->waterlevel == 1 ) {
+	if ( pc->pm->waterlevel == 1 ) {
 		delta *= 0.5;
 	}
 
@@ -981,23 +980,23 @@ static void PM_CrashLand( void ) {
 
 	// SURF_NODAMAGE is used for bounce pads where you don't ever
 	// want to take damage or play a crunch sound
-	if ( !(pml.groundTrace.surfaceFlags & SURF_NODAMAGE) )  {
+	if ( !(pc->pml.groundTrace.surfaceFlags & SURF_NODAMAGE) )  {
 		if ( delta > 60 ) {
-			PM_AddEvent( EV_FALL_FAR );
+			PM_AddEvent( pc, EV_FALL_FAR );
 		} else if ( delta > 40 ) {
 			// this is a pain grunt, so don't play it if dead
-			if ( pm->ps->stats[STAT_HEALTH] > 0 ) {
-				PM_AddEvent( EV_FALL_MEDIUM );
+			if ( pc->pm->ps->stats[STAT_HEALTH] > 0 ) {
+				PM_AddEvent( pc, EV_FALL_MEDIUM );
 			}
 		} else if ( delta > 7 ) {
-			PM_AddEvent( EV_FALL_SHORT );
+			PM_AddEvent( pc, EV_FALL_SHORT );
 		} else {
-			PM_AddEvent( PM_FootstepForSurface() );
+			PM_AddEvent( pc, PM_FootstepForSurface( pc ) );
 		}
 	}
 
 	// start footstep cycle over
-	pm->ps->bobCycle = 0;
+	pc->pm->ps->bobCycle = 0;
 }
 
 /*
@@ -1006,10 +1005,10 @@ PM_CheckStuck
 =============
 */
 /*
-void PM_CheckStuck(void) {
+void PM_CheckStuck( pmoveContext_t *pc ) {
 	trace_t trace;
 
-	pm->trace (&trace, pm->ps->origin, pm->mins, pm->maxs, pm->ps->origin, pm->ps->clientNum, pm->tracemask);
+	PM_Trace( pc, &trace, pc->pm->ps->origin, pc->pm->mins, pc->pm->maxs, pc->pm->ps->origin, pc->pm->ps->clientNum, pc->pm->tracemask);
 	if (trace.allsolid) {
 		//int shit = qtrue;
 	}
@@ -1021,11 +1020,11 @@ void PM_CheckStuck(void) {
 PM_CorrectAllSolid
 =============
 */
-static int PM_CorrectAllSolid( trace_t *trace ) {
+static int PM_CorrectAllSolid( pmoveContext_t *pc, trace_t *trace ) {
 	int			i, j, k;
 	vec3_t		point;
 
-	if ( pm->debugLevel ) {
+	if ( pc->pm->debugLevel ) {
 		Com_Printf("%i:allsolid\n", c_pmove);
 	}
 
@@ -1033,27 +1032,27 @@ static int PM_CorrectAllSolid( trace_t *trace ) {
 	for (i = -1; i <= 1; i++) {
 		for (j = -1; j <= 1; j++) {
 			for (k = -1; k <= 1; k++) {
-				VectorCopy(pm->ps->origin, point);
+				VectorCopy(pc->pm->ps->origin, point);
 				point[0] += (float) i;
 				point[1] += (float) j;
 				point[2] += (float) k;
-				pm->trace (trace, point, pm->mins, pm->maxs, point, pm->ps->clientNum, pm->tracemask);
+				PM_Trace( pc, trace, point, pc->pm->mins, pc->pm->maxs, point, pc->pm->ps->clientNum, pc->pm->tracemask);
 				if ( !trace->allsolid ) {
-					point[0] = pm->ps->origin[0];
-					point[1] = pm->ps->origin[1];
-					point[2] = pm->ps->origin[2] - 0.25;
+					point[0] = pc->pm->ps->origin[0];
+					point[1] = pc->pm->ps->origin[1];
+					point[2] = pc->pm->ps->origin[2] - 0.25;
 
-					pm->trace (trace, pm->ps->origin, pm->mins, pm->maxs, point, pm->ps->clientNum, pm->tracemask);
-					pml.groundTrace = *trace;
+					PM_Trace( pc, trace, pc->pm->ps->origin, pc->pm->mins, pc->pm->maxs, point, pc->pm->ps->clientNum, pc->pm->tracemask);
+					pc->pml.groundTrace = *trace;
 					return qtrue;
 				}
 			}
 		}
 	}
 
-	pm->ps->groundEntityNum = ENTITYNUM_NONE;
-	pml.groundPlane = qfalse;
-	pml.walking = qfalse;
+	pc->pm->ps->groundEntityNum = ENTITYNUM_NONE;
+	pc->pml.groundPlane = qfalse;
+	pc->pml.walking = qfalse;
 
 	return qfalse;
 }
@@ -1066,36 +1065,36 @@ PM_GroundTraceMissed
 The ground trace didn't hit a surface, so we are in freefall
 =============
 */
-static void PM_GroundTraceMissed( void ) {
+static void PM_GroundTraceMissed( pmoveContext_t *pc ) {
 	trace_t		trace;
 	vec3_t		point;
 
-	if ( pm->ps->groundEntityNum != ENTITYNUM_NONE ) {
+	if ( pc->pm->ps->groundEntityNum != ENTITYNUM_NONE ) {
 		// we just transitioned into freefall
-		if ( pm->debugLevel ) {
+		if ( pc->pm->debugLevel ) {
 			Com_Printf("%i:lift\n", c_pmove);
 		}
 
 		// if they aren't in a jumping animation and the ground is a ways away, force into it
 		// if we didn't do the trace, the player would be backflipping down staircases
-		VectorCopy( pm->ps->origin, point );
+		VectorCopy( pc->pm->ps->origin, point );
 		point[2] -= 64;
 
-		pm->trace (&trace, pm->ps->origin, pm->mins, pm->maxs, point, pm->ps->clientNum, pm->tracemask);
+		PM_Trace( pc, &trace, pc->pm->ps->origin, pc->pm->mins, pc->pm->maxs, point, pc->pm->ps->clientNum, pc->pm->tracemask);
 		if ( trace.fraction == 1.0 ) {
-			if ( pm->cmd.forwardmove >= 0 ) {
-				PM_ForceLegsAnim( LEGS_JUMP );
-				pm->ps->pm_flags &= ~PMF_BACKWARDS_JUMP;
+			if ( pc->pm->cmd.forwardmove >= 0 ) {
+				PM_ForceLegsAnim( pc, LEGS_JUMP );
+				pc->pm->ps->pm_flags &= ~PMF_BACKWARDS_JUMP;
 			} else {
-				PM_ForceLegsAnim( LEGS_JUMPB );
-				pm->ps->pm_flags |= PMF_BACKWARDS_JUMP;
+				PM_ForceLegsAnim( pc, LEGS_JUMPB );
+				pc->pm->ps->pm_flags |= PMF_BACKWARDS_JUMP;
 			}
 		}
 	}
 
-	pm->ps->groundEntityNum = ENTITYNUM_NONE;
-	pml.groundPlane = qfalse;
-	pml.walking = qfalse;
+	pc->pm->ps->groundEntityNum = ENTITYNUM_NONE;
+	pc->pml.groundPlane = qfalse;
+	pc->pml.walking = qfalse;
 }
 
 
@@ -1104,96 +1103,96 @@ static void PM_GroundTraceMissed( void ) {
 PM_GroundTrace
 =============
 */
-static void PM_GroundTrace( void ) {
+static void PM_GroundTrace( pmoveContext_t *pc ) {
 	vec3_t		point;
 	trace_t		trace;
 
-	point[0] = pm->ps->origin[0];
-	point[1] = pm->ps->origin[1];
-	point[2] = pm->ps->origin[2] - 0.25;
+	point[0] = pc->pm->ps->origin[0];
+	point[1] = pc->pm->ps->origin[1];
+	point[2] = pc->pm->ps->origin[2] - 0.25;
 
-	pm->trace (&trace, pm->ps->origin, pm->mins, pm->maxs, point, pm->ps->clientNum, pm->tracemask);
-	pml.groundTrace = trace;
+	PM_Trace( pc, &trace, pc->pm->ps->origin, pc->pm->mins, pc->pm->maxs, point, pc->pm->ps->clientNum, pc->pm->tracemask);
+	pc->pml.groundTrace = trace;
 
 	// do something corrective if the trace starts in a solid...
 	if ( trace.allsolid ) {
-		if ( !PM_CorrectAllSolid(&trace) )
+		if ( !PM_CorrectAllSolid( pc, &trace) )
 			return;
 	}
 
 	// if the trace didn't hit anything, we are in free fall
 	if ( trace.fraction == 1.0 ) {
-		PM_GroundTraceMissed();
-		pml.groundPlane = qfalse;
-		pml.walking = qfalse;
+		PM_GroundTraceMissed( pc );
+		pc->pml.groundPlane = qfalse;
+		pc->pml.walking = qfalse;
 		return;
 	}
 
 	// check if getting thrown off the ground
-	if ( pm->ps->velocity[2] > 0 && DotProduct( pm->ps->velocity, trace.plane.normal ) > 10 ) {
-		if ( pm->debugLevel ) {
+	if ( pc->pm->ps->velocity[2] > 0 && DotProduct( pc->pm->ps->velocity, trace.plane.normal ) > 10 ) {
+		if ( pc->pm->debugLevel ) {
 			Com_Printf("%i:kickoff\n", c_pmove);
 		}
 		// go into jump animation
-		if ( pm->cmd.forwardmove >= 0 ) {
-			PM_ForceLegsAnim( LEGS_JUMP );
-			pm->ps->pm_flags &= ~PMF_BACKWARDS_JUMP;
+		if ( pc->pm->cmd.forwardmove >= 0 ) {
+			PM_ForceLegsAnim( pc, LEGS_JUMP );
+			pc->pm->ps->pm_flags &= ~PMF_BACKWARDS_JUMP;
 		} else {
-			PM_ForceLegsAnim( LEGS_JUMPB );
-			pm->ps->pm_flags |= PMF_BACKWARDS_JUMP;
+			PM_ForceLegsAnim( pc, LEGS_JUMPB );
+			pc->pm->ps->pm_flags |= PMF_BACKWARDS_JUMP;
 		}
 
-		pm->ps->groundEntityNum = ENTITYNUM_NONE;
-		pml.groundPlane = qfalse;
-		pml.walking = qfalse;
+		pc->pm->ps->groundEntityNum = ENTITYNUM_NONE;
+		pc->pml.groundPlane = qfalse;
+		pc->pml.walking = qfalse;
 		return;
 	}
 	
 	// slopes that are too steep will not be considered onground
 	if ( trace.plane.normal[2] < MIN_WALK_NORMAL ) {
-		if ( pm->debugLevel ) {
+		if ( pc->pm->debugLevel ) {
 			Com_Printf("%i:steep\n", c_pmove);
 		}
 		// FIXME: if they can't slide down the slope, let them
 		// walk (sharp crevices)
-		pm->ps->groundEntityNum = ENTITYNUM_NONE;
-		pml.groundPlane = qtrue;
-		pml.walking = qfalse;
+		pc->pm->ps->groundEntityNum = ENTITYNUM_NONE;
+		pc->pml.groundPlane = qtrue;
+		pc->pml.walking = qfalse;
 		return;
 	}
 
-	pml.groundPlane = qtrue;
-	pml.walking = qtrue;
+	pc->pml.groundPlane = qtrue;
+	pc->pml.walking = qtrue;
 
 	// hitting solid ground will end a waterjump
-	if (pm->ps->pm_flags & PMF_TIME_WATERJUMP)
+	if (pc->pm->ps->pm_flags & PMF_TIME_WATERJUMP)
 	{
-		pm->ps->pm_flags &= ~(PMF_TIME_WATERJUMP | PMF_TIME_LAND);
-		pm->ps->pm_time = 0;
+		pc->pm->ps->pm_flags &= ~(PMF_TIME_WATERJUMP | PMF_TIME_LAND);
+		pc->pm->ps->pm_time = 0;
 	}
 
-	if ( pm->ps->groundEntityNum == ENTITYNUM_NONE ) {
+	if ( pc->pm->ps->groundEntityNum == ENTITYNUM_NONE ) {
 		// just hit the ground
-		if ( pm->debugLevel ) {
+		if ( pc->pm->debugLevel ) {
 			Com_Printf("%i:Land\n", c_pmove);
 		}
 		
-		PM_CrashLand();
+		PM_CrashLand( pc );
 
 		// don't do landing time if we were just going down a slope
-		if ( pml.previous_velocity[2] < -200 ) {
+		if ( pc->pml.previous_velocity[2] < -200 ) {
 			// don't allow another jump for a little while
-			pm->ps->pm_flags |= PMF_TIME_LAND;
-			pm->ps->pm_time = 250;
+			pc->pm->ps->pm_flags |= PMF_TIME_LAND;
+			pc->pm->ps->pm_time = 250;
 		}
 	}
 
-	pm->ps->groundEntityNum = trace.entityNum;
+	pc->pm->ps->groundEntityNum = trace.entityNum;
 
 	// don't reset the z velocity for slopes
-//	pm->ps->velocity[2] = 0;
+//	pc->pm->ps->velocity[2] = 0;
 
-	PM_AddTouchEnt( trace.entityNum );
+	PM_AddTouchEnt( pc, trace.entityNum );
 }
 
 
@@ -1202,7 +1201,7 @@ static void PM_GroundTrace( void ) {
 PM_SetWaterLevel	FIXME: avoid this twice?  certainly if not moving
 =============
 */
-static void PM_SetWaterLevel( void ) {
+static void PM_SetWaterLevel( pmoveContext_t *pc ) {
 	vec3_t		point;
 	int			cont;
 	int			sample1;
@@ -1211,28 +1210,28 @@ static void PM_SetWaterLevel( void ) {
 	//
 	// get waterlevel, accounting for ducking
 	//
-	pm->waterlevel = 0;
-	pm->watertype = 0;
+	pc->pm->waterlevel = 0;
+	pc->pm->watertype = 0;
 
-	point[0] = pm->ps->origin[0];
-	point[1] = pm->ps->origin[1];
-	point[2] = pm->ps->origin[2] + MINS_Z + 1;	
-	cont = pm->pointcontents( point, pm->ps->clientNum );
+	point[0] = pc->pm->ps->origin[0];
+	point[1] = pc->pm->ps->origin[1];
+	point[2] = pc->pm->ps->origin[2] + MINS_Z + 1;	
+	cont = pc->pm->pointcontents( point, pc->pm->ps->clientNum );
 
 	if ( cont & MASK_WATER ) {
-		sample2 = pm->ps->viewheight - MINS_Z;
+		sample2 = pc->pm->ps->viewheight - MINS_Z;
 		sample1 = sample2 / 2;
 
-		pm->watertype = cont;
-		pm->waterlevel = 1;
-		point[2] = pm->ps->origin[2] + MINS_Z + sample1;
-		cont = pm->pointcontents (point, pm->ps->clientNum );
+		pc->pm->watertype = cont;
+		pc->pm->waterlevel = 1;
+		point[2] = pc->pm->ps->origin[2] + MINS_Z + sample1;
+		cont = pc->pm->pointcontents (point, pc->pm->ps->clientNum );
 		if ( cont & MASK_WATER ) {
-			pm->waterlevel = 2;
-			point[2] = pm->ps->origin[2] + MINS_Z + sample2;
-			cont = pm->pointcontents (point, pm->ps->clientNum );
+			pc->pm->waterlevel = 2;
+			point[2] = pc->pm->ps->origin[2] + MINS_Z + sample2;
+			cont = pc->pm->pointcontents (point, pc->pm->ps->clientNum );
 			if ( cont & MASK_WATER ){
-				pm->waterlevel = 3;
+				pc->pm->waterlevel = 3;
 			}
 		}
 	}
@@ -1243,69 +1242,69 @@ static void PM_SetWaterLevel( void ) {
 ==============
 PM_CheckDuck
 
-Sets mins, maxs, and pm->ps->viewheight
+Sets mins, maxs, and pc->pm->ps->viewheight
 ==============
 */
-static void PM_CheckDuck (void)
+static void PM_CheckDuck( pmoveContext_t *pc )
 {
 	trace_t	trace;
 
-	if ( pm->ps->powerups[PW_INVULNERABILITY] ) {
-		if ( pm->ps->pm_flags & PMF_INVULEXPAND ) {
+	if ( pc->pm->ps->powerups[PW_INVULNERABILITY] ) {
+		if ( pc->pm->ps->pm_flags & PMF_INVULEXPAND ) {
 			// invulnerability sphere has a 42 units radius
-			VectorSet( pm->mins, -42, -42, -42 );
-			VectorSet( pm->maxs, 42, 42, 42 );
+			VectorSet( pc->pm->mins, -42, -42, -42 );
+			VectorSet( pc->pm->maxs, 42, 42, 42 );
 		}
 		else {
-			VectorSet( pm->mins, -15, -15, MINS_Z );
-			VectorSet( pm->maxs, 15, 15, 16 );
+			VectorSet( pc->pm->mins, -15, -15, MINS_Z );
+			VectorSet( pc->pm->maxs, 15, 15, 16 );
 		}
-		pm->ps->pm_flags |= PMF_DUCKED;
-		pm->ps->viewheight = CROUCH_VIEWHEIGHT;
+		pc->pm->ps->pm_flags |= PMF_DUCKED;
+		pc->pm->ps->viewheight = CROUCH_VIEWHEIGHT;
 		return;
 	}
-	pm->ps->pm_flags &= ~PMF_INVULEXPAND;
+	pc->pm->ps->pm_flags &= ~PMF_INVULEXPAND;
 
-	pm->mins[0] = -15;
-	pm->mins[1] = -15;
+	pc->pm->mins[0] = -15;
+	pc->pm->mins[1] = -15;
 
-	pm->maxs[0] = 15;
-	pm->maxs[1] = 15;
+	pc->pm->maxs[0] = 15;
+	pc->pm->maxs[1] = 15;
 
-	pm->mins[2] = MINS_Z;
+	pc->pm->mins[2] = MINS_Z;
 
-	if (pm->ps->pm_type == PM_DEAD)
+	if (pc->pm->ps->pm_type == PM_DEAD)
 	{
-		pm->maxs[2] = -8;
-		pm->ps->viewheight = DEAD_VIEWHEIGHT;
+		pc->pm->maxs[2] = -8;
+		pc->pm->ps->viewheight = DEAD_VIEWHEIGHT;
 		return;
 	}
 
-	if (pm->cmd.upmove < 0)
+	if (pc->pm->cmd.upmove < 0)
 	{	// duck
-		pm->ps->pm_flags |= PMF_DUCKED;
+		pc->pm->ps->pm_flags |= PMF_DUCKED;
 	}
 	else
 	{	// stand up if possible
-		if (pm->ps->pm_flags & PMF_DUCKED)
+		if (pc->pm->ps->pm_flags & PMF_DUCKED)
 		{
 			// try to stand up
-			pm->maxs[2] = 32;
-			pm->trace (&trace, pm->ps->origin, pm->mins, pm->maxs, pm->ps->origin, pm->ps->clientNum, pm->tracemask );
+			pc->pm->maxs[2] = 32;
+			PM_Trace( pc, &trace, pc->pm->ps->origin, pc->pm->mins, pc->pm->maxs, pc->pm->ps->origin, pc->pm->ps->clientNum, pc->pm->tracemask );
 			if (!trace.allsolid)
-				pm->ps->pm_flags &= ~PMF_DUCKED;
+				pc->pm->ps->pm_flags &= ~PMF_DUCKED;
 		}
 	}
 
-	if (pm->ps->pm_flags & PMF_DUCKED)
+	if (pc->pm->ps->pm_flags & PMF_DUCKED)
 	{
-		pm->maxs[2] = 16;
-		pm->ps->viewheight = CROUCH_VIEWHEIGHT;
+		pc->pm->maxs[2] = 16;
+		pc->pm->ps->viewheight = CROUCH_VIEWHEIGHT;
 	}
 	else
 	{
-		pm->maxs[2] = 32;
-		pm->ps->viewheight = DEFAULT_VIEWHEIGHT;
+		pc->pm->maxs[2] = 32;
+		pc->pm->ps->viewheight = DEFAULT_VIEWHEIGHT;
 	}
 }
 
@@ -1319,7 +1318,7 @@ static void PM_CheckDuck (void)
 PM_Footsteps
 ===============
 */
-static void PM_Footsteps( void ) {
+static void PM_Footsteps( pmoveContext_t *pc ) {
 	float		bobmove;
 	int			old;
 	qboolean	footstep;
@@ -1328,29 +1327,29 @@ static void PM_Footsteps( void ) {
 	// calculate speed and cycle to be used for
 	// all cyclic walking effects
 	//
-	pm->xyspeed = sqrt( pm->ps->velocity[0] * pm->ps->velocity[0]
-		+  pm->ps->velocity[1] * pm->ps->velocity[1] );
+	pc->pm->xyspeed = sqrt( pc->pm->ps->velocity[0] * pc->pm->ps->velocity[0]
+		+  pc->pm->ps->velocity[1] * pc->pm->ps->velocity[1] );
 
-	if ( pm->ps->groundEntityNum == ENTITYNUM_NONE ) {
+	if ( pc->pm->ps->groundEntityNum == ENTITYNUM_NONE ) {
 
-		if ( pm->ps->powerups[PW_INVULNERABILITY] ) {
-			PM_ContinueLegsAnim( LEGS_IDLECR );
+		if ( pc->pm->ps->powerups[PW_INVULNERABILITY] ) {
+			PM_ContinueLegsAnim( pc, LEGS_IDLECR );
 		}
 		// airborne leaves position in cycle intact, but doesn't advance
-		if ( pm->waterlevel > 1 ) {
-			PM_ContinueLegsAnim( LEGS_SWIM );
+		if ( pc->pm->waterlevel > 1 ) {
+			PM_ContinueLegsAnim( pc, LEGS_SWIM );
 		}
 		return;
 	}
 
 	// if not trying to move
-	if ( !pm->cmd.forwardmove && !pm->cmd.rightmove ) {
-		if (  pm->xyspeed < 5 ) {
-			pm->ps->bobCycle = 0;	// start at beginning of cycle again
-			if ( pm->ps->pm_flags & PMF_DUCKED ) {
-				PM_ContinueLegsAnim( LEGS_IDLECR );
+	if ( !pc->pm->cmd.forwardmove && !pc->pm->cmd.rightmove ) {
+		if (  pc->pm->xyspeed < 5 ) {
+			pc->pm->ps->bobCycle = 0;	// start at beginning of cycle again
+			if ( pc->pm->ps->pm_flags & PMF_DUCKED ) {
+				PM_ContinueLegsAnim( pc, LEGS_IDLECR );
 			} else {
-				PM_ContinueLegsAnim( LEGS_IDLE );
+				PM_ContinueLegsAnim( pc, LEGS_IDLE );
 			}
 		}
 		return;
@@ -1359,64 +1358,64 @@ static void PM_Footsteps( void ) {
 
 	footstep = qfalse;
 
-	if ( pm->ps->pm_flags & PMF_DUCKED ) {
+	if ( pc->pm->ps->pm_flags & PMF_DUCKED ) {
 		bobmove = 0.5;	// ducked characters bob much faster
-		if ( pm->ps->pm_flags & PMF_BACKWARDS_RUN ) {
-			PM_ContinueLegsAnim( LEGS_BACKCR );
+		if ( pc->pm->ps->pm_flags & PMF_BACKWARDS_RUN ) {
+			PM_ContinueLegsAnim( pc, LEGS_BACKCR );
 		}
 		else {
-			PM_ContinueLegsAnim( LEGS_WALKCR );
+			PM_ContinueLegsAnim( pc, LEGS_WALKCR );
 		}
 		// ducked characters never play footsteps
 	/*
-	} else 	if ( pm->ps->pm_flags & PMF_BACKWARDS_RUN ) {
-		if ( !( pm->cmd.buttons & BUTTON_WALKING ) ) {
+	} else 	if ( pc->pm->ps->pm_flags & PMF_BACKWARDS_RUN ) {
+		if ( !( pc->pm->cmd.buttons & BUTTON_WALKING ) ) {
 			bobmove = 0.4;	// faster speeds bob faster
 			footstep = qtrue;
 		} else {
 			bobmove = 0.3;
 		}
-		PM_ContinueLegsAnim( LEGS_BACK );
+		PM_ContinueLegsAnim( pc, LEGS_BACK );
 	*/
 	} else {
-		if ( !( pm->cmd.buttons & BUTTON_WALKING ) ) {
+		if ( !( pc->pm->cmd.buttons & BUTTON_WALKING ) ) {
 			bobmove = 0.4f;	// faster speeds bob faster
-			if ( pm->ps->pm_flags & PMF_BACKWARDS_RUN ) {
-				PM_ContinueLegsAnim( LEGS_BACK );
+			if ( pc->pm->ps->pm_flags & PMF_BACKWARDS_RUN ) {
+				PM_ContinueLegsAnim( pc, LEGS_BACK );
 			}
 			else {
-				PM_ContinueLegsAnim( LEGS_RUN );
+				PM_ContinueLegsAnim( pc, LEGS_RUN );
 			}
 			footstep = qtrue;
 		} else {
 			bobmove = 0.3f;	// walking bobs slow
-			if ( pm->ps->pm_flags & PMF_BACKWARDS_RUN ) {
-				PM_ContinueLegsAnim( LEGS_BACKWALK );
+			if ( pc->pm->ps->pm_flags & PMF_BACKWARDS_RUN ) {
+				PM_ContinueLegsAnim( pc, LEGS_BACKWALK );
 			}
 			else {
-				PM_ContinueLegsAnim( LEGS_WALK );
+				PM_ContinueLegsAnim( pc, LEGS_WALK );
 			}
 		}
 	}
 
 	// check for footstep / splash sounds
-	old = pm->ps->bobCycle;
-	pm->ps->bobCycle = (int)( old + bobmove * pml.msec ) & 255;
+	old = pc->pm->ps->bobCycle;
+	pc->pm->ps->bobCycle = (int)( old + bobmove * pc->pml.msec ) & 255;
 
 	// if we just crossed a cycle boundary, play an apropriate footstep event
-	if ( ( ( old + 64 ) ^ ( pm->ps->bobCycle + 64 ) ) & 128 ) {
-		if ( pm->waterlevel == 0 ) {
+	if ( ( ( old + 64 ) ^ ( pc->pm->ps->bobCycle + 64 ) ) & 128 ) {
+		if ( pc->pm->waterlevel == 0 ) {
 			// on ground will only play sounds if running
-			if ( footstep && !pm->noFootsteps ) {
-				PM_AddEvent( PM_FootstepForSurface() );
+			if ( footstep && !pc->pm->noFootsteps ) {
+				PM_AddEvent( pc, PM_FootstepForSurface( pc ) );
 			}
-		} else if ( pm->waterlevel == 1 ) {
+		} else if ( pc->pm->waterlevel == 1 ) {
 			// splashing
-			PM_AddEvent( EV_FOOTSPLASH );
-		} else if ( pm->waterlevel == 2 ) {
+			PM_AddEvent( pc, EV_FOOTSPLASH );
+		} else if ( pc->pm->waterlevel == 2 ) {
 			// wading / swimming at surface
-			PM_AddEvent( EV_SWIM );
-		} else if ( pm->waterlevel == 3 ) {
+			PM_AddEvent( pc, EV_SWIM );
+		} else if ( pc->pm->waterlevel == 3 ) {
 			// no sound when completely underwater
 
 		}
@@ -1430,33 +1429,33 @@ PM_WaterEvents
 Generate sound events for entering and leaving water
 ==============
 */
-static void PM_WaterEvents( void ) {		// FIXME?
+static void PM_WaterEvents( pmoveContext_t *pc ) {		// FIXME?
 	//
 	// if just entered a water volume, play a sound
 	//
-	if (!pml.previous_waterlevel && pm->waterlevel) {
-		PM_AddEvent( EV_WATER_TOUCH );
+	if (!pc->pml.previous_waterlevel && pc->pm->waterlevel) {
+		PM_AddEvent( pc, EV_WATER_TOUCH );
 	}
 
 	//
 	// if just completely exited a water volume, play a sound
 	//
-	if (pml.previous_waterlevel && !pm->waterlevel) {
-		PM_AddEvent( EV_WATER_LEAVE );
+	if (pc->pml.previous_waterlevel && !pc->pm->waterlevel) {
+		PM_AddEvent( pc, EV_WATER_LEAVE );
 	}
 
 	//
 	// check for head just going under water
 	//
-	if (pml.previous_waterlevel != 3 && pm->waterlevel == 3) {
-		PM_AddEvent( EV_WATER_UNDER );
+	if (pc->pml.previous_waterlevel != 3 && pc->pm->waterlevel == 3) {
+		PM_AddEvent( pc, EV_WATER_UNDER );
 	}
 
 	//
 	// check for head just coming out of water
 	//
-	if (pml.previous_waterlevel == 3 && pm->waterlevel != 3) {
-		PM_AddEvent( EV_WATER_CLEAR );
+	if (pc->pml.previous_waterlevel == 3 && pc->pm->waterlevel != 3) {
+		PM_AddEvent( pc, EV_WATER_CLEAR );
 	}
 }
 
@@ -1466,23 +1465,23 @@ static void PM_WaterEvents( void ) {		// FIXME?
 PM_BeginWeaponChange
 ===============
 */
-static void PM_BeginWeaponChange( int weapon ) {
+static void PM_BeginWeaponChange( pmoveContext_t *pc, int weapon ) {
 	if ( weapon <= WP_NONE || weapon >= WP_NUM_WEAPONS ) {
 		return;
 	}
 
-	if ( !( pm->ps->stats[STAT_WEAPONS] & ( 1 << weapon ) ) ) {
+	if ( !( pc->pm->ps->stats[STAT_WEAPONS] & ( 1 << weapon ) ) ) {
 		return;
 	}
 	
-	if ( pm->ps->weaponstate == WEAPON_DROPPING ) {
+	if ( pc->pm->ps->weaponstate == WEAPON_DROPPING ) {
 		return;
 	}
 
-	PM_AddEvent( EV_CHANGE_WEAPON );
-	pm->ps->weaponstate = WEAPON_DROPPING;
-	pm->ps->weaponTime += 200;
-	PM_StartTorsoAnim( TORSO_DROP );
+	PM_AddEvent( pc, EV_CHANGE_WEAPON );
+	pc->pm->ps->weaponstate = WEAPON_DROPPING;
+	pc->pm->ps->weaponTime += 200;
+	PM_StartTorsoAnim( pc, TORSO_DROP );
 }
 
 
@@ -1491,22 +1490,22 @@ static void PM_BeginWeaponChange( int weapon ) {
 PM_FinishWeaponChange
 ===============
 */
-static void PM_FinishWeaponChange( void ) {
+static void PM_FinishWeaponChange( pmoveContext_t *pc ) {
 	int		weapon;
 
-	weapon = pm->cmd.weapon;
+	weapon = pc->pm->cmd.weapon;
 	if ( weapon < WP_NONE || weapon >= WP_NUM_WEAPONS ) {
 		weapon = WP_NONE;
 	}
 
-	if ( !( pm->ps->stats[STAT_WEAPONS] & ( 1 << weapon ) ) ) {
+	if ( !( pc->pm->ps->stats[STAT_WEAPONS] & ( 1 << weapon ) ) ) {
 		weapon = WP_NONE;
 	}
 
-	pm->ps->weapon = weapon;
-	pm->ps->weaponstate = WEAPON_RAISING;
-	pm->ps->weaponTime += 250;
-	PM_StartTorsoAnim( TORSO_RAISE );
+	pc->pm->ps->weapon = weapon;
+	pc->pm->ps->weaponstate = WEAPON_RAISING;
+	pc->pm->ps->weaponTime += 250;
+	PM_StartTorsoAnim( pc, TORSO_RAISE );
 }
 
 
@@ -1516,12 +1515,12 @@ PM_TorsoAnimation
 
 ==============
 */
-static void PM_TorsoAnimation( void ) {
-	if ( pm->ps->weaponstate == WEAPON_READY ) {
-		if ( pm->ps->weapon == WP_GAUNTLET ) {
-			PM_ContinueTorsoAnim( TORSO_STAND2 );
+static void PM_TorsoAnimation( pmoveContext_t *pc ) {
+	if ( pc->pm->ps->weaponstate == WEAPON_READY ) {
+		if ( pc->pm->ps->weapon == WP_GAUNTLET ) {
+			PM_ContinueTorsoAnim( pc, TORSO_STAND2 );
 		} else {
-			PM_ContinueTorsoAnim( TORSO_STAND );
+			PM_ContinueTorsoAnim( pc, TORSO_STAND );
 		}
 		return;
 	}
@@ -1535,115 +1534,115 @@ PM_Weapon
 Generates weapon events and modifes the weapon counter
 ==============
 */
-static void PM_Weapon( void ) {
+static void PM_Weapon( pmoveContext_t *pc ) {
 	int		addTime;
 
 	// don't allow attack until all buttons are up
-	if ( pm->ps->pm_flags & PMF_RESPAWNED ) {
+	if ( pc->pm->ps->pm_flags & PMF_RESPAWNED ) {
 		return;
 	}
 
 	// ignore if spectator
-	if ( pm->ps->persistant[PERS_TEAM] == TEAM_SPECTATOR ) {
+	if ( pc->pm->ps->persistant[PERS_TEAM] == TEAM_SPECTATOR ) {
 		return;
 	}
 
 	// check for dead player
-	if ( pm->ps->stats[STAT_HEALTH] <= 0 ) {
-		pm->ps->weapon = WP_NONE;
+	if ( pc->pm->ps->stats[STAT_HEALTH] <= 0 ) {
+		pc->pm->ps->weapon = WP_NONE;
 		return;
 	}
 
 	// check for item using
-	if ( pm->cmd.buttons & BUTTON_USE_HOLDABLE ) {
-		if ( ! ( pm->ps->pm_flags & PMF_USE_ITEM_HELD ) ) {
-			if ( bg_itemlist[pm->ps->stats[STAT_HOLDABLE_ITEM]].giTag == HI_MEDKIT
-				&& pm->ps->stats[STAT_HEALTH] >= (pm->ps->stats[STAT_MAX_HEALTH] + 25) ) {
+	if ( pc->pm->cmd.buttons & BUTTON_USE_HOLDABLE ) {
+		if ( ! ( pc->pm->ps->pm_flags & PMF_USE_ITEM_HELD ) ) {
+			if ( bg_itemlist[pc->pm->ps->stats[STAT_HOLDABLE_ITEM]].giTag == HI_MEDKIT
+				&& pc->pm->ps->stats[STAT_HEALTH] >= (pc->pm->ps->stats[STAT_MAX_HEALTH] + 25) ) {
 				// don't use medkit if at max health
 			} else {
-				pm->ps->pm_flags |= PMF_USE_ITEM_HELD;
-				PM_AddEvent( EV_USE_ITEM0 + bg_itemlist[pm->ps->stats[STAT_HOLDABLE_ITEM]].giTag );
-				pm->ps->stats[STAT_HOLDABLE_ITEM] = 0;
+				pc->pm->ps->pm_flags |= PMF_USE_ITEM_HELD;
+				PM_AddEvent( pc, EV_USE_ITEM0 + bg_itemlist[pc->pm->ps->stats[STAT_HOLDABLE_ITEM]].giTag );
+				pc->pm->ps->stats[STAT_HOLDABLE_ITEM] = 0;
 			}
 			return;
 		}
 	} else {
-		pm->ps->pm_flags &= ~PMF_USE_ITEM_HELD;
+		pc->pm->ps->pm_flags &= ~PMF_USE_ITEM_HELD;
 	}
 
 
 	// make weapon function
-	if ( pm->ps->weaponTime > 0 ) {
-		pm->ps->weaponTime -= pml.msec;
+	if ( pc->pm->ps->weaponTime > 0 ) {
+		pc->pm->ps->weaponTime -= pc->pml.msec;
 	}
 
 	// check for weapon change
 	// can't change if weapon is firing, but can change
 	// again if lowering or raising
-	if ( pm->ps->weaponTime <= 0 || pm->ps->weaponstate != WEAPON_FIRING ) {
-		if ( pm->ps->weapon != pm->cmd.weapon ) {
-			PM_BeginWeaponChange( pm->cmd.weapon );
+	if ( pc->pm->ps->weaponTime <= 0 || pc->pm->ps->weaponstate != WEAPON_FIRING ) {
+		if ( pc->pm->ps->weapon != pc->pm->cmd.weapon ) {
+			PM_BeginWeaponChange( pc, pc->pm->cmd.weapon );
 		}
 	}
 
-	if ( pm->ps->weaponTime > 0 ) {
+	if ( pc->pm->ps->weaponTime > 0 ) {
 		return;
 	}
 
 	// change weapon if time
-	if ( pm->ps->weaponstate == WEAPON_DROPPING ) {
-		PM_FinishWeaponChange();
+	if ( pc->pm->ps->weaponstate == WEAPON_DROPPING ) {
+		PM_FinishWeaponChange( pc );
 		return;
 	}
 
-	if ( pm->ps->weaponstate == WEAPON_RAISING ) {
-		pm->ps->weaponstate = WEAPON_READY;
-		if ( pm->ps->weapon == WP_GAUNTLET ) {
-			PM_StartTorsoAnim( TORSO_STAND2 );
+	if ( pc->pm->ps->weaponstate == WEAPON_RAISING ) {
+		pc->pm->ps->weaponstate = WEAPON_READY;
+		if ( pc->pm->ps->weapon == WP_GAUNTLET ) {
+			PM_StartTorsoAnim( pc, TORSO_STAND2 );
 		} else {
-			PM_StartTorsoAnim( TORSO_STAND );
+			PM_StartTorsoAnim( pc, TORSO_STAND );
 		}
 		return;
 	}
 
 	// check for fire
-	if ( ! (pm->cmd.buttons & BUTTON_ATTACK) ) {
-		pm->ps->weaponTime = 0;
-		pm->ps->weaponstate = WEAPON_READY;
+	if ( ! (pc->pm->cmd.buttons & BUTTON_ATTACK) ) {
+		pc->pm->ps->weaponTime = 0;
+		pc->pm->ps->weaponstate = WEAPON_READY;
 		return;
 	}
 
 	// start the animation even if out of ammo
-	if ( pm->ps->weapon == WP_GAUNTLET ) {
+	if ( pc->pm->ps->weapon == WP_GAUNTLET ) {
 		// the guantlet only "fires" when it actually hits something
-		if ( !pm->gauntletHit ) {
-			pm->ps->weaponTime = 0;
-			pm->ps->weaponstate = WEAPON_READY;
+		if ( !pc->pm->gauntletHit ) {
+			pc->pm->ps->weaponTime = 0;
+			pc->pm->ps->weaponstate = WEAPON_READY;
 			return;
 		}
-		PM_StartTorsoAnim( TORSO_ATTACK2 );
+		PM_StartTorsoAnim( pc, TORSO_ATTACK2 );
 	} else {
-		PM_StartTorsoAnim( TORSO_ATTACK );
+		PM_StartTorsoAnim( pc, TORSO_ATTACK );
 	}
 
-	pm->ps->weaponstate = WEAPON_FIRING;
+	pc->pm->ps->weaponstate = WEAPON_FIRING;
 
 	// check for out of ammo
-	if ( ! pm->ps->ammo[ pm->ps->weapon ] ) {
-		PM_AddEvent( EV_NOAMMO );
-		pm->ps->weaponTime += 500;
+	if ( ! pc->pm->ps->ammo[ pc->pm->ps->weapon ] ) {
+		PM_AddEvent( pc, EV_NOAMMO );
+		pc->pm->ps->weaponTime += 500;
 		return;
 	}
 
 	// take an ammo away if not infinite
-	if ( pm->ps->ammo[ pm->ps->weapon ] != -1 ) {
-		pm->ps->ammo[ pm->ps->weapon ]--;
+	if ( pc->pm->ps->ammo[ pc->pm->ps->weapon ] != -1 ) {
+		pc->pm->ps->ammo[ pc->pm->ps->weapon ]--;
 	}
 
 	// fire weapon
-	PM_AddEvent( EV_FIRE_WEAPON );
+	PM_AddEvent( pc, EV_FIRE_WEAPON );
 
-	switch( pm->ps->weapon ) {
+	switch( pc->pm->ps->weapon ) {
 	default:
 	case WP_GAUNTLET:
 		addTime = 400;
@@ -1689,20 +1688,20 @@ static void PM_Weapon( void ) {
 	}
 
 #ifdef MISSIONPACK
-	if( bg_itemlist[pm->ps->stats[STAT_PERSISTANT_POWERUP]].giTag == PW_SCOUT ) {
+	if( bg_itemlist[pc->pm->ps->stats[STAT_PERSISTANT_POWERUP]].giTag == PW_SCOUT ) {
 		addTime /= 1.5;
 	}
 	else
-	if( bg_itemlist[pm->ps->stats[STAT_PERSISTANT_POWERUP]].giTag == PW_AMMOREGEN ) {
+	if( bg_itemlist[pc->pm->ps->stats[STAT_PERSISTANT_POWERUP]].giTag == PW_AMMOREGEN ) {
 		addTime /= 1.3;
   }
   else
 #endif
-	if ( pm->ps->powerups[PW_HASTE] ) {
+	if ( pc->pm->ps->powerups[PW_HASTE] ) {
 		addTime /= 1.3;
 	}
 
-	pm->ps->weaponTime += addTime;
+	pc->pm->ps->weaponTime += addTime;
 }
 
 /*
@@ -1711,43 +1710,43 @@ PM_Animate
 ================
 */
 
-static void PM_Animate( void ) {
-	if ( pm->cmd.buttons & BUTTON_GESTURE ) {
-		if ( pm->ps->torsoTimer == 0 ) {
-			PM_StartTorsoAnim( TORSO_GESTURE );
-			pm->ps->torsoTimer = TIMER_GESTURE;
-			PM_AddEvent( EV_TAUNT );
+static void PM_Animate( pmoveContext_t *pc ) {
+	if ( pc->pm->cmd.buttons & BUTTON_GESTURE ) {
+		if ( pc->pm->ps->torsoTimer == 0 ) {
+			PM_StartTorsoAnim( pc, TORSO_GESTURE );
+			pc->pm->ps->torsoTimer = TIMER_GESTURE;
+			PM_AddEvent( pc, EV_TAUNT );
 		}
 #ifdef MISSIONPACK
-	} else if ( pm->cmd.buttons & BUTTON_GETFLAG ) {
-		if ( pm->ps->torsoTimer == 0 ) {
-			PM_StartTorsoAnim( TORSO_GETFLAG );
-			pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
+	} else if ( pc->pm->cmd.buttons & BUTTON_GETFLAG ) {
+		if ( pc->pm->ps->torsoTimer == 0 ) {
+			PM_StartTorsoAnim( pc, TORSO_GETFLAG );
+			pc->pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
 		}
-	} else if ( pm->cmd.buttons & BUTTON_GUARDBASE ) {
-		if ( pm->ps->torsoTimer == 0 ) {
-			PM_StartTorsoAnim( TORSO_GUARDBASE );
-			pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
+	} else if ( pc->pm->cmd.buttons & BUTTON_GUARDBASE ) {
+		if ( pc->pm->ps->torsoTimer == 0 ) {
+			PM_StartTorsoAnim( pc, TORSO_GUARDBASE );
+			pc->pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
 		}
-	} else if ( pm->cmd.buttons & BUTTON_PATROL ) {
-		if ( pm->ps->torsoTimer == 0 ) {
-			PM_StartTorsoAnim( TORSO_PATROL );
-			pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
+	} else if ( pc->pm->cmd.buttons & BUTTON_PATROL ) {
+		if ( pc->pm->ps->torsoTimer == 0 ) {
+			PM_StartTorsoAnim( pc, TORSO_PATROL );
+			pc->pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
 		}
-	} else if ( pm->cmd.buttons & BUTTON_FOLLOWME ) {
-		if ( pm->ps->torsoTimer == 0 ) {
-			PM_StartTorsoAnim( TORSO_FOLLOWME );
-			pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
+	} else if ( pc->pm->cmd.buttons & BUTTON_FOLLOWME ) {
+		if ( pc->pm->ps->torsoTimer == 0 ) {
+			PM_StartTorsoAnim( pc, TORSO_FOLLOWME );
+			pc->pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
 		}
-	} else if ( pm->cmd.buttons & BUTTON_AFFIRMATIVE ) {
-		if ( pm->ps->torsoTimer == 0 ) {
-			PM_StartTorsoAnim( TORSO_AFFIRMATIVE);
-			pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
+	} else if ( pc->pm->cmd.buttons & BUTTON_AFFIRMATIVE ) {
+		if ( pc->pm->ps->torsoTimer == 0 ) {
+			PM_StartTorsoAnim( pc, TORSO_AFFIRMATIVE);
+			pc->pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
 		}
-	} else if ( pm->cmd.buttons & BUTTON_NEGATIVE ) {
-		if ( pm->ps->torsoTimer == 0 ) {
-			PM_StartTorsoAnim( TORSO_NEGATIVE );
-			pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
+	} else if ( pc->pm->cmd.buttons & BUTTON_NEGATIVE ) {
+		if ( pc->pm->ps->torsoTimer == 0 ) {
+			PM_StartTorsoAnim( pc, TORSO_NEGATIVE );
+			pc->pm->ps->torsoTimer = 600;	//TIMER_GESTURE;
 		}
 #endif
 	}
@@ -1759,29 +1758,29 @@ static void PM_Animate( void ) {
 PM_DropTimers
 ================
 */
-static void PM_DropTimers( void ) {
+static void PM_DropTimers( pmoveContext_t *pc ) {
 	// drop misc timing counter
-	if ( pm->ps->pm_time ) {
-		if ( pml.msec >= pm->ps->pm_time ) {
-			pm->ps->pm_flags &= ~PMF_ALL_TIMES;
-			pm->ps->pm_time = 0;
+	if ( pc->pm->ps->pm_time ) {
+		if ( pc->pml.msec >= pc->pm->ps->pm_time ) {
+			pc->pm->ps->pm_flags &= ~PMF_ALL_TIMES;
+			pc->pm->ps->pm_time = 0;
 		} else {
-			pm->ps->pm_time -= pml.msec;
+			pc->pm->ps->pm_time -= pc->pml.msec;
 		}
 	}
 
 	// drop animation counter
-	if ( pm->ps->legsTimer > 0 ) {
-		pm->ps->legsTimer -= pml.msec;
-		if ( pm->ps->legsTimer < 0 ) {
-			pm->ps->legsTimer = 0;
+	if ( pc->pm->ps->legsTimer > 0 ) {
+		pc->pm->ps->legsTimer -= pc->pml.msec;
+		if ( pc->pm->ps->legsTimer < 0 ) {
+			pc->pm->ps->legsTimer = 0;
 		}
 	}
 
-	if ( pm->ps->torsoTimer > 0 ) {
-		pm->ps->torsoTimer -= pml.msec;
-		if ( pm->ps->torsoTimer < 0 ) {
-			pm->ps->torsoTimer = 0;
+	if ( pc->pm->ps->torsoTimer > 0 ) {
+		pc->pm->ps->torsoTimer -= pc->pml.msec;
+		if ( pc->pm->ps->torsoTimer < 0 ) {
+			pc->pm->ps->torsoTimer = 0;
 		}
 	}
 }
@@ -1833,47 +1832,47 @@ PmoveSingle
 */
 void trap_SnapVector( float *v );
 
-void PmoveSingle (pmove_t *pmove) {
-	pm = pmove;
+static void PmoveSingle( pmoveContext_t *pc, pmove_t *pmove ) {
+	pc->pm = pmove;
 
 	// this counter lets us debug movement problems with a journal
 	// by setting a conditional breakpoint fot the previous frame
 	c_pmove++;
 
 	// clear results
-	pm->numtouch = 0;
-	pm->watertype = 0;
-	pm->waterlevel = 0;
+	pc->pm->numtouch = 0;
+	pc->pm->watertype = 0;
+	pc->pm->waterlevel = 0;
 
-	if ( pm->ps->stats[STAT_HEALTH] <= 0 ) {
-		pm->tracemask &= ~CONTENTS_BODY;	// corpses can fly through bodies
+	if ( pc->pm->ps->stats[STAT_HEALTH] <= 0 ) {
+		pc->pm->tracemask &= ~CONTENTS_BODY;	// corpses can fly through bodies
 	}
 
 	// make sure walking button is clear if they are running, to avoid
 	// proxy no-footsteps cheats
-	if ( abs( pm->cmd.forwardmove ) > 64 || abs( pm->cmd.rightmove ) > 64 ) {
-		pm->cmd.buttons &= ~BUTTON_WALKING;
+	if ( abs( pc->pm->cmd.forwardmove ) > 64 || abs( pc->pm->cmd.rightmove ) > 64 ) {
+		pc->pm->cmd.buttons &= ~BUTTON_WALKING;
 	}
 
 	// set the talk balloon flag
-	if ( pm->cmd.buttons & BUTTON_TALK ) {
-		pm->ps->eFlags |= EF_TALK;
+	if ( pc->pm->cmd.buttons & BUTTON_TALK ) {
+		pc->pm->ps->eFlags |= EF_TALK;
 	} else {
-		pm->ps->eFlags &= ~EF_TALK;
+		pc->pm->ps->eFlags &= ~EF_TALK;
 	}
 
 	// set the firing flag for continuous beam weapons
-	if ( !(pm->ps->pm_flags & PMF_RESPAWNED) && pm->ps->pm_type != PM_INTERMISSION
-		&& ( pm->cmd.buttons & BUTTON_ATTACK ) && pm->ps->ammo[ pm->ps->weapon ] ) {
-		pm->ps->eFlags |= EF_FIRING;
+	if ( !(pc->pm->ps->pm_flags & PMF_RESPAWNED) && pc->pm->ps->pm_type != PM_INTERMISSION
+		&& ( pc->pm->cmd.buttons & BUTTON_ATTACK ) && pc->pm->ps->ammo[ pc->pm->ps->weapon ] ) {
+		pc->pm->ps->eFlags |= EF_FIRING;
 	} else {
-		pm->ps->eFlags &= ~EF_FIRING;
+		pc->pm->ps->eFlags &= ~EF_FIRING;
 	}
 
 	// clear the respawned flag if attack and use are cleared
-	if ( pm->ps->stats[STAT_HEALTH] > 0 && 
-		!( pm->cmd.buttons & (BUTTON_ATTACK | BUTTON_USE_HOLDABLE) ) ) {
-		pm->ps->pm_flags &= ~PMF_RESPAWNED;
+	if ( pc->pm->ps->stats[STAT_HEALTH] > 0 && 
+		!( pc->pm->cmd.buttons & (BUTTON_ATTACK | BUTTON_USE_HOLDABLE) ) ) {
+		pc->pm->ps->pm_flags &= ~PMF_RESPAWNED;
 	}
 
 	// if talk button is down, dissallow all other input
@@ -1889,141 +1888,141 @@ void PmoveSingle (pmove_t *pmove) {
 	}
 
 	// clear all pmove local vars
-	memset (&pml, 0, sizeof(pml));
+	memset (&pc->pml, 0, sizeof( pc->pml ));
 
 	// determine the time
-	pml.msec = pmove->cmd.serverTime - pm->ps->commandTime;
-	if ( pml.msec < 1 ) {
-		pml.msec = 1;
-	} else if ( pml.msec > 200 ) {
-		pml.msec = 200;
+	pc->pml.msec = pmove->cmd.serverTime - pc->pm->ps->commandTime;
+	if ( pc->pml.msec < 1 ) {
+		pc->pml.msec = 1;
+	} else if ( pc->pml.msec > 200 ) {
+		pc->pml.msec = 200;
 	}
-	pm->ps->commandTime = pmove->cmd.serverTime;
+	pc->pm->ps->commandTime = pmove->cmd.serverTime;
 
 	// save old org in case we get stuck
-	VectorCopy (pm->ps->origin, pml.previous_origin);
+	VectorCopy (pc->pm->ps->origin, pc->pml.previous_origin);
 
 	// save old velocity for crashlanding
-	VectorCopy (pm->ps->velocity, pml.previous_velocity);
+	VectorCopy (pc->pm->ps->velocity, pc->pml.previous_velocity);
 
-	pml.frametime = pml.msec * 0.001;
+	pc->pml.frametime = pc->pml.msec * 0.001;
 
 	// update the viewangles
-	PM_UpdateViewAngles( pm->ps, &pm->cmd );
+	PM_UpdateViewAngles( pc->pm->ps, &pc->pm->cmd );
 
-	AngleVectors (pm->ps->viewangles, pml.forward, pml.right, pml.up);
+	AngleVectors (pc->pm->ps->viewangles, pc->pml.forward, pc->pml.right, pc->pml.up);
 
-	if ( pm->cmd.upmove < 10 ) {
+	if ( pc->pm->cmd.upmove < 10 ) {
 		// not holding jump
-		pm->ps->pm_flags &= ~PMF_JUMP_HELD;
+		pc->pm->ps->pm_flags &= ~PMF_JUMP_HELD;
 	}
 
 	// decide if backpedaling animations should be used
-	if ( pm->cmd.forwardmove < 0 ) {
-		pm->ps->pm_flags |= PMF_BACKWARDS_RUN;
-	} else if ( pm->cmd.forwardmove > 0 || ( pm->cmd.forwardmove == 0 && pm->cmd.rightmove ) ) {
-		pm->ps->pm_flags &= ~PMF_BACKWARDS_RUN;
+	if ( pc->pm->cmd.forwardmove < 0 ) {
+		pc->pm->ps->pm_flags |= PMF_BACKWARDS_RUN;
+	} else if ( pc->pm->cmd.forwardmove > 0 || ( pc->pm->cmd.forwardmove == 0 && pc->pm->cmd.rightmove ) ) {
+		pc->pm->ps->pm_flags &= ~PMF_BACKWARDS_RUN;
 	}
 
-	if ( pm->ps->pm_type >= PM_DEAD ) {
-		pm->cmd.forwardmove = 0;
-		pm->cmd.rightmove = 0;
-		pm->cmd.upmove = 0;
+	if ( pc->pm->ps->pm_type >= PM_DEAD ) {
+		pc->pm->cmd.forwardmove = 0;
+		pc->pm->cmd.rightmove = 0;
+		pc->pm->cmd.upmove = 0;
 	}
 
-	if ( pm->ps->pm_type == PM_SPECTATOR ) {
-		PM_CheckDuck ();
-		PM_FlyMove ();
-		PM_DropTimers ();
+	if ( pc->pm->ps->pm_type == PM_SPECTATOR ) {
+		PM_CheckDuck( pc );
+		PM_FlyMove( pc );
+		PM_DropTimers( pc );
 		return;
 	}
 
-	if ( pm->ps->pm_type == PM_NOCLIP ) {
-		PM_NoclipMove ();
-		PM_DropTimers ();
+	if ( pc->pm->ps->pm_type == PM_NOCLIP ) {
+		PM_NoclipMove( pc );
+		PM_DropTimers( pc );
 		return;
 	}
 
-	if (pm->ps->pm_type == PM_FREEZE) {
+	if (pc->pm->ps->pm_type == PM_FREEZE) {
 		return;		// no movement at all
 	}
 
-	if ( pm->ps->pm_type == PM_INTERMISSION || pm->ps->pm_type == PM_SPINTERMISSION) {
+	if ( pc->pm->ps->pm_type == PM_INTERMISSION || pc->pm->ps->pm_type == PM_SPINTERMISSION) {
 		return;		// no movement at all
 	}
 
 	// set watertype, and waterlevel
-	PM_SetWaterLevel();
-	pml.previous_waterlevel = pmove->waterlevel;
+	PM_SetWaterLevel( pc );
+	pc->pml.previous_waterlevel = pmove->waterlevel;
 
 	// set mins, maxs, and viewheight
-	PM_CheckDuck ();
+	PM_CheckDuck( pc );
 
 	// set groundentity
-	PM_GroundTrace();
+	PM_GroundTrace( pc );
 
-	if ( pm->ps->pm_type == PM_DEAD ) {
-		PM_DeadMove ();
+	if ( pc->pm->ps->pm_type == PM_DEAD ) {
+		PM_DeadMove( pc );
 	}
 
-	PM_DropTimers();
+	PM_DropTimers( pc );
 
 #ifdef MISSIONPACK
-	if ( pm->ps->powerups[PW_INVULNERABILITY] ) {
-		PM_InvulnerabilityMove();
+	if ( pc->pm->ps->powerups[PW_INVULNERABILITY] ) {
+		PM_InvulnerabilityMove( pc );
 	} else
 #endif
-	if ( pm->ps->powerups[PW_FLIGHT] ) {
+	if ( pc->pm->ps->powerups[PW_FLIGHT] ) {
 		// flight powerup doesn't allow jump and has different friction
-		PM_FlyMove();
-	} else if (pm->ps->pm_flags & PMF_GRAPPLE_PULL) {
-		PM_GrappleMove();
+		PM_FlyMove( pc );
+	} else if (pc->pm->ps->pm_flags & PMF_GRAPPLE_PULL) {
+		PM_GrappleMove( pc );
 		// We can wiggle a bit
-		PM_AirMove();
-	} else if (pm->ps->pm_flags & PMF_TIME_WATERJUMP) {
-		PM_WaterJumpMove();
-	} else if ( pm->waterlevel > 1 ) {
+		PM_AirMove( pc );
+	} else if (pc->pm->ps->pm_flags & PMF_TIME_WATERJUMP) {
+		PM_WaterJumpMove( pc );
+	} else if ( pc->pm->waterlevel > 1 ) {
 		// swimming
-		PM_WaterMove();
-	} else if ( pml.walking ) {
+		PM_WaterMove( pc );
+	} else if ( pc->pml.walking ) {
 		// walking on ground
-		PM_WalkMove();
+		PM_WalkMove( pc );
 	} else {
 		// airborne
-		PM_AirMove();
+		PM_AirMove( pc );
 	}
 
-	PM_Animate();
+	PM_Animate( pc );
 
 	// set groundentity, watertype, and waterlevel
-	PM_GroundTrace();
-	PM_SetWaterLevel();
+	PM_GroundTrace( pc );
+	PM_SetWaterLevel( pc );
 
 	// weapons
-	PM_Weapon();
+	PM_Weapon( pc );
 
 	// torso animation
-	PM_TorsoAnimation();
+	PM_TorsoAnimation( pc );
 
 	// footstep events / legs animations
-	PM_Footsteps();
+	PM_Footsteps( pc );
 
 	// entering / leaving water splashes
-	PM_WaterEvents();
+	PM_WaterEvents( pc );
 
 	// snap some parts of playerstate to save network bandwidth
-	trap_SnapVector( pm->ps->velocity );
+	trap_SnapVector( pc->pm->ps->velocity );
 }
 
 
 /*
 ================
-Pmove
+PM_Move
 
-Can be called by either the server or the client
+Chops the move up and runs it through pc
 ================
 */
-void Pmove (pmove_t *pmove) {
+static void PM_Move( pmoveContext_t *pc, pmove_t *pmove ) {
 	int			finalTime;
 
 	finalTime = pmove->cmd.serverTime;
@@ -2056,14 +2055,116 @@ void Pmove (pmove_t *pmove) {
 			}
 		}
 		pmove->cmd.serverTime = pmove->ps->commandTime + msec;
-		PmoveSingle( pmove );
+		PmoveSingle( pc, pmove );
 
 		if ( pmove->ps->pm_flags & PMF_JUMP_HELD ) {
 			pmove->cmd.upmove = 20;
 		}
 	}
 
-	//PM_CheckStuck();
+	//PM_CheckStuck( pc );
+}
+
+
+/*
+================
+Pmove
+
+Can be called by either the server or the client
+================
+*/
+void Pmove (pmove_t *pmove) {
+	pmoveContext_t	pc;
+
+	pc.traceCache = NULL;
+	PM_Move( &pc, pmove );
+}
+
+
+/*
+=============================================================================
 
+BATCHED PMOVE
+
+PmoveBatch steps several player states through the same world, as when
+candidate moves are tried out from one start.  Nothing is linked or
+unlinked between the moves, so they ask for many identical traces, and
+those are answered from a small cache that lives on the batch's stack.
+
+=============================================================================
+*/
+
+/*
+================
+PM_Trace
+
+pm->trace, through the batch cache when there is one
+================
+*/
+void PM_Trace( pmoveContext_t *pc, trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentMask ) {
+	pmTraceCache_t	*c;
+	int				hash;
+
+	if ( !pc->traceCache ) {
+		pc->pm->trace( results, start, mins, maxs, end, passEntityNum, contentMask );
+		return;
+	}
+
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	c_pmoveTraces++;
+
+	hash = (int)( start[0] * 3 + start[1] * 5 + start[2] * 7 + end[0] * 11 + end[1] * 13 + end[2] * 17
+		+ mins[2] * 19 + maxs[2] * 23 ) ^ ( passEntityNum << 4 ) ^ contentMask;
+	c = &pc->traceCache[ hash & ( PM_TRACE_CACHE_SIZE - 1 ) ];
+
+	if ( c->valid && c->passEntityNum == passEntityNum && c->contentMask == contentMask
+		&& VectorCompare( c->start, start ) && VectorCompare( c->end, end )
+		&& VectorCompare( c->mins, mins ) && VectorCompare( c->maxs, maxs ) ) {
+		c_pmoveTraceHits++;
+		*results = c->trace;
+		return;
+	}
+
+	pc->pm->trace( results, start, mins, maxs, end, passEntityNum, contentMask );
+
+	c->valid = qtrue;
+	VectorCopy( start, c->start );
+	VectorCopy( mins, c->mins );
+	VectorCopy( maxs, c->maxs );
+	VectorCopy( end, c->end );
+	c->passEntityNum = passEntityNum;
+	c->contentMask = contentMask;
+	c->trace = *results;
+}
+
+/*
+================
+PmoveBatch
+
+Runs Pmove on every entry, the results are the same as calling Pmove on
+each of them in turn as long as the world doesn't change in between
+================
+*/
+void PmoveBatch( pmove_t *pmoves, int numPmoves ) {
+	pmTraceCache_t	traceCache[PM_TRACE_CACHE_SIZE];
+	pmoveContext_t	pc;
+	int				i;
+
+	memset( traceCache, 0, sizeof( traceCache ) );
+	pc.traceCache = traceCache;
+
+	for ( i = 0 ; i < numPmoves ; i++ ) {
+		// traces from different worlds can't be shared
+		if ( i > 0 && pmoves[i].trace != pmoves[i-1].trace ) {
+			memset( traceCache, 0, sizeof( traceCache ) );
+		}
+		PM_Move( &pc, &pmoves[i] );
+	}
 }
 
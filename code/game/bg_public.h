@@ -194,6 +194,10 @@ typedef struct {
 // if a full pmove isn't done on the client, you can just update the angles
 void PM_UpdateViewAngles( playerState_t *ps, const usercmd_t *cmd );
 void Pmove (pmove_t *pmove);
+void PmoveBatch( pmove_t *pmoves, int numPmoves );
+
+extern	int		c_pmoveTraces;		// traces asked for by PmoveBatch
+extern	int		c_pmoveTraceHits;	// of those, answered from the batch cache
 
 //===================================================================================
 
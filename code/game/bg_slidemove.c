@@ -42,7 +42,7 @@ Returns qtrue if the velocity was clipped in some way
 ==================
 */
 #define	MAX_CLIP_PLANES	5
-qboolean	PM_SlideMove( qboolean gravity ) {
+qboolean	PM_SlideMove( pmoveContext_t *pc, qboolean gravity ) {
 	int			bumpcount, numbumps;
 	vec3_t		dir;
 	float		d;
@@ -60,51 +60,51 @@ qboolean	PM_SlideMove( qboolean gravity ) {
 	
 	numbumps = 4;
 
-	VectorCopy (pm->ps->velocity, primal_velocity);
+	VectorCopy (pc->pm->ps->velocity, primal_velocity);
 
 	if ( gravity ) {
-		VectorCopy( pm->ps->velocity, endVelocity );
-		endVelocity[2] -= pm->ps->gravity * pml.frametime;
-		pm->ps->velocity[2] = ( pm->ps->velocity[2] + endVelocity[2] ) * 0.5;
+		VectorCopy( pc->pm->ps->velocity, endVelocity );
+		endVelocity[2] -= pc->pm->ps->gravity * pc->pml.frametime;
+		pc->pm->ps->velocity[2] = ( pc->pm->ps->velocity[2] + endVelocity[2] ) * 0.5;
 		primal_velocity[2] = endVelocity[2];
-		if ( pml.groundPlane ) {
+		if ( pc->pml.groundPlane ) {
 			// slide along the ground plane
-			PM_ClipVelocity (pm->ps->velocity, pml.groundTrace.plane.normal, 
-				pm->ps->velocity, OVERCLIP );
+			PM_ClipVelocity (pc->pm->ps->velocity, pc->pml.groundTrace.plane.normal, 
+				pc->pm->ps->velocity, OVERCLIP );
 		}
 	}
 
-	time_left = pml.frametime;
+	time_left = pc->pml.frametime;
 
 	// never turn against the ground plane
-	if ( pml.groundPlane ) {
+	if ( pc->pml.groundPlane ) {
 		numplanes = 1;
-		VectorCopy( pml.groundTrace.plane.normal, planes[0] );
+		VectorCopy( pc->pml.groundTrace.plane.normal, planes[0] );
 	} else {
 		numplanes = 0;
 	}
 
 	// never turn against original velocity
-	VectorNormalize2( pm->ps->velocity, planes[numplanes] );
+	VectorNormalize2( pc->pm->ps->velocity, planes[numplanes] );
 	numplanes++;
 
 	for ( bumpcount=0 ; bumpcount < numbumps ; bumpcount++ ) {
 
 		// calculate position we are trying to move to
-		VectorMA( pm->ps->origin, time_left, pm->ps->velocity, end );
+		VectorMA( pc->pm->ps->origin, time_left, pc->pm->ps->velocity, end );
 
 		// see if we can make it there
-		pm->trace ( &trace, pm->ps->origin, pm->mins, pm->maxs, end, pm->ps->clientNum, pm->tracemask);
+		PM_Trace( pc, &trace, pc->pm->ps->origin, pc->pm->mins, pc->pm->maxs, end, pc->pm->ps->clientNum, pc->pm->tracemask);
 
 		if (trace.allsolid) {
 			// entity is completely trapped in another solid
-			pm->ps->velocity[2] = 0;	// don't build up falling damage, but allow sideways acceleration
+			pc->pm->ps->velocity[2] = 0;	// don't build up falling damage, but allow sideways acceleration
 			return qtrue;
 		}
 
 		if (trace.fraction > 0) {
 			// actually covered some distance
-			VectorCopy (trace.endpos, pm->ps->origin);
+			VectorCopy (trace.endpos, pc->pm->ps->origin);
 		}
 
 		if (trace.fraction == 1) {
@@ -112,13 +112,13 @@ qboolean	PM_SlideMove( qboolean gravity ) {
 		}
 
 		// save entity for contact
-		PM_AddTouchEnt( trace.entityNum );
+		PM_AddTouchEnt( pc, trace.entityNum );
 
 		time_left -= time_left * trace.fraction;
 
 		if (numplanes >= MAX_CLIP_PLANES) {
 			// this shouldn't really happen
-			VectorClear( pm->ps->velocity );
+			VectorClear( pc->pm->ps->velocity );
 			return qtrue;
 		}
 
@@ -129,7 +129,7 @@ qboolean	PM_SlideMove( qboolean gravity ) {
 		//
 		for ( i = 0 ; i < numplanes ; i++ ) {
 			if ( DotProduct( trace.plane.normal, planes[i] ) > 0.99 ) {
-				VectorAdd( trace.plane.normal, pm->ps->velocity, pm->ps->velocity );
+				VectorAdd( trace.plane.normal, pc->pm->ps->velocity, pc->pm->ps->velocity );
 				break;
 			}
 		}
@@ -145,18 +145,18 @@ qboolean	PM_SlideMove( qboolean gravity ) {
 
 		// find a plane that it enters
 		for ( i = 0 ; i < numplanes ; i++ ) {
-			into = DotProduct( pm->ps->velocity, planes[i] );
+			into = DotProduct( pc->pm->ps->velocity, planes[i] );
 			if ( into >= 0.1 ) {
 				continue;		// move doesn't interact with the plane
 			}
 
 			// see how hard we are hitting things
-			if ( -into > pml.impactSpeed ) {
-				pml.impactSpeed = -into;
+			if ( -into > pc->pml.impactSpeed ) {
+				pc->pml.impactSpeed = -into;
 			}
 
 			// slide along the plane
-			PM_ClipVelocity (pm->ps->velocity, planes[i], clipVelocity, OVERCLIP );
+			PM_ClipVelocity (pc->pm->ps->velocity, planes[i], clipVelocity, OVERCLIP );
 
 			// slide along the plane
 			PM_ClipVelocity (endVelocity, planes[i], endClipVelocity, OVERCLIP );
@@ -182,7 +182,7 @@ qboolean	PM_SlideMove( qboolean gravity ) {
 				// slide the original velocity along the crease
 				CrossProduct (planes[i], planes[j], dir);
 				VectorNormalize( dir );
-				d = DotProduct( dir, pm->ps->velocity );
+				d = DotProduct( dir, pc->pm->ps->velocity );
 				VectorScale( dir, d, clipVelocity );
 
 				CrossProduct (planes[i], planes[j], dir);
@@ -200,25 +200,25 @@ qboolean	PM_SlideMove( qboolean gravity ) {
 					}
 
 					// stop dead at a tripple plane interaction
-					VectorClear( pm->ps->velocity );
+					VectorClear( pc->pm->ps->velocity );
 					return qtrue;
 				}
 			}
 
 			// if we have fixed all interactions, try another move
-			VectorCopy( clipVelocity, pm->ps->velocity );
+			VectorCopy( clipVelocity, pc->pm->ps->velocity );
 			VectorCopy( endClipVelocity, endVelocity );
 			break;
 		}
 	}
 
 	if ( gravity ) {
-		VectorCopy( endVelocity, pm->ps->velocity );
+		VectorCopy( endVelocity, pc->pm->ps->velocity );
 	}
 
 	// don't change velocity if in a timer (FIXME: is this correct?)
-	if ( pm->ps->pm_time ) {
-		VectorCopy( primal_velocity, pm->ps->velocity );
+	if ( pc->pm->ps->pm_time ) {
+		VectorCopy( primal_velocity, pc->pm->ps->velocity );
 	}
 
 	return ( bumpcount != 0 );
@@ -230,7 +230,7 @@ PM_StepSlideMove
 
 ==================
 */
-void PM_StepSlideMove( qboolean gravity ) {
+void PM_StepSlideMove( pmoveContext_t *pc, qboolean gravity ) {
 	vec3_t		start_o, start_v;
 	vec3_t		down_o, down_v;
 	trace_t		trace;
@@ -239,33 +239,33 @@ void PM_StepSlideMove( qboolean gravity ) {
 	vec3_t		up, down;
 	float		stepSize;
 
-	VectorCopy (pm->ps->origin, start_o);
-	VectorCopy (pm->ps->velocity, start_v);
+	VectorCopy (pc->pm->ps->origin, start_o);
+	VectorCopy (pc->pm->ps->velocity, start_v);
 
-	if ( PM_SlideMove( gravity ) == 0 ) {
+	if ( PM_SlideMove( pc, gravity ) == 0 ) {
 		return;		// we got exactly where we wanted to go first try	
 	}
 
 	VectorCopy(start_o, down);
 	down[2] -= STEPSIZE;
-	pm->trace (&trace, start_o, pm->mins, pm->maxs, down, pm->ps->clientNum, pm->tracemask);
+	PM_Trace( pc, &trace, start_o, pc->pm->mins, pc->pm->maxs, down, pc->pm->ps->clientNum, pc->pm->tracemask);
 	VectorSet(up, 0, 0, 1);
 	// never step up when you still have up velocity
-	if ( pm->ps->velocity[2] > 0 && (trace.fraction == 1.0 ||
+	if ( pc->pm->ps->velocity[2] > 0 && (trace.fraction == 1.0 ||
 										DotProduct(trace.plane.normal, up) < 0.7)) {
 		return;
 	}
 
-	VectorCopy (pm->ps->origin, down_o);
-	VectorCopy (pm->ps->velocity, down_v);
+	VectorCopy (pc->pm->ps->origin, down_o);
+	VectorCopy (pc->pm->ps->velocity, down_v);
 
 	VectorCopy (start_o, up);
 	up[2] += STEPSIZE;
 
 	// test the player position if they were a stepheight higher
-	pm->trace (&trace, start_o, pm->mins, pm->maxs, up, pm->ps->clientNum, pm->tracemask);
+	PM_Trace( pc, &trace, start_o, pc->pm->mins, pc->pm->maxs, up, pc->pm->ps->clientNum, pc->pm->tracemask);
 	if ( trace.allsolid ) {
-		if ( pm->debugLevel ) {
+		if ( pc->pm->debugLevel ) {
 			Com_Printf("%i:bend can't step\n", c_pmove);
 		}
 		return;		// can't step up
@@ -273,30 +273,30 @@ void PM_StepSlideMove( qboolean gravity ) {
 
 	stepSize = trace.endpos[2] - start_o[2];
 	// try slidemove from this position
-	VectorCopy (trace.endpos, pm->ps->origin);
-	VectorCopy (start_v, pm->ps->velocity);
+	VectorCopy (trace.endpos, pc->pm->ps->origin);
+	VectorCopy (start_v, pc->pm->ps->velocity);
 
-	PM_SlideMove( gravity );
+	PM_SlideMove( pc, gravity );
 
 	// push down the final amount
-	VectorCopy (pm->ps->origin, down);
+	VectorCopy (pc->pm->ps->origin, down);
 	down[2] -= stepSize;
-	pm->trace (&trace, pm->ps->origin, pm->mins, pm->maxs, down, pm->ps->clientNum, pm->tracemask);
+	PM_Trace( pc, &trace, pc->pm->ps->origin, pc->pm->mins, pc->pm->maxs, down, pc->pm->ps->clientNum, pc->pm->tracemask);
 	if ( !trace.allsolid ) {
-		VectorCopy (trace.endpos, pm->ps->origin);
+		VectorCopy (trace.endpos, pc->pm->ps->origin);
 	}
 	if ( trace.fraction < 1.0 ) {
-		PM_ClipVelocity( pm->ps->velocity, trace.plane.normal, pm->ps->velocity, OVERCLIP );
+		PM_ClipVelocity( pc->pm->ps->velocity, trace.plane.normal, pc->pm->ps->velocity, OVERCLIP );
 	}
 
 #if 0
 	// if the down trace can trace back to the original position directly, don't step
-	pm->trace( &trace, pm->ps->origin, pm->mins, pm->maxs, start_o, pm->ps->clientNum, pm->tracemask);
+	PM_Trace( pc, &trace, pc->pm->ps->origin, pc->pm->mins, pc->pm->maxs, start_o, pc->pm->ps->clientNum, pc->pm->tracemask);
 	if ( trace.fraction == 1.0 ) {
 		// use the original move
-		VectorCopy (down_o, pm->ps->origin);
-		VectorCopy (down_v, pm->ps->velocity);
-		if ( pm->debugLevel ) {
+		VectorCopy (down_o, pc->pm->ps->origin);
+		VectorCopy (down_v, pc->pm->ps->velocity);
+		if ( pc->pm->debugLevel ) {
 			Com_Printf("%i:bend\n", c_pmove);
 		}
 	} else 
@@ -305,19 +305,19 @@ void PM_StepSlideMove( qboolean gravity ) {
 		// use the step move
 		float	delta;
 
-		delta = pm->ps->origin[2] - start_o[2];
+		delta = pc->pm->ps->origin[2] - start_o[2];
 		if ( delta > 2 ) {
 			if ( delta < 7 ) {
-				PM_AddEvent( EV_STEP_4 );
+				PM_AddEvent( pc, EV_STEP_4 );
 			} else if ( delta < 11 ) {
-				PM_AddEvent( EV_STEP_8 );
+				PM_AddEvent( pc, EV_STEP_8 );
 			} else if ( delta < 15 ) {
-				PM_AddEvent( EV_STEP_12 );
+				PM_AddEvent( pc, EV_STEP_12 );
 			} else {
-				PM_AddEvent( EV_STEP_16 );
+				PM_AddEvent( pc, EV_STEP_16 );
 			}
 		}
-		if ( pm->debugLevel ) {
+		if ( pc->pm->debugLevel ) {
 			Com_Printf("%i:stepped\n", c_pmove);
 		}
 	}
@@ -1189,3 +1189,139 @@ void ClientEndFrame( gentity_t *ent ) {
 }
 
 
+/*
+==============================================================================
+
+PMOVE BENCHMARK
+
+==============================================================================
+*/
+
+#define	PMOVE_BENCH_MOVES		16		// eight directions, walking and jumping
+#define	PMOVE_BENCH_MAX_ITERATIONS	10000
+
+static const signed char pmoveBenchDirs[8][2] = {
+	{ 127, 0 }, { 127, 127 }, { 0, 127 }, { -127, 127 },
+	{ -127, 0 }, { -127, -127 }, { 0, -127 }, { 127, -127 }
+};
+
+/*
+==================
+G_PmoveBenchSetup
+
+A second of each candidate move from where the client stands, on
+copies of its playerState
+==================
+*/
+static void G_PmoveBenchSetup( gentity_t *ent, pmove_t *pmoves, playerState_t *states ) {
+	gclient_t	*client;
+	pmove_t		*pm;
+	int			i;
+
+	client = ent->client;
+	for ( i = 0 ; i < PMOVE_BENCH_MOVES ; i++ ) {
+		states[i] = client->ps;
+
+		pm = &pmoves[i];
+		memset( pm, 0, sizeof( *pm ) );
+		pm->ps = &states[i];
+		pm->cmd = client->pers.cmd;
+		pm->cmd.serverTime = states[i].commandTime + 1000;
+		pm->cmd.buttons = 0;
+		pm->cmd.forwardmove = pmoveBenchDirs[i & 7][0];
+		pm->cmd.rightmove = pmoveBenchDirs[i & 7][1];
+		pm->cmd.upmove = i < 8 ? 0 : 127;
+		if ( ent->r.svFlags & SVF_BOT ) {
+			pm->tracemask = MASK_PLAYERSOLID | CONTENTS_BOTCLIP;
+		} else {
+			pm->tracemask = MASK_PLAYERSOLID;
+		}
+		pm->trace = trap_Trace;
+		pm->pointcontents = trap_PointContents;
+		pm->noFootsteps = ( g_dmflags.integer & DF_NO_FOOTSTEPS ) > 0;
+		pm->pmove_fixed = pmove_fixed.integer | client->pers.pmoveFixed;
+		pm->pmove_msec = pmove_msec.integer;
+	}
+}
+
+/*
+==================
+Svcmd_PmoveBench_f
+
+pmovebench [iterations]
+
+Tries the candidate moves of every live client with a Pmove each and
+then with one PmoveBatch, and prints the time of both and how many of
+the batch's traces came out of its cache.  The clients are untouched.
+==================
+*/
+void Svcmd_PmoveBench_f( void ) {
+	char			arg[MAX_TOKEN_CHARS];
+	pmove_t			pmoves[PMOVE_BENCH_MOVES];
+	playerState_t	states[PMOVE_BENCH_MOVES];
+	vec3_t			ends[PMOVE_BENCH_MOVES];
+	gentity_t		*ent;
+	int				iterations, iteration;
+	int				msec[2], start;
+	int				traces, hits;
+	int				numClients, mismatches;
+	int				i, j, pass;
+
+	iterations = 100;
+	if ( trap_Argc() > 1 ) {
+		trap_Argv( 1, arg, sizeof( arg ) );
+		iterations = atoi( arg );
+		if ( iterations < 1 || iterations > PMOVE_BENCH_MAX_ITERATIONS ) {
+			G_Printf( "Usage: pmovebench [iterations], iterations from 1 to %i\n", PMOVE_BENCH_MAX_ITERATIONS );
+			return;
+		}
+	}
+
+	traces = c_pmoveTraces;
+	hits = c_pmoveTraceHits;
+	msec[0] = msec[1] = 0;
+	numClients = 0;
+	mismatches = 0;
+
+	for ( i = 0 ; i < level.maxclients ; i++ ) {
+		ent = &g_entities[i];
+		if ( !ent->inuse || ent->client->pers.connected != CON_CONNECTED
+			|| ent->client->ps.pm_type != PM_NORMAL ) {
+			continue;
+		}
+		numClients++;
+
+		for ( pass = 0 ; pass < 2 ; pass++ ) {
+			start = trap_Milliseconds();
+			for ( iteration = 0 ; iteration < iterations ; iteration++ ) {
+				G_PmoveBenchSetup( ent, pmoves, states );
+				if ( pass ) {
+					PmoveBatch( pmoves, PMOVE_BENCH_MOVES );
+				} else {
+					for ( j = 0 ; j < PMOVE_BENCH_MOVES ; j++ ) {
+						Pmove( &pmoves[j] );
+					}
+				}
+			}
+			msec[pass] += trap_Milliseconds() - start;
+
+			// the batch has to land every move where Pmove did
+			for ( j = 0 ; j < PMOVE_BENCH_MOVES ; j++ ) {
+				if ( !pass ) {
+					VectorCopy( states[j].origin, ends[j] );
+				} else if ( !VectorCompare( states[j].origin, ends[j] ) ) {
+					mismatches++;
+				}
+			}
+		}
+	}
+
+	if ( !numClients ) {
+		G_Printf( "no live clients to move\n" );
+		return;
+	}
+
+	G_Printf( "%i clients x %i moves x %i: Pmove %i msec, PmoveBatch %i msec, %i of %i traces cached, %i mismatches\n",
+		numClients, PMOVE_BENCH_MOVES, iterations, msec[0], msec[1],
+		c_pmoveTraceHits - hits, c_pmoveTraces - traces, mismatches );
+}
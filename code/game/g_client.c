@@ -354,7 +354,7 @@ void BodySink( gentity_t *ent ) {
 		ent->physicsObject = qfalse;
 		return;	
 	}
-	ent->nextthink = level.time + 100;
+	G_SetNextThink( ent, level.time + 100 );
 	ent->s.pos.trBase[2] -= 1;
 }
 
@@ -422,6 +422,7 @@ void CopyToBodyQue( gentity_t *ent ) {
 		body->s.pos.trType = TR_STATIONARY;
 	}
 	body->s.event = 0;
+	G_ActivateEntity( body );
 
 	// change the animation to the last-frame only, so the sequence
 	// doesn't repeat anew for the body
@@ -451,7 +452,7 @@ void CopyToBodyQue( gentity_t *ent ) {
 	body->r.contents = CONTENTS_CORPSE;
 	body->r.ownerNum = ent->s.number;
 
-	body->nextthink = level.time + 5000;
+	G_SetNextThink( body, level.time + 5000 );
 	body->think = BodySink;
 
 	body->die = body_die;
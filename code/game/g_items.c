@@ -406,7 +406,7 @@ void RespawnItem( gentity_t *ent ) {
 	// play the normal respawn sound only to nearby clients
 	G_AddEvent( ent, EV_ITEM_RESPAWN, 0 );
 
-	ent->nextthink = 0;
+	G_SetNextThink( ent, 0 );
 }
 
 
@@ -508,6 +508,7 @@ void Touch_Item (gentity_t *ent, gentity_t *other, trace_t *trace) {
 		ent->s.eFlags |= EF_NODRAW;
 		ent->r.contents = 0;
 		ent->unlinkAfterEvent = qtrue;
+		G_ActivateEntity( ent );
 		return;
 	}
 
@@ -527,6 +528,7 @@ void Touch_Item (gentity_t *ent, gentity_t *other, trace_t *trace) {
 	// dropped items will not respawn
 	if ( ent->flags & FL_DROPPED_ITEM ) {
 		ent->freeAfterEvent = qtrue;
+		G_ActivateEntity( ent );
 	}
 
 	// picked up items still stay around, they just don't
@@ -541,10 +543,10 @@ void Touch_Item (gentity_t *ent, gentity_t *other, trace_t *trace) {
 	// delete it).  This is used by items that are respawned by third party 
 	// events such as ctf flags
 	if ( respawn <= 0 ) {
-		ent->nextthink = 0;
+		G_SetNextThink( ent, 0 );
 		ent->think = 0;
 	} else {
-		ent->nextthink = level.time + respawn * 1000;
+		G_SetNextThink( ent, level.time + respawn * 1000 );
 		ent->think = RespawnItem;
 	}
 	trap_LinkEntity( ent );
@@ -589,11 +591,11 @@ gentity_t *LaunchItem( gitem_t *item, vec3_t origin, vec3_t velocity ) {
 	if (g_gametype.integer == GT_CTF && item->giType == IT_TEAM) { // Special case for CTF flags
 #endif
 		dropped->think = Team_DroppedFlagThink;
-		dropped->nextthink = level.time + 30000;
+		G_SetNextThink( dropped, level.time + 30000 );
 		Team_CheckDroppedItem( dropped );
 	} else { // auto-remove after 30 seconds
 		dropped->think = G_FreeEntity;
-		dropped->nextthink = level.time + 30000;
+		G_SetNextThink( dropped, level.time + 30000 );
 	}
 
 	dropped->flags = FL_DROPPED_ITEM;
@@ -696,7 +698,7 @@ void FinishSpawningItem( gentity_t *ent ) {
 		respawn = 45 + crandom() * 15;
 		ent->s.eFlags |= EF_NODRAW;
 		ent->r.contents = 0;
-		ent->nextthink = level.time + respawn * 1000;
+		G_SetNextThink( ent, level.time + respawn * 1000 );
 		ent->think = RespawnItem;
 		return;
 	}
@@ -888,7 +890,7 @@ void G_SpawnItem (gentity_t *ent, gitem_t *item) {
 	ent->item = item;
 	// some movers spawn on the second frame, so delay item
 	// spawns until the third frame so they can ride trains
-	ent->nextthink = level.time + FRAMETIME * 2;
+	G_SetNextThink( ent, level.time + FRAMETIME * 2 );
 	ent->think = FinishSpawningItem;
 
 	ent->physicsBounce = 0.50;		// items are bouncy
@@ -129,7 +129,9 @@ struct gentity_s {
 	float		speed;
 	vec3_t		movedir;
 
-	int			nextthink;
+	int			nextthink;			// only set through G_SetNextThink
+	gentity_t	*thinkNext;			// in the same think wheel slot
+	gentity_t	**thinkPrev;		// pointer to this entity, NULL if not scheduled
 	void		(*think)(gentity_t *self);
 	void		(*reached)(gentity_t *self);	// movers call this when hitting endpoint
 	void		(*blocked)(gentity_t *self, gentity_t *other);
@@ -255,6 +257,18 @@ typedef struct {
 } clientPersistant_t;
 
 
+// recent positions of a client, sampled at the end of every frame so
+// hitscan weapons can trace against what the shooter was looking at
+#define	MAX_CLIENT_HISTORY		32		// must be a power of two
+#define	CLIENT_HISTORY_MASK		( MAX_CLIENT_HISTORY - 1 )
+
+typedef struct {
+	int			time;				// level.time of the sample, 0 if never written
+	vec3_t		origin;
+	vec3_t		mins, maxs;
+	int			teleportBit;		// don't lerp across teleports
+} clientHistory_t;
+
 // this structure is cleared on each ClientSpawn(),
 // except for 'client->pers' and 'client->sess'
 struct gclient_s {
@@ -315,6 +329,10 @@ struct gclient_s {
 	// like health / armor countdowns and regeneration
 	int			timeResidual;
 
+	// lag compensation, starts over on every spawn
+	clientHistory_t	history[MAX_CLIENT_HISTORY];
+	int			historyHead;		// most recently written sample
+
 #ifdef MISSIONPACK
 	gentity_t	*persistantPowerup;
 	int			portalID;
@@ -326,6 +344,13 @@ struct gclient_s {
 };
 
 
+// thinks are kept on a two level timing wheel, so entities that are
+// just waiting to think cost nothing until their time comes
+#define	THINK_TICK_SHIFT		4		// 16 msec wheel ticks
+#define	THINK_WHEEL_BITS		6
+#define	THINK_WHEEL_SIZE		( 1 << THINK_WHEEL_BITS )
+#define	THINK_WHEEL_MASK		( THINK_WHEEL_SIZE - 1 )
+
 //
 // this structure is cleared as each map is entered
 //
@@ -350,6 +375,15 @@ typedef struct {
 	int			time;					// in msec
 	int			previousTime;			// so movers can back up when blocked
 
+	// think scheduling, see G_SetNextThink
+	int			thinkTick;							// near slots before this one are empty
+	gentity_t	*thinkNear[THINK_WHEEL_SIZE];		// a wheel tick per slot
+	gentity_t	*thinkFar[THINK_WHEEL_SIZE];		// THINK_WHEEL_SIZE wheel ticks per slot
+	gentity_t	*thinkLater;						// beyond the far wheel
+
+	// entities G_RunFrame has to visit, one bit per entity
+	unsigned	activeEntities[MAX_GENTITIES / 32];
+
 	int			startTime;				// level.time the map was started
 
 	int			teamScores[TEAM_NUM_TEAMS];
@@ -471,6 +505,10 @@ gentity_t *G_PickTarget (char *targetname);
 void	G_UseTargets (gentity_t *ent, gentity_t *activator);
 void	G_SetMovedir ( vec3_t angles, vec3_t movedir);
 
+void	G_SetNextThink( gentity_t *ent, int time );
+void	G_ActivateEntity( gentity_t *ent );
+void	G_RunThinkWheel( void );
+
 void	G_InitGentity( gentity_t *e );
 gentity_t	*G_Spawn (void);
 gentity_t *G_TempEntity( vec3_t origin, int event );
@@ -596,6 +634,7 @@ qboolean G_FilterPacket (char *from);
 // g_weapon.c
 //
 void FireWeapon( gentity_t *ent );
+void G_StoreClientHistory( gentity_t *ent );
 #ifdef MISSIONPACK
 void G_StartKamikaze( gentity_t *ent );
 #endif
@@ -627,6 +666,7 @@ void QDECL G_LogPrintf( const char *fmt, ... );
 void SendScoreboardMessageToAllClients( void );
 void QDECL G_Printf( const char *fmt, ... );
 void QDECL G_Error( const char *fmt, ... );
+void Svcmd_GameSpeeds_f( void );
 
 //
 // g_client.c
@@ -643,6 +683,7 @@ void ClientCommand( int clientNum );
 void ClientThink( int clientNum );
 void ClientEndFrame( gentity_t *ent );
 void G_RunClient( gentity_t *ent );
+void Svcmd_PmoveBench_f( void );
 
 //
 // g_team.c
@@ -760,6 +801,8 @@ extern	vmCvar_t	g_smoothClients;
 extern	vmCvar_t	pmove_fixed;
 extern	vmCvar_t	pmove_msec;
 extern	vmCvar_t	g_rankings;
+extern	vmCvar_t	g_speeds;
+extern	vmCvar_t	g_lagCompensation;
 extern	vmCvar_t	g_enableDust;
 extern	vmCvar_t	g_enableBreath;
 extern	vmCvar_t	g_singlePlayer;
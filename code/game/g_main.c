@@ -81,6 +81,8 @@ vmCvar_t	pmove_fixed;
 vmCvar_t	pmove_msec;
 vmCvar_t	g_rankings;
 vmCvar_t	g_listEntity;
+vmCvar_t	g_speeds;
+vmCvar_t	g_lagCompensation;
 #ifdef MISSIONPACK
 vmCvar_t	g_obeliskHealth;
 vmCvar_t	g_obeliskRegenPeriod;
@@ -158,6 +160,8 @@ static cvarTable_t		gameCvarTable[] = {
 
 	{ &g_allowVote, "g_allowVote", "1", CVAR_ARCHIVE, 0, qfalse },
 	{ &g_listEntity, "g_listEntity", "0", 0, 0, qfalse },
+	{ &g_speeds, "g_speeds", "0", 0, 0, qfalse },
+	{ &g_lagCompensation, "g_lagCompensation", "1", CVAR_SERVERINFO | CVAR_ARCHIVE, 0, qtrue },
 
 #ifdef MISSIONPACK
 	{ &g_obeliskHealth, "g_obeliskHealth", "2500", 0, 0, qfalse },
@@ -192,6 +196,98 @@ void G_ShutdownGame( int restart );
 void CheckExitRules( void );
 
 
+/*
+==============================================================================
+
+FRAME TIMING
+
+When g_speeds is set, the time spent in each kind of entity update is
+accumulated until the "gamespeeds" server command reports and clears it.
+Only millisecond timing is available to the game, but the clock phase is
+uncorrelated with the work being timed, so the sums converge on the real
+cost over a few hundred frames.
+
+==============================================================================
+*/
+
+typedef enum {
+	GSPEED_MISSILE,
+	GSPEED_ITEM,
+	GSPEED_MOVER,
+	GSPEED_CLIENT,		// ClientThink_real, from usercmds or G_RunClient
+	GSPEED_THINK,
+	GSPEED_ENDFRAME,	// ClientEndFrame
+	GSPEED_BOTAI,		// BotAIStartFrame
+	GSPEED_NONE,
+
+	GSPEED_NUM_SPEEDS = GSPEED_NONE
+} gameSpeed_t;
+
+static const char *gameSpeedNames[GSPEED_NUM_SPEEDS] = {
+	"missile",
+	"item",
+	"mover",
+	"client",
+	"think",
+	"endframe",
+	"botai"
+};
+
+typedef struct {
+	int			frames;
+	int			frameMsec;
+	int			msec[GSPEED_NUM_SPEEDS];
+	int			count[GSPEED_NUM_SPEEDS];
+	int			visited;				// entities G_RunFrame looked at
+	int			inuse;
+} gameSpeeds_t;
+
+static gameSpeeds_t	gameSpeeds;
+
+/*
+================
+G_AddSpeed
+================
+*/
+static void G_AddSpeed( gameSpeed_t speed, int startTime ) {
+	if ( speed == GSPEED_NONE ) {
+		return;
+	}
+	gameSpeeds.msec[speed] += trap_Milliseconds() - startTime;
+	gameSpeeds.count[speed]++;
+}
+
+/*
+================
+Svcmd_GameSpeeds_f
+
+gamespeeds [clear]
+================
+*/
+void Svcmd_GameSpeeds_f( void ) {
+	char	arg[MAX_TOKEN_CHARS];
+	int		i;
+	float	frames;
+
+	trap_Argv( 1, arg, sizeof( arg ) );
+	if ( Q_stricmp( arg, "clear" ) ) {
+		if ( !gameSpeeds.frames ) {
+			G_Printf( "no frames timed, set g_speeds 1 first\n" );
+			return;
+		}
+		frames = gameSpeeds.frames;
+		G_Printf( "%i frames, %.3f msec/frame\n", gameSpeeds.frames, gameSpeeds.frameMsec / frames );
+		G_Printf( "%.1f of %.1f entities visited/frame\n", gameSpeeds.visited / frames, gameSpeeds.inuse / frames );
+		G_Printf( "type       calls/frame  msec/frame\n" );
+		for ( i = 0 ; i < GSPEED_NUM_SPEEDS ; i++ ) {
+			G_Printf( "%-10s %11.2f %11.3f\n", gameSpeedNames[i],
+				gameSpeeds.count[i] / frames, gameSpeeds.msec[i] / frames );
+		}
+	}
+	memset( &gameSpeeds, 0, sizeof( gameSpeeds ) );
+}
+
+
 /*
 ================
 vmMain
@@ -211,6 +307,14 @@ int vmMain( int command, int arg0, int arg1, int arg2, int arg3, int arg4, int a
 	case GAME_CLIENT_CONNECT:
 		return (int)ClientConnect( arg0, arg1, arg2 );
 	case GAME_CLIENT_THINK:
+		if ( g_speeds.integer ) {
+			int		startTime;
+
+			startTime = trap_Milliseconds();
+			ClientThink( arg0 );
+			G_AddSpeed( GSPEED_CLIENT, startTime );
+			return 0;
+		}
 		ClientThink( arg0 );
 		return 0;
 	case GAME_CLIENT_USERINFO_CHANGED:
@@ -231,6 +335,18 @@ int vmMain( int command, int arg0, int arg1, int arg2, int arg3, int arg4, int a
 	case GAME_CONSOLE_COMMAND:
 		return ConsoleCommand();
 	case BOTAI_START_FRAME:
+		if ( g_speeds.integer ) {
+			int		startTime, clientMsec, result;
+
+			// the bots' usercmds come back through GAME_CLIENT_THINK
+			// and are charged to client, so leave them out of botai
+			startTime = trap_Milliseconds();
+			clientMsec = gameSpeeds.msec[GSPEED_CLIENT];
+			result = BotAIStartFrame( arg0 );
+			startTime += gameSpeeds.msec[GSPEED_CLIENT] - clientMsec;
+			G_AddSpeed( GSPEED_BOTAI, startTime );
+			return result;
+		}
 		return BotAIStartFrame( arg0 );
 	}
 
@@ -424,6 +540,7 @@ void G_InitGame( int levelTime, int randomSeed, int restart ) {
 	memset( &level, 0, sizeof( level ) );
 	level.time = levelTime;
 	level.startTime = levelTime;
+	level.thinkTick = levelTime >> THINK_TICK_SHIFT;
 
 	level.snd_fry = G_SoundIndex("sound/player/fry.wav");	// FIXME standing in lava / slime
 
@@ -1696,13 +1813,134 @@ void G_RunThink (gentity_t *ent) {
 		return;
 	}
 	
-	ent->nextthink = 0;
+	G_SetNextThink( ent, 0 );
 	if (!ent->think) {
 		G_Error ( "NULL ent->think");
 	}
 	ent->think (ent);
 }
 
+/*
+================
+G_RunEntity
+
+Runs the per-frame update for one entity and returns
+the g_speeds category the work was charged to
+================
+*/
+static gameSpeed_t G_RunEntity( gentity_t *ent, int entityNum ) {
+	// clear events that are too old
+	if ( level.time - ent->eventTime > EVENT_VALID_MSEC ) {
+		if ( ent->s.event ) {
+			ent->s.event = 0;	// &= EV_EVENT_BITS;
+			if ( ent->client ) {
+				ent->client->ps.externalEvent = 0;
+				// predicted events should never be set to zero
+				//ent->client->ps.events[0] = 0;
+				//ent->client->ps.events[1] = 0;
+			}
+		}
+		if ( ent->freeAfterEvent ) {
+			// tempEntities or dropped items completely go away after their event
+			G_FreeEntity( ent );
+			return GSPEED_NONE;
+		} else if ( ent->unlinkAfterEvent ) {
+			// items that will respawn will hide themselves after their pickup event
+			ent->unlinkAfterEvent = qfalse;
+			trap_UnlinkEntity( ent );
+		}
+	}
+
+	// temporary entities don't think
+	if ( ent->freeAfterEvent ) {
+		return GSPEED_NONE;
+	}
+
+	if ( !ent->r.linked && ent->neverFree ) {
+		return GSPEED_NONE;
+	}
+
+	if ( ent->s.eType == ET_MISSILE ) {
+		G_RunMissile( ent );
+		return GSPEED_MISSILE;
+	}
+
+	if ( ent->s.eType == ET_ITEM || ent->physicsObject ) {
+		G_RunItem( ent );
+		return GSPEED_ITEM;
+	}
+
+	if ( ent->s.eType == ET_MOVER ) {
+		G_RunMover( ent );
+		return GSPEED_MOVER;
+	}
+
+	if ( entityNum < MAX_CLIENTS ) {
+		G_RunClient( ent );
+		if ( !(ent->r.svFlags & SVF_BOT) && !g_synchronousClients.integer ) {
+			return GSPEED_NONE;		// already charged when the usercmd arrived
+		}
+		return GSPEED_CLIENT;
+	}
+
+	G_RunThink( ent );
+	return GSPEED_THINK;
+}
+
+/*
+================
+G_EntityNeedsFrame
+
+Entities that move, carry an event or belong to a client are visited
+every frame, everything else waits for G_ActivateEntity or its think
+================
+*/
+static qboolean G_EntityNeedsFrame( gentity_t *ent, int entityNum ) {
+	if ( entityNum < MAX_CLIENTS ) {
+		return qtrue;
+	}
+
+	// old events still have to be cleared
+	if ( ent->s.event || ent->freeAfterEvent || ent->unlinkAfterEvent ) {
+		return qtrue;
+	}
+
+	if ( ent->s.eType == ET_MISSILE ) {
+		return qtrue;
+	}
+
+	if ( ent->s.eType == ET_ITEM || ent->physicsObject ) {
+		return ent->s.pos.trType != TR_STATIONARY || ent->s.groundEntityNum == -1;
+	}
+
+	if ( ent->s.eType == ET_MOVER ) {
+		if ( ent->flags & FL_TEAMSLAVE ) {
+			return qfalse;
+		}
+		return ent->s.pos.trType != TR_STATIONARY || ent->s.apos.trType != TR_STATIONARY;
+	}
+
+	return qfalse;
+}
+
+/*
+================
+G_ThinkNeverRuns
+
+G_RunEntity never gets to the think of a client or a team slave,
+the captain moves and thinks for the whole team
+================
+*/
+static qboolean G_ThinkNeverRuns( gentity_t *ent, int entityNum ) {
+	if ( entityNum < MAX_CLIENTS ) {
+		return qtrue;
+	}
+	if ( ent->s.eType == ET_MOVER && ( ent->flags & FL_TEAMSLAVE ) ) {
+		return qtrue;
+	}
+	return qfalse;
+}
+
 /*
 ================
 G_RunFrame
@@ -1714,7 +1952,7 @@ void G_RunFrame( int levelTime ) {
 	int			i;
 	gentity_t	*ent;
 	int			msec;
-int start, end;
+	int			start, frameStart;
 
 	// if we are waiting for the level to restart, do nothing
 	if ( level.restarted ) {
@@ -1729,80 +1967,91 @@ int start, end;
 	// get any cvar changes
 	G_UpdateCvars();
 
-	//
-	// go through all allocated objects
-	//
-	start = trap_Milliseconds();
-	ent = &g_entities[0];
-	for (i=0 ; i<level.num_entities ; i++, ent++) {
-		if ( !ent->inuse ) {
-			continue;
-		}
+	if ( g_speeds.integer ) {
+		frameStart = trap_Milliseconds();
+	} else {
+		frameStart = 0;
+	}
 
-		// clear events that are too old
-		if ( level.time - ent->eventTime > EVENT_VALID_MSEC ) {
-			if ( ent->s.event ) {
-				ent->s.event = 0;	// &= EV_EVENT_BITS;
-				if ( ent->client ) {
-					ent->client->ps.externalEvent = 0;
-					// predicted events should never be set to zero
-					//ent->client->ps.events[0] = 0;
-					//ent->client->ps.events[1] = 0;
-				}
-			}
-			if ( ent->freeAfterEvent ) {
-				// tempEntities or dropped items completely go away after their event
-				G_FreeEntity( ent );
-				continue;
-			} else if ( ent->unlinkAfterEvent ) {
-				// items that will respawn will hide themselves after their pickup event
-				ent->unlinkAfterEvent = qfalse;
-				trap_UnlinkEntity( ent );
-			}
-		}
+	// mark everything whose think is due
+	G_RunThinkWheel();
 
-		// temporary entities don't think
-		if ( ent->freeAfterEvent ) {
-			continue;
+	ent = &g_entities[0];
+	for (i=0 ; i < level.maxclients ; i++, ent++ ) {
+		if ( ent->inuse ) {
+			G_ActivateEntity( ent );
 		}
+	}
 
-		if ( !ent->r.linked && ent->neverFree ) {
+	//
+	// go through the active objects, in the same order as all of them
+	// were gone through, entities activated along the way are picked
+	// up if they come later
+	//
+	for (i=0 ; i<level.num_entities ; i++) {
+		if ( !level.activeEntities[i >> 5] ) {
+			i |= 31;		// skip the rest of an idle block
 			continue;
 		}
-
-		if ( ent->s.eType == ET_MISSILE ) {
-			G_RunMissile( ent );
+		if ( !( level.activeEntities[i >> 5] & ( 1 << ( i & 31 ) ) ) ) {
 			continue;
 		}
 
-		if ( ent->s.eType == ET_ITEM || ent->physicsObject ) {
-			G_RunItem( ent );
-			continue;
+		ent = &g_entities[i];
+		if ( ent->inuse ) {
+			if ( g_speeds.integer ) {
+				start = trap_Milliseconds();
+				G_AddSpeed( G_RunEntity( ent, i ), start );
+				gameSpeeds.visited++;
+			} else {
+				G_RunEntity( ent, i );
+			}
 		}
 
-		if ( ent->s.eType == ET_MOVER ) {
-			G_RunMover( ent );
-			continue;
+		if ( !ent->inuse || !G_EntityNeedsFrame( ent, i ) ) {
+			level.activeEntities[i >> 5] &= ~( 1 << ( i & 31 ) );
 		}
 
-		if ( i < MAX_CLIENTS ) {
-			G_RunClient( ent );
-			continue;
+		// a think held back this frame has to come around again, one
+		// that can never run is dropped instead of being due every frame
+		if ( ent->inuse && ent->nextthink > 0 && !ent->thinkPrev ) {
+			if ( G_ThinkNeverRuns( ent, i ) ) {
+				G_SetNextThink( ent, 0 );
+			} else {
+				G_SetNextThink( ent, ent->nextthink );
+			}
 		}
+	}
 
-		G_RunThink( ent );
+	if ( g_speeds.integer ) {
+		for (i=0 ; i<level.num_entities ; i++) {
+			if ( g_entities[i].inuse ) {
+				gameSpeeds.inuse++;
+			}
+		}
 	}
-end = trap_Milliseconds();
 
-start = trap_Milliseconds();
 	// perform final fixups on the players
 	ent = &g_entities[0];
 	for (i=0 ; i < level.maxclients ; i++, ent++ ) {
 		if ( ent->inuse ) {
-			ClientEndFrame( ent );
+			if ( g_speeds.integer ) {
+				start = trap_Milliseconds();
+				ClientEndFrame( ent );
+				G_AddSpeed( GSPEED_ENDFRAME, start );
+			} else {
+				ClientEndFrame( ent );
+			}
+		}
+	}
+
+	// remember where everyone ended up for lag compensated hitscan
+	ent = &g_entities[0];
+	for (i=0 ; i < level.maxclients ; i++, ent++ ) {
+		if ( ent->inuse && ent->client->pers.connected == CON_CONNECTED ) {
+			G_StoreClientHistory( ent );
 		}
 	}
-end = trap_Milliseconds();
 
 	// see if it is time to do a tournement restart
 	CheckTournament();
@@ -1829,4 +2078,9 @@ end = trap_Milliseconds();
 		}
 		trap_Cvar_Set("g_listEntity", "0");
 	}
+
+	if ( g_speeds.integer ) {
+		gameSpeeds.frames++;
+		gameSpeeds.frameMsec += trap_Milliseconds() - frameStart;
+	}
 }
@@ -114,7 +114,7 @@ ProximityMine_Die
 */
 static void ProximityMine_Die( gentity_t *ent, gentity_t *inflictor, gentity_t *attacker, int damage, int mod ) {
 	ent->think = ProximityMine_Explode;
-	ent->nextthink = level.time + 1;
+	G_SetNextThink( ent, level.time + 1 );
 }
 
 /*
@@ -153,7 +153,7 @@ void ProximityMine_Trigger( gentity_t *trigger, gentity_t *other, trace_t *trace
 	mine = trigger->parent;
 	mine->s.loopSound = 0;
 	G_AddEvent( mine, EV_PROXIMITY_MINE_TRIGGER, 0 );
-	mine->nextthink = level.time + 500;
+	G_SetNextThink( mine, level.time + 500 );
 
 	G_FreeEntity( trigger );
 }
@@ -168,7 +168,7 @@ static void ProximityMine_Activate( gentity_t *ent ) {
 	float		r;
 
 	ent->think = ProximityMine_Explode;
-	ent->nextthink = level.time + g_proxMineTimeout.integer;
+	G_SetNextThink( ent, level.time + g_proxMineTimeout.integer );
 
 	ent->takedamage = qtrue;
 	ent->health = 1;
@@ -238,7 +238,7 @@ static void ProximityMine_Player( gentity_t *mine, gentity_t *player ) {
 		player->activator->splashDamage += mine->splashDamage;
 		player->activator->splashRadius *= 1.50;
 		mine->think = G_FreeEntity;
-		mine->nextthink = level.time;
+		G_SetNextThink( mine, level.time );
 		return;
 	}
 
@@ -253,10 +253,10 @@ static void ProximityMine_Player( gentity_t *mine, gentity_t *player ) {
 	mine->enemy = player;
 	mine->think = ProximityMine_ExplodeOnPlayer;
 	if ( player->client->invulnerabilityTime > level.time ) {
-		mine->nextthink = level.time + 2 * 1000;
+		G_SetNextThink( mine, level.time + 2 * 1000 );
 	}
 	else {
-		mine->nextthink = level.time + 10 * 1000;
+		G_SetNextThink( mine, level.time + 10 * 1000 );
 	}
 }
 #endif
@@ -343,7 +343,7 @@ void G_MissileImpact( gentity_t *ent, trace_t *trace ) {
 		G_AddEvent( ent, EV_PROXIMITY_MINE_STICK, trace->surfaceFlags );
 
 		ent->think = ProximityMine_Activate;
-		ent->nextthink = level.time + 2000;
+		G_SetNextThink( ent, level.time + 2000 );
 
 		vectoangles( trace->plane.normal, ent->s.angles );
 		ent->s.angles[0] += 90;
@@ -394,7 +394,7 @@ void G_MissileImpact( gentity_t *ent, trace_t *trace ) {
 		G_SetOrigin( nent, v );
 
 		ent->think = Weapon_HookThink;
-		ent->nextthink = level.time + FRAMETIME;
+		G_SetNextThink( ent, level.time + FRAMETIME );
 
 		ent->parent->client->ps.pm_flags |= PMF_GRAPPLE_PULL;
 		VectorCopy( ent->r.currentOrigin, ent->parent->client->ps.grapplePoint);
@@ -525,7 +525,7 @@ gentity_t *fire_plasma (gentity_t *self, vec3_t start, vec3_t dir) {
 
 	bolt = G_Spawn();
 	bolt->classname = "plasma";
-	bolt->nextthink = level.time + 10000;
+	G_SetNextThink( bolt, level.time + 10000 );
 	bolt->think = G_ExplodeMissile;
 	bolt->s.eType = ET_MISSILE;
 	bolt->r.svFlags = SVF_USE_CURRENT_ORIGIN;
@@ -566,7 +566,7 @@ gentity_t *fire_grenade (gentity_t *self, vec3_t start, vec3_t dir) {
 
 	bolt = G_Spawn();
 	bolt->classname = "grenade";
-	bolt->nextthink = level.time + 2500;
+	G_SetNextThink( bolt, level.time + 2500 );
 	bolt->think = G_ExplodeMissile;
 	bolt->s.eType = ET_MISSILE;
 	bolt->r.svFlags = SVF_USE_CURRENT_ORIGIN;
@@ -608,7 +608,7 @@ gentity_t *fire_bfg (gentity_t *self, vec3_t start, vec3_t dir) {
 
 	bolt = G_Spawn();
 	bolt->classname = "bfg";
-	bolt->nextthink = level.time + 10000;
+	G_SetNextThink( bolt, level.time + 10000 );
 	bolt->think = G_ExplodeMissile;
 	bolt->s.eType = ET_MISSILE;
 	bolt->r.svFlags = SVF_USE_CURRENT_ORIGIN;
@@ -648,7 +648,7 @@ gentity_t *fire_rocket (gentity_t *self, vec3_t start, vec3_t dir) {
 
 	bolt = G_Spawn();
 	bolt->classname = "rocket";
-	bolt->nextthink = level.time + 15000;
+	G_SetNextThink( bolt, level.time + 15000 );
 	bolt->think = G_ExplodeMissile;
 	bolt->s.eType = ET_MISSILE;
 	bolt->r.svFlags = SVF_USE_CURRENT_ORIGIN;
@@ -685,7 +685,7 @@ gentity_t *fire_grapple (gentity_t *self, vec3_t start, vec3_t dir) {
 
 	hook = G_Spawn();
 	hook->classname = "hook";
-	hook->nextthink = level.time + 10000;
+	G_SetNextThink( hook, level.time + 10000 );
 	hook->think = Weapon_HookFree;
 	hook->s.eType = ET_MISSILE;
 	hook->r.svFlags = SVF_USE_CURRENT_ORIGIN;
@@ -726,7 +726,7 @@ gentity_t *fire_nail( gentity_t *self, vec3_t start, vec3_t forward, vec3_t righ
 
 	bolt = G_Spawn();
 	bolt->classname = "nail";
-	bolt->nextthink = level.time + 10000;
+	G_SetNextThink( bolt, level.time + 10000 );
 	bolt->think = G_ExplodeMissile;
 	bolt->s.eType = ET_MISSILE;
 	bolt->r.svFlags = SVF_USE_CURRENT_ORIGIN;
@@ -773,7 +773,7 @@ gentity_t *fire_prox( gentity_t *self, vec3_t start, vec3_t dir ) {
 
 	bolt = G_Spawn();
 	bolt->classname = "prox mine";
-	bolt->nextthink = level.time + 3000;
+	G_SetNextThink( bolt, level.time + 3000 );
 	bolt->think = G_ExplodeMissile;
 	bolt->s.eType = ET_MISSILE;
 	bolt->r.svFlags = SVF_USE_CURRENT_ORIGIN;
@@ -167,6 +167,7 @@ qboolean	G_TryPushingEntity( gentity_t *check, gentity_t *pusher, vec3_t move, v
 	// may have pushed them off an edge
 	if ( check->s.groundEntityNum != pusher->s.number ) {
 		check->s.groundEntityNum = -1;
+		G_ActivateEntity( check );
 	}
 
 	block = G_TestEntityPosition( check );
@@ -192,6 +193,7 @@ qboolean	G_TryPushingEntity( gentity_t *check, gentity_t *pusher, vec3_t move, v
 	block = G_TestEntityPosition (check);
 	if ( !block ) {
 		check->s.groundEntityNum = -1;
+		G_ActivateEntity( check );
 		pushed_p--;
 		return qtrue;
 	}
@@ -541,6 +543,7 @@ void SetMoverState( gentity_t *ent, moverState_t moverState, int time ) {
 	}
 	BG_EvaluateTrajectory( &ent->s.pos, level.time, ent->r.currentOrigin );	
 	trap_LinkEntity( ent );
+	G_ActivateEntity( ent );
 }
 
 /*
@@ -600,7 +603,7 @@ void Reached_BinaryMover( gentity_t *ent ) {
 
 		// return to pos1 after a delay
 		ent->think = ReturnToPos1;
-		ent->nextthink = level.time + ent->wait;
+		G_SetNextThink( ent, level.time + ent->wait );
 
 		// fire targets
 		if ( !ent->activator ) {
@@ -665,7 +668,7 @@ void Use_BinaryMover( gentity_t *ent, gentity_t *other, gentity_t *activator ) {
 
 	// if all the way up, just delay before coming down
 	if ( ent->moverState == MOVER_POS2 ) {
-		ent->nextthink = level.time + ent->wait;
+		G_SetNextThink( ent, level.time + ent->wait );
 		return;
 	}
 
@@ -993,7 +996,7 @@ void SP_func_door (gentity_t *ent) {
 
 	InitMover( ent );
 
-	ent->nextthink = level.time + FRAMETIME;
+	G_SetNextThink( ent, level.time + FRAMETIME );
 
 	if ( ! (ent->flags & FL_TEAMSLAVE ) ) {
 		int health;
@@ -1035,7 +1038,7 @@ void Touch_Plat( gentity_t *ent, gentity_t *other, trace_t *trace ) {
 
 	// delay return-to-pos1 by one second
 	if ( ent->moverState == MOVER_POS2 ) {
-		ent->nextthink = level.time + 1000;
+		G_SetNextThink( ent, level.time + 1000 );
 	}
 }
 
@@ -1316,7 +1319,7 @@ void Reached_Train( gentity_t *ent ) {
 
 	// if there is a "wait" value on the target, don't start moving yet
 	if ( next->wait ) {
-		ent->nextthink = level.time + next->wait * 1000;
+		G_SetNextThink( ent, level.time + next->wait * 1000 );
 		ent->think = Think_BeginMoving;
 		ent->s.pos.trType = TR_STATIONARY;
 	}
@@ -1431,7 +1434,7 @@ void SP_func_train (gentity_t *self) {
 
 	// start trains on the second frame, to make sure their targets have had
 	// a chance to spawn
-	self->nextthink = level.time + FRAMETIME;
+	G_SetNextThink( self, level.time + FRAMETIME );
 	self->think = Think_SetupTrainTargets;
 }
 
@@ -463,6 +463,16 @@ qboolean	ConsoleCommand( void ) {
 		return qtrue;
 	}
 
+	if (Q_stricmp (cmd, "gamespeeds") == 0) {
+		Svcmd_GameSpeeds_f();
+		return qtrue;
+	}
+
+	if (Q_stricmp (cmd, "pmovebench") == 0) {
+		Svcmd_PmoveBench_f();
+		return qtrue;
+	}
+
 	if (Q_stricmp (cmd, "addbot") == 0) {
 		Svcmd_AddBot_f();
 		return qtrue;
@@ -1197,7 +1197,7 @@ Obelisks
 */
 
 static void ObeliskRegen( gentity_t *self ) {
-	self->nextthink = level.time + g_obeliskRegenPeriod.integer * 1000;
+	G_SetNextThink( self, level.time + g_obeliskRegenPeriod.integer * 1000 );
 	if( self->health >= g_obeliskHealth.integer ) {
 		return;
 	}
@@ -1218,7 +1218,7 @@ static void ObeliskRespawn( gentity_t *self ) {
 	self->health = g_obeliskHealth.integer;
 
 	self->think = ObeliskRegen;
-	self->nextthink = level.time + g_obeliskRegenPeriod.integer * 1000;
+	G_SetNextThink( self, level.time + g_obeliskRegenPeriod.integer * 1000 );
 
 	self->activator->s.frame = 0;
 }
@@ -1235,7 +1235,7 @@ static void ObeliskDie( gentity_t *self, gentity_t *inflictor, gentity_t *attack
 
 	self->takedamage = qfalse;
 	self->think = ObeliskRespawn;
-	self->nextthink = level.time + g_obeliskRespawnDelay.integer * 1000;
+	G_SetNextThink( self, level.time + g_obeliskRespawnDelay.integer * 1000 );
 
 	self->activator->s.modelindex2 = 0xff;
 	self->activator->s.frame = 2;
@@ -1328,7 +1328,7 @@ gentity_t *SpawnObelisk( vec3_t origin, int team, int spawnflags) {
 		ent->die = ObeliskDie;
 		ent->pain = ObeliskPain;
 		ent->think = ObeliskRegen;
-		ent->nextthink = level.time + g_obeliskRegenPeriod.integer * 1000;
+		G_SetNextThink( ent, level.time + g_obeliskRegenPeriod.integer * 1000 );
 	}
 	if( g_gametype.integer == GT_HARVESTER ) {
 		ent->r.contents = CONTENTS_TRIGGER;
@@ -35,7 +35,7 @@ void InitTrigger( gentity_t *self ) {
 
 // the wait time has passed, so set back up for another activation
 void multi_wait( gentity_t *ent ) {
-	ent->nextthink = 0;
+	G_SetNextThink( ent, 0 );
 }
 
 
@@ -63,12 +63,12 @@ void multi_trigger( gentity_t *ent, gentity_t *activator ) {
 
 	if ( ent->wait > 0 ) {
 		ent->think = multi_wait;
-		ent->nextthink = level.time + ( ent->wait + ent->random * crandom() ) * 1000;
+		G_SetNextThink( ent, level.time + ( ent->wait + ent->random * crandom() ) * 1000 );
 	} else {
 		// we can't just remove (self) here, because this is a touch function
 		// called while looping through area links...
 		ent->touch = 0;
-		ent->nextthink = level.time + FRAMETIME;
+		G_SetNextThink( ent, level.time + FRAMETIME );
 		ent->think = G_FreeEntity;
 	}
 }
@@ -127,7 +127,7 @@ This trigger will always fire.  It is activated by the world.
 */
 void SP_trigger_always (gentity_t *ent) {
 	// we must have some delay to make sure our use targets are present
-	ent->nextthink = level.time + 300;
+	G_SetNextThink( ent, level.time + 300 );
 	ent->think = trigger_always_think;
 }
 
@@ -208,7 +208,7 @@ void SP_trigger_push( gentity_t *self ) {
 	self->s.eType = ET_PUSH_TRIGGER;
 	self->touch = trigger_push_touch;
 	self->think = AimAtTarget;
-	self->nextthink = level.time + FRAMETIME;
+	G_SetNextThink( self, level.time + FRAMETIME );
 	trap_LinkEntity (self);
 }
 
@@ -255,7 +255,7 @@ void SP_target_push( gentity_t *self ) {
 		VectorCopy( self->s.origin, self->r.absmin );
 		VectorCopy( self->s.origin, self->r.absmax );
 		self->think = AimAtTarget;
-		self->nextthink = level.time + FRAMETIME;
+		G_SetNextThink( self, level.time + FRAMETIME );
 	}
 	self->use = Use_target_push;
 }
@@ -426,7 +426,7 @@ so, the basic time between firing is a random time between
 void func_timer_think( gentity_t *self ) {
 	G_UseTargets (self, self->activator);
 	// set time before next firing
-	self->nextthink = level.time + 1000 * ( self->wait + crandom() * self->random );
+	G_SetNextThink( self, level.time + 1000 * ( self->wait + crandom() * self->random ) );
 }
 
 void func_timer_use( gentity_t *self, gentity_t *other, gentity_t *activator ) {
@@ -434,7 +434,7 @@ void func_timer_use( gentity_t *self, gentity_t *other, gentity_t *activator ) {
 
 	// if on, turn it off
 	if ( self->nextthink ) {
-		self->nextthink = 0;
+		G_SetNextThink( self, 0 );
 		return;
 	}
 
@@ -455,7 +455,7 @@ void SP_func_timer( gentity_t *self ) {
 	}
 
 	if ( self->spawnflags & 1 ) {
-		self->nextthink = level.time + FRAMETIME;
+		G_SetNextThink( self, level.time + FRAMETIME );
 		self->activator = self;
 	}
 
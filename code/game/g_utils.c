@@ -364,11 +364,171 @@ float vectoyaw( const vec3_t vec ) {
 }
 
 
+/*
+==============================================================================
+
+THINK SCHEDULING
+
+Entities that are only waiting for their nextthink are left out of the
+G_RunFrame loop.  Their thinks sit on a timing wheel: near slots cover
+one 16 msec tick each, far slots cover a whole revolution of the near
+wheel and are moved down when it comes around, and anything further out
+waits on the later list.  An entity whose think comes due is marked
+active, and G_RunFrame visits active entities in entity number order,
+just as the full scan did.
+
+==============================================================================
+*/
+
+/*
+=================
+G_ActivateEntity
+
+Makes G_RunFrame visit the entity until it has nothing left to do every frame
+=================
+*/
+void G_ActivateEntity( gentity_t *ent ) {
+	int		num;
+
+	num = ent - g_entities;
+	level.activeEntities[ num >> 5 ] |= 1 << ( num & 31 );
+}
+
+/*
+=================
+G_UnscheduleThink
+=================
+*/
+static void G_UnscheduleThink( gentity_t *ent ) {
+	if ( !ent->thinkPrev ) {
+		return;
+	}
+	*ent->thinkPrev = ent->thinkNext;
+	if ( ent->thinkNext ) {
+		ent->thinkNext->thinkPrev = ent->thinkPrev;
+	}
+	ent->thinkNext = NULL;
+	ent->thinkPrev = NULL;
+}
+
+/*
+=================
+G_ScheduleThink
+
+Puts the entity in the wheel slot for its nextthink
+=================
+*/
+static void G_ScheduleThink( gentity_t *ent ) {
+	gentity_t	**slot;
+	int			tick;
+
+	tick = ent->nextthink >> THINK_TICK_SHIFT;
+	if ( tick < level.thinkTick + THINK_WHEEL_SIZE ) {
+		if ( tick < level.thinkTick ) {
+			tick = level.thinkTick;		// overdue
+		}
+		slot = &level.thinkNear[ tick & THINK_WHEEL_MASK ];
+	} else if ( ( tick >> THINK_WHEEL_BITS ) - ( level.thinkTick >> THINK_WHEEL_BITS ) < THINK_WHEEL_SIZE ) {
+		slot = &level.thinkFar[ ( tick >> THINK_WHEEL_BITS ) & THINK_WHEEL_MASK ];
+	} else {
+		slot = &level.thinkLater;
+	}
+
+	ent->thinkNext = *slot;
+	if ( ent->thinkNext ) {
+		ent->thinkNext->thinkPrev = &ent->thinkNext;
+	}
+	ent->thinkPrev = slot;
+	*slot = ent;
+}
+
+/*
+=================
+G_SetNextThink
+
+All nextthink changes go through here, 0 cancels the think
+=================
+*/
+void G_SetNextThink( gentity_t *ent, int time ) {
+	G_UnscheduleThink( ent );
+	ent->nextthink = time;
+	if ( time <= 0 ) {
+		return;
+	}
+	G_ScheduleThink( ent );
+
+	// a think that is already due still runs this frame
+	// if the entity comes later in the G_RunFrame loop
+	if ( time <= level.time ) {
+		G_ActivateEntity( ent );
+	}
+}
+
+/*
+=================
+G_RescheduleThinks
+
+Empties a wheel slot back into the wheel, which has moved on since
+=================
+*/
+static void G_RescheduleThinks( gentity_t **slot ) {
+	gentity_t	*ent, *next;
+
+	ent = *slot;
+	*slot = NULL;
+	for ( ; ent ; ent = next ) {
+		next = ent->thinkNext;
+		ent->thinkNext = NULL;
+		ent->thinkPrev = NULL;
+		G_ScheduleThink( ent );
+	}
+}
+
+/*
+=================
+G_RunThinkWheel
+
+Turns the wheel up to level.time and activates every entity whose think is due
+=================
+*/
+void G_RunThinkWheel( void ) {
+	gentity_t	*ent, *next;
+	int			tick;
+
+	tick = level.time >> THINK_TICK_SHIFT;
+
+	while ( 1 ) {
+		// the current slot can also hold thinks due later in the tick
+		for ( ent = level.thinkNear[ level.thinkTick & THINK_WHEEL_MASK ] ; ent ; ent = next ) {
+			next = ent->thinkNext;
+			if ( ent->nextthink <= level.time ) {
+				G_UnscheduleThink( ent );
+				G_ActivateEntity( ent );
+			}
+		}
+
+		if ( level.thinkTick >= tick ) {
+			break;
+		}
+		level.thinkTick++;
+
+		// coming around to a new far slot, move it down to the near wheel
+		if ( !( level.thinkTick & THINK_WHEEL_MASK ) ) {
+			if ( !( ( level.thinkTick >> THINK_WHEEL_BITS ) & THINK_WHEEL_MASK ) ) {
+				G_RescheduleThinks( &level.thinkLater );
+			}
+			G_RescheduleThinks( &level.thinkFar[ ( level.thinkTick >> THINK_WHEEL_BITS ) & THINK_WHEEL_MASK ] );
+		}
+	}
+}
+
+
 void G_InitGentity( gentity_t *e ) {
 	e->inuse = qtrue;
 	e->classname = "noclass";
 	e->s.number = e - g_entities;
 	e->r.ownerNum = ENTITYNUM_NONE;
+	G_ActivateEntity( e );
 }
 
 /*
@@ -468,6 +628,8 @@ void G_FreeEntity( gentity_t *ed ) {
 		return;
 	}
 
+	G_SetNextThink( ed, 0 );
+
 	memset (ed, 0, sizeof(*ed));
 	ed->classname = "freed";
 	ed->freetime = level.time;
@@ -593,6 +755,7 @@ void G_AddEvent( gentity_t *ent, int event, int eventParm ) {
 		ent->s.eventParm = eventParm;
 	}
 	ent->eventTime = level.time;
+	G_ActivateEntity( ent );
 }
 
 
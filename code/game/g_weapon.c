@@ -804,12 +804,211 @@ void CalcMuzzlePointOrigin ( gentity_t *ent, vec3_t origin, vec3_t forward, vec3
 
 
 
+/*
+======================================================================
+
+LAG COMPENSATION
+
+Hitscan weapons trace against the other clients moved back to where
+they were at the shooter's commandTime, so players don't have to lead
+targets by their ping.  Positions come from a ring of samples taken at
+the end of every frame, so a rewind is a couple of array lookups per
+target and never allocates.
+
+======================================================================
+*/
+
+typedef struct {
+	qboolean	rewound;
+	vec3_t		origin;					// current state to put back
+	vec3_t		mins, maxs;
+	vec3_t		rewoundMins, rewoundMaxs;	// to tell if the game resized a dying client
+} clientRewind_t;
+
+static clientRewind_t	clientRewind[MAX_CLIENTS];
+
+/*
+================
+G_StoreClientHistory
+
+Called at the end of every frame
+================
+*/
+void G_StoreClientHistory( gentity_t *ent ) {
+	gclient_t		*client;
+	clientHistory_t	*sample;
+
+	client = ent->client;
+	client->historyHead = ( client->historyHead + 1 ) & CLIENT_HISTORY_MASK;
+	sample = &client->history[client->historyHead];
+
+	sample->time = level.time;
+	VectorCopy( ent->r.currentOrigin, sample->origin );
+	VectorCopy( ent->r.mins, sample->mins );
+	VectorCopy( ent->r.maxs, sample->maxs );
+	sample->teleportBit = client->ps.eFlags & EF_TELEPORT_BIT;
+}
+
+/*
+================
+G_ClientHistoryAtTime
+
+Returns qfalse if the client should be left where it is
+================
+*/
+static qboolean G_ClientHistoryAtTime( gclient_t *client, int time, vec3_t origin, vec3_t mins, vec3_t maxs ) {
+	clientHistory_t	*older, *newer;
+	int				frameMsec, back, steps;
+	float			frac;
+
+	newer = &client->history[client->historyHead];
+	if ( !newer->time || time >= newer->time ) {
+		return qfalse;
+	}
+
+	// samples are a frame apart, so the one just before time can be
+	// found directly, a changed sv_fps only puts the guess off a slot
+	frameMsec = level.time - level.previousTime;
+	if ( frameMsec < 1 ) {
+		frameMsec = 1;
+	}
+	back = ( newer->time - time + frameMsec - 1 ) / frameMsec;
+	if ( back > MAX_CLIENT_HISTORY - 1 ) {
+		back = MAX_CLIENT_HISTORY - 1;
+	}
+	for ( steps = 0 ; steps < 2 ; steps++ ) {
+		older = &client->history[( client->historyHead - back ) & CLIENT_HISTORY_MASK];
+		if ( older->time > time && back < MAX_CLIENT_HISTORY - 1 ) {
+			back++;
+		} else if ( back > 1 && client->history[( client->historyHead - back + 1 ) & CLIENT_HISTORY_MASK].time <= time ) {
+			back--;
+		} else {
+			break;
+		}
+	}
+
+	// spawned more recently than time, use the oldest position there is,
+	// the slots before it have never been written
+	while ( back > 0 && !client->history[( client->historyHead - back ) & CLIENT_HISTORY_MASK].time ) {
+		back--;
+	}
+	older = &client->history[( client->historyHead - back ) & CLIENT_HISTORY_MASK];
+	if ( back > 0 ) {
+		newer = &client->history[( client->historyHead - back + 1 ) & CLIENT_HISTORY_MASK];
+	} else {
+		newer = older;
+	}
+
+	VectorCopy( older->mins, mins );
+	VectorCopy( older->maxs, maxs );
+
+	if ( older == newer || older->time >= time || newer->time <= older->time
+		|| older->teleportBit != newer->teleportBit ) {
+		VectorCopy( older->origin, origin );
+		return qtrue;
+	}
+
+	frac = (float)( time - older->time ) / ( newer->time - older->time );
+	origin[0] = older->origin[0] + frac * ( newer->origin[0] - older->origin[0] );
+	origin[1] = older->origin[1] + frac * ( newer->origin[1] - older->origin[1] );
+	origin[2] = older->origin[2] + frac * ( newer->origin[2] - older->origin[2] );
+	return qtrue;
+}
+
+/*
+================
+G_RewindClients
+
+Moves everyone but the attacker back to the attacker's commandTime
+================
+*/
+static void G_RewindClients( gentity_t *attacker ) {
+	int				i, time;
+	gentity_t		*ent;
+	clientRewind_t	*rewind;
+	vec3_t			origin, mins, maxs;
+
+	if ( !g_lagCompensation.integer || ( attacker->r.svFlags & SVF_BOT ) ) {
+		return;
+	}
+
+	time = attacker->client->ps.commandTime;
+
+	for ( i = 0 ; i < level.maxclients ; i++ ) {
+		ent = &g_entities[i];
+		rewind = &clientRewind[i];
+
+		if ( ent == attacker || !ent->inuse || !ent->r.linked ) {
+			continue;
+		}
+		if ( ent->client->pers.connected != CON_CONNECTED ) {
+			continue;
+		}
+		if ( !G_ClientHistoryAtTime( ent->client, time, origin, mins, maxs ) ) {
+			continue;
+		}
+
+		rewind->rewound = qtrue;
+		VectorCopy( ent->r.currentOrigin, rewind->origin );
+		VectorCopy( ent->r.mins, rewind->mins );
+		VectorCopy( ent->r.maxs, rewind->maxs );
+		VectorCopy( mins, rewind->rewoundMins );
+		VectorCopy( maxs, rewind->rewoundMaxs );
+
+		VectorCopy( origin, ent->r.currentOrigin );
+		VectorCopy( mins, ent->r.mins );
+		VectorCopy( maxs, ent->r.maxs );
+		trap_LinkEntity( ent );
+	}
+}
+
+/*
+================
+G_RestoreClients
+
+Undoes G_RewindClients
+================
+*/
+static void G_RestoreClients( void ) {
+	int				i;
+	gentity_t		*ent;
+	clientRewind_t	*rewind;
+
+	for ( i = 0 ; i < level.maxclients ; i++ ) {
+		rewind = &clientRewind[i];
+		if ( !rewind->rewound ) {
+			continue;
+		}
+		rewind->rewound = qfalse;
+
+		ent = &g_entities[i];
+		if ( !ent->inuse ) {
+			continue;
+		}
+
+		VectorCopy( rewind->origin, ent->r.currentOrigin );
+		// a client killed by the shot has already been given its corpse bounds
+		if ( VectorCompare( ent->r.mins, rewind->rewoundMins ) && VectorCompare( ent->r.maxs, rewind->rewoundMaxs ) ) {
+			VectorCopy( rewind->mins, ent->r.mins );
+			VectorCopy( rewind->maxs, ent->r.maxs );
+		}
+		if ( ent->r.linked ) {
+			trap_LinkEntity( ent );
+		}
+	}
+}
+
+//======================================================================
+
+
 /*
 ===============
 FireWeapon
 ===============
 */
 void FireWeapon( gentity_t *ent ) {
+	qboolean	hitscan;
+
 	if (ent->client->ps.powerups[PW_QUAD] ) {
 		s_quadFactor = g_quadfactor.value;
 	} else {
@@ -839,6 +1038,15 @@ void FireWeapon( gentity_t *ent ) {
 
 	CalcMuzzlePointOrigin ( ent, ent->client->oldOrigin, forward, right, up, muzzle );
 
+	hitscan = ( ent->s.weapon == WP_MACHINEGUN || ent->s.weapon == WP_SHOTGUN
+		|| ent->s.weapon == WP_LIGHTNING || ent->s.weapon == WP_RAILGUN );
+#ifdef MISSIONPACK
+	hitscan |= ( ent->s.weapon == WP_CHAINGUN );
+#endif
+	if ( hitscan ) {
+		G_RewindClients( ent );
+	}
+
 	// fire the specific weapon
 	switch( ent->s.weapon ) {
 	case WP_GAUNTLET:
@@ -890,6 +1098,9 @@ void FireWeapon( gentity_t *ent ) {
 // FIXME		G_Error( "Bad ent->s.weapon" );
 		break;
 	}
+	if ( hitscan ) {
+		G_RestoreClients();
+	}
 }
 
 
@@ -1056,7 +1267,7 @@ static void KamikazeDamage( gentity_t *self ) {
 		G_FreeEntity( self );
 		return;
 	}
-	self->nextthink = level.time + 100;
+	G_SetNextThink( self, level.time + 100 );
 
 	// add earth quake effect
 	newangles[0] = crandom() * 2;
@@ -1114,7 +1325,7 @@ void G_StartKamikaze( gentity_t *ent ) {
 	explosion->kamikazeTime = level.time;
 
 	explosion->think = KamikazeDamage;
-	explosion->nextthink = level.time + 100;
+	G_SetNextThink( explosion, level.time + 100 );
 	explosion->count = 0;
 	VectorClear(explosion->movedir);
 
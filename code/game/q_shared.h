@@ -116,6 +116,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define idppc_altivec 0
 #endif
 
+#if (defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)) && !defined(C_ONLY)
+#define idsse2	1
+#else
+#define idsse2	0
+#endif
+
 // for windows fastcall option
 
 #define	QDECL
@@ -22,6 +22,10 @@
 
 #include "../renderer/tr_local.h"
 
+/* image prefetch jobs decode on worker threads out of their own arena */
+extern void *R_JpegJobAlloc (j_common_ptr cinfo, size_t sizeofobject);
+extern boolean R_JpegJobOwns (j_common_ptr cinfo);
+
 /*
  * Memory allocation and ri.Freeing are controlled by the regular library
  * routines ri.Malloc() and ri.Free().
@@ -30,12 +34,16 @@
 GLOBAL void *
 jpeg_get_small (j_common_ptr cinfo, size_t sizeofobject)
 {
+  if (R_JpegJobOwns(cinfo))
+    return (void *) R_JpegJobAlloc(cinfo, sizeofobject);
   return (void *) ri.Malloc(sizeofobject);
 }
 
 GLOBAL void
 jpeg_free_small (j_common_ptr cinfo, void * object, size_t sizeofobject)
 {
+  if (R_JpegJobOwns(cinfo))
+    return;			/* released with the job's arena */
   ri.Free(object);
 }
 
@@ -50,12 +58,16 @@ jpeg_free_small (j_common_ptr cinfo, void * object, size_t sizeofobject)
 GLOBAL void FAR *
 jpeg_get_large (j_common_ptr cinfo, size_t sizeofobject)
 {
+  if (R_JpegJobOwns(cinfo))
+    return (void FAR *) R_JpegJobAlloc(cinfo, sizeofobject);
   return (void FAR *) ri.Malloc(sizeofobject);
 }
 
 GLOBAL void
 jpeg_free_large (j_common_ptr cinfo, void FAR * object, size_t sizeofobject)
 {
+  if (R_JpegJobOwns(cinfo))
+    return;			/* released with the job's arena */
   ri.Free(object);
 }
 
@@ -44,3 +44,12 @@ void GLimp_WakeRenderer( void *data )
     
 }
 
+
+// No worker threads here, the front end jobs run in order on the calling thread
+void GLimp_RunFrontEndJobs( void (*job)( int index ), int count, int numThreads )
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        job(i);
+}
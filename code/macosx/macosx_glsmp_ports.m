@@ -423,3 +423,12 @@ void GLimp_WakeRenderer( void *data )
 
     GLSTAMP("GLimp_WakeRenderer end", 1);
 }
+
+// No worker threads here, the front end jobs run in order on the calling thread
+void GLimp_RunFrontEndJobs( void (*job)( int index ), int count, int numThreads )
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        job(i);
+}
@@ -35,13 +35,35 @@ void ( * qglUnlockArraysEXT) ( void );
 void		GLimp_EndFrame( void ) {
 }
 
-int 		GLimp_Init( void )
-{
+void		GLimp_Init( void ) {
+	// a screen size for the front end to work with
+	glConfig.vidWidth = 640;
+	glConfig.vidHeight = 480;
+	glConfig.windowAspect = 640.0f / 480.0f;
+	glConfig.colorBits = 32;
+	glConfig.depthBits = 24;
+	glConfig.maxTextureSize = 2048;
+	glConfig.maxActiveTextures = 1;
 }
 
 void		GLimp_Shutdown( void ) {
 }
 
+/*
+=======================
+GLimp_RunFrontEndJobs
+
+No worker threads here, the jobs run in order on the calling thread
+=======================
+*/
+void GLimp_RunFrontEndJobs( void (*job)( int index ), int count, int numThreads ) {
+	int		i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		job( i );
+	}
+}
+
 void		GLimp_EnableLogging( qboolean enable ) {
 }
 
@@ -62,6 +62,8 @@ byte		*cmod_base;
 cvar_t		*cm_noAreas;
 cvar_t		*cm_noCurves;
 cvar_t		*cm_playerCurveClip;
+cvar_t		*cm_patchBVH;
+cvar_t		*cm_leafGrid;
 #endif
 
 cmodel_t	box_model;
@@ -302,6 +304,9 @@ void CMod_LoadLeafs (lump_t *l)
 
 	cm.areas = Hunk_Alloc( cm.numAreas * sizeof( *cm.areas ), h_high );
 	cm.areaPortals = Hunk_Alloc( cm.numAreas * cm.numAreas * sizeof( *cm.areaPortals ), h_high );
+	cm.floodSizes = Hunk_Alloc( ( cm.numAreas + 1 ) * sizeof( *cm.floodSizes ), h_high );
+	cm.areaBits = Hunk_Alloc( cm.numAreas * ( ( cm.numAreas + 7 ) >> 3 ), h_high );
+	cm.areaBitsGeneration = Hunk_Alloc( cm.numAreas * sizeof( *cm.areaBitsGeneration ), h_high );
 }
 
 /*
@@ -572,6 +577,9 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	dheader_t		header;
 	int				length;
 	static unsigned	last_checksum;
+#ifndef BSPC
+	static qboolean	commandsAdded;
+#endif
 
 	if ( !name || !name[0] ) {
 		Com_Error( ERR_DROP, "CM_LoadMap: NULL name" );
@@ -581,6 +589,12 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	cm_noAreas = Cvar_Get ("cm_noAreas", "0", CVAR_CHEAT);
 	cm_noCurves = Cvar_Get ("cm_noCurves", "0", CVAR_CHEAT);
 	cm_playerCurveClip = Cvar_Get ("cm_playerCurveClip", "1", CVAR_ARCHIVE|CVAR_CHEAT );
+	cm_patchBVH = Cvar_Get ("cm_patchBVH", "1", CVAR_CHEAT);
+	cm_leafGrid = Cvar_Get ("cm_leafGrid", "1", 0);
+	if ( !commandsAdded ) {
+		Cmd_AddCommand( "patchbench", CM_PatchBench_f );
+		commandsAdded = qtrue;
+	}
 #endif
 	Com_DPrintf( "CM_LoadMap( %s, %i )\n", name, clientload );
 
@@ -649,6 +663,8 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 
 	CM_InitBoxHull ();
 
+	CM_InitLeafGrid ();
+
 	CM_FloodAreaConnections ();
 
 	// allow this to be cached if it is loaded by the server
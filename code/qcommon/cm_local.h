@@ -125,7 +125,17 @@ typedef struct {
 	cPatch_t	**surfaces;			// non-patches will be NULL
 
 	int			floodvalid;
+	int			floodGeneration;			// incremented when the floods change
+	int			*floodSizes;				// [ numAreas+1 ] areas in each flood
+	byte		*areaBits;					// [ numAreas*areaBytes ] cached CM_WriteAreaBits
+	int			*areaBitsGeneration;		// floodGeneration each areaBits row was written at
 	int			checkcount;					// incremented on each trace
+
+	int			*leafGrid;					// node, or -1-leaf, each grid cell lies entirely under
+	vec3_t		leafGridMins;
+	vec3_t		leafGridMaxs;
+	int			leafGridSize[3];			// cells along each axis
+	float		leafGridScale;				// 1 / cell size
 } clipMap_t;
 
 
@@ -139,9 +149,13 @@ extern	int			c_traces, c_brush_traces, c_patch_traces;
 extern	cvar_t		*cm_noAreas;
 extern	cvar_t		*cm_noCurves;
 extern	cvar_t		*cm_playerCurveClip;
+extern	cvar_t		*cm_patchBVH;
+extern	cvar_t		*cm_leafGrid;
 
 // cm_test.c
 
+void CM_InitLeafGrid( void );
+
 // Used for oriented capsule collision detection
 typedef struct
 {
@@ -192,3 +206,9 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 void CM_ClearLevelPatches( void );
+
+extern	qboolean	cm_forceFacetScan;
+
+// cm_trace.c
+
+void CM_PatchBench_f( void );
@@ -89,6 +89,8 @@ static const facet_t		*debugFacet;
 static qboolean		debugBlock;
 static vec3_t		debugBlockPoints[4];
 
+qboolean			cm_forceFacetScan;	// patchbench compares against the full facet scan
+
 /*
 =================
 CM_ClearLevelPatches
@@ -1135,6 +1137,118 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 }
 
 
+/*
+================================================================================
+
+FACET HIERARCHY
+
+================================================================================
+*/
+
+static vec3_t		facetBounds[MAX_FACETS][2];
+static facetNode_t	facetNodes[MAX_FACETS*2];
+static int			numFacetNodes;
+
+/*
+==================
+CM_FacetBounds
+
+The axial bevels keep every facet inside the bounds of its winding
+==================
+*/
+static void CM_FacetBounds( const patchCollide_t *pf, const facet_t *facet, vec3_t mins, vec3_t maxs ) {
+	int			j;
+	float		plane[4];
+	winding_t	*w;
+
+	Vector4Copy( pf->planes[ facet->surfacePlane ].plane, plane );
+
+	w = BaseWindingForPlane( plane, plane[3] );
+	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
+		if (facet->borderPlanes[j] == facet->surfacePlane) continue;
+		Vector4Copy( pf->planes[ facet->borderPlanes[j] ].plane, plane );
+
+		if ( !facet->borderInward[j] ) {
+			VectorSubtract( vec3_origin, plane, plane );
+			plane[3] = -plane[3];
+		}
+
+		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
+	}
+	if ( !w ) {
+		// no bevels were added for it, so only the patch bounds hold
+		VectorCopy( pf->bounds[0], mins );
+		VectorCopy( pf->bounds[1], maxs );
+		return;
+	}
+
+	WindingBounds( w, mins, maxs );
+	FreeWinding( w );
+
+	for ( j = 0 ; j < 3 ; j++ ) {
+		mins[j] -= FACET_BOUNDS_EPSILON;
+		maxs[j] += FACET_BOUNDS_EPSILON;
+	}
+}
+
+/*
+==================
+CM_FacetNodes_r
+
+Splits a run of facets in half, which follows the grid
+the facets were generated from
+==================
+*/
+static void CM_FacetNodes_r( int firstFacet, int numFacets ) {
+	facetNode_t	*node;
+	int			i, half;
+
+	node = &facetNodes[numFacetNodes++];
+	node->firstFacet = firstFacet;
+
+	ClearBounds( node->bounds[0], node->bounds[1] );
+	for ( i = firstFacet ; i < firstFacet + numFacets ; i++ ) {
+		AddPointToBounds( facetBounds[i][0], node->bounds[0], node->bounds[1] );
+		AddPointToBounds( facetBounds[i][1], node->bounds[0], node->bounds[1] );
+	}
+
+	if ( numFacets <= FACET_LEAF_SIZE ) {
+		node->numFacets = numFacets;
+	} else {
+		node->numFacets = 0;
+		half = numFacets >> 1;
+		CM_FacetNodes_r( firstFacet, half );
+		CM_FacetNodes_r( firstFacet + half, numFacets - half );
+	}
+	node->skip = numFacetNodes;
+}
+
+/*
+==================
+CM_PatchCollideNodes
+==================
+*/
+static void CM_PatchCollideNodes( patchCollide_t *pf ) {
+	int		i;
+
+	pf->numNodes = 0;
+	pf->nodes = NULL;
+	if ( !pf->numFacets ) {
+		return;
+	}
+
+	for ( i = 0 ; i < pf->numFacets ; i++ ) {
+		CM_FacetBounds( pf, &pf->facets[i], facetBounds[i][0], facetBounds[i][1] );
+	}
+
+	numFacetNodes = 0;
+	CM_FacetNodes_r( 0, pf->numFacets );
+
+	pf->numNodes = numFacetNodes;
+	pf->nodes = Hunk_Alloc( numFacetNodes * sizeof( *pf->nodes ), h_high );
+	Com_Memcpy( pf->nodes, facetNodes, numFacetNodes * sizeof( *pf->nodes ) );
+}
+
 /*
 ===================
 CM_GeneratePatchCollide
@@ -1210,6 +1324,8 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 	pf->bounds[1][1] += 1;
 	pf->bounds[1][2] += 1;
 
+	CM_PatchCollideNodes( pf );
+
 	return pf;
 }
 
@@ -1371,34 +1487,65 @@ int CM_CheckFacetPlane(float *plane, vec3_t start, vec3_t end, float *enterFrac,
 
 /*
 ====================
-CM_TraceThroughPatchCollide
+CM_TraceThroughFacet
 ====================
 */
-void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
-	int i, j, hit, hitnum;
+static void CM_TraceThroughFacet( traceWork_t *tw, const patchCollide_t *pc, const facet_t *facet ) {
+	int j, hit, hitnum;
 	float offset, enterFrac, leaveFrac, t;
 	patchPlane_t *planes;
-	facet_t	*facet;
 	float plane[4], bestplane[4];
 	vec3_t startp, endp;
 #ifndef BSPC
 	static cvar_t *cv;
 #endif //BSPC
 
-	if (tw->isPoint) {
-		CM_TracePointThroughPatchCollide( tw, pc );
+	enterFrac = -1.0;
+	leaveFrac = 1.0;
+	hitnum = -1;
+	//
+	planes = &pc->planes[ facet->surfacePlane ];
+	VectorCopy(planes->plane, plane);
+	plane[3] = planes->plane[3];
+	if ( tw->sphere.use ) {
+		// adjust the plane distance apropriately for radius
+		plane[3] += tw->sphere.radius;
+
+		// find the closest point on the capsule to the plane
+		t = DotProduct( plane, tw->sphere.offset );
+		if ( t > 0.0f ) {
+			VectorSubtract( tw->start, tw->sphere.offset, startp );
+			VectorSubtract( tw->end, tw->sphere.offset, endp );
+		}
+		else {
+			VectorAdd( tw->start, tw->sphere.offset, startp );
+			VectorAdd( tw->end, tw->sphere.offset, endp );
+		}
+	}
+	else {
+		offset = DotProduct( tw->offsets[ planes->signbits ], plane);
+		plane[3] -= offset;
+		VectorCopy( tw->start, startp );
+		VectorCopy( tw->end, endp );
+	}
+
+	if (!CM_CheckFacetPlane(plane, startp, endp, &enterFrac, &leaveFrac, &hit)) {
 		return;
 	}
+	if (hit) {
+		Vector4Copy(plane, bestplane);
+	}
 
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
-		enterFrac = -1.0;
-		leaveFrac = 1.0;
-		hitnum = -1;
-		//
-		planes = &pc->planes[ facet->surfacePlane ];
-		VectorCopy(planes->plane, plane);
-		plane[3] = planes->plane[3];
+	for ( j = 0; j < facet->numBorders; j++ ) {
+		planes = &pc->planes[ facet->borderPlanes[j] ];
+		if (facet->borderInward[j]) {
+			VectorNegate(planes->plane, plane);
+			plane[3] = -planes->plane[3];
+		}
+		else {
+			VectorCopy(planes->plane, plane);
+			plane[3] = planes->plane[3];
+		}
 		if ( tw->sphere.use ) {
 			// adjust the plane distance apropriately for radius
 			plane[3] += tw->sphere.radius;
@@ -1415,84 +1562,108 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 			}
 		}
 		else {
+			// NOTE: this works even though the plane might be flipped because the bbox is centered
 			offset = DotProduct( tw->offsets[ planes->signbits ], plane);
-			plane[3] -= offset;
+			plane[3] += fabs(offset);
 			VectorCopy( tw->start, startp );
 			VectorCopy( tw->end, endp );
 		}
 
 		if (!CM_CheckFacetPlane(plane, startp, endp, &enterFrac, &leaveFrac, &hit)) {
-			continue;
+			return;
 		}
 		if (hit) {
+			hitnum = j;
 			Vector4Copy(plane, bestplane);
 		}
+	}
+	//never clip against the back side
+	if (hitnum == facet->numBorders - 1) return;
 
-		for ( j = 0; j < facet->numBorders; j++ ) {
-			planes = &pc->planes[ facet->borderPlanes[j] ];
-			if (facet->borderInward[j]) {
-				VectorNegate(planes->plane, plane);
-				plane[3] = -planes->plane[3];
+	if (enterFrac < leaveFrac && enterFrac >= 0) {
+		if (enterFrac < tw->trace.fraction) {
+			if (enterFrac < 0) {
+				enterFrac = 0;
 			}
-			else {
-				VectorCopy(planes->plane, plane);
-				plane[3] = planes->plane[3];
-			}
-			if ( tw->sphere.use ) {
-				// adjust the plane distance apropriately for radius
-				plane[3] += tw->sphere.radius;
-
-				// find the closest point on the capsule to the plane
-				t = DotProduct( plane, tw->sphere.offset );
-				if ( t > 0.0f ) {
-					VectorSubtract( tw->start, tw->sphere.offset, startp );
-					VectorSubtract( tw->end, tw->sphere.offset, endp );
-				}
-				else {
-					VectorAdd( tw->start, tw->sphere.offset, startp );
-					VectorAdd( tw->end, tw->sphere.offset, endp );
-				}
+#ifndef BSPC
+			if (!cv) {
+				cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
 			}
-			else {
-				// NOTE: this works even though the plane might be flipped because the bbox is centered
-				offset = DotProduct( tw->offsets[ planes->signbits ], plane);
-				plane[3] += fabs(offset);
-				VectorCopy( tw->start, startp );
-				VectorCopy( tw->end, endp );
+			if (cv && cv->integer) {
+				debugPatchCollide = pc;
+				debugFacet = facet;
 			}
+#endif //BSPC
 
-			if (!CM_CheckFacetPlane(plane, startp, endp, &enterFrac, &leaveFrac, &hit)) {
-				break;
-			}
-			if (hit) {
-				hitnum = j;
-				Vector4Copy(plane, bestplane);
-			}
+			tw->trace.fraction = enterFrac;
+			VectorCopy( bestplane, tw->trace.plane.normal );
+			tw->trace.plane.dist = bestplane[3];
 		}
-		if (j < facet->numBorders) continue;
-		//never clip against the back side
-		if (hitnum == facet->numBorders - 1) continue;
+	}
+}
 
-		if (enterFrac < leaveFrac && enterFrac >= 0) {
-			if (enterFrac < tw->trace.fraction) {
-				if (enterFrac < 0) {
-					enterFrac = 0;
-				}
+/*
+====================
+CM_UseFacetNodes
+====================
+*/
+static qboolean CM_UseFacetNodes( const patchCollide_t *pc ) {
+	if ( !pc->nodes ) {
+		return qfalse;
+	}
 #ifndef BSPC
-				if (!cv) {
-					cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-				}
-				if (cv && cv->integer) {
-					debugPatchCollide = pc;
-					debugFacet = facet;
-				}
+	if ( cm_forceFacetScan || ( cm_patchBVH && !cm_patchBVH->integer ) ) {
+		return qfalse;
+	}
 #endif //BSPC
+	return qtrue;
+}
 
-				tw->trace.fraction = enterFrac;
-				VectorCopy( bestplane, tw->trace.plane.normal );
-				tw->trace.plane.dist = bestplane[3];
-			}
+/*
+====================
+CM_TraceMissesNode
+====================
+*/
+static qboolean CM_TraceMissesNode( const traceWork_t *tw, const facetNode_t *node ) {
+	return tw->bounds[0][0] > node->bounds[1][0]
+		|| tw->bounds[0][1] > node->bounds[1][1]
+		|| tw->bounds[0][2] > node->bounds[1][2]
+		|| tw->bounds[1][0] < node->bounds[0][0]
+		|| tw->bounds[1][1] < node->bounds[0][1]
+		|| tw->bounds[1][2] < node->bounds[0][2];
+}
+
+/*
+====================
+CM_TraceThroughPatchCollide
+====================
+*/
+void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
+	int i, n;
+	const facetNode_t *node;
+
+	if (tw->isPoint) {
+		CM_TracePointThroughPatchCollide( tw, pc );
+		return;
+	}
+
+	if ( !CM_UseFacetNodes( pc ) ) {
+		for ( i = 0 ; i < pc->numFacets ; i++ ) {
+			CM_TraceThroughFacet( tw, pc, &pc->facets[i] );
+		}
+		return;
+	}
+
+	for ( n = 0 ; n < pc->numNodes ; ) {
+		node = &pc->nodes[n];
+		if ( CM_TraceMissesNode( tw, node ) ) {
+			n = node->skip;
+			continue;
+		}
+		for ( i = 0 ; i < node->numFacets ; i++ ) {
+			CM_TraceThroughFacet( tw, pc, &pc->facets[ node->firstFacet + i ] );
 		}
+		n++;
 	}
 }
 
@@ -1507,33 +1678,59 @@ POSITION TEST
 
 /*
 ====================
-CM_PositionTestInPatchCollide
+CM_PositionTestInFacet
 ====================
 */
-qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
-	int i, j;
+static qboolean CM_PositionTestInFacet( traceWork_t *tw, const patchCollide_t *pc, const facet_t *facet ) {
+	int j;
 	float offset, t;
 	patchPlane_t *planes;
-	facet_t	*facet;
 	float plane[4];
 	vec3_t startp;
 
-	if (tw->isPoint) {
+	planes = &pc->planes[ facet->surfacePlane ];
+	VectorCopy(planes->plane, plane);
+	plane[3] = planes->plane[3];
+	if ( tw->sphere.use ) {
+		// adjust the plane distance apropriately for radius
+		plane[3] += tw->sphere.radius;
+
+		// find the closest point on the capsule to the plane
+		t = DotProduct( plane, tw->sphere.offset );
+		if ( t > 0 ) {
+			VectorSubtract( tw->start, tw->sphere.offset, startp );
+		}
+		else {
+			VectorAdd( tw->start, tw->sphere.offset, startp );
+		}
+	}
+	else {
+		offset = DotProduct( tw->offsets[ planes->signbits ], plane);
+		plane[3] -= offset;
+		VectorCopy( tw->start, startp );
+	}
+
+	if ( DotProduct( plane, startp ) - plane[3] > 0.0f ) {
 		return qfalse;
 	}
-	//
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
-		planes = &pc->planes[ facet->surfacePlane ];
-		VectorCopy(planes->plane, plane);
-		plane[3] = planes->plane[3];
+
+	for ( j = 0; j < facet->numBorders; j++ ) {
+		planes = &pc->planes[ facet->borderPlanes[j] ];
+		if (facet->borderInward[j]) {
+			VectorNegate(planes->plane, plane);
+			plane[3] = -planes->plane[3];
+		}
+		else {
+			VectorCopy(planes->plane, plane);
+			plane[3] = planes->plane[3];
+		}
 		if ( tw->sphere.use ) {
 			// adjust the plane distance apropriately for radius
 			plane[3] += tw->sphere.radius;
 
 			// find the closest point on the capsule to the plane
 			t = DotProduct( plane, tw->sphere.offset );
-			if ( t > 0 ) {
+			if ( t > 0.0f ) {
 				VectorSubtract( tw->start, tw->sphere.offset, startp );
 			}
 			else {
@@ -1541,54 +1738,54 @@ qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchColli
 			}
 		}
 		else {
+			// NOTE: this works even though the plane might be flipped because the bbox is centered
 			offset = DotProduct( tw->offsets[ planes->signbits ], plane);
-			plane[3] -= offset;
+			plane[3] += fabs(offset);
 			VectorCopy( tw->start, startp );
 		}
 
 		if ( DotProduct( plane, startp ) - plane[3] > 0.0f ) {
-			continue;
+			return qfalse;
 		}
+	}
+	// inside this patch facet
+	return qtrue;
+}
 
-		for ( j = 0; j < facet->numBorders; j++ ) {
-			planes = &pc->planes[ facet->borderPlanes[j] ];
-			if (facet->borderInward[j]) {
-				VectorNegate(planes->plane, plane);
-				plane[3] = -planes->plane[3];
-			}
-			else {
-				VectorCopy(planes->plane, plane);
-				plane[3] = planes->plane[3];
-			}
-			if ( tw->sphere.use ) {
-				// adjust the plane distance apropriately for radius
-				plane[3] += tw->sphere.radius;
-
-				// find the closest point on the capsule to the plane
-				t = DotProduct( plane, tw->sphere.offset );
-				if ( t > 0.0f ) {
-					VectorSubtract( tw->start, tw->sphere.offset, startp );
-				}
-				else {
-					VectorAdd( tw->start, tw->sphere.offset, startp );
-				}
-			}
-			else {
-				// NOTE: this works even though the plane might be flipped because the bbox is centered
-				offset = DotProduct( tw->offsets[ planes->signbits ], plane);
-				plane[3] += fabs(offset);
-				VectorCopy( tw->start, startp );
-			}
+/*
+====================
+CM_PositionTestInPatchCollide
+====================
+*/
+qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc ) {
+	int i, n;
+	const facetNode_t *node;
 
-			if ( DotProduct( plane, startp ) - plane[3] > 0.0f ) {
-				break;
+	if (tw->isPoint) {
+		return qfalse;
+	}
+
+	if ( !CM_UseFacetNodes( pc ) ) {
+		for ( i = 0 ; i < pc->numFacets ; i++ ) {
+			if ( CM_PositionTestInFacet( tw, pc, &pc->facets[i] ) ) {
+				return qtrue;
 			}
 		}
-		if (j < facet->numBorders) {
+		return qfalse;
+	}
+
+	for ( n = 0 ; n < pc->numNodes ; ) {
+		node = &pc->nodes[n];
+		if ( CM_TraceMissesNode( tw, node ) ) {
+			n = node->skip;
 			continue;
 		}
-		// inside this patch facet
-		return qtrue;
+		for ( i = 0 ; i < node->numFacets ; i++ ) {
+			if ( CM_PositionTestInFacet( tw, pc, &pc->facets[ node->firstFacet + i ] ) ) {
+				return qtrue;
+			}
+		}
+		n++;
 	}
 	return qfalse;
 }
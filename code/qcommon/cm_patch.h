@@ -76,12 +76,28 @@ typedef struct {
 	qboolean	borderNoAdjust[4+6+16];
 } facet_t;
 
+// the facets of a patch are covered by a bounding volume hierarchy so
+// traces only have to look at the facets they can touch.  Nodes are
+// stored depth first and every node covers a run of consecutive facets,
+// so walking the tree visits facets in the same order as a full scan
+#define	FACET_LEAF_SIZE		4
+#define	FACET_BOUNDS_EPSILON	1
+
+typedef struct {
+	vec3_t	bounds[2];
+	int		firstFacet;
+	int		numFacets;			// 0 for an inner node, the children follow it
+	int		skip;				// next node once this one is missed or done
+} facetNode_t;
+
 typedef struct patchCollide_s {
 	vec3_t	bounds[2];
 	int		numPlanes;			// surface planes plus edge planes
 	patchPlane_t	*planes;
 	int		numFacets;
 	facet_t	*facets;
+	int		numNodes;
+	facetNode_t	*nodes;
 } patchCollide_t;
 
 
@@ -49,6 +49,7 @@ void		CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 byte		*CM_ClusterPVS (int cluster);
 
 int			CM_PointLeafnum( const vec3_t p );
+void		CM_PointLeafnums( const vec3_t *points, int numPoints, int *leafnums );
 
 // only returns non-solid leafs
 // overflow if return listsize and if *lastLeaf != list[listsize-1]
@@ -53,11 +53,201 @@ int CM_PointLeafnum_r( const vec3_t p, int num ) {
 	return -1 - num;
 }
 
+
+/*
+======================================================================
+
+LEAF GRID
+
+A uniform grid over the world remembers, for each cell, the deepest node
+whose subtree holds the whole cell, or the leaf itself when the cell is
+entirely inside one.  Point lookups start there instead of at the root.
+
+======================================================================
+*/
+
+#define	LEAFGRID_CELL_SIZE	64			// smallest cell size tried
+#define	LEAFGRID_MAX_CELLS	65536
+#define	LEAFGRID_EPSILON	1			// keeps float rounding of point tests away from the cell edges
+
+/*
+==================
+CM_LeafGridCellNode
+==================
+*/
+static int CM_LeafGridCellNode( const vec3_t mins, const vec3_t maxs ) {
+	int			i, num;
+	cNode_t		*node;
+	cplane_t	*plane;
+	float		front, back;
+
+	num = 0;
+	while ( num >= 0 ) {
+		node = cm.nodes + num;
+		plane = node->plane;
+
+		// distances of the nearest and farthest corners of the cell
+		if ( plane->type < 3 ) {
+			back = mins[plane->type] - plane->dist;
+			front = maxs[plane->type] - plane->dist;
+		} else {
+			back = front = -plane->dist;
+			for ( i = 0 ; i < 3 ; i++ ) {
+				if ( plane->normal[i] > 0 ) {
+					back += plane->normal[i] * mins[i];
+					front += plane->normal[i] * maxs[i];
+				} else {
+					back += plane->normal[i] * maxs[i];
+					front += plane->normal[i] * mins[i];
+				}
+			}
+		}
+
+		if ( back >= 0 ) {
+			num = node->children[0];
+		} else if ( front < 0 ) {
+			num = node->children[1];
+		} else {
+			break;		// the plane splits the cell
+		}
+	}
+
+	return num;
+}
+
+/*
+==================
+CM_InitLeafGrid
+
+Called after the nodes and leafs are loaded
+==================
+*/
+void CM_InitLeafGrid( void ) {
+	int		i, x, y, z;
+	int		numCells;
+	float	cellSize;
+	vec3_t	mins, maxs;
+	int		*cell;
+
+	cm.leafGrid = NULL;
+
+#ifndef BSPC
+	if ( !cm_leafGrid->integer ) {
+		return;
+	}
+#endif
+	if ( !cm.numNodes || !cm.numSubModels ) {
+		return;
+	}
+
+	// grow the cells until the grid is small enough
+	for ( cellSize = LEAFGRID_CELL_SIZE ; ; cellSize *= 2 ) {
+		numCells = 1;
+		for ( i = 0 ; i < 3 ; i++ ) {
+			cm.leafGridSize[i] = ceil( ( cm.cmodels[0].maxs[i] - cm.cmodels[0].mins[i] ) / cellSize );
+			if ( cm.leafGridSize[i] < 1 ) {
+				cm.leafGridSize[i] = 1;
+			}
+			numCells *= cm.leafGridSize[i];
+		}
+		if ( numCells <= LEAFGRID_MAX_CELLS ) {
+			break;
+		}
+	}
+
+	cm.leafGridScale = 1.0f / cellSize;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		cm.leafGridMins[i] = cm.cmodels[0].mins[i];
+		cm.leafGridMaxs[i] = cm.leafGridMins[i] + cm.leafGridSize[i] * cellSize;
+	}
+
+	cm.leafGrid = Hunk_Alloc( numCells * sizeof( *cm.leafGrid ), h_high );
+	cell = cm.leafGrid;
+	for ( z = 0 ; z < cm.leafGridSize[2] ; z++ ) {
+		mins[2] = cm.leafGridMins[2] + z * cellSize - LEAFGRID_EPSILON;
+		maxs[2] = mins[2] + cellSize + 2 * LEAFGRID_EPSILON;
+		for ( y = 0 ; y < cm.leafGridSize[1] ; y++ ) {
+			mins[1] = cm.leafGridMins[1] + y * cellSize - LEAFGRID_EPSILON;
+			maxs[1] = mins[1] + cellSize + 2 * LEAFGRID_EPSILON;
+			for ( x = 0 ; x < cm.leafGridSize[0] ; x++ ) {
+				mins[0] = cm.leafGridMins[0] + x * cellSize - LEAFGRID_EPSILON;
+				maxs[0] = mins[0] + cellSize + 2 * LEAFGRID_EPSILON;
+				*cell++ = CM_LeafGridCellNode( mins, maxs );
+			}
+		}
+	}
+}
+
+/*
+==================
+CM_LeafGridNode
+
+Returns the node to start a point lookup from,
+or -1-leaf when the grid already knows the leaf
+==================
+*/
+static int CM_LeafGridNode( const vec3_t p ) {
+	int		i;
+	int		c[3];
+
+	if ( !cm.leafGrid ) {
+		return 0;
+	}
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		if ( !( p[i] >= cm.leafGridMins[i] && p[i] < cm.leafGridMaxs[i] ) ) {
+			return 0;		// outside the world, or not a number
+		}
+		c[i] = ( p[i] - cm.leafGridMins[i] ) * cm.leafGridScale;
+		if ( c[i] >= cm.leafGridSize[i] ) {
+			c[i] = cm.leafGridSize[i] - 1;
+		}
+	}
+
+	return cm.leafGrid[ ( c[2] * cm.leafGridSize[1] + c[1] ) * cm.leafGridSize[0] + c[0] ];
+}
+
 int CM_PointLeafnum( const vec3_t p ) {
+	int		num;
+
 	if ( !cm.numNodes ) {	// map not loaded
 		return 0;
 	}
-	return CM_PointLeafnum_r (p, 0);
+
+	num = CM_LeafGridNode( p );
+	if ( num < 0 ) {
+		c_pointcontents++;
+		return -1 - num;
+	}
+	return CM_PointLeafnum_r (p, num);
+}
+
+/*
+==================
+CM_PointLeafnums
+
+Looks up a batch of points at once
+==================
+*/
+void CM_PointLeafnums( const vec3_t *points, int numPoints, int *leafnums ) {
+	int		i, num;
+
+	if ( !cm.numNodes ) {	// map not loaded
+		for ( i = 0 ; i < numPoints ; i++ ) {
+			leafnums[i] = 0;
+		}
+		return;
+	}
+
+	for ( i = 0 ; i < numPoints ; i++ ) {
+		num = CM_LeafGridNode( points[i] );
+		if ( num < 0 ) {
+			c_pointcontents++;
+			leafnums[i] = -1 - num;
+		} else {
+			leafnums[i] = CM_PointLeafnum_r( points[i], num );
+		}
+	}
 }
 
 
@@ -241,7 +431,7 @@ int CM_PointContents( const vec3_t p, clipHandle_t model ) {
 		clipm = CM_ClipHandleToModel( model );
 		leaf = &clipm->leaf;
 	} else {
-		leafnum = CM_PointLeafnum_r (p, 0);
+		leafnum = CM_PointLeafnum (p);
 		leaf = &cm.leafs[leafnum];
 	}
 
@@ -324,6 +514,11 @@ byte	*CM_ClusterPVS (int cluster) {
 
 AREAPORTALS
 
+Each group of connected areas shares a floodnum.  A portal reference count
+changing between zero and one merges two floods or splits one, and only
+the areas of the floods involved are relabeled.  Any other change leaves
+the connectivity alone.
+
 ===============================================================================
 */
 
@@ -342,6 +537,7 @@ void CM_FloodArea_r( int areaNum, int floodnum) {
 
 	area->floodnum = floodnum;
 	area->floodvalid = cm.floodvalid;
+	cm.floodSizes[ floodnum ]++;
 	con = cm.areaPortals + areaNum * cm.numAreas;
 	for ( i=0 ; i < cm.numAreas  ; i++ ) {
 		if ( con[i] > 0 ) {
@@ -363,7 +559,9 @@ void	CM_FloodAreaConnections( void ) {
 
 	// all current floods are now invalid
 	cm.floodvalid++;
+	cm.floodGeneration++;
 	floodnum = 0;
+	Com_Memset( cm.floodSizes, 0, ( cm.numAreas + 1 ) * sizeof( *cm.floodSizes ) );
 
 	for (i = 0 ; i < cm.numAreas ; i++) {
 		area = &cm.areas[i];
@@ -376,6 +574,67 @@ void	CM_FloodAreaConnections( void ) {
 
 }
 
+/*
+====================
+CM_MergeFloods
+
+A portal opened between two floods, the smaller one takes the other's floodnum
+====================
+*/
+static void CM_MergeFloods( int area1, int area2 ) {
+	int		i;
+	int		from, to;
+
+	from = cm.areas[area1].floodnum;
+	to = cm.areas[area2].floodnum;
+	if ( from == to ) {
+		return;		// already connected some other way
+	}
+	if ( cm.floodSizes[from] > cm.floodSizes[to] ) {
+		from = to;
+		to = cm.areas[area1].floodnum;
+	}
+
+	for ( i = 0 ; i < cm.numAreas ; i++ ) {
+		if ( cm.areas[i].floodnum == from ) {
+			cm.areas[i].floodnum = to;
+		}
+	}
+	cm.floodSizes[to] += cm.floodSizes[from];
+	cm.floodSizes[from] = 0;
+	cm.floodGeneration++;
+}
+
+/*
+====================
+CM_SplitFlood
+
+The last portal between two areas closed, reflood one side
+under a new floodnum and see if the other side is still reached
+====================
+*/
+static void CM_SplitFlood( int area1, int area2 ) {
+	int		oldFlood, newFlood;
+
+	oldFlood = cm.areas[area1].floodnum;
+	if ( cm.areas[area2].floodnum != oldFlood ) {
+		return;
+	}
+
+	// there are never more floods than areas, so a number is always free
+	for ( newFlood = 1 ; cm.floodSizes[newFlood] ; newFlood++ ) {
+	}
+
+	cm.floodvalid++;
+	CM_FloodArea_r( area1, newFlood );
+	cm.floodSizes[oldFlood] -= cm.floodSizes[newFlood];
+
+	if ( cm.areas[area2].floodvalid == cm.floodvalid ) {
+		return;		// still connected, the whole flood just got renumbered
+	}
+	cm.floodGeneration++;
+}
+
 /*
 ====================
 CM_AdjustAreaPortalState
@@ -394,15 +653,19 @@ void	CM_AdjustAreaPortalState( int area1, int area2, qboolean open ) {
 	if ( open ) {
 		cm.areaPortals[ area1 * cm.numAreas + area2 ]++;
 		cm.areaPortals[ area2 * cm.numAreas + area1 ]++;
+		if ( cm.areaPortals[ area2 * cm.numAreas + area1 ] == 1 ) {
+			CM_MergeFloods( area1, area2 );
+		}
 	} else {
 		cm.areaPortals[ area1 * cm.numAreas + area2 ]--;
 		cm.areaPortals[ area2 * cm.numAreas + area1 ]--;
 		if ( cm.areaPortals[ area2 * cm.numAreas + area1 ] < 0 ) {
 			Com_Error (ERR_DROP, "CM_AdjustAreaPortalState: negative reference count");
 		}
+		if ( cm.areaPortals[ area2 * cm.numAreas + area1 ] == 0 ) {
+			CM_SplitFlood( area1, area2 );
+		}
 	}
-
-	CM_FloodAreaConnections ();
 }
 
 /*
@@ -444,6 +707,9 @@ Returns the number of bytes needed to hold all the bits.
 The bits are OR'd in, so you can CM_WriteAreaBits from multiple
 viewpoints and get the union of all visible areas.
 
+The bits for each area are kept until the floods change,
+so every client in the same flood shares them.
+
 This is used to cull non-visible entities from snapshots
 =================
 */
@@ -452,6 +718,7 @@ int CM_WriteAreaBits (byte *buffer, int area)
 	int		i;
 	int		floodnum;
 	int		bytes;
+	byte	*bits;
 
 	bytes = (cm.numAreas+7)>>3;
 
@@ -465,11 +732,20 @@ int CM_WriteAreaBits (byte *buffer, int area)
 	}
 	else
 	{
-		floodnum = cm.areas[area].floodnum;
-		for (i=0 ; i<cm.numAreas ; i++)
+		bits = cm.areaBits + area * bytes;
+		if ( cm.areaBitsGeneration[area] != cm.floodGeneration ) {
+			Com_Memset( bits, 0, bytes );
+			floodnum = cm.areas[area].floodnum;
+			for (i=0 ; i<cm.numAreas ; i++)
+			{
+				if (cm.areas[i].floodnum == floodnum)
+					bits[i>>3] |= 1<<(i&7);
+			}
+			cm.areaBitsGeneration[area] = cm.floodGeneration;
+		}
+		for (i=0 ; i<bytes ; i++)
 		{
-			if (cm.areas[i].floodnum == floodnum || area == -1)
-				buffer[i>>3] |= 1<<(i&7);
+			buffer[i] |= bits[i];
 		}
 	}
 
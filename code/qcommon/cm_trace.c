@@ -20,6 +20,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
 #include "cm_local.h"
+#include "cm_patch.h"
 
 // always use bbox vs. bbox collision and never capsule vs. bbox or vice versa
 //#define ALWAYS_BBOX_VS_BBOX
@@ -1469,3 +1470,178 @@ void CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 
 	*results = trace;
 }
+
+#ifndef BSPC
+/*
+===============================================================================
+
+PATCH TRACE BENCHMARK
+
+===============================================================================
+*/
+
+#define	PATCHBENCH_TRACES	64		// default per patch and trace type
+#define	PATCHBENCH_SPREAD	48		// how far outside the patch bounds traces start and end
+
+typedef enum {
+	PB_BOX,
+	PB_CAPSULE,
+	PB_POSITION,
+	PB_NUM_TYPES
+} patchBenchType_t;
+
+/*
+==================
+CM_PatchBenchTrace
+
+Traces a player sized hull somewhere around the patch
+==================
+*/
+static void CM_PatchBenchTrace( trace_t *tr, const cPatch_t *patch, patchBenchType_t type, int *seed ) {
+	const patchCollide_t	*pc;
+	vec3_t		mins = { -15, -15, -24 };
+	vec3_t		maxs = { 15, 15, 32 };
+	vec3_t		start, end;
+	vec3_t		lo, size;
+	int			i;
+
+	pc = patch->pc;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		lo[i] = pc->bounds[0][i] - PATCHBENCH_SPREAD;
+		size[i] = pc->bounds[1][i] + PATCHBENCH_SPREAD - lo[i];
+	}
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		start[i] = lo[i] + size[i] * Q_random( seed );
+	}
+	if ( type == PB_POSITION ) {
+		VectorCopy( start, end );
+	} else {
+		for ( i = 0 ; i < 3 ; i++ ) {
+			end[i] = lo[i] + size[i] * Q_random( seed );
+		}
+	}
+
+	CM_BoxTrace( tr, start, end, mins, maxs, 0, patch->contents, type == PB_CAPSULE );
+}
+
+/*
+==================
+CM_PatchBenchMatch
+==================
+*/
+static qboolean CM_PatchBenchMatch( const trace_t *a, const trace_t *b ) {
+	return a->fraction == b->fraction
+		&& a->allsolid == b->allsolid
+		&& a->startsolid == b->startsolid
+		&& VectorCompare( a->endpos, b->endpos )
+		&& VectorCompare( a->plane.normal, b->plane.normal )
+		&& a->plane.dist == b->plane.dist
+		&& a->surfaceFlags == b->surfaceFlags
+		&& a->contents == b->contents;
+}
+
+/*
+==================
+CM_PatchBench_f
+
+patchbench [traces per patch]
+
+Times box, capsule and position traces around every patch on the map with
+the facet hierarchy and with a full facet scan, and checks that both give
+the same results
+==================
+*/
+void CM_PatchBench_f( void ) {
+	trace_t		*results;
+	trace_t		tr;
+	int			count, numPatches, numTraces;
+	int			i, j, type, n;
+	int			seed;
+	int			start, scanMsec, nodeMsec;
+	int			mismatches;
+	qboolean	oldScan;
+
+	if ( !cm.numSurfaces ) {
+		Com_Printf( "no map loaded\n" );
+		return;
+	}
+	if ( cm_noCurves->integer ) {
+		Com_Printf( "cm_noCurves is set\n" );
+		return;
+	}
+
+	count = PATCHBENCH_TRACES;
+	if ( Cmd_Argc() > 1 ) {
+		count = atoi( Cmd_Argv( 1 ) );
+		if ( count < 1 ) {
+			count = 1;
+		}
+	}
+
+	numPatches = 0;
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		if ( cm.surfaces[i] ) {
+			numPatches++;
+		}
+	}
+	if ( !numPatches ) {
+		Com_Printf( "map has no patches\n" );
+		return;
+	}
+
+	numTraces = numPatches * count * PB_NUM_TYPES;
+	results = Hunk_AllocateTempMemory( numTraces * sizeof( *results ) );
+	oldScan = cm_forceFacetScan;
+
+	// every facet, the reference results
+	cm_forceFacetScan = qtrue;
+	seed = 0x1234;
+	n = 0;
+	start = Sys_Milliseconds();
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		if ( !cm.surfaces[i] ) {
+			continue;
+		}
+		for ( j = 0 ; j < count ; j++ ) {
+			for ( type = 0 ; type < PB_NUM_TYPES ; type++ ) {
+				CM_PatchBenchTrace( &results[n++], cm.surfaces[i], type, &seed );
+			}
+		}
+	}
+	scanMsec = Sys_Milliseconds() - start;
+
+	// the same traces through the facet hierarchy
+	cm_forceFacetScan = qfalse;
+	seed = 0x1234;
+	n = 0;
+	mismatches = 0;
+	start = Sys_Milliseconds();
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		if ( !cm.surfaces[i] ) {
+			continue;
+		}
+		for ( j = 0 ; j < count ; j++ ) {
+			for ( type = 0 ; type < PB_NUM_TYPES ; type++ ) {
+				CM_PatchBenchTrace( &tr, cm.surfaces[i], type, &seed );
+				if ( !CM_PatchBenchMatch( &tr, &results[n++] ) ) {
+					mismatches++;
+				}
+			}
+		}
+	}
+	nodeMsec = Sys_Milliseconds() - start;
+
+	cm_forceFacetScan = oldScan;
+	Hunk_FreeTempMemory( results );
+
+	Com_Printf( "%i traces around %i patches\n", numTraces, numPatches );
+	Com_Printf( "facet scan: %5i msec\n", scanMsec );
+	Com_Printf( "facet bvh:  %5i msec%s\n", nodeMsec, cm_patchBVH->integer ? "" : " (cm_patchBVH is 0)" );
+	if ( mismatches ) {
+		Com_Printf( S_COLOR_RED "%i traces differ from the facet scan\n", mismatches );
+	} else {
+		Com_Printf( "all traces match the facet scan\n" );
+	}
+}
+#endif //BSPC
@@ -1428,12 +1428,52 @@ CONVENIENCE FUNCTIONS FOR ENTIRE FILES
 ======================================================================================
 */
 
-int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
+/*
+================
+FS_LooseFileAllowed
+
+Whether FS_FOpenFileRead would look for the file in a directory
+================
+*/
+static qboolean FS_LooseFileAllowed( const char *filename ) {
+	char	demoExt[16];
+	int		l;
+
+	if ( !fs_restrict->integer && !fs_numServerPaks ) {
+		return qtrue;
+	}
+
+	Com_sprintf( demoExt, sizeof( demoExt ), ".dm_%d", PROTOCOL_VERSION );
+	l = strlen( filename );
+	return !Q_stricmp( filename + l - 4, ".cfg" )
+		|| !Q_stricmp( filename + l - 5, ".menu" )
+		|| !Q_stricmp( filename + l - 5, ".game" )
+		|| !Q_stricmp( filename + l - strlen( demoExt ), demoExt )
+		|| !Q_stricmp( filename + l - 4, ".dat" );
+}
+
+/*
+================
+FS_PakForFile
+
+The pure pak a file would be read from, or NULL.  If inDir is given
+the directories are searched too, in the same order FS_FOpenFileRead
+goes through them, and a file found in one sets it and returns NULL.
+================
+*/
+static pack_t *FS_PakForFile( const char *filename, qboolean *inDir ) {
 	searchpath_t	*search;
 	pack_t			*pak;
 	fileInPack_t	*pakFile;
+	directory_t		*dir;
+	char			*netpath;
+	FILE			*temp;
 	long			hash = 0;
 
+	if ( inDir ) {
+		*inDir = qfalse;
+	}
+
 	if ( !fs_searchpaths ) {
 		Com_Error( ERR_FATAL, "Filesystem call made without initialization\n" );
 	}
@@ -1451,7 +1491,7 @@ int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
 	// The searchpaths do guarantee that something will always
 	// be prepended, so we don't need to worry about "c:" or "//limbo" 
 	if ( strstr( filename, ".." ) || strstr( filename, "::" ) ) {
-		return -1;
+		return NULL;
 	}
 
 	//
@@ -1476,16 +1516,70 @@ int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
 			do {
 				// case and separator insensitive comparisons
 				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					if (pChecksum) {
-						*pChecksum = pak->pure_checksum;
-					}
-					return 1;
+					return pak;
 				}
 				pakFile = pakFile->next;
 			} while(pakFile != NULL);
+		} else if ( search->dir && inDir ) {
+			if ( !FS_LooseFileAllowed( filename ) ) {
+				continue;
+			}
+
+			dir = search->dir;
+			netpath = FS_BuildOSPath( dir->path, dir->gamedir, filename );
+			temp = fopen( netpath, "rb" );
+			if ( !temp ) {
+				continue;
+			}
+			fclose( temp );
+
+			*inDir = qtrue;
+			return NULL;
 		}
 	}
-	return -1;
+	return NULL;
+}
+
+int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
+	pack_t	*pak;
+
+	pak = FS_PakForFile( filename, NULL );
+	if ( !pak ) {
+		return -1;
+	}
+	if (pChecksum) {
+		*pChecksum = pak->pure_checksum;
+	}
+	return 1;
+}
+
+/*
+================
+FS_FilePakChecksum
+
+Like FS_FileIsInPAK, but hands back the pak's own checksum instead of
+the one keyed with fs_checksumFeed, so it stays the same across map
+loads.  Only good for telling whether the pak changed on disk.
+
+Returns 0 if the file would be read from a directory instead, which
+the checksum says nothing about, and -1 if it can't be found at all.
+================
+*/
+int	FS_FilePakChecksum(const char *filename, int *pChecksum ) {
+	pack_t		*pak;
+	qboolean	inDir;
+
+	pak = FS_PakForFile( filename, &inDir );
+	if ( inDir ) {
+		return 0;
+	}
+	if ( !pak ) {
+		return -1;
+	}
+	if (pChecksum) {
+		*pChecksum = pak->checksum;
+	}
+	return 1;
 }
 
 /*
@@ -101,6 +101,45 @@ bit functions
 =============================================================================
 */
 
+/*
+==================
+MSG_WriteBitString
+
+Appends bits already written to another message, starting at bit 0.
+The message bits don't depend on where they start, so this gives the
+same result as writing them again.
+==================
+*/
+void MSG_WriteBitString( msg_t *msg, const byte *bits, int numBits ) {
+	unsigned int	acc;
+	int				pos, shift;
+	int				i, numBytes;
+
+	numBytes = ( numBits + 7 ) >> 3;
+	if ( msg->maxsize - msg->cursize < numBytes + 4 ) {
+		msg->overflowed = qtrue;
+		return;
+	}
+	if ( !numBits ) {
+		return;
+	}
+
+	pos = msg->bit >> 3;
+	shift = msg->bit & 7;
+	acc = msg->data[pos] & ( ( 1 << shift ) - 1 );
+	for ( i = 0 ; i < numBytes ; i++ ) {
+		acc |= bits[i] << shift;
+		msg->data[pos++] = acc;
+		acc >>= 8;
+	}
+	if ( shift ) {
+		msg->data[pos] = acc;
+	}
+
+	msg->bit += numBits;
+	msg->cursize = ( msg->bit >> 3 ) + 1;
+}
+
 int	overflows;
 
 // negative bit values include signs
@@ -844,6 +883,257 @@ netField_t	entityStateFields[] =
 #define	FLOAT_INT_BITS	13
 #define	FLOAT_INT_BIAS	(1<<(FLOAT_INT_BITS-1))
 
+/*
+==============================================================================
+
+			DELTA ENTITY ENCODING
+
+The changed fields are found by comparing the packed entityState_t a word
+at a time and mapping the changed words through a precomputed table, and
+the fields are written straight into a bit accumulator with the Huffman
+codes of the message compressor.  The bits on the wire are identical to
+writing every field with MSG_WriteBits, which is still used when the
+message might overflow.
+==============================================================================
+*/
+
+#define	ENTITY_STATE_WORDS	( sizeof( entityState_t ) / 4 )
+#define	MAX_DELTA_HUFF_BITS	24		// longest code the accumulator takes
+
+qboolean		msg_genericDelta;	// deltabench compares against MSG_WriteBits
+
+static qboolean		msgDeltaReady;
+static int			msgDeltaMaxBytes;		// worst case size of one entity delta
+static unsigned int	msgHuffCode[256];		// first bit sent is the lowest
+static int			msgHuffLen[256];
+static int			entityWordField[ENTITY_STATE_WORDS];	// -1 for the number
+
+typedef struct {
+	byte			*data;
+	int				pos;		// byte being filled
+	unsigned int	acc;		// bits not yet stored, first bit lowest
+	int				count;		// bits in acc
+} bitWriter_t;
+
+/*
+==================
+MSG_InitDeltaEncoding
+
+Called after the compressor is built
+==================
+*/
+static void MSG_InitDeltaEncoding( void ) {
+	node_t			*node;
+	unsigned int	code;
+	int				numFields;
+	int				ch, len, maxLen;
+	int				i;
+
+	msgDeltaReady = qfalse;
+
+	maxLen = 0;
+	for ( ch = 0 ; ch < 256 ; ch++ ) {
+		node = msgHuff.compressor.loc[ch];
+		if ( !node ) {
+			return;
+		}
+		// bits are sent from the root down, so walking up finds the last one first
+		code = 0;
+		len = 0;
+		for ( ; node->parent ; node = node->parent ) {
+			code = ( code << 1 ) | ( node->parent->right == node );
+			len++;
+		}
+		if ( len > MAX_DELTA_HUFF_BITS ) {
+			return;
+		}
+		msgHuffCode[ch] = code;
+		msgHuffLen[ch] = len;
+		if ( len > maxLen ) {
+			maxLen = len;
+		}
+	}
+
+	numFields = sizeof(entityStateFields)/sizeof(entityStateFields[0]);
+	for ( i = 0 ; i < ENTITY_STATE_WORDS ; i++ ) {
+		entityWordField[i] = -1;
+	}
+	for ( i = 0 ; i < numFields ; i++ ) {
+		entityWordField[ entityStateFields[i].offset >> 2 ] = i;
+	}
+
+	// entity number, removed and delta bits, field count, then each
+	// field with up to three flag bits and four coded bytes
+	msgDeltaMaxBytes = ( ( 2 + maxLen ) + 2 + maxLen + numFields * ( 3 + 4 * maxLen ) ) / 8 + 1;
+	msgDeltaReady = qtrue;
+}
+
+static void MSG_BitWriterBegin( bitWriter_t *bw, msg_t *msg ) {
+	bw->data = msg->data;
+	bw->pos = msg->bit >> 3;
+	bw->count = msg->bit & 7;
+	bw->acc = bw->data[bw->pos] & ( ( 1 << bw->count ) - 1 );
+}
+
+static void MSG_BitWriterEnd( bitWriter_t *bw, msg_t *msg ) {
+	if ( bw->count ) {
+		bw->data[bw->pos] = bw->acc;
+	}
+	msg->bit = ( bw->pos << 3 ) + bw->count;
+	msg->cursize = ( msg->bit >> 3 ) + 1;
+}
+
+static void MSG_BitWriterPut( bitWriter_t *bw, unsigned int bits, int count ) {
+	bw->acc |= bits << bw->count;
+	bw->count += count;
+	while ( bw->count >= 8 ) {
+		bw->data[bw->pos++] = bw->acc;
+		bw->acc >>= 8;
+		bw->count -= 8;
+	}
+}
+
+/*
+==================
+MSG_BitWriterValue
+
+Same bits as MSG_WriteBits with a positive bit count
+==================
+*/
+static void MSG_BitWriterValue( bitWriter_t *bw, int value, int bits ) {
+	unsigned int	v;
+	int				nbits;
+
+	v = value & ( 0xffffffff >> ( 32 - bits ) );
+	nbits = bits & 7;
+	if ( nbits ) {
+		MSG_BitWriterPut( bw, v & ( ( 1 << nbits ) - 1 ), nbits );
+		v >>= nbits;
+		bits -= nbits;
+	}
+	for ( ; bits > 0 ; bits -= 8 ) {
+		MSG_BitWriterPut( bw, msgHuffCode[v & 0xff], msgHuffLen[v & 0xff] );
+		v >>= 8;
+	}
+}
+
+/*
+==================
+MSG_EntityChanges
+
+Sets a bit for every changed field and returns the number of fields
+up to and including the last changed one
+==================
+*/
+static int MSG_EntityChanges( const entityState_t *from, const entityState_t *to, unsigned int changed[2] ) {
+	const int		*fromW, *toW;
+	unsigned int	words[2];
+	int				i, f, lc;
+
+	changed[0] = changed[1] = 0;
+	if ( !memcmp( from, to, sizeof( *from ) ) ) {
+		return 0;
+	}
+
+	fromW = (const int *)from;
+	toW = (const int *)to;
+	words[0] = words[1] = 0;
+	for ( i = 0 ; i < ENTITY_STATE_WORDS ; i++ ) {
+		words[i >> 5] |= (unsigned int)( fromW[i] != toW[i] ) << ( i & 31 );
+	}
+
+	lc = 0;
+	for ( i = 0 ; i < ENTITY_STATE_WORDS ; i++ ) {
+		if ( !( words[i >> 5] & ( 1u << ( i & 31 ) ) ) ) {
+			continue;
+		}
+		f = entityWordField[i];
+		if ( f < 0 ) {
+			continue;
+		}
+		changed[f >> 5] |= 1u << ( f & 31 );
+		if ( f >= lc ) {
+			lc = f + 1;
+		}
+	}
+	return lc;
+}
+
+/*
+==================
+MSG_WriteDeltaEntityFast
+
+The changes are written the same way as MSG_WriteDeltaEntity does,
+the caller has made sure the message can't overflow
+==================
+*/
+static void MSG_WriteDeltaEntityFast( msg_t *msg, entityState_t *from, entityState_t *to, 
+						   qboolean force ) {
+	bitWriter_t		bw;
+	unsigned int	changed[2];
+	netField_t		*field;
+	int				i, lc;
+	int				trunc;
+	float			fullFloat;
+	int				*toF;
+
+	lc = MSG_EntityChanges( from, to, changed );
+	if ( lc == 0 && !force ) {
+		return;		// nothing at all
+	}
+
+	MSG_BitWriterBegin( &bw, msg );
+	MSG_BitWriterValue( &bw, to->number, GENTITYNUM_BITS );
+	MSG_BitWriterPut( &bw, 0, 1 );			// not removed
+
+	if ( lc == 0 ) {
+		MSG_BitWriterPut( &bw, 0, 1 );		// no delta
+		MSG_BitWriterEnd( &bw, msg );
+		return;
+	}
+
+	MSG_BitWriterPut( &bw, 1, 1 );			// we have a delta
+	MSG_BitWriterValue( &bw, lc, 8 );		// # of changes
+
+	for ( i = 0, field = entityStateFields ; i < lc ; i++, field++ ) {
+		if ( !( changed[i >> 5] & ( 1u << ( i & 31 ) ) ) ) {
+			MSG_BitWriterPut( &bw, 0, 1 );	// no change
+			continue;
+		}
+
+		toF = (int *)( (byte *)to + field->offset );
+
+		if ( field->bits == 0 ) {
+			// float
+			fullFloat = *(float *)toF;
+			trunc = (int)fullFloat;
+
+			if ( fullFloat == 0.0f ) {
+				MSG_BitWriterPut( &bw, 1, 2 );	// changed, zero
+			} else if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 && 
+				trunc + FLOAT_INT_BIAS < ( 1 << FLOAT_INT_BITS ) ) {
+				// send as small integer
+				MSG_BitWriterPut( &bw, 3, 3 );	// changed, nonzero, integral
+				MSG_BitWriterValue( &bw, trunc + FLOAT_INT_BIAS, FLOAT_INT_BITS );
+			} else {
+				// send as full floating point value
+				MSG_BitWriterPut( &bw, 7, 3 );	// changed, nonzero, full float
+				MSG_BitWriterValue( &bw, *toF, 32 );
+			}
+		} else {
+			if ( *toF == 0 ) {
+				MSG_BitWriterPut( &bw, 1, 2 );	// changed, zero
+			} else {
+				MSG_BitWriterPut( &bw, 3, 2 );	// changed, nonzero
+				// integer
+				MSG_BitWriterValue( &bw, *toF, field->bits );
+			}
+		}
+	}
+
+	MSG_BitWriterEnd( &bw, msg );
+}
+
 /*
 ==================
 MSG_WriteDeltaEntity
@@ -886,6 +1176,13 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 		Com_Error (ERR_FATAL, "MSG_WriteDeltaEntity: Bad entity number: %i", to->number );
 	}
 
+	// with room for the largest delta MSG_WriteBits could never overflow
+	if ( msgDeltaReady && !msg_genericDelta && !msg->oob 
+		&& msg->maxsize - msg->cursize >= msgDeltaMaxBytes + 4 ) {
+		MSG_WriteDeltaEntityFast( msg, from, to, force );
+		return;
+	}
+
 	lc = 0;
 	// build the change vector as bytes so it is endien independent
 	for ( i = 0, field = entityStateFields ; i < numFields ; i++, field++ ) {
@@ -1717,6 +2014,7 @@ void MSG_initHuffman() {
 			Huff_addRef(&msgHuff.decompressor,	(byte)i);			// Do update
 		}
 	}
+	MSG_InitDeltaEncoding();
 }
 
 /*
@@ -47,6 +47,7 @@ void MSG_Init (msg_t *buf, byte *data, int length);
 void MSG_InitOOB( msg_t *buf, byte *data, int length );
 void MSG_Clear (msg_t *buf);
 void MSG_WriteData (msg_t *buf, const void *data, int length);
+void MSG_WriteBitString( msg_t *msg, const byte *bits, int numBits );
 void MSG_Bitstream( msg_t *buf );
 
 // TTimo
@@ -95,6 +96,7 @@ void MSG_ReadDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *t
 
 void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entityState_s *to
 						   , qboolean force );
+extern	qboolean	msg_genericDelta;	// force the per-field MSG_WriteBits encoder
 void MSG_ReadDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, 
 						 int number );
 
@@ -538,6 +540,10 @@ int		FS_FOpenFileRead( const char *qpath, fileHandle_t *file, qboolean uniqueFIL
 int		FS_FileIsInPAK(const char *filename, int *pChecksum );
 // returns 1 if a file is in the PAK file, otherwise -1
 
+int		FS_FilePakChecksum(const char *filename, int *pChecksum );
+// same, but the checksum doesn't depend on fs_checksumFeed,
+// returns 0 if the file would be read from a directory
+
 int		FS_Write( const void *buffer, int len, fileHandle_t f );
 
 int		FS_Read2( void *buffer, int len, fileHandle_t f );
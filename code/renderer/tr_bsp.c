@@ -1219,6 +1219,44 @@ void R_MovePatchSurfacesToHunk(void) {
 	}
 }
 
+/*
+===============
+R_SetSurfaceBounds
+
+Surfaces that can be drawn outside their vertexes get bounds that
+are never culled
+===============
+*/
+static void R_SetSurfaceBounds( msurface_t *surf ) {
+	srfSurfaceFace_t	*face;
+	int					i;
+
+	if ( !surf->shader->numDeforms ) {
+		switch ( *surf->data ) {
+		case SF_FACE:
+			face = (srfSurfaceFace_t *)surf->data;
+			ClearBounds( surf->bounds[0], surf->bounds[1] );
+			for ( i = 0 ; i < face->numPoints ; i++ ) {
+				AddPointToBounds( face->points[i], surf->bounds[0], surf->bounds[1] );
+			}
+			return;
+		case SF_GRID:
+			VectorCopy( ((srfGridMesh_t *)surf->data)->meshBounds[0], surf->bounds[0] );
+			VectorCopy( ((srfGridMesh_t *)surf->data)->meshBounds[1], surf->bounds[1] );
+			return;
+		case SF_TRIANGLES:
+			VectorCopy( ((srfTriangles_t *)surf->data)->bounds[0], surf->bounds[0] );
+			VectorCopy( ((srfTriangles_t *)surf->data)->bounds[1], surf->bounds[1] );
+			return;
+		default:
+			break;
+		}
+	}
+
+	VectorSet( surf->bounds[0], -99999, -99999, -99999 );
+	VectorSet( surf->bounds[1], 99999, 99999, 99999 );
+}
+
 /*
 ===============
 R_LoadSurfaces
@@ -1289,6 +1327,10 @@ static	void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump ) {
 	R_MovePatchSurfacesToHunk();
 #endif
 
+	for ( i = 0, out = s_worldData.surfaces ; i < count ; i++, out++ ) {
+		R_SetSurfaceBounds( out );
+	}
+
 	ri.Printf( PRINT_ALL, "...loaded %d faces, %i meshes, %i trisurfs, %i flares\n", 
 		numFaces, numMeshes, numTriSurfs, numFlares );
 }
@@ -1345,10 +1387,13 @@ R_SetParent
 static	void R_SetParent (mnode_t *node, mnode_t *parent)
 {
 	node->parent = parent;
-	if (node->contents != -1)
+	if (node->contents != -1) {
+		node->numLeafs = 1;
 		return;
+	}
 	R_SetParent (node->children[0], node);
 	R_SetParent (node->children[1], node);
+	node->numLeafs = node->children[0]->numLeafs + node->children[1]->numLeafs;
 }
 
 /*
@@ -1425,6 +1470,23 @@ static	void R_LoadNodesAndLeafs (lump_t *nodeLump, lump_t *leafLump) {
 
 	// chain decendants
 	R_SetParent (s_worldData.nodes, NULL);
+
+	// front end job scratch, see R_AddWorldSurfaces
+	s_worldData.jobLeafs = ri.Hunk_Alloc( numLeafs * sizeof( *s_worldData.jobLeafs ), h_low );
+	s_worldData.jobSurfs = ri.Hunk_Alloc( s_worldData.numsurfaces * sizeof( *s_worldData.jobSurfs ), h_low );
+	s_worldData.jobDrawSurfs = ri.Hunk_Alloc( s_worldData.numsurfaces * sizeof( *s_worldData.jobDrawSurfs ), h_low );
+
+	// vis lists, built on the first view
+	s_worldData.visListCount = -1;
+	s_worldData.visLeafs = ri.Hunk_Alloc( numLeafs * sizeof( *s_worldData.visLeafs ), h_low );
+	s_worldData.visSurfs = ri.Hunk_Alloc( s_worldData.numsurfaces * sizeof( *s_worldData.visSurfs ), h_low );
+	for ( j = 0 ; j < 6 ; j++ ) {
+		s_worldData.visLeafBounds[j] = ri.Hunk_Alloc( numLeafs * sizeof( float ), h_low );
+		s_worldData.visSurfBounds[j] = ri.Hunk_Alloc( s_worldData.numsurfaces * sizeof( float ), h_low );
+	}
+	s_worldData.visSurfMarks = ri.Hunk_Alloc( s_worldData.numsurfaces, h_low );
+	s_worldData.visIndexes = ri.Hunk_Alloc( ( numLeafs > s_worldData.numsurfaces ? numLeafs : s_worldData.numsurfaces )
+		* sizeof( *s_worldData.visIndexes ), h_low );
 }
 
 //=============================================================================
@@ -1452,7 +1514,11 @@ static	void R_LoadShaders( lump_t *l ) {
 	for ( i=0 ; i<count ; i++ ) {
 		out[i].surfaceFlags = LittleLong( out[i].surfaceFlags );
 		out[i].contentFlags = LittleLong( out[i].contentFlags );
+		R_PrefetchShaderImages( out[i].shader, qtrue );
 	}
+
+	// decode everything the surfaces' shaders will ask for up front
+	R_LoadPrefetchedImages();
 }
 
 
@@ -1679,6 +1745,8 @@ void R_LoadLightGrid( lump_t *l ) {
 		R_ColorShiftLightingBytes( &w->lightGridData[i*8], &w->lightGridData[i*8] );
 		R_ColorShiftLightingBytes( &w->lightGridData[i*8+3], &w->lightGridData[i*8+3] );
 	}
+
+	R_ClearLightGridCache();
 }
 
 /*
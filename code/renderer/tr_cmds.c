@@ -53,6 +53,9 @@ void R_PerformanceCounters( void ) {
 			tr.pc.c_box_cull_md3_in, tr.pc.c_box_cull_md3_clip, tr.pc.c_box_cull_md3_out );
 	} else if (r_speeds->integer == 3) {
 		ri.Printf (PRINT_ALL, "viewcluster: %i\n", tr.viewCluster );
+		if ( tr.world && r_visLists->integer ) {
+			ri.Printf (PRINT_ALL, "vis lists: %i leafs %i surfs\n", tr.world->numVisLeafs, tr.world->numVisSurfs );
+		}
 	} else if (r_speeds->integer == 4) {
 		if ( backEnd.pc.c_dlightVertexes ) {
 			ri.Printf (PRINT_ALL, "dlight srf:%i  culled:%i  verts:%i  tris:%i\n", 
@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 // tr_image.c
 #include "tr_local.h"
+#include <setjmp.h>
 
 /*
  * Include file for users of JPEG library.
@@ -165,12 +166,16 @@ void R_ImageList_f( void ) {
 	int		i;
 	image_t	*image;
 	int		texels;
+	int		msec;
+	int		cached;
 	const char *yesno[] = {
 		"no ", "yes"
 	};
 
-	ri.Printf (PRINT_ALL, "\n      -w-- -h-- -mm- -TMU- -if-- wrap --name-------\n");
+	ri.Printf (PRINT_ALL, "\n      -w-- -h-- -mm- -TMU- -if-- wrap -msec- --name-------\n");
 	texels = 0;
+	msec = 0;
+	cached = 0;
 
 	for ( i = 0 ; i < tr.numImages ; i++ ) {
 		image = tr.images[ i ];
@@ -221,12 +226,17 @@ void R_ImageList_f( void ) {
 			ri.Printf( PRINT_ALL, "%4i ", image->wrapClampMode );
 			break;
 		}
+
+		ri.Printf( PRINT_ALL, "%5i%c", image->loadMsec, image->cached ? 'c' : ' ' );
+		msec += image->loadMsec;
+		cached += image->cached;
 		
 		ri.Printf( PRINT_ALL, " %s\n", image->imgName );
 	}
 	ri.Printf (PRINT_ALL, " ---------\n");
 	ri.Printf (PRINT_ALL, " %i total texels (not including mipmaps)\n", texels);
-	ri.Printf (PRINT_ALL, " %i total images\n\n", tr.numImages );
+	ri.Printf (PRINT_ALL, " %i total images, %i from the image cache\n", tr.numImages, cached );
+	ri.Printf (PRINT_ALL, " %i msec loading\n\n", msec );
 }
 
 //=======================================================================
@@ -348,28 +358,26 @@ void R_LightScaleTexture (unsigned *in, int inwidth, int inheight, qboolean only
 ================
 R_MipMap2
 
-Operates in place, quartering the size of the texture
+Quarters the size of the texture into out
 Proper linear filter
 ================
 */
-static void R_MipMap2( unsigned *in, int inWidth, int inHeight ) {
+static void R_MipMap2( const unsigned *in, int inWidth, int inHeight, unsigned *out ) {
 	int			i, j, k;
 	byte		*outpix;
 	int			inWidthMask, inHeightMask;
 	int			total;
 	int			outWidth, outHeight;
-	unsigned	*temp;
 
 	outWidth = inWidth >> 1;
 	outHeight = inHeight >> 1;
-	temp = ri.Hunk_AllocateTempMemory( outWidth * outHeight * 4 );
 
 	inWidthMask = inWidth - 1;
 	inHeightMask = inHeight - 1;
 
 	for ( i = 0 ; i < outHeight ; i++ ) {
 		for ( j = 0 ; j < outWidth ; j++ ) {
-			outpix = (byte *) ( temp + i * outWidth + j );
+			outpix = (byte *) ( out + i * outWidth + j );
 			for ( k = 0 ; k < 4 ; k++ ) {
 				total = 
 					1 * ((byte *)&in[ ((i*2-1)&inHeightMask)*inWidth + ((j*2-1)&inWidthMask) ])[k] +
@@ -395,34 +403,35 @@ static void R_MipMap2( unsigned *in, int inWidth, int inHeight ) {
 			}
 		}
 	}
-
-	Com_Memcpy( in, temp, outWidth * outHeight * 4 );
-	ri.Hunk_FreeTempMemory( temp );
 }
 
 /*
 ================
 R_MipMap
 
-Operates in place, quartering the size of the texture
+Quarters the size of the texture into out, which must not overlap in
 ================
 */
-static void R_MipMap (byte *in, int width, int height) {
+static void R_MipMap (const byte *in, int width, int height, byte *out) {
 	int		i, j;
-	byte	*out;
 	int		row;
 
 	if ( !r_simpleMipMaps->integer ) {
-		R_MipMap2( (unsigned *)in, width, height );
+		if ( width == 1 || height == 1 ) {
+			// nothing for the filter to work on, the level is just cut down
+			Com_Memcpy( out, in, ( width > 1 ? width >> 1 : 1 ) * ( height > 1 ? height >> 1 : 1 ) * 4 );
+			return;
+		}
+		R_MipMap2( (const unsigned *)in, width, height, (unsigned *)out );
 		return;
 	}
 
 	if ( width == 1 && height == 1 ) {
+		Com_Memcpy( out, in, 4 );
 		return;
 	}
 
 	row = width * 4;
-	out = in;
 	width >>= 1;
 	height >>= 1;
 
@@ -493,28 +502,154 @@ byte	mipBlendColors[16][4] = {
 
 
 /*
-===============
-Upload32
+================
+R_SetImageFilter
+================
+*/
+static void R_SetImageFilter( qboolean mipmap ) {
+	if (mipmap)
+	{
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter_min);
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter_max);
+	}
+	else
+	{
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	}
+}
 
-===============
+/*
+=========================================================
+
+IMAGE CACHE
+
+Images that come out of a pure pak are kept under imagecache/
+as the exact mip chain Upload32 handed to GL, keyed by the pak
+checksum, the path and every setting that changes the uploaded
+texels.  A hit uploads the levels straight from the file and
+never touches the decoders, the resampler or the mipmapper.
+
+There is one file per path, so a stale entry is overwritten by
+the next miss and the directory never holds more files than the
+paks hold images.
+
+=========================================================
 */
-extern qboolean charSet;
-static void Upload32( unsigned *data, 
-						  int width, int height, 
-						  qboolean mipmap, 
-						  qboolean picmip, 
-							qboolean lightMap,
-						  int *format, 
-						  int *pUploadWidth, int *pUploadHeight )
-{
-	int			samples;
-	unsigned	*scaledBuffer = NULL;
-	unsigned	*resampledBuffer = NULL;
-	int			scaled_width, scaled_height;
-	int			i, c;
-	byte		*scan;
-	GLenum		internalFormat = GL_RGB;
-	float		rMax = 0, gMax = 0, bMax = 0;
+
+#define	IMAGE_CACHE_IDENT	(('C'<<24)+('G'<<16)+('M'<<8)+'I')
+#define	IMAGE_CACHE_VERSION	1
+#define	IMAGE_CACHE_KEY		192
+#define	IMAGE_CACHE_LEVELS	16
+
+typedef struct {
+	int		ident;
+	int		version;
+	char	key[IMAGE_CACHE_KEY];
+	int		width, height;				// source image
+	int		uploadWidth, uploadHeight;
+	int		internalFormat;
+	int		numLevels;					// RGBA texels of each level follow the header
+	int		size;						// of the whole file
+} imageCacheHeader_t;
+
+typedef struct {
+	qboolean	active;					// set by R_FindImageFile around R_CreateImage
+	char		key[IMAGE_CACHE_KEY];
+	int			width, height;
+} imageCapture_t;
+
+static imageCapture_t	imageCapture;
+
+/*
+================
+R_ImageCacheFile
+
+Names the cache file by an FNV-1a hash of the path at the front of
+the key, the full key is checked on load
+================
+*/
+static const char *R_ImageCacheFile( const char *key ) {
+	unsigned	hash;
+
+	hash = 2166136261u;
+	while ( *key && *key != ' ' ) {
+		hash ^= (byte)*key++;
+		hash *= 16777619u;
+	}
+	return va( "imagecache/%08x.dat", hash );
+}
+
+/*
+================
+R_MipChainSize
+
+Bytes of RGBA texels in a chain that starts at width x height
+================
+*/
+static int R_MipChainSize( int width, int height, qboolean mipmap, int *numLevels ) {
+	int		size;
+
+	size = width * height * 4;
+	*numLevels = 1;
+	while ( mipmap && ( width > 1 || height > 1 ) ) {
+		width = width > 1 ? width >> 1 : 1;
+		height = height > 1 ? height >> 1 : 1;
+		size += width * height * 4;
+		(*numLevels)++;
+	}
+	return size;
+}
+
+/*
+================
+R_WriteCachedImage
+================
+*/
+static void R_WriteCachedImage( const char *key, int width, int height, imageCacheHeader_t *chain ) {
+	chain->ident = IMAGE_CACHE_IDENT;
+	chain->version = IMAGE_CACHE_VERSION;
+	Q_strncpyz( chain->key, key, sizeof( chain->key ) );
+	chain->width = width;
+	chain->height = height;
+
+	ri.FS_WriteFile( R_ImageCacheFile( key ), chain, chain->size );
+	ri.Printf( PRINT_DEVELOPER, "cached %s (%i bytes)\n", key, chain->size );
+}
+
+/*
+=========================================================
+
+MIP CHAINS
+
+Everything Upload32 does to the texels before GL sees them,
+split from the upload so it can run on any thread.  Nothing
+here touches ri, GL or shared state; the caller hands in all
+the memory, sized by R_ImageLayout.
+
+=========================================================
+*/
+
+typedef struct {
+	int		width, height;				// source image
+	int		powerWidth, powerHeight;	// after rounding to a power of two
+	int		scaledWidth, scaledHeight;	// level 0, after picmip and the GL limit
+	int		numLevels;
+	int		chainSize;					// imageCacheHeader_t and all the levels
+	int		resampleSize;				// 0 if the source is a power of two already
+	int		mipSize;					// 0 if the power of two size is level 0
+} imageLayout_t;
+
+/*
+================
+R_ImageLayout
+================
+*/
+static void R_ImageLayout( int width, int height, qboolean mipmap, qboolean picmip, imageLayout_t *layout ) {
+	int		scaled_width, scaled_height;
+
+	layout->width = width;
+	layout->height = height;
 
 	//
 	// convert to exact power of 2 sizes
@@ -528,12 +663,12 @@ static void Upload32( unsigned *data,
 	if ( r_roundImagesDown->integer && scaled_height > height )
 		scaled_height >>= 1;
 
+	layout->powerWidth = scaled_width;
+	layout->powerHeight = scaled_height;
 	if ( scaled_width != width || scaled_height != height ) {
-		resampledBuffer = ri.Hunk_AllocateTempMemory( scaled_width * scaled_height * 4 );
-		ResampleTexture (data, width, height, resampledBuffer, scaled_width, scaled_height);
-		data = resampledBuffer;
-		width = scaled_width;
-		height = scaled_height;
+		layout->resampleSize = scaled_width * scaled_height * 4;
+	} else {
+		layout->resampleSize = 0;
 	}
 
 	//
@@ -565,7 +700,49 @@ static void Upload32( unsigned *data,
 		scaled_height >>= 1;
 	}
 
-	scaledBuffer = ri.Hunk_AllocateTempMemory( sizeof( unsigned ) * scaled_width * scaled_height );
+	layout->scaledWidth = scaled_width;
+	layout->scaledHeight = scaled_height;
+	if ( scaled_width != layout->powerWidth || scaled_height != layout->powerHeight ) {
+		layout->mipSize = ( layout->powerWidth > 1 ? layout->powerWidth >> 1 : 1 )
+			* ( layout->powerHeight > 1 ? layout->powerHeight >> 1 : 1 ) * 4;
+	} else {
+		layout->mipSize = 0;
+	}
+
+	layout->chainSize = sizeof( imageCacheHeader_t )
+		+ R_MipChainSize( scaled_width, scaled_height, mipmap, &layout->numLevels );
+}
+
+/*
+================
+R_BuildImageChain
+
+Fills chain with the levels Upload32 would upload for data.
+data is overwritten when it has to be mipped down to level 0.
+================
+*/
+static void R_BuildImageChain( unsigned *data, const imageLayout_t *layout, qboolean mipmap, qboolean lightMap,
+							  imageCacheHeader_t *chain, unsigned *resampledBuffer, unsigned *mipBuffer ) {
+	int			samples;
+	int			width, height;
+	int			scaled_width, scaled_height;
+	int			i, c;
+	byte		*scan;
+	byte		*level, *next;
+	GLenum		internalFormat = GL_RGB;
+	float		rMax = 0, gMax = 0, bMax = 0;
+
+	width = layout->width;
+	height = layout->height;
+	scaled_width = layout->scaledWidth;
+	scaled_height = layout->scaledHeight;
+
+	if ( layout->resampleSize ) {
+		ResampleTexture (data, width, height, resampledBuffer, layout->powerWidth, layout->powerHeight);
+		data = resampledBuffer;
+		width = layout->powerWidth;
+		height = layout->powerHeight;
+	}
 
 	//
 	// scan the texture for each channel's max values
@@ -633,102 +810,155 @@ static void Upload32( unsigned *data,
 	} else {
 		internalFormat = 3;
 	}
+
+	chain->uploadWidth = scaled_width;
+	chain->uploadHeight = scaled_height;
+	chain->internalFormat = internalFormat;
+	chain->numLevels = layout->numLevels;
+	chain->size = layout->chainSize;
+
 	// copy or resample data as appropriate for first MIP level
+	level = (byte *)( chain + 1 );
 	if ( ( scaled_width == width ) && 
 		( scaled_height == height ) ) {
+		Com_Memcpy (level, data, width*height*4);
 		if (!mipmap)
 		{
-			qglTexImage2D (GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-			*pUploadWidth = scaled_width;
-			*pUploadHeight = scaled_height;
-			*format = internalFormat;
-
-			goto done;
+			// uploaded as is, without the light scale
+			return;
 		}
-		Com_Memcpy (scaledBuffer, data, width*height*4);
 	}
 	else
 	{
-		// use the normal mip-mapping function to go down from here
+		byte	*src, *dst;
+		int		nextWidth, nextHeight;
+
+		// use the normal mip-mapping function to go down from here,
+		// the last step lands in level 0
+		src = (byte *)data;
 		while ( width > scaled_width || height > scaled_height ) {
-			R_MipMap( (byte *)data, width, height );
-			width >>= 1;
-			height >>= 1;
-			if ( width < 1 ) {
-				width = 1;
-			}
-			if ( height < 1 ) {
-				height = 1;
+			nextWidth = width > 1 ? width >> 1 : 1;
+			nextHeight = height > 1 ? height >> 1 : 1;
+			if ( nextWidth <= scaled_width && nextHeight <= scaled_height ) {
+				dst = level;
+			} else if ( src == (byte *)mipBuffer ) {
+				dst = (byte *)data;
+			} else {
+				dst = (byte *)mipBuffer;
 			}
+			R_MipMap( src, width, height, dst );
+			src = dst;
+			width = nextWidth;
+			height = nextHeight;
 		}
-		Com_Memcpy( scaledBuffer, data, width * height * 4 );
 	}
 
-	R_LightScaleTexture (scaledBuffer, scaled_width, scaled_height, !mipmap );
-
-	*pUploadWidth = scaled_width;
-	*pUploadHeight = scaled_height;
-	*format = internalFormat;
+	R_LightScaleTexture ((unsigned *)level, scaled_width, scaled_height, !mipmap );
 
-	qglTexImage2D (GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+	for ( i = 1 ; i < layout->numLevels ; i++ ) {
+		next = level + scaled_width * scaled_height * 4;
+		R_MipMap( level, scaled_width, scaled_height, next );
+		scaled_width = scaled_width > 1 ? scaled_width >> 1 : 1;
+		scaled_height = scaled_height > 1 ? scaled_height >> 1 : 1;
 
-	if (mipmap)
-	{
-		int		miplevel;
+		if ( r_colorMipLevels->integer ) {
+			R_BlendOverTexture( next, scaled_width * scaled_height, mipBlendColors[i] );
+		}
+		level = next;
+	}
+}
 
-		miplevel = 0;
-		while (scaled_width > 1 || scaled_height > 1)
-		{
-			R_MipMap( (byte *)scaledBuffer, scaled_width, scaled_height );
-			scaled_width >>= 1;
-			scaled_height >>= 1;
-			if (scaled_width < 1)
-				scaled_width = 1;
-			if (scaled_height < 1)
-				scaled_height = 1;
-			miplevel++;
-
-			if ( r_colorMipLevels->integer ) {
-				R_BlendOverTexture( (byte *)scaledBuffer, scaled_width * scaled_height, mipBlendColors[miplevel] );
-			}
+/*
+================
+R_UploadImageChain
+================
+*/
+static void R_UploadImageChain( const imageCacheHeader_t *chain, qboolean mipmap ) {
+	const byte	*data;
+	int			width, height;
+	int			i;
 
-			qglTexImage2D (GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
-		}
+	data = (const byte *)( chain + 1 );
+	width = chain->uploadWidth;
+	height = chain->uploadHeight;
+	for ( i = 0 ; i < chain->numLevels ; i++ ) {
+		qglTexImage2D (GL_TEXTURE_2D, i, chain->internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data );
+		data += width * height * 4;
+		width = width > 1 ? width >> 1 : 1;
+		height = height > 1 ? height >> 1 : 1;
 	}
-done:
 
-	if (mipmap)
-	{
-		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter_min);
-		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter_max);
+	R_SetImageFilter( mipmap );
+
+	GL_CheckErrors();
+}
+
+/*
+===============
+Upload32
+
+===============
+*/
+extern qboolean charSet;
+static void Upload32( unsigned *data, 
+						  int width, int height, 
+						  qboolean mipmap, 
+						  qboolean picmip, 
+							qboolean lightMap,
+						  int *format, 
+						  int *pUploadWidth, int *pUploadHeight )
+{
+	imageLayout_t		layout;
+	imageCacheHeader_t	*chain;
+	unsigned			*resampledBuffer = NULL;
+	unsigned			*mipBuffer = NULL;
+
+	R_ImageLayout( width, height, mipmap, picmip, &layout );
+
+	chain = ri.Hunk_AllocateTempMemory( layout.chainSize );
+	if ( layout.resampleSize ) {
+		resampledBuffer = ri.Hunk_AllocateTempMemory( layout.resampleSize );
 	}
-	else
-	{
-		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	if ( layout.mipSize ) {
+		mipBuffer = ri.Hunk_AllocateTempMemory( layout.mipSize );
 	}
 
-	GL_CheckErrors();
+	R_BuildImageChain( data, &layout, mipmap, lightMap, chain, resampledBuffer, mipBuffer );
 
-	if ( scaledBuffer != 0 )
-		ri.Hunk_FreeTempMemory( scaledBuffer );
+	if ( mipBuffer != 0 )
+		ri.Hunk_FreeTempMemory( mipBuffer );
 	if ( resampledBuffer != 0 )
 		ri.Hunk_FreeTempMemory( resampledBuffer );
+
+	R_UploadImageChain( chain, mipmap );
+
+	*pUploadWidth = chain->uploadWidth;
+	*pUploadHeight = chain->uploadHeight;
+	*format = chain->internalFormat;
+
+	if ( imageCapture.active && chain->numLevels <= IMAGE_CACHE_LEVELS ) {
+		R_WriteCachedImage( imageCapture.key, imageCapture.width, imageCapture.height, chain );
+	}
+
+	ri.Hunk_FreeTempMemory( chain );
 }
 
 
 /*
 ================
-R_CreateImage
+R_CreateImageExt
 
-This is the only way any image_t are created
+This is the only way any image_t are created.
+With a cache the texels come from its mip chain instead of pic.
 ================
 */
-image_t *R_CreateImage( const char *name, const byte *pic, int width, int height, 
-					   qboolean mipmap, qboolean allowPicmip, int glWrapClampMode ) {
+static image_t *R_CreateImageExt( const char *name, const byte *pic, int width, int height, 
+					   qboolean mipmap, qboolean allowPicmip, int glWrapClampMode,
+					   const imageCacheHeader_t *cache ) {
 	image_t		*image;
 	qboolean	isLightmap = qfalse;
 	long		hash;
+	int			start;
 
 	if (strlen(name) >= MAX_QPATH ) {
 		ri.Error (ERR_DROP, "R_CreateImage: \"%s\" is too long\n", name);
@@ -767,13 +997,22 @@ image_t *R_CreateImage( const char *name, const byte *pic, int width, int height
 
 	GL_Bind(image);
 
-	Upload32( (unsigned *)pic, image->width, image->height, 
-								image->mipmap,
-								allowPicmip,
-								isLightmap,
-								&image->internalFormat,
-								&image->uploadWidth,
-								&image->uploadHeight );
+	start = ri.Milliseconds();
+	if ( cache ) {
+		R_UploadImageChain( cache, mipmap );
+		image->internalFormat = cache->internalFormat;
+		image->uploadWidth = cache->uploadWidth;
+		image->uploadHeight = cache->uploadHeight;
+	} else {
+		Upload32( (unsigned *)pic, image->width, image->height, 
+									image->mipmap,
+									allowPicmip,
+									isLightmap,
+									&image->internalFormat,
+									&image->uploadWidth,
+									&image->uploadHeight );
+	}
+	image->loadMsec = ri.Milliseconds() - start;
 
 	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrapClampMode );
 	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrapClampMode );
@@ -791,6 +1030,103 @@ image_t *R_CreateImage( const char *name, const byte *pic, int width, int height
 	return image;
 }
 
+/*
+================
+R_CreateImage
+================
+*/
+image_t *R_CreateImage( const char *name, const byte *pic, int width, int height, 
+					   qboolean mipmap, qboolean allowPicmip, int glWrapClampMode ) {
+	return R_CreateImageExt( name, pic, width, height, mipmap, allowPicmip, glWrapClampMode, NULL );
+}
+
+/*
+================
+R_ImageCacheKey
+
+Only images read from a pure pak, with no loose file in front of it,
+can be cached, the pak checksum stands in for the contents.  It has to be the unkeyed one, the pure
+checksum changes with fs_checksumFeed on every map load.  Returns qfalse if the image can't be.
+================
+*/
+static qboolean R_ImageCacheKey( const char *name, qboolean mipmap, qboolean allowPicmip, char *key, int keySize ) {
+	char		source[MAX_QPATH];
+	int			checksum;
+	int			found;
+	int			len;
+	unsigned	tables;
+	int			i;
+
+	if ( !r_imageCache->integer || r_colorMipLevels->integer ) {
+		return qfalse;
+	}
+
+	// a loose file that shadows the pak copy can't be cached
+	Q_strncpyz( source, name, sizeof( source ) );
+	found = ri.FS_FilePakChecksum( source, &checksum );
+	if ( found == -1 ) {
+		// R_LoadImage falls back to a jpg when the tga is missing
+		len = strlen( source );
+		if ( len < 5 || Q_stricmp( source + len - 4, ".tga" ) ) {
+			return qfalse;
+		}
+		strcpy( source + len - 3, "jpg" );
+		found = ri.FS_FilePakChecksum( source, &checksum );
+	}
+	if ( found != 1 ) {
+		return qfalse;
+	}
+
+	// the gamma and overbright settings are baked into the texels
+	tables = 2166136261u;
+	for ( i = 0 ; i < 256 ; i++ ) {
+		tables = ( tables ^ s_gammatable[i] ) * 16777619u;
+		tables = ( tables ^ s_intensitytable[i] ) * 16777619u;
+	}
+
+	Com_sprintf( key, keySize, "%s %08x %i%i %i %i %i %i %i %i %i %08x",
+		source, checksum, mipmap, allowPicmip,
+		allowPicmip ? r_picmip->integer : 0, r_roundImagesDown->integer,
+		r_simpleMipMaps->integer, r_texturebits->integer,
+		glConfig.textureCompression, glConfig.maxTextureSize,
+		glConfig.deviceSupportsGamma, tables );
+
+	return qtrue;
+}
+
+/*
+================
+R_LoadCachedImage
+
+Returns NULL on a miss or a stale / damaged cache file
+================
+*/
+static image_t *R_LoadCachedImage( const char *name, const char *key, qboolean mipmap, qboolean allowPicmip, int glWrapClampMode ) {
+	imageCacheHeader_t	*cache;
+	image_t				*image;
+	int					len;
+	int					numLevels;
+
+	len = ri.FS_ReadFile( R_ImageCacheFile( key ), (void **)&cache );
+	if ( !cache ) {
+		return NULL;
+	}
+
+	image = NULL;
+	if ( len >= sizeof( *cache ) && cache->ident == IMAGE_CACHE_IDENT && cache->version == IMAGE_CACHE_VERSION
+		&& !strncmp( cache->key, key, sizeof( cache->key ) ) && cache->size == len
+		&& cache->uploadWidth > 0 && cache->uploadHeight > 0
+		&& cache->uploadWidth <= glConfig.maxTextureSize && cache->uploadHeight <= glConfig.maxTextureSize
+		&& sizeof( *cache ) + R_MipChainSize( cache->uploadWidth, cache->uploadHeight, mipmap, &numLevels ) == len
+		&& cache->numLevels == numLevels ) {
+		image = R_CreateImageExt( name, NULL, cache->width, cache->height, mipmap, allowPicmip, glWrapClampMode, cache );
+		image->cached = qtrue;
+	}
+
+	ri.FS_FreeFile( cache );
+	return image;
+}
+
 
 /*
 =========================================================
@@ -1115,83 +1451,61 @@ TARGA LOADING
 
 /*
 =============
-LoadTGA
+R_ReadTGAHeader
+
+Returns the first pixel, past the header and the image comment
 =============
 */
-static void LoadTGA ( const char *name, byte **pic, int *width, int *height)
+static byte *R_ReadTGAHeader( byte *buffer, TargaHeader *header )
 {
-	int		columns, rows, numPixels;
-	byte	*pixbuf;
-	int		row, column;
 	byte	*buf_p;
-	byte	*buffer;
-	TargaHeader	targa_header;
-	byte		*targa_rgba;
-
-	*pic = NULL;
-
-	//
-	// load the file
-	//
-	ri.FS_ReadFile ( ( char * ) name, (void **)&buffer);
-	if (!buffer) {
-		return;
-	}
 
 	buf_p = buffer;
 
-	targa_header.id_length = *buf_p++;
-	targa_header.colormap_type = *buf_p++;
-	targa_header.image_type = *buf_p++;
+	header->id_length = *buf_p++;
+	header->colormap_type = *buf_p++;
+	header->image_type = *buf_p++;
 	
-	targa_header.colormap_index = LittleShort ( *(short *)buf_p );
+	header->colormap_index = LittleShort ( *(short *)buf_p );
 	buf_p += 2;
-	targa_header.colormap_length = LittleShort ( *(short *)buf_p );
+	header->colormap_length = LittleShort ( *(short *)buf_p );
 	buf_p += 2;
-	targa_header.colormap_size = *buf_p++;
-	targa_header.x_origin = LittleShort ( *(short *)buf_p );
+	header->colormap_size = *buf_p++;
+	header->x_origin = LittleShort ( *(short *)buf_p );
 	buf_p += 2;
-	targa_header.y_origin = LittleShort ( *(short *)buf_p );
+	header->y_origin = LittleShort ( *(short *)buf_p );
 	buf_p += 2;
-	targa_header.width = LittleShort ( *(short *)buf_p );
+	header->width = LittleShort ( *(short *)buf_p );
 	buf_p += 2;
-	targa_header.height = LittleShort ( *(short *)buf_p );
+	header->height = LittleShort ( *(short *)buf_p );
 	buf_p += 2;
-	targa_header.pixel_size = *buf_p++;
-	targa_header.attributes = *buf_p++;
+	header->pixel_size = *buf_p++;
+	header->attributes = *buf_p++;
 
-	if (targa_header.image_type!=2 
-		&& targa_header.image_type!=10
-		&& targa_header.image_type != 3 ) 
-	{
-		ri.Error (ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported\n");
-	}
+	if (header->id_length != 0)
+		buf_p += header->id_length;  // skip TARGA image comment
 
-	if ( targa_header.colormap_type != 0 )
-	{
-		ri.Error( ERR_DROP, "LoadTGA: colormaps not supported\n" );
-	}
+	return buf_p;
+}
 
-	if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 )
-	{
-		ri.Error (ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)\n");
-	}
+/*
+=============
+R_DecodeTGA
+
+Expands the pixels into targa_rgba, the header has been checked
+=============
+*/
+static void R_DecodeTGA( const char *name, const TargaHeader *header, byte *buf_p, byte *targa_rgba )
+{
+	int		columns, rows;
+	byte	*pixbuf;
+	int		row, column;
+	TargaHeader	targa_header;
 
+	targa_header = *header;
 	columns = targa_header.width;
 	rows = targa_header.height;
-	numPixels = columns * rows;
-
-	if (width)
-		*width = columns;
-	if (height)
-		*height = rows;
-
-	targa_rgba = ri.Malloc (numPixels*4);
-	*pic = targa_rgba;
 
-	if (targa_header.id_length != 0)
-		buf_p += targa_header.id_length;  // skip TARGA image comment
-	
 	if ( targa_header.image_type==2 || targa_header.image_type == 3 )
 	{ 
 		// Uncompressed RGB or gray scale image
@@ -1329,6 +1643,63 @@ static void LoadTGA ( const char *name, byte **pic, int *width, int *height)
 			breakOut:;
 		}
 	}
+}
+
+/*
+=============
+LoadTGA
+=============
+*/
+static void LoadTGA ( const char *name, byte **pic, int *width, int *height)
+{
+	int		columns, rows, numPixels;
+	byte	*buf_p;
+	byte	*buffer;
+	TargaHeader	targa_header;
+	byte		*targa_rgba;
+
+	*pic = NULL;
+
+	//
+	// load the file
+	//
+	ri.FS_ReadFile ( ( char * ) name, (void **)&buffer);
+	if (!buffer) {
+		return;
+	}
+
+	buf_p = R_ReadTGAHeader( buffer, &targa_header );
+
+	if (targa_header.image_type!=2 
+		&& targa_header.image_type!=10
+		&& targa_header.image_type != 3 ) 
+	{
+		ri.Error (ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported\n");
+	}
+
+	if ( targa_header.colormap_type != 0 )
+	{
+		ri.Error( ERR_DROP, "LoadTGA: colormaps not supported\n" );
+	}
+
+	if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 )
+	{
+		ri.Error (ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)\n");
+	}
+
+	columns = targa_header.width;
+	rows = targa_header.height;
+	numPixels = columns * rows;
+
+	if (width)
+		*width = columns;
+	if (height)
+		*height = rows;
+
+	targa_rgba = ri.Malloc (numPixels*4);
+	*pic = targa_rgba;
+
+	R_DecodeTGA( name, &targa_header, buf_p, targa_rgba );
 
 #if 0 
   // TTimo: this is the chunk of code to ensure a behavior that meets TGA specs 
@@ -1858,6 +2229,8 @@ image_t	*R_FindImageFile( const char *name, qboolean mipmap, qboolean allowPicmi
 	int		width, height;
 	byte	*pic;
 	long	hash;
+	int		start;
+	char	key[IMAGE_CACHE_KEY];
 
 	if (!name) {
 		return NULL;
@@ -1886,6 +2259,21 @@ image_t	*R_FindImageFile( const char *name, qboolean mipmap, qboolean allowPicmi
 		}
 	}
 
+	start = ri.Milliseconds();
+
+	//
+	// a cached mip chain skips decoding entirely
+	//
+	imageCapture.active = R_ImageCacheKey( name, mipmap, allowPicmip, key, sizeof( key ) );
+	if ( imageCapture.active ) {
+		image = R_LoadCachedImage( name, key, mipmap, allowPicmip, glWrapClampMode );
+		if ( image ) {
+			imageCapture.active = qfalse;
+			image->loadMsec = ri.Milliseconds() - start;
+			return image;
+		}
+	}
+
 	//
 	// load the pic from disk
 	//
@@ -1901,16 +2289,640 @@ image_t	*R_FindImageFile( const char *name, qboolean mipmap, qboolean allowPicmi
 		ri.Printf( PRINT_ALL, "trying %s...\n", altname );    // 
 	  R_LoadImage( altname, &pic, &width, &height );        //
     if (pic == NULL) {                                    // if that fails
+      imageCapture.active = qfalse;                       //
       return NULL;                                        // bail
     }
 	}
 
+	if ( imageCapture.active ) {
+		Q_strncpyz( imageCapture.key, key, sizeof( imageCapture.key ) );
+		imageCapture.width = width;
+		imageCapture.height = height;
+	}
 	image = R_CreateImage( ( char * ) name, pic, width, height, mipmap, allowPicmip, glWrapClampMode );
+	imageCapture.active = qfalse;
 	ri.Free( pic );
+	image->loadMsec = ri.Milliseconds() - start;
 	return image;
 }
 
 
+/*
+=========================================================
+
+IMAGE PREFETCH
+
+With r_imageThreads the images that the map's shaders will ask
+for are queued before any shader is parsed and loaded in batches.
+The files are read and checked here, decoded and mipped on the
+GLimp_RunFrontEndJobs workers, then uploaded in queue order.
+A worker never calls into ri, not even for the clock, so the
+jobs are timed as a whole on the main thread; its memory comes
+from an arena carved out up front.  Anything it can't handle is simply left
+for R_FindImageFile to load the usual way.
+
+=========================================================
+*/
+
+#define	IMAGE_BATCH_JOBS	64
+#define	IMAGE_BATCH_BYTES	( 16 * 1024 * 1024 )
+
+typedef struct {
+	char		name[MAX_QPATH];
+	qboolean	mipmap;
+	qboolean	allowPicmip;
+	int			wrapClampMode;
+	int			next;					// hash chain, index + 1
+} imagePrefetch_t;
+
+static imagePrefetch_t	imagePrefetch[MAX_DRAWIMAGES];
+static int				numImagePrefetch;
+static int				imagePrefetchHash[FILE_HASH_SIZE];	// index + 1
+
+typedef struct {
+	byte	*base;
+	int		size;
+	int		used;
+} imageArena_t;
+
+typedef struct {
+	const imagePrefetch_t	*request;
+	char				fileName[MAX_QPATH];
+	byte				*file;				// from FS_ReadFile
+	int					fileLength;
+	qboolean			jpeg;
+	TargaHeader			targa;
+	byte				*targaPixels;		// past the targa header
+	int					width, height;
+	imageLayout_t		layout;
+	int					arenaSize;
+	imageArena_t		arena;
+
+	// set by the worker
+	qboolean			done;
+	imageCacheHeader_t	*chain;
+} imageJob_t;
+
+typedef struct {
+	int		images;
+	int		skipped;			// left for R_FindImageFile
+	int		bytes;				// read from disk
+	int		readMsec;
+	int		jobMsec;			// wall clock for the worker pool
+	int		uploadMsec;
+} imageLoadStats_t;
+
+typedef struct {
+	struct jpeg_error_mgr	pub;
+	imageArena_t			*arena;
+	jmp_buf					abort;
+} jpegJobError_t;
+
+static imageJob_t	*imageJobs;
+
+/*
+================
+R_ArenaAlloc
+
+Returns NULL when the arena is used up
+================
+*/
+static void *R_ArenaAlloc( imageArena_t *arena, int size ) {
+	byte	*p;
+
+	size = ( size + 15 ) & ~15;
+	if ( arena->used + size > arena->size ) {
+		return NULL;
+	}
+	p = arena->base + arena->used;
+	arena->used += size;
+	return p;
+}
+
+/*
+================
+R_JpegJobErrorExit
+================
+*/
+static void R_JpegJobErrorExit( j_common_ptr cinfo ) {
+	longjmp( ( (jpegJobError_t *)cinfo->err )->abort, 1 );
+}
+
+/*
+================
+R_JpegJobMessage
+
+Workers can't print, corrupt data warnings are dropped
+================
+*/
+static void R_JpegJobMessage( j_common_ptr cinfo ) {
+}
+
+/*
+================
+R_JpegJobOwns
+
+Called by the jpeg memory manager in jmemnobs.c
+================
+*/
+boolean R_JpegJobOwns( j_common_ptr cinfo ) {
+	return cinfo->err->error_exit == R_JpegJobErrorExit;
+}
+
+/*
+================
+R_JpegJobAlloc
+
+A NULL return makes the library bail out through R_JpegJobErrorExit
+================
+*/
+void *R_JpegJobAlloc( j_common_ptr cinfo, size_t size ) {
+	return R_ArenaAlloc( ( (jpegJobError_t *)cinfo->err )->arena, size );
+}
+
+/*
+================
+R_ReadJPGSize
+
+Walks the markers up to the frame header
+================
+*/
+static qboolean R_ReadJPGSize( const byte *buffer, int length, int *width, int *height, qboolean *progressive ) {
+	int		i, marker, size;
+
+	if ( length < 4 || buffer[0] != 0xff || buffer[1] != 0xd8 ) {
+		return qfalse;
+	}
+
+	for ( i = 2 ; i + 4 <= length ; i += 2 + size ) {
+		if ( buffer[i] != 0xff ) {
+			return qfalse;
+		}
+		marker = buffer[i+1];
+		size = ( buffer[i+2] << 8 ) | buffer[i+3];
+
+		// SOF0 - SOF15, except DHT, JPG and DAC
+		if ( marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc ) {
+			if ( i + 9 > length ) {
+				return qfalse;
+			}
+			*height = ( buffer[i+5] << 8 ) | buffer[i+6];
+			*width = ( buffer[i+7] << 8 ) | buffer[i+8];
+			*progressive = ( marker & 3 ) == 2;
+			return qtrue;
+		}
+		if ( marker == 0xda || marker == 0xd9 ) {
+			return qfalse;		// scan data before a frame header
+		}
+	}
+
+	return qfalse;
+}
+
+/*
+================
+R_DecodeJPGJob
+
+LoadJPG for a worker
+================
+*/
+static qboolean R_DecodeJPGJob( imageJob_t *job, byte *out ) {
+	struct jpeg_decompress_struct	cinfo;
+	jpegJobError_t					jerr;
+	JSAMPARRAY	buffer;
+	int			row_stride;
+	byte		*bbuf;
+	int			i, j;
+
+	cinfo.err = jpeg_std_error( &jerr.pub );
+	jerr.pub.error_exit = R_JpegJobErrorExit;
+	jerr.pub.output_message = R_JpegJobMessage;
+	jerr.arena = &job->arena;
+	if ( setjmp( jerr.abort ) ) {
+		return qfalse;
+	}
+
+	jpeg_create_decompress( &cinfo );
+	jpeg_stdio_src( &cinfo, job->file );
+	(void) jpeg_read_header( &cinfo, TRUE );
+	(void) jpeg_start_decompress( &cinfo );
+
+	if ( cinfo.output_width != job->width || cinfo.output_height != job->height
+		|| cinfo.output_components != 4 ) {
+		return qfalse;
+	}
+
+	row_stride = cinfo.output_width * cinfo.output_components;
+	while ( cinfo.output_scanline < cinfo.output_height ) {
+		bbuf = out + row_stride * cinfo.output_scanline;
+		buffer = &bbuf;
+		(void) jpeg_read_scanlines( &cinfo, buffer, 1 );
+	}
+
+	// clear all the alphas to 255
+	j = cinfo.output_width * cinfo.output_height * 4;
+	for ( i = 3 ; i < j ; i += 4 ) {
+		out[i] = 255;
+	}
+
+	(void) jpeg_finish_decompress( &cinfo );
+	jpeg_destroy_decompress( &cinfo );
+
+	return qtrue;
+}
+
+/*
+================
+R_ImageJob
+
+Runs on a worker
+================
+*/
+static void R_ImageJob( int index ) {
+	imageJob_t	*job;
+	byte		*pixels;
+	unsigned	*resampledBuffer, *mipBuffer;
+
+	job = &imageJobs[index];
+
+	pixels = R_ArenaAlloc( &job->arena, job->width * job->height * 4 );
+	job->chain = R_ArenaAlloc( &job->arena, job->layout.chainSize );
+	resampledBuffer = R_ArenaAlloc( &job->arena, job->layout.resampleSize );
+	mipBuffer = R_ArenaAlloc( &job->arena, job->layout.mipSize );
+
+	if ( job->jpeg ) {
+		if ( !R_DecodeJPGJob( job, pixels ) ) {
+			return;
+		}
+	} else {
+		R_DecodeTGA( job->fileName, &job->targa, job->targaPixels, pixels );
+	}
+
+	R_BuildImageChain( (unsigned *)pixels, &job->layout, job->request->mipmap, qfalse,
+		job->chain, resampledBuffer, mipBuffer );
+
+	job->done = qtrue;
+}
+
+/*
+================
+R_ImageLoaded
+================
+*/
+static qboolean R_ImageLoaded( const char *name ) {
+	image_t	*image;
+
+	for ( image = hashTable[generateHashValue( name )] ; image ; image = image->next ) {
+		if ( !strcmp( name, image->imgName ) ) {
+			return qtrue;
+		}
+	}
+	return qfalse;
+}
+
+/*
+================
+R_PrepareImageJob
+
+Reads the file and sizes the job on the main thread, returns qfalse
+with nothing allocated if the image is better left to R_FindImageFile
+================
+*/
+static qboolean R_PrepareImageJob( const imagePrefetch_t *request, imageJob_t *job, qboolean bench ) {
+	char		key[IMAGE_CACHE_KEY];
+	int			len;
+	qboolean	progressive;
+	int			jpegSize;
+
+	Com_Memset( job, 0, sizeof( *job ) );
+	job->request = request;
+
+	if ( !bench ) {
+		if ( R_ImageLoaded( request->name ) ) {
+			return qfalse;
+		}
+		// a cache file only means a hit if its key matches, and checking
+		// that costs the read anyway, so a hit is uploaded right here
+		if ( R_ImageCacheKey( request->name, request->mipmap, request->allowPicmip, key, sizeof( key ) )
+			&& R_LoadCachedImage( request->name, key, request->mipmap, request->allowPicmip, request->wrapClampMode ) ) {
+			return qfalse;
+		}
+	}
+
+	// the same search as R_LoadImage
+	Q_strncpyz( job->fileName, request->name, sizeof( job->fileName ) );
+	len = strlen( job->fileName );
+	if ( len < 5 ) {
+		return qfalse;
+	}
+	if ( !Q_stricmp( job->fileName + len - 4, ".tga" ) ) {
+		job->fileLength = ri.FS_ReadFile( job->fileName, (void **)&job->file );
+		if ( !job->file ) {
+			strcpy( job->fileName + len - 3, "jpg" );
+			job->jpeg = qtrue;
+		}
+	} else if ( !Q_stricmp( job->fileName + len - 4, ".jpg" ) ) {
+		job->jpeg = qtrue;
+	} else {
+		return qfalse;
+	}
+	if ( job->jpeg ) {
+		job->fileLength = ri.FS_ReadFile( job->fileName, (void **)&job->file );
+	}
+	if ( !job->file ) {
+		return qfalse;
+	}
+
+	// only what the decoders handle without an error
+	jpegSize = 0;
+	if ( job->jpeg ) {
+		if ( !R_ReadJPGSize( job->file, job->fileLength, &job->width, &job->height, &progressive ) ) {
+			ri.FS_FreeFile( job->file );
+			return qfalse;
+		}
+		// the library's working memory, a whole coefficient image when progressive
+		jpegSize = 128 * 1024 + ( ( job->width + 15 ) & ~15 ) * 512;
+		if ( progressive ) {
+			jpegSize += ( ( job->width + 15 ) & ~15 ) * ( ( job->height + 15 ) & ~15 ) * 6;
+		}
+	} else {
+		if ( job->fileLength < 18 ) {
+			ri.FS_FreeFile( job->file );
+			return qfalse;
+		}
+		job->targaPixels = R_ReadTGAHeader( job->file, &job->targa );
+		if ( job->targa.colormap_type != 0 || job->targa.attributes & 0x20
+			|| !( ( ( job->targa.image_type == 2 || job->targa.image_type == 10 )
+				&& ( job->targa.pixel_size == 24 || job->targa.pixel_size == 32 ) )
+			|| ( job->targa.image_type == 3 && job->targa.pixel_size == 8 ) ) ) {
+			ri.FS_FreeFile( job->file );
+			return qfalse;
+		}
+		job->width = job->targa.width;
+		job->height = job->targa.height;
+	}
+
+	if ( job->width <= 0 || job->height <= 0 ) {
+		ri.FS_FreeFile( job->file );
+		return qfalse;
+	}
+
+	R_ImageLayout( job->width, job->height, request->mipmap, request->allowPicmip, &job->layout );
+	if ( job->layout.powerWidth > 2048 || job->layout.numLevels > IMAGE_CACHE_LEVELS ) {
+		ri.FS_FreeFile( job->file );
+		return qfalse;
+	}
+
+	job->arenaSize = job->width * job->height * 4 + job->layout.chainSize
+		+ job->layout.resampleSize + job->layout.mipSize + jpegSize + 4 * 16;
+	job->arenaSize = ( job->arenaSize + 15 ) & ~15;
+
+	return qtrue;
+}
+
+/*
+================
+R_RunImageBatch
+
+Returns how many of the requests were dealt with
+================
+*/
+static int R_RunImageBatch( const imagePrefetch_t *requests, int count, int numThreads,
+						   qboolean bench, imageLoadStats_t *stats ) {
+	imageJob_t	jobs[IMAGE_BATCH_JOBS];
+	imageJob_t	*job;
+	image_t		*image;
+	image_t		scratch;
+	char		key[IMAGE_CACHE_KEY];
+	byte		*arena;
+	int			arenaSize, batchSize;
+	int			numJobs, consumed;
+	int			i, start, jobMsec, uploadStart;
+
+	//
+	// read the files on this thread
+	//
+	start = ri.Milliseconds();
+	numJobs = 0;
+	arenaSize = 0;
+	batchSize = 0;
+	for ( consumed = 0 ; consumed < count && numJobs < IMAGE_BATCH_JOBS ; consumed++ ) {
+		job = &jobs[numJobs];
+		if ( !R_PrepareImageJob( &requests[consumed], job, bench ) ) {
+			stats->skipped++;
+			continue;
+		}
+		if ( numJobs && batchSize + job->fileLength + job->arenaSize > IMAGE_BATCH_BYTES ) {
+			ri.FS_FreeFile( job->file );		// next batch
+			break;
+		}
+		arenaSize += job->arenaSize;
+		batchSize += job->fileLength + job->arenaSize;
+		stats->bytes += job->fileLength;
+		numJobs++;
+	}
+	stats->readMsec += ri.Milliseconds() - start;
+
+	if ( !numJobs ) {
+		return consumed;
+	}
+
+	//
+	// decode and mip on the workers
+	//
+	arena = ri.Hunk_AllocateTempMemory( arenaSize );
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		jobs[i].arena.base = arena;
+		jobs[i].arena.size = jobs[i].arenaSize;
+		arena += jobs[i].arenaSize;
+	}
+	arena -= arenaSize;
+
+	start = ri.Milliseconds();
+	imageJobs = jobs;
+	GLimp_RunFrontEndJobs( R_ImageJob, numJobs, numThreads );
+	imageJobs = NULL;
+	jobMsec = ri.Milliseconds() - start;
+	stats->jobMsec += jobMsec;
+
+	//
+	// upload in order
+	//
+	start = ri.Milliseconds();
+	Com_Memset( &scratch, 0, sizeof( scratch ) );
+	scratch.texnum = 1024 + MAX_DRAWIMAGES;
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		job = &jobs[i];
+		if ( !job->done ) {
+			stats->skipped++;
+			continue;
+		}
+		stats->images++;
+
+		if ( bench ) {
+			GL_Bind( &scratch );
+			R_UploadImageChain( job->chain, job->request->mipmap );
+			continue;
+		}
+
+		uploadStart = ri.Milliseconds();
+		image = R_CreateImageExt( job->request->name, NULL, job->width, job->height, job->request->mipmap,
+			job->request->allowPicmip, job->request->wrapClampMode, job->chain );
+		// the workers aren't timed one by one, each gets an even share
+		image->loadMsec = jobMsec / numJobs + ri.Milliseconds() - uploadStart;
+
+		if ( R_ImageCacheKey( job->request->name, job->request->mipmap, job->request->allowPicmip, key, sizeof( key ) ) ) {
+			R_WriteCachedImage( key, job->width, job->height, job->chain );
+		}
+	}
+	if ( bench ) {
+		qglDeleteTextures( 1, &scratch.texnum );
+		qglBindTexture( GL_TEXTURE_2D, 0 );
+		glState.currenttextures[glState.currenttmu] = 0;
+	}
+	stats->uploadMsec += ri.Milliseconds() - start;
+
+	ri.Hunk_FreeTempMemory( arena );
+	for ( i = numJobs - 1 ; i >= 0 ; i-- ) {
+		ri.FS_FreeFile( jobs[i].file );
+	}
+
+	return consumed;
+}
+
+/*
+================
+R_RunImageJobs
+================
+*/
+static void R_RunImageJobs( const imagePrefetch_t *requests, int count, int numThreads,
+						   qboolean bench, imageLoadStats_t *stats ) {
+	int		i;
+
+	Com_Memset( stats, 0, sizeof( *stats ) );
+	for ( i = 0 ; i < count ; ) {
+		i += R_RunImageBatch( requests + i, count - i, numThreads, bench, stats );
+	}
+}
+
+/*
+================
+R_PrintImageLoadStats
+================
+*/
+static void R_PrintImageLoadStats( int printLevel, const imageLoadStats_t *stats, int numThreads, int msec ) {
+	ri.Printf( printLevel, "%i images, %i KB in %i msec on %i threads: read %i, decode and mip %i, upload %i, %i left to the loader\n",
+		stats->images, stats->bytes >> 10, msec, numThreads, stats->readMsec,
+		stats->jobMsec, stats->uploadMsec, stats->skipped );
+}
+
+/*
+================
+R_PrefetchImage
+
+Queues an image for R_LoadPrefetchedImages, with the parms
+that R_FindImageFile will be called with
+================
+*/
+void R_PrefetchImage( const char *name, qboolean mipmap, qboolean allowPicmip, int glWrapClampMode ) {
+	imagePrefetch_t	*request;
+	long			hash;
+	int				i;
+
+	if ( r_imageThreads->integer <= 0 || numImagePrefetch == MAX_DRAWIMAGES || strlen( name ) >= MAX_QPATH ) {
+		return;
+	}
+
+	hash = generateHashValue( name );
+	for ( i = imagePrefetchHash[hash] ; i ; i = imagePrefetch[i-1].next ) {
+		if ( !strcmp( imagePrefetch[i-1].name, name ) ) {
+			return;
+		}
+	}
+
+	request = &imagePrefetch[numImagePrefetch++];
+	Q_strncpyz( request->name, name, sizeof( request->name ) );
+	request->mipmap = mipmap;
+	request->allowPicmip = allowPicmip;
+	request->wrapClampMode = glWrapClampMode;
+	request->next = imagePrefetchHash[hash];
+	imagePrefetchHash[hash] = numImagePrefetch;
+}
+
+/*
+================
+R_LoadPrefetchedImages
+================
+*/
+void R_LoadPrefetchedImages( void ) {
+	imageLoadStats_t	stats;
+	int					start;
+
+	if ( !numImagePrefetch ) {
+		return;
+	}
+
+	// make sure the render thread is stopped, we are about to upload
+	R_SyncRenderThread();
+
+	start = ri.Milliseconds();
+	R_RunImageJobs( imagePrefetch, numImagePrefetch, r_imageThreads->integer, qfalse, &stats );
+	R_PrintImageLoadStats( PRINT_DEVELOPER, &stats, r_imageThreads->integer, ri.Milliseconds() - start );
+
+	numImagePrefetch = 0;
+	Com_Memset( imagePrefetchHash, 0, sizeof( imagePrefetchHash ) );
+}
+
+/*
+================
+R_ImageBench_f
+
+imagebench [threads]
+
+Reloads every image that came from a file through the prefetch path
+into a scratch texture, once on this thread and once on the workers
+================
+*/
+void R_ImageBench_f( void ) {
+	imagePrefetch_t		*requests;
+	imageLoadStats_t	stats;
+	image_t				*image;
+	int					numThreads;
+	int					count;
+	int					i, pass, start;
+
+	numThreads = r_imageThreads->integer;
+	if ( ri.Cmd_Argc() > 1 ) {
+		numThreads = atoi( ri.Cmd_Argv( 1 ) );
+	}
+
+	R_SyncRenderThread();
+
+	requests = ri.Hunk_AllocateTempMemory( tr.numImages * sizeof( *requests ) );
+	count = 0;
+	for ( i = 0 ; i < tr.numImages ; i++ ) {
+		image = tr.images[i];
+		if ( image->imgName[0] == '*' ) {
+			continue;
+		}
+		Com_Memset( &requests[count], 0, sizeof( requests[count] ) );
+		Q_strncpyz( requests[count].name, image->imgName, sizeof( requests[count].name ) );
+		requests[count].mipmap = image->mipmap;
+		requests[count].allowPicmip = image->allowPicmip;
+		requests[count].wrapClampMode = image->wrapClampMode;
+		count++;
+	}
+
+	for ( pass = 0 ; pass < 2 ; pass++ ) {
+		start = ri.Milliseconds();
+		R_RunImageJobs( requests, count, pass ? numThreads : 0, qtrue, &stats );
+		R_PrintImageLoadStats( PRINT_ALL, &stats, pass ? numThreads : 0, ri.Milliseconds() - start );
+	}
+
+	ri.Hunk_FreeTempMemory( requests );
+}
+
+
 /*
 ================
 R_CreateDlightImage
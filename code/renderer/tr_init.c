@@ -49,6 +49,13 @@ cvar_t	*r_znear;
 cvar_t	*r_smp;
 cvar_t	*r_showSmp;
 cvar_t	*r_skipBackEnd;
+cvar_t	*r_frontEndThreads;
+cvar_t	*r_simd;
+cvar_t	*r_md3FloatFrames;
+cvar_t	*r_imageCache;
+cvar_t	*r_imageThreads;
+cvar_t	*r_shaderCache;
+cvar_t	*r_visLists;
 
 cvar_t	*r_ignorehwgamma;
 cvar_t	*r_measureOverdraw;
@@ -969,6 +976,13 @@ void R_Register( void )
 
 	r_showSmp = ri.Cvar_Get ("r_showSmp", "0", CVAR_CHEAT);
 	r_skipBackEnd = ri.Cvar_Get ("r_skipBackEnd", "0", CVAR_CHEAT);
+	r_frontEndThreads = ri.Cvar_Get ("r_frontEndThreads", "0", CVAR_ARCHIVE);
+	r_simd = ri.Cvar_Get ("r_simd", "1", CVAR_ARCHIVE);
+	r_md3FloatFrames = ri.Cvar_Get ("r_md3FloatFrames", "0", CVAR_ARCHIVE | CVAR_LATCH);
+	r_imageCache = ri.Cvar_Get ("r_imageCache", "1", CVAR_ARCHIVE);
+	r_imageThreads = ri.Cvar_Get ("r_imageThreads", "0", CVAR_ARCHIVE);
+	r_shaderCache = ri.Cvar_Get ("r_shaderCache", "1", CVAR_ARCHIVE);
+	r_visLists = ri.Cvar_Get ("r_visLists", "1", CVAR_ARCHIVE);
 
 	r_measureOverdraw = ri.Cvar_Get( "r_measureOverdraw", "0", CVAR_CHEAT );
 	r_lodscale = ri.Cvar_Get( "r_lodscale", "5", CVAR_CHEAT );
@@ -1011,6 +1025,12 @@ void R_Register( void )
 	ri.Cmd_AddCommand( "screenshot", R_ScreenShot_f );
 	ri.Cmd_AddCommand( "screenshotJPEG", R_ScreenShotJPEG_f );
 	ri.Cmd_AddCommand( "gfxinfo", GfxInfo_f );
+	ri.Cmd_AddCommand( "sortbench", R_SortBench_f );
+	ri.Cmd_AddCommand( "shadebench", R_ShadeBench_f );
+	ri.Cmd_AddCommand( "animbench", R_AnimBench_f );
+	ri.Cmd_AddCommand( "imagebench", R_ImageBench_f );
+	ri.Cmd_AddCommand( "worldbench", R_WorldBench_f );
+	ri.Cmd_AddCommand( "lightbench", R_LightBench_f );
 }
 
 /*
@@ -1128,6 +1148,12 @@ void RE_Shutdown( qboolean destroyWindow ) {
 	ri.Cmd_RemoveCommand ("shaderlist");
 	ri.Cmd_RemoveCommand ("skinlist");
 	ri.Cmd_RemoveCommand ("gfxinfo");
+	ri.Cmd_RemoveCommand ("sortbench");
+	ri.Cmd_RemoveCommand ("shadebench");
+	ri.Cmd_RemoveCommand ("animbench");
+	ri.Cmd_RemoveCommand ("imagebench");
+	ri.Cmd_RemoveCommand ("worldbench");
+	ri.Cmd_RemoveCommand ("lightbench");
 	ri.Cmd_RemoveCommand( "modelist" );
 	ri.Cmd_RemoveCommand( "shaderstate" );
 
@@ -1207,6 +1233,7 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp ) {
 	re.AddRefEntityToScene = RE_AddRefEntityToScene;
 	re.AddPolyToScene = RE_AddPolyToScene;
 	re.LightForPoint = R_LightForPoint;
+	re.LightForPoints = R_LightForPoints;
 	re.AddLightToScene = RE_AddLightToScene;
 	re.AddAdditiveLightToScene = RE_AddAdditiveLightToScene;
 	re.RenderScene = RE_RenderScene;
@@ -23,6 +23,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "tr_local.h"
 
+#if idsse2
+#include <emmintrin.h>
+#endif
+
 #define	DLIGHT_AT_RADIUS		16
 // at the edge of a dlight's influence, this amount of light will be added
 
@@ -119,30 +123,139 @@ extern	cvar_t	*r_debugLight;
 
 /*
 =================
-R_SetupEntityLightingGrid
+LIGHT GRID CACHE
+
+Decoding a grid cell means gathering its 8 corners and turning each
+lat/long byte pair into a normal, and the head, torso and legs of
+every player land in the same cell, as do most particles of an effect.
+The decoded corners are kept in a small direct mapped cache, and
+since the grid never changes while a map is loaded the cells stay
+valid until the next R_LoadLightGrid clears them.
+
+Each corner is stored as ambient and a 1, directed, and the normal,
+all zero for the samples in walls, so a sample is just the weighted
+sum of the corners and the fourth ambient float sums the weights of
+the lit ones.
+=================
+*/
+
+#define	LIGHTGRID_CACHE_CELLS	64		// must be a power of two
 
+typedef struct {
+	int		cell;				// index of the first corner + 1, 0 if unused
+	float	corners[8][12];
+} lightGridCell_t;
+
+static lightGridCell_t	lightGridCache[LIGHTGRID_CACHE_CELLS];
+
+static qboolean	lightScalarOnly;		// set by lightbench to time each path
+static qboolean	lightNoCache;
+
+/*
+=================
+R_ClearLightGridCache
 =================
 */
-static void R_SetupEntityLightingGrid( trRefEntity_t *ent ) {
-	vec3_t	lightOrigin;
-	int		pos[3];
-	int		i, j;
-	byte	*gridData;
-	float	frac[3];
-	int		gridStep[3];
-	vec3_t	direction;
-	float	totalFactor;
+void R_ClearLightGridCache( void ) {
+	Com_Memset( lightGridCache, 0, sizeof( lightGridCache ) );
+}
 
-	if ( ent->e.renderfx & RF_LIGHTING_ORIGIN ) {
-		// seperate lightOrigins are needed so an object that is
-		// sinking into the ground can still be lit, and so
-		// multi-part models can be lit identically
-		VectorCopy( ent->e.lightingOrigin, lightOrigin );
-	} else {
-		VectorCopy( ent->e.origin, lightOrigin );
+/*
+=================
+R_LightGridCell
+
+The decoded corners of the cell at pos.  Corners past the last grid
+point are clamped to it.
+=================
+*/
+static lightGridCell_t *R_LightGridCell( const int pos[3] ) {
+	world_t			*w;
+	lightGridCell_t	*c;
+	byte			*data;
+	float			*corner;
+	int				gridStep[3];
+	int				cell, index, p;
+	int				lat, lng;
+	int				i, j;
+
+	w = tr.world;
+	gridStep[0] = 1;
+	gridStep[1] = w->lightGridBounds[0];
+	gridStep[2] = w->lightGridBounds[0] * w->lightGridBounds[1];
+	cell = pos[0] * gridStep[0] + pos[1] * gridStep[1] + pos[2] * gridStep[2];
+
+	// grid row and plane strides are often multiples of the cache size,
+	// so scramble the index before picking a slot
+	c = &lightGridCache[ ( (unsigned)cell * 2654435761u >> 16 ) & ( LIGHTGRID_CACHE_CELLS - 1 ) ];
+	if ( c->cell == cell + 1 && !lightNoCache ) {
+		return c;
+	}
+	c->cell = cell + 1;
+
+	for ( i = 0 ; i < 8 ; i++ ) {
+		index = 0;
+		for ( j = 0 ; j < 3 ; j++ ) {
+			p = pos[j] + ( ( i >> j ) & 1 );
+			if ( p >= w->lightGridBounds[j] ) {
+				p = w->lightGridBounds[j] - 1;
+			}
+			index += p * gridStep[j];
+		}
+		data = w->lightGridData + index * 8;
+		corner = c->corners[i];
+
+		if ( !(data[0]+data[1]+data[2]) ) {
+			Com_Memset( corner, 0, sizeof( c->corners[i] ) );
+			continue;	// ignore samples in walls
+		}
+
+		corner[0] = data[0];
+		corner[1] = data[1];
+		corner[2] = data[2];
+		corner[3] = 1.0f;
+		corner[4] = data[3];
+		corner[5] = data[4];
+		corner[6] = data[5];
+		corner[7] = 0;
+
+		lat = data[7];
+		lng = data[6];
+		lat *= (FUNCTABLE_SIZE/256);
+		lng *= (FUNCTABLE_SIZE/256);
+
+		// decode X as cos( lat ) * sin( long )
+		// decode Y as sin( lat ) * sin( long )
+		// decode Z as cos( long )
+
+		corner[8] = tr.sinTable[(lat+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK] * tr.sinTable[lng];
+		corner[9] = tr.sinTable[lat] * tr.sinTable[lng];
+		corner[10] = tr.sinTable[(lng+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK];
+		corner[11] = 0;
 	}
 
-	VectorSubtract( lightOrigin, tr.world->lightGridOrigin, lightOrigin );
+	return c;
+}
+
+/*
+=================
+R_LightGridSample
+
+Trilerps the light grid at point, the way entities are lit from it
+=================
+*/
+static void R_LightGridSample( const vec3_t point, vec3_t ambientLight, vec3_t directedLight, vec3_t lightDir ) {
+	vec3_t			lightOrigin;
+	int				pos[3];
+	int				i, j;
+	float			frac[3];
+	float			factors[8];
+	float			sum[12];
+	float			totalFactor;
+	lightGridCell_t	*c;
+
+	assert( tr.world->lightGridData ); // bk010103 - NULL with -nolight maps
+
+	VectorSubtract( point, tr.world->lightGridOrigin, lightOrigin );
 	for ( i = 0 ; i < 3 ; i++ ) {
 		float	v;
 
@@ -156,89 +269,76 @@ static void R_SetupEntityLightingGrid( trRefEntity_t *ent ) {
 		}
 	}
 
-	VectorClear( ent->ambientLight );
-	VectorClear( ent->directedLight );
-	VectorClear( direction );
-
-	assert( tr.world->lightGridData ); // bk010103 - NULL with -nolight maps
+	c = R_LightGridCell( pos );
 
-	// trilerp the light value
-	gridStep[0] = 8;
-	gridStep[1] = 8 * tr.world->lightGridBounds[0];
-	gridStep[2] = 8 * tr.world->lightGridBounds[0] * tr.world->lightGridBounds[1];
-	gridData = tr.world->lightGridData + pos[0] * gridStep[0]
-		+ pos[1] * gridStep[1] + pos[2] * gridStep[2];
-
-	totalFactor = 0;
 	for ( i = 0 ; i < 8 ; i++ ) {
-		float	factor;
-		byte	*data;
-		int		lat, lng;
-		vec3_t	normal;
-		#if idppc
-		float d0, d1, d2, d3, d4, d5;
-		#endif
-		factor = 1.0;
-		data = gridData;
+		factors[i] = 1.0;
 		for ( j = 0 ; j < 3 ; j++ ) {
 			if ( i & (1<<j) ) {
-				factor *= frac[j];
-				data += gridStep[j];
+				factors[i] *= frac[j];
 			} else {
-				factor *= (1.0f - frac[j]);
+				factors[i] *= (1.0f - frac[j]);
 			}
 		}
+	}
 
-		if ( !(data[0]+data[1]+data[2]) ) {
-			continue;	// ignore samples in walls
+	// trilerp the light value
+#if idsse2
+	if ( r_simd->integer && !lightScalarOnly ) {
+		__m128	factor;
+		__m128	ambient, directed, normal;
+
+		ambient = directed = normal = _mm_setzero_ps();
+		for ( i = 0 ; i < 8 ; i++ ) {
+			factor = _mm_set1_ps( factors[i] );
+			ambient = _mm_add_ps( ambient, _mm_mul_ps( factor, _mm_loadu_ps( c->corners[i] ) ) );
+			directed = _mm_add_ps( directed, _mm_mul_ps( factor, _mm_loadu_ps( c->corners[i] + 4 ) ) );
+			normal = _mm_add_ps( normal, _mm_mul_ps( factor, _mm_loadu_ps( c->corners[i] + 8 ) ) );
+		}
+		_mm_storeu_ps( sum, ambient );
+		_mm_storeu_ps( sum + 4, directed );
+		_mm_storeu_ps( sum + 8, normal );
+	} else
+#endif
+	{
+		for ( j = 0 ; j < 12 ; j++ ) {
+			sum[j] = 0;
+		}
+		for ( i = 0 ; i < 8 ; i++ ) {
+			for ( j = 0 ; j < 12 ; j++ ) {
+				sum[j] += factors[i] * c->corners[i][j];
+			}
 		}
-		totalFactor += factor;
-		#if idppc
-		d0 = data[0]; d1 = data[1]; d2 = data[2];
-		d3 = data[3]; d4 = data[4]; d5 = data[5];
-
-		ent->ambientLight[0] += factor * d0;
-		ent->ambientLight[1] += factor * d1;
-		ent->ambientLight[2] += factor * d2;
-
-		ent->directedLight[0] += factor * d3;
-		ent->directedLight[1] += factor * d4;
-		ent->directedLight[2] += factor * d5;
-		#else
-		ent->ambientLight[0] += factor * data[0];
-		ent->ambientLight[1] += factor * data[1];
-		ent->ambientLight[2] += factor * data[2];
-
-		ent->directedLight[0] += factor * data[3];
-		ent->directedLight[1] += factor * data[4];
-		ent->directedLight[2] += factor * data[5];
-		#endif
-		lat = data[7];
-		lng = data[6];
-		lat *= (FUNCTABLE_SIZE/256);
-		lng *= (FUNCTABLE_SIZE/256);
-
-		// decode X as cos( lat ) * sin( long )
-		// decode Y as sin( lat ) * sin( long )
-		// decode Z as cos( long )
-
-		normal[0] = tr.sinTable[(lat+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK] * tr.sinTable[lng];
-		normal[1] = tr.sinTable[lat] * tr.sinTable[lng];
-		normal[2] = tr.sinTable[(lng+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK];
-
-		VectorMA( direction, factor, normal, direction );
 	}
 
+	totalFactor = sum[3];
 	if ( totalFactor > 0 && totalFactor < 0.99 ) {
 		totalFactor = 1.0f / totalFactor;
-		VectorScale( ent->ambientLight, totalFactor, ent->ambientLight );
-		VectorScale( ent->directedLight, totalFactor, ent->directedLight );
+		VectorScale( sum, totalFactor, sum );
+		VectorScale( sum + 4, totalFactor, sum + 4 );
 	}
 
-	VectorScale( ent->ambientLight, r_ambientScale->value, ent->ambientLight );
-	VectorScale( ent->directedLight, r_directedScale->value, ent->directedLight );
+	VectorScale( sum, r_ambientScale->value, ambientLight );
+	VectorScale( sum + 4, r_directedScale->value, directedLight );
 
-	VectorNormalize2( direction, ent->lightDir );
+	VectorNormalize2( sum + 8, lightDir );
+}
+
+/*
+=================
+R_SetupEntityLightingGrid
+
+=================
+*/
+static void R_SetupEntityLightingGrid( trRefEntity_t *ent ) {
+	if ( ent->e.renderfx & RF_LIGHTING_ORIGIN ) {
+		// seperate lightOrigins are needed so an object that is
+		// sinking into the ground can still be lit, and so
+		// multi-part models can be lit identically
+		R_LightGridSample( ent->e.lightingOrigin, ent->ambientLight, ent->directedLight, ent->lightDir );
+	} else {
+		R_LightGridSample( ent->e.origin, ent->ambientLight, ent->directedLight, ent->lightDir );
+	}
 }
 
 
@@ -378,18 +478,137 @@ R_LightForPoint
 */
 int R_LightForPoint( vec3_t point, vec3_t ambientLight, vec3_t directedLight, vec3_t lightDir )
 {
-	trRefEntity_t ent;
-	
 	// bk010103 - this segfaults with -nolight maps
 	if ( tr.world->lightGridData == NULL )
 	  return qfalse;
 
-	Com_Memset(&ent, 0, sizeof(ent));
-	VectorCopy( point, ent.e.origin );
-	R_SetupEntityLightingGrid( &ent );
-	VectorCopy(ent.ambientLight, ambientLight);
-	VectorCopy(ent.directedLight, directedLight);
-	VectorCopy(ent.lightDir, lightDir);
+	R_LightGridSample( point, ambientLight, directedLight, lightDir );
 
 	return qtrue;
 }
+
+/*
+=================
+R_LightForPoints
+
+R_LightForPoint for a batch of points, such as the particles of an
+effect, which mostly share grid cells
+=================
+*/
+int R_LightForPoints( int numPoints, const vec3_t *points, vec3_t *ambientLight, vec3_t *directedLight, vec3_t *lightDir ) {
+	int		i;
+
+	if ( !tr.world || !tr.world->lightGridData ) {
+		return qfalse;
+	}
+
+	for ( i = 0 ; i < numPoints ; i++ ) {
+		R_LightGridSample( points[i], ambientLight[i], directedLight[i], lightDir[i] );
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+R_LightBench_f
+
+lightbench [points] [iterations]
+
+Lights clusters of random points in the grid with R_LightForPoints,
+decoding every cell, through the cell cache, and through the cache
+with r_simd, printing the time each took and the largest difference
+from the first.
+=================
+*/
+void R_LightBench_f( void ) {
+	static char		*pathNames[3] = { "uncached", "cached", "cached r_simd" };
+	vec3_t			*points, *results, *reference;
+	vec3_t			center;
+	int				numPoints, iterations;
+	int				start, msec[3];
+	float			diff[3], d;
+	int				i, j, k;
+
+	if ( !tr.world || !tr.world->lightGridData ) {
+		ri.Printf( PRINT_ALL, "lightbench needs a map with a light grid\n" );
+		return;
+	}
+
+	numPoints = 4096;
+	if ( ri.Cmd_Argc() > 1 ) {
+		numPoints = atoi( ri.Cmd_Argv( 1 ) );
+	}
+	if ( numPoints < 16 ) {
+		numPoints = 16;
+	}
+	iterations = 100;
+	if ( ri.Cmd_Argc() > 2 ) {
+		iterations = atoi( ri.Cmd_Argv( 2 ) );
+	}
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	points = ri.Hunk_AllocateTempMemory( numPoints * 7 * sizeof( vec3_t ) );
+	results = points + numPoints;
+	reference = results + numPoints * 3;
+
+	// 16 points within 32 units of each center, like the parts of a
+	// player or the particles of an effect
+	for ( i = 0 ; i < numPoints ; i++ ) {
+		if ( !( i & 15 ) ) {
+			for ( j = 0 ; j < 3 ; j++ ) {
+				center[j] = tr.world->lightGridOrigin[j] + ( rand() / (float)RAND_MAX )
+					* ( tr.world->lightGridBounds[j] - 1 ) * tr.world->lightGridSize[j];
+			}
+		}
+		for ( j = 0 ; j < 3 ; j++ ) {
+			points[i][j] = center[j] + ( rand() / (float)RAND_MAX ) * 64 - 32;
+		}
+	}
+
+	for ( k = 0 ; k < 3 ; k++ ) {
+		msec[k] = -1;
+		if ( k == 2 && ( !idsse2 || !r_simd->integer ) ) {
+			continue;
+		}
+		lightNoCache = ( k == 0 );
+		lightScalarOnly = ( k != 2 );
+
+		R_ClearLightGridCache();
+		R_LightForPoints( numPoints, (const vec3_t *)points, k ? results : reference,
+			( k ? results : reference ) + numPoints, ( k ? results : reference ) + numPoints * 2 );
+		diff[k] = 0;
+		for ( i = 0 ; k && i < numPoints * 3 ; i++ ) {
+			for ( j = 0 ; j < 3 ; j++ ) {
+				d = fabs( results[i][j] - reference[i][j] );
+				if ( d > diff[k] ) {
+					diff[k] = d;
+				}
+			}
+		}
+
+		start = ri.Milliseconds();
+		for ( i = 0 ; i < iterations ; i++ ) {
+			R_LightForPoints( numPoints, (const vec3_t *)points, results, results + numPoints, results + numPoints * 2 );
+		}
+		msec[k] = ri.Milliseconds() - start;
+	}
+
+	lightNoCache = qfalse;
+	lightScalarOnly = qfalse;
+	R_ClearLightGridCache();
+	ri.Hunk_FreeTempMemory( points );
+
+	ri.Printf( PRINT_ALL, "%i points x %i\n", numPoints, iterations );
+	for ( k = 0 ; k < 3 ; k++ ) {
+		if ( msec[k] < 0 ) {
+			ri.Printf( PRINT_ALL, "%14s: off\n", pathNames[k] );
+		} else if ( k == 0 ) {
+			ri.Printf( PRINT_ALL, "%14s: %i msec\n", pathNames[k], msec[k] );
+		} else {
+			ri.Printf( PRINT_ALL, "%14s: %i msec, max diff %g\n", pathNames[k], msec[k], diff[k] );
+		}
+	}
+}
@@ -105,6 +105,9 @@ typedef struct image_s {
 	qboolean	allowPicmip;
 	int			wrapClampMode;		// GL_CLAMP or GL_REPEAT
 
+	int			loadMsec;			// decode and upload time, reported by imagelist
+	qboolean	cached;				// uploaded from the image cache without decoding
+
 	struct image_s*	next;
 } image_t;
 
@@ -656,6 +659,8 @@ typedef struct msurface_s {
 	int					fogIndex;
 
 	surfaceType_t		*data;			// any of srf*_t
+
+	vec3_t				bounds[2];		// for culling the world vis lists
 } msurface_t;
 
 
@@ -671,6 +676,7 @@ typedef struct mnode_s {
 	// node specific
 	cplane_t	*plane;
 	struct mnode_s	*children[2];	
+	int			numLeafs;		// leafs beneath this node, for splitting front end jobs
 
 	// leaf specific
 	int			cluster;
@@ -686,6 +692,16 @@ typedef struct {
 	int			numSurfaces;
 } bmodel_t;
 
+typedef struct {
+	mnode_t		*leaf;
+	int			dlightBits;
+} worldJobLeaf_t;
+
+typedef struct {
+	msurface_t	*surf;
+	int			dlightBits;
+} worldJobSurf_t;
+
 typedef struct {
 	char		name[MAX_QPATH];		// ie: maps/tim_dm2.bsp
 	char		baseName[MAX_QPATH];	// ie: tim_dm2
@@ -710,6 +726,26 @@ typedef struct {
 	int			nummarksurfaces;
 	msurface_t	**marksurfaces;
 
+	// scratch space for R_AddWorldSurfaces when it runs as front end jobs
+	worldJobLeaf_t	*jobLeafs;		// numnodes - numDecisionNodes
+	worldJobSurf_t	*jobSurfs;		// numsurfaces
+	drawSurf_t		*jobDrawSurfs;	// numsurfaces
+
+	// the leafs R_MarkLeaves marked and the surfaces under them, each
+	// once, with their bounds split into mins[0..2] and maxs[0..2]
+	// arrays for culling.  Rebuilt only when the leafs are marked again,
+	// which with a mirror or portal in view is every view that lands in
+	// another cluster than the last one
+	int			visListCount;		// tr.visCount they were built for
+	int			numVisLeafs;
+	mnode_t		**visLeafs;			// numnodes - numDecisionNodes
+	float		*visLeafBounds[6];
+	int			numVisSurfs;
+	msurface_t	**visSurfs;			// numsurfaces
+	float		*visSurfBounds[6];
+	byte		*visSurfMarks;		// numsurfaces
+	int			*visIndexes;		// culling output, the larger of the two
+
 	int			numfogs;
 	fog_t		*fogs;
 
@@ -739,6 +775,14 @@ typedef enum {
 	MOD_MD4
 } modtype_t;
 
+// r_md3FloatFrames decodes the LOD 0 frames at load time, each frame
+// is the x, y, z and normal x, y, z columns of stride floats
+typedef struct {
+	md3Surface_t	*surf;
+	int				stride;			// numVerts rounded up to 4
+	float			*frames;		// numFrames * 6 * stride
+} md3FloatSurface_t;
+
 typedef struct model_s {
 	char		name[MAX_QPATH];
 	modtype_t	type;
@@ -748,6 +792,7 @@ typedef struct model_s {
 	bmodel_t	*bmodel;			// only if type == MOD_BRUSH
 	md3Header_t	*md3[MD3_MAX_LODS];	// only if type == MOD_MESH
 	md4Header_t	*md4;				// only if type == MOD_MD4
+	md3FloatSurface_t	*md3Float;	// md3[0]->numSurfaces, only with r_md3FloatFrames
 
 	int			 numLods;
 } model_t;
@@ -1074,6 +1119,13 @@ extern	cvar_t	*r_subdivisions;
 extern	cvar_t	*r_lodCurveError;
 extern	cvar_t	*r_smp;
 extern	cvar_t	*r_showSmp;
+extern	cvar_t	*r_frontEndThreads;	// worker threads for world surface jobs, 0 = serial
+extern	cvar_t	*r_simd;			// use the SSE2 tess kernels when built with them
+extern	cvar_t	*r_md3FloatFrames;	// decode LOD 0 md3 frames to floats at load time
+extern	cvar_t	*r_imageCache;		// keep uploaded mip chains of pak images under imagecache/
+extern	cvar_t	*r_imageThreads;	// decode the map's images on this many workers, 0 loads them as shaders ask
+extern	cvar_t	*r_shaderCache;		// keep the shader script text and its label index in shadercache/
+extern	cvar_t	*r_visLists;		// add the world from the marked leafs' surface lists instead of walking the BSP
 extern	cvar_t	*r_skipBackEnd;
 
 extern	cvar_t	*r_ignoreGLErrors;
@@ -1115,6 +1167,7 @@ void R_DecomposeSort( unsigned sort, int *entityNum, shader_t **shader,
 					 int *fogNum, int *dlightMap );
 
 void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader, int fogIndex, int dlightMap );
+void R_SortBench_f( void );
 
 
 #define	CULL_IN		0		// completely unclipped
@@ -1202,6 +1255,7 @@ void		R_SetColorMappings( void );
 void		R_GammaCorrect( byte *buffer, int bufSize );
 
 void	R_ImageList_f( void );
+void	R_ImageBench_f( void );
 void	R_SkinList_f( void );
 // https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=516
 const void *RB_TakeScreenshotCmd( const void *data );
@@ -1211,6 +1265,8 @@ void	R_InitFogTable( void );
 float	R_FogFactor( float s, float t );
 void	R_InitImages( void );
 void	R_DeleteTextures( void );
+void	R_PrefetchImage( const char *name, qboolean mipmap, qboolean allowPicmip, int glWrapClampMode );
+void	R_LoadPrefetchedImages( void );
 int		R_SumOfUsedImages( void );
 void	R_InitSkins( void );
 skin_t	*R_GetSkinByHandle( qhandle_t hSkin );
@@ -1225,6 +1281,7 @@ qhandle_t		 RE_RegisterShaderNoMip( const char *name );
 qhandle_t RE_RegisterShaderFromImage(const char *name, int lightmapIndex, image_t *image, qboolean mipRawImage);
 
 shader_t	*R_FindShader( const char *name, int lightmapIndex, qboolean mipRawImage );
+void		R_PrefetchShaderImages( const char *name, qboolean mipRawImage );
 shader_t	*R_GetShaderByHandle( qhandle_t hShader );
 shader_t	*R_GetShaderByState( int index, long *cycleTime );
 shader_t *R_FindShaderByName( const char *name );
@@ -1249,6 +1306,10 @@ void		*GLimp_RendererSleep( void );
 void		GLimp_FrontEndSleep( void );
 void		GLimp_WakeRenderer( void *data );
 
+// runs job( 0 ) .. job( numJobs - 1 ) on up to numThreads worker threads plus
+// the calling thread, returning when all of them have finished
+void		GLimp_RunFrontEndJobs( void (*job)( int index ), int numJobs, int numThreads );
+
 void		GLimp_LogComment( char *comment );
 
 // NOTE TTimo linux works with float gamma value, not the gamma table
@@ -1329,6 +1390,7 @@ WORLD MAP
 
 void R_AddBrushModelSurfaces( trRefEntity_t *e );
 void R_AddWorldSurfaces( void );
+void R_WorldBench_f( void );
 qboolean R_inPVS( const vec3_t p1, const vec3_t p2 );
 
 
@@ -1358,6 +1420,9 @@ void R_DlightBmodel( bmodel_t *bmodel );
 void R_SetupEntityLighting( const trRefdef_t *refdef, trRefEntity_t *ent );
 void R_TransformDlights( int count, dlight_t *dl, orientationr_t *or );
 int R_LightForPoint( vec3_t point, vec3_t ambientLight, vec3_t directedLight, vec3_t lightDir );
+int R_LightForPoints( int numPoints, const vec3_t *points, vec3_t *ambientLight, vec3_t *directedLight, vec3_t *lightDir );
+void R_ClearLightGridCache( void );
+void R_LightBench_f( void );
 
 
 /*
@@ -1472,6 +1537,8 @@ void	RB_CalcColorFromEntity( unsigned char *dstColors );
 void	RB_CalcColorFromOneMinusEntity( unsigned char *dstColors );
 void	RB_CalcSpecularAlpha( unsigned char *alphas );
 void	RB_CalcDiffuseColor( unsigned char *colors );
+void	R_ShadeBench_f( void );
+void	R_AnimBench_f( void );
 
 /*
 =============================================================
@@ -799,6 +799,144 @@ void R_DecomposeSort( unsigned sort, int *entityNum, shader_t **shader,
 	*dlightMap = sort & 3;
 }
 
+/*
+=================
+R_RadixSortDrawSurfs
+
+Stable LSD radix sort on the sort key a byte at a time, skipping the
+bytes every key has in common
+=================
+*/
+static drawSurf_t	radixScratch[MAX_DRAWSURFS];
+
+static void R_RadixSortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
+	int			counts[4][256];
+	drawSurf_t	*src, *dst, *swap;
+	unsigned	sort;
+	int			i, pass, shift;
+	int			sum, count;
+
+	Com_Memset( counts, 0, sizeof( counts ) );
+	for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+		sort = drawSurfs[i].sort;
+		counts[0][sort & 255]++;
+		counts[1][(sort >> 8) & 255]++;
+		counts[2][(sort >> 16) & 255]++;
+		counts[3][sort >> 24]++;
+	}
+
+	src = drawSurfs;
+	dst = radixScratch;
+	for ( pass = 0 ; pass < 4 ; pass++ ) {
+		shift = pass * 8;
+		if ( counts[pass][ ( src[0].sort >> shift ) & 255 ] == numDrawSurfs ) {
+			continue;
+		}
+
+		sum = 0;
+		for ( i = 0 ; i < 256 ; i++ ) {
+			count = counts[pass][i];
+			counts[pass][i] = sum;
+			sum += count;
+		}
+		for ( i = 0 ; i < numDrawSurfs ; i++ ) {
+			dst[ counts[pass][ ( src[i].sort >> shift ) & 255 ]++ ] = src[i];
+		}
+
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if ( src != drawSurfs ) {
+		Com_Memcpy( drawSurfs, src, numDrawSurfs * sizeof( *drawSurfs ) );
+	}
+}
+
+/*
+=================
+R_SortBench_f
+
+sortbench [surfaces] [iterations]
+
+Sorts random keys laid out like R_AddDrawSurf's with qsortFast and the
+radix sort.  No GL calls are made, so it runs on the null renderer too.
+=================
+*/
+void R_SortBench_f( void ) {
+	drawSurf_t	*keys, *work;
+	int			numSurfs, iterations;
+	int			i, j, start;
+	int			qsortMsec, radixMsec;
+	int			numShaders;
+	unsigned	seed;
+
+	numSurfs = 4096;
+	iterations = 200;
+	if ( ri.Cmd_Argc() > 1 ) {
+		numSurfs = atoi( ri.Cmd_Argv( 1 ) );
+	}
+	if ( ri.Cmd_Argc() > 2 ) {
+		iterations = atoi( ri.Cmd_Argv( 2 ) );
+	}
+	if ( numSurfs < 2 || numSurfs > MAX_DRAWSURFS ) {
+		numSurfs = MAX_DRAWSURFS;
+	}
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	keys = ri.Hunk_AllocateTempMemory( 2 * numSurfs * sizeof( *keys ) );
+	work = keys + numSurfs;
+
+	// runs of surfaces with the same shader, as world and model surfaces give
+	numShaders = tr.numShaders > 1 ? tr.numShaders : MAX_SHADERS;
+	seed = 0x1234;
+	for ( i = 0 ; i < numSurfs ; ) {
+		unsigned	sort;
+		int			run;
+
+		seed = seed * 1103515245 + 12345;
+		sort = ( ( seed >> 8 ) % numShaders ) << QSORT_SHADERNUM_SHIFT;
+		seed = seed * 1103515245 + 12345;
+		sort |= ( ( seed >> 8 ) % 64 ) << QSORT_ENTITYNUM_SHIFT;
+		sort |= ( ( seed >> 20 ) & 3 ) << QSORT_FOGNUM_SHIFT;
+		sort |= ( seed >> 24 ) & 1;
+		run = 1 + ( ( seed >> 26 ) & 15 );
+		for ( j = 0 ; j < run && i < numSurfs ; j++, i++ ) {
+			keys[i].sort = sort;
+			keys[i].surface = (surfaceType_t *)&keys[i];	// only compared, for stability
+		}
+	}
+
+	start = ri.Milliseconds();
+	for ( i = 0 ; i < iterations ; i++ ) {
+		Com_Memcpy( work, keys, numSurfs * sizeof( *keys ) );
+		qsortFast( work, numSurfs, sizeof( drawSurf_t ) );
+	}
+	qsortMsec = ri.Milliseconds() - start;
+
+	start = ri.Milliseconds();
+	for ( i = 0 ; i < iterations ; i++ ) {
+		Com_Memcpy( work, keys, numSurfs * sizeof( *keys ) );
+		R_RadixSortDrawSurfs( work, numSurfs );
+	}
+	radixMsec = ri.Milliseconds() - start;
+
+	for ( i = 1 ; i < numSurfs ; i++ ) {
+		if ( work[i-1].sort > work[i].sort || ( work[i-1].sort == work[i].sort 
+			&& work[i-1].surface > work[i].surface ) ) {
+			ri.Printf( PRINT_WARNING, "radix sort out of order at %i\n", i );
+			break;
+		}
+	}
+
+	ri.Printf( PRINT_ALL, "%i surfaces x %i: qsortFast %i msec, radix %i msec\n", 
+		numSurfs, iterations, qsortMsec, radixMsec );
+
+	ri.Hunk_FreeTempMemory( keys );
+}
+
 /*
 =================
 R_SortDrawSurfs
@@ -827,7 +965,7 @@ void R_SortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs ) {
 	}
 
 	// sort the drawsurfs by sort type, then orientation, then shader
-	qsortFast (drawSurfs, numDrawSurfs, sizeof(drawSurf_t) );
+	R_RadixSortDrawSurfs( drawSurfs, numDrawSurfs );
 
 	// check for any pass through drawing, which
 	// may cause another view to be rendered first
@@ -209,6 +209,55 @@ fail:
 }
 
 
+/*
+=================
+R_DecodeMD3Frames
+
+Expands every LOD 0 frame to float columns for LerpMeshVertexes,
+three times the memory of the packed frames.
+=================
+*/
+static void R_DecodeMD3Frames( model_t *mod ) {
+	int					i, j, k;
+	int					size;
+	unsigned			lat, lng;
+	md3Surface_t		*surf;
+	md3XyzNormal_t		*xyz;
+	md3FloatSurface_t	*fs;
+	float				*out;
+
+	mod->md3Float = ri.Hunk_Alloc( mod->md3[0]->numSurfaces * sizeof( *mod->md3Float ), h_low );
+
+	surf = (md3Surface_t *) ( (byte *)mod->md3[0] + mod->md3[0]->ofsSurfaces );
+	for ( i = 0, fs = mod->md3Float ; i < mod->md3[0]->numSurfaces ; i++, fs++ ) {
+		fs->surf = surf;
+		fs->stride = ( surf->numVerts + 3 ) & ~3;
+
+		size = surf->numFrames * 6 * fs->stride * sizeof( float );
+		fs->frames = ri.Hunk_Alloc( size, h_low );
+		mod->dataSize += size;
+
+		xyz = (md3XyzNormal_t *) ( (byte *)surf + surf->ofsXyzNormals );
+		for ( j = 0 ; j < surf->numFrames ; j++ ) {
+			out = fs->frames + j * 6 * fs->stride;
+			for ( k = 0 ; k < surf->numVerts ; k++, xyz++ ) {
+				out[k] = xyz->xyz[0] * MD3_XYZ_SCALE;
+				out[k + fs->stride] = xyz->xyz[1] * MD3_XYZ_SCALE;
+				out[k + fs->stride * 2] = xyz->xyz[2] * MD3_XYZ_SCALE;
+
+				// same lat/long decode as LerpMeshVertexes
+				lat = ( ( xyz->normal >> 8 ) & 0xff ) * ( FUNCTABLE_SIZE / 256 );
+				lng = ( xyz->normal & 0xff ) * ( FUNCTABLE_SIZE / 256 );
+				out[k + fs->stride * 3] = tr.sinTable[(lat+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK] * tr.sinTable[lng];
+				out[k + fs->stride * 4] = tr.sinTable[lat] * tr.sinTable[lng];
+				out[k + fs->stride * 5] = tr.sinTable[(lng+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK];
+			}
+		}
+
+		surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
+	}
+}
+
 /*
 =================
 R_LoadMD3
@@ -361,6 +410,10 @@ static qboolean R_LoadMD3 (model_t *mod, int lod, void *buffer, const char *mod_
 		// find the next surface
 		surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
 	}
+
+	if ( lod == 0 && idsse2 && r_md3FloatFrames->integer ) {
+		R_DecodeMD3Frames( mod );
+	}
     
 	return qtrue;
 }
@@ -97,6 +97,9 @@ typedef struct {
 	void	(*RemapShader)(const char *oldShader, const char *newShader, const char *offsetTime);
 	qboolean (*GetEntityToken)( char *buffer, int size );
 	qboolean (*inPVS)( const vec3_t p1, const vec3_t p2 );
+
+	// R_LightForPoint for numPoints points at once
+	int		(*LightForPoints)( int numPoints, const vec3_t *points, vec3_t *ambientLight, vec3_t *directedLight, vec3_t *lightDir );
 } refexport_t;
 
 //
@@ -144,6 +147,7 @@ typedef struct {
 	// a -1 return means the file does not exist
 	// NULL can be passed for buf to just determine existance
 	int		(*FS_FileIsInPAK)( const char *name, int *pCheckSum );
+	int		(*FS_FilePakChecksum)( const char *name, int *pCheckSum );
 	int		(*FS_ReadFile)( const char *name, void **buf );
 	void	(*FS_FreeFile)( void *buf );
 	char **	(*FS_ListFiles)( const char *name, const char *extension, int *numfilesfound );
@@ -397,6 +397,10 @@ static void DrawMultitextured( shaderCommands_t *input, int stage ) {
 ProjectDlightTexture
 
 Perform dynamic lighting with another rendering pass
+
+Only dlit world surfaces share a batch with tess.dlightBits set, and
+they all fill in tess.vertexDlightBits, so each light only projects
+onto the vertexes of the surfaces it was assigned to
 ===================
 */
 static void ProjectDlightTexture( void ) {
@@ -477,6 +481,11 @@ static void ProjectDlightTexture( void ) {
 #endif
 			int		clip;
 
+			if ( !( tess.vertexDlightBits[i] & ( 1 << l ) ) ) {
+				clipBits[i] = 63;	// on a surface the front end kept this light off
+				continue;
+			}
+
 			backEnd.pc.c_dlightVertexes++;
 
 #if idppc_altivec
@@ -23,6 +23,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "tr_local.h"
 
+#if idsse2
+#include <emmintrin.h>
+#endif
+
 
 #define	WAVEVALUE( table, base, amplitude, phase, freq )  ((base) + table[ myftol( ( ( (phase) + tess.shaderTime * (freq) ) * FUNCTABLE_SIZE ) ) & FUNCTABLE_MASK ] * (amplitude))
 
@@ -104,6 +108,290 @@ void RB_CalcStretchTexCoords( const waveForm_t *wf, float *st )
 /*
 ====================================================================
 
+SSE2 KERNELS
+
+Each kernel handles the vertexes in groups of four and returns how
+many it did, the scalar loop finishes the rest.  tess is not declared
+aligned, so every load and store is unaligned.  The kernels keep the
+scalar operation order, so only the reciprocal square root in the
+environment map and the double precision fog distance differ in the
+low bits, see shadebench.
+
+====================================================================
+*/
+
+static qboolean	rb_scalarOnly;		// set by shadebench to time the scalar loops
+
+#define	RB_SIMD		( r_simd->integer && !rb_scalarOnly )
+
+#if idsse2
+
+// loads four vec4_t rows and transposes them into x, y and z columns
+#define	SSE2_LOAD_COLUMNS( p, x, y, z ) {		\
+	__m128	r0, r1, r2, r3;						\
+	r0 = _mm_loadu_ps( (p) );					\
+	r1 = _mm_loadu_ps( (p) + 4 );				\
+	r2 = _mm_loadu_ps( (p) + 8 );				\
+	r3 = _mm_loadu_ps( (p) + 12 );				\
+	_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );		\
+	x = r0; y = r1; z = r2; }
+
+// stores four s and four t values as interleaved st pairs
+#define	SSE2_STORE_ST( st, s, t ) {						\
+	_mm_storeu_ps( (st), _mm_unpacklo_ps( (s), (t) ) );		\
+	_mm_storeu_ps( (st) + 4, _mm_unpackhi_ps( (s), (t) ) ); }
+
+static __m128 SSE2_MaskXYZ( void ) {
+	return _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+}
+
+static int RB_DeformVertexesSSE2( deformStage_t *ds, const float *table, float constantScale ) {
+	int		i, j;
+	int		count;
+	int		index[4];
+	float	*xyz, *normal;
+	__m128	mask, scale;
+	__m128	x, y, z, off;
+	__m128	spread, phase, now, size;
+	__m128i	idx, funcMask;
+
+	xyz = tess.xyz[0];
+	normal = tess.normal[0];
+	mask = SSE2_MaskXYZ();
+
+	if ( !table ) {
+		// same scale everywhere, w is left alone
+		scale = _mm_and_ps( _mm_set1_ps( constantScale ), mask );
+		for ( i = 0 ; i < tess.numVertexes ; i++, xyz += 4, normal += 4 ) {
+			_mm_storeu_ps( xyz, _mm_add_ps( _mm_loadu_ps( xyz ), _mm_mul_ps( _mm_loadu_ps( normal ), scale ) ) );
+		}
+		return tess.numVertexes;
+	}
+
+	count = tess.numVertexes & ~3;
+	spread = _mm_set1_ps( ds->deformationSpread );
+	phase = _mm_set1_ps( ds->deformationWave.phase );
+	now = _mm_set1_ps( tess.shaderTime * ds->deformationWave.frequency );
+	size = _mm_set1_ps( FUNCTABLE_SIZE );
+	funcMask = _mm_set1_epi32( FUNCTABLE_MASK );
+
+	for ( i = 0 ; i < count ; i += 4, xyz += 16, normal += 16 ) {
+		SSE2_LOAD_COLUMNS( xyz, x, y, z );
+
+		// WAVEVALUE with the phase offset by position
+		off = _mm_mul_ps( _mm_add_ps( _mm_add_ps( x, y ), z ), spread );
+		idx = _mm_cvttps_epi32( _mm_mul_ps( _mm_add_ps( _mm_add_ps( phase, off ), now ), size ) );
+		_mm_storeu_si128( (__m128i *)index, _mm_and_si128( idx, funcMask ) );
+
+		for ( j = 0 ; j < 4 ; j++ ) {
+			scale = _mm_set1_ps( ds->deformationWave.base + table[ index[j] ] * ds->deformationWave.amplitude );
+			scale = _mm_and_ps( _mm_mul_ps( _mm_loadu_ps( normal + j * 4 ), scale ), mask );
+			_mm_storeu_ps( xyz + j * 4, _mm_add_ps( _mm_loadu_ps( xyz + j * 4 ), scale ) );
+		}
+	}
+
+	return count;
+}
+
+static int RB_EnvironmentTexCoordsSSE2( float *st ) {
+	int		i;
+	int		count;
+	float	*v, *normal;
+	__m128	vx, vy, vz;
+	__m128	x, y, z, nx, ny, nz;
+	__m128	len, half, ilength, d, two, threehalfs;
+	__m128	r1, r2;
+
+	count = tess.numVertexes & ~3;
+	v = tess.xyz[0];
+	normal = tess.normal[0];
+	vx = _mm_set1_ps( backEnd.or.viewOrigin[0] );
+	vy = _mm_set1_ps( backEnd.or.viewOrigin[1] );
+	vz = _mm_set1_ps( backEnd.or.viewOrigin[2] );
+	half = _mm_set1_ps( 0.5f );
+	two = _mm_set1_ps( 2.0f );
+	threehalfs = _mm_set1_ps( 1.5f );
+
+	for ( i = 0 ; i < count ; i += 4, v += 16, normal += 16, st += 8 ) {
+		SSE2_LOAD_COLUMNS( v, x, y, z );
+		SSE2_LOAD_COLUMNS( normal, nx, ny, nz );
+
+		// viewer = viewOrigin - v, VectorNormalizeFast
+		x = _mm_sub_ps( vx, x );
+		y = _mm_sub_ps( vy, y );
+		z = _mm_sub_ps( vz, z );
+		len = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+
+		// Q_rsqrt
+		ilength = _mm_castsi128_ps( _mm_sub_epi32( _mm_set1_epi32( 0x5f3759df ),
+			_mm_srli_epi32( _mm_castps_si128( len ), 1 ) ) );
+		ilength = _mm_mul_ps( ilength, _mm_sub_ps( threehalfs,
+			_mm_mul_ps( _mm_mul_ps( _mm_mul_ps( len, half ), ilength ), ilength ) ) );
+
+		x = _mm_mul_ps( x, ilength );
+		y = _mm_mul_ps( y, ilength );
+		z = _mm_mul_ps( z, ilength );
+
+		d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, x ), _mm_mul_ps( ny, y ) ), _mm_mul_ps( nz, z ) );
+
+		r1 = _mm_sub_ps( _mm_mul_ps( _mm_mul_ps( ny, two ), d ), y );
+		r2 = _mm_sub_ps( _mm_mul_ps( _mm_mul_ps( nz, two ), d ), z );
+
+		SSE2_STORE_ST( st, _mm_add_ps( half, _mm_mul_ps( r1, half ) ), _mm_sub_ps( half, _mm_mul_ps( r2, half ) ) );
+	}
+
+	return count;
+}
+
+static int RB_FogTexCoordsSSE2( const vec4_t fogDistanceVector, const vec4_t fogDepthVector,
+							   float eyeT, qboolean eyeOutside, float *st ) {
+	int		i;
+	int		count;
+	float	*v;
+	__m128	x, y, z, s, t;
+	__m128	d0, d1, d2, d3, f0, f1, f2, f3;
+	__m128	outside, inside, scale, eye, fogged;
+
+	count = tess.numVertexes & ~3;
+	v = tess.xyz[0];
+
+	d0 = _mm_set1_ps( fogDistanceVector[0] );
+	d1 = _mm_set1_ps( fogDistanceVector[1] );
+	d2 = _mm_set1_ps( fogDistanceVector[2] );
+	d3 = _mm_set1_ps( fogDistanceVector[3] );
+	f0 = _mm_set1_ps( fogDepthVector[0] );
+	f1 = _mm_set1_ps( fogDepthVector[1] );
+	f2 = _mm_set1_ps( fogDepthVector[2] );
+	f3 = _mm_set1_ps( fogDepthVector[3] );
+	outside = _mm_set1_ps( 1.0f/32 );
+	inside = _mm_set1_ps( 31.0f/32 );
+	scale = _mm_set1_ps( 30.0f/32 );
+	eye = _mm_set1_ps( eyeT );
+
+	for ( i = 0 ; i < count ; i += 4, v += 16, st += 8 ) {
+		SSE2_LOAD_COLUMNS( v, x, y, z );
+
+		// calculate the length in fog
+		s = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, d0 ), _mm_mul_ps( y, d1 ) ), _mm_mul_ps( z, d2 ) ), d3 );
+		t = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, f0 ), _mm_mul_ps( y, f1 ) ), _mm_mul_ps( z, f2 ) ), f3 );
+
+		if ( eyeOutside ) {
+			// cut the distance at the fog plane, points outside get no fog
+			fogged = _mm_add_ps( outside, _mm_div_ps( _mm_mul_ps( scale, t ), _mm_sub_ps( t, eye ) ) );
+			t = _mm_cmplt_ps( t, _mm_set1_ps( 1.0f ) );
+		} else {
+			fogged = inside;
+			t = _mm_cmplt_ps( t, _mm_setzero_ps() );
+		}
+		t = _mm_or_ps( _mm_and_ps( t, outside ), _mm_andnot_ps( t, fogged ) );
+
+		SSE2_STORE_ST( st, s, t );
+	}
+
+	return count;
+}
+
+static int RB_TurbulentTexCoordsSSE2( const waveForm_t *wf, float now, float *st ) {
+	int		i, j;
+	int		count;
+	int		index[8];
+	float	*v;
+	float	amplitude;
+	__m128	x, y, z, lo, hi;
+	__m128d	scale, size, dnow;
+	__m128i	funcMask;
+
+	count = tess.numVertexes & ~3;
+	v = tess.xyz[0];
+	amplitude = wf->amplitude;
+	scale = _mm_set1_pd( 1.0/128 * 0.125 );
+	size = _mm_set1_pd( FUNCTABLE_SIZE );
+	dnow = _mm_set1_pd( now );
+	funcMask = _mm_set1_epi32( FUNCTABLE_MASK );
+
+	for ( i = 0 ; i < count ; i += 4, v += 16, st += 8 ) {
+		SSE2_LOAD_COLUMNS( v, x, y, z );
+
+		// the scalar loop does this in double, so the table indexes match
+		x = _mm_add_ps( x, z );
+		lo = _mm_unpacklo_ps( x, y );		// s0 t0 s1 t1
+		hi = _mm_unpackhi_ps( x, y );		// s2 t2 s3 t3
+		_mm_storeu_si128( (__m128i *)index, _mm_and_si128( funcMask, _mm_unpacklo_epi64(
+			_mm_cvttpd_epi32( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_cvtps_pd( lo ), scale ), dnow ), size ) ),
+			_mm_cvttpd_epi32( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_cvtps_pd( _mm_movehl_ps( lo, lo ) ), scale ), dnow ), size ) ) ) ) );
+		_mm_storeu_si128( (__m128i *)( index + 4 ), _mm_and_si128( funcMask, _mm_unpacklo_epi64(
+			_mm_cvttpd_epi32( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_cvtps_pd( hi ), scale ), dnow ), size ) ),
+			_mm_cvttpd_epi32( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_cvtps_pd( _mm_movehl_ps( hi, hi ) ), scale ), dnow ), size ) ) ) ) );
+
+		for ( j = 0 ; j < 8 ; j++ ) {
+			st[j] = st[j] + tr.sinTable[ index[j] ] * amplitude;
+		}
+	}
+
+	return count;
+}
+
+static int RB_TransformTexCoordsSSE2( const texModInfo_t *tmi, float *st ) {
+	int		i;
+	int		count;
+	__m128	pair, s, t;
+	__m128	m0, m1, translate;
+
+	// two st pairs per register
+	count = tess.numVertexes & ~1;
+	m0 = _mm_setr_ps( tmi->matrix[0][0], tmi->matrix[0][1], tmi->matrix[0][0], tmi->matrix[0][1] );
+	m1 = _mm_setr_ps( tmi->matrix[1][0], tmi->matrix[1][1], tmi->matrix[1][0], tmi->matrix[1][1] );
+	translate = _mm_setr_ps( tmi->translate[0], tmi->translate[1], tmi->translate[0], tmi->translate[1] );
+
+	for ( i = 0 ; i < count ; i += 2, st += 4 ) {
+		pair = _mm_loadu_ps( st );
+		s = _mm_shuffle_ps( pair, pair, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+		t = _mm_shuffle_ps( pair, pair, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+		_mm_storeu_ps( st, _mm_add_ps( _mm_add_ps( _mm_mul_ps( s, m0 ), _mm_mul_ps( t, m1 ) ), translate ) );
+	}
+
+	return count;
+}
+
+static int RB_ScaleTexCoordsSSE2( float s, float t, qboolean add, float *st ) {
+	int		i;
+	int		count;
+	__m128	st2;
+
+	count = tess.numVertexes & ~1;
+	st2 = _mm_setr_ps( s, t, s, t );
+	if ( add ) {
+		for ( i = 0 ; i < count ; i += 2, st += 4 ) {
+			_mm_storeu_ps( st, _mm_add_ps( _mm_loadu_ps( st ), st2 ) );
+		}
+	} else {
+		for ( i = 0 ; i < count ; i += 2, st += 4 ) {
+			_mm_storeu_ps( st, _mm_mul_ps( _mm_loadu_ps( st ), st2 ) );
+		}
+	}
+
+	return count;
+}
+
+static int RB_FillColorsSSE2( int c, int *colors ) {
+	int		i;
+	int		count;
+	__m128i	c4;
+
+	count = tess.numVertexes & ~3;
+	c4 = _mm_set1_epi32( c );
+	for ( i = 0 ; i < count ; i += 4, colors += 4 ) {
+		_mm_storeu_si128( (__m128i *)colors, c4 );
+	}
+
+	return count;
+}
+
+#endif	// idsse2
+
+/*
+====================================================================
+
 DEFORMATIONS
 
 ====================================================================
@@ -124,11 +412,17 @@ void RB_CalcDeformVertexes( deformStage_t *ds )
 	float	*normal = ( float * ) tess.normal;
 	float	*table;
 
+	i = 0;
 	if ( ds->deformationWave.frequency == 0 )
 	{
 		scale = EvalWaveForm( &ds->deformationWave );
 
-		for ( i = 0; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
+#if idsse2
+		if ( RB_SIMD ) {
+			i = RB_DeformVertexesSSE2( ds, NULL, scale );
+		}
+#endif
+		for ( ; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
 		{
 			VectorScale( normal, scale, offset );
 			
@@ -141,7 +435,14 @@ void RB_CalcDeformVertexes( deformStage_t *ds )
 	{
 		table = TableForFunc( ds->deformationWave.func );
 
-		for ( i = 0; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
+#if idsse2
+		if ( RB_SIMD ) {
+			i = RB_DeformVertexesSSE2( ds, table, 0 );
+			xyz += i * 4;
+			normal += i * 4;
+		}
+#endif
+		for ( ; i < tess.numVertexes; i++, xyz += 4, normal += 4 )
 		{
 			float off = ( xyz[0] + xyz[1] + xyz[2] ) * ds->deformationSpread;
 
@@ -603,7 +904,14 @@ void RB_CalcColorFromEntity( unsigned char *dstColors )
 
 	c = * ( int * ) backEnd.currentEntity->e.shaderRGBA;
 
-	for ( i = 0; i < tess.numVertexes; i++, pColors++ )
+	i = 0;
+#if idsse2
+	if ( RB_SIMD ) {
+		i = RB_FillColorsSSE2( c, pColors );
+		pColors += i;
+	}
+#endif
+	for ( ; i < tess.numVertexes; i++, pColors++ )
 	{
 		*pColors = c;
 	}
@@ -701,7 +1009,14 @@ void RB_CalcWaveColor( const waveForm_t *wf, unsigned char *dstColors )
 	color[3] = 255;
 	v = *(int *)color;
 	
-	for ( i = 0; i < tess.numVertexes; i++, colors++ ) {
+	i = 0;
+#if idsse2
+	if ( RB_SIMD ) {
+		i = RB_FillColorsSSE2( v, colors );
+		colors += i;
+	}
+#endif
+	for ( ; i < tess.numVertexes; i++, colors++ ) {
 		*colors = v;
 	}
 }
@@ -839,6 +1154,9 @@ void RB_CalcFogTexCoords( float *st ) {
 
 		eyeT = DotProduct( backEnd.or.viewOrigin, fogDepthVector ) + fogDepthVector[3];
 	} else {
+		// every point is in the fog, rather than whatever was on the stack
+		VectorClear( fogDepthVector );
+		fogDepthVector[3] = 0;
 		eyeT = 1;	// non-surface fog always has eye inside
 	}
 
@@ -853,8 +1171,16 @@ void RB_CalcFogTexCoords( float *st ) {
 
 	fogDistanceVector[3] += 1.0/512;
 
+	i = 0;
+#if idsse2
+	if ( RB_SIMD ) {
+		i = RB_FogTexCoordsSSE2( fogDistanceVector, fogDepthVector, eyeT, eyeOutside, st );
+		st += i * 2;
+	}
+#endif
+
 	// calculate density for each point
-	for (i = 0, v = tess.xyz[0] ; i < tess.numVertexes ; i++, v += 4) {
+	for ( v = tess.xyz[i] ; i < tess.numVertexes ; i++, v += 4) {
 		// calculate the length in fog
 		s = DotProduct( v, fogDistanceVector ) + fogDistanceVector[3];
 		t = DotProduct( v, fogDepthVector ) + fogDepthVector[3];
@@ -892,10 +1218,18 @@ void RB_CalcEnvironmentTexCoords( float *st )
 	vec3_t		viewer, reflected;
 	float		d;
 
-	v = tess.xyz[0];
-	normal = tess.normal[0];
+	i = 0;
+#if idsse2
+	if ( RB_SIMD ) {
+		i = RB_EnvironmentTexCoordsSSE2( st );
+		st += i * 2;
+	}
+#endif
+
+	v = tess.xyz[i];
+	normal = tess.normal[i];
 
-	for (i = 0 ; i < tess.numVertexes ; i++, v += 4, normal += 4, st += 2 ) 
+	for ( ; i < tess.numVertexes ; i++, v += 4, normal += 4, st += 2 ) 
 	{
 		VectorSubtract (backEnd.or.viewOrigin, v, viewer);
 		VectorNormalizeFast (viewer);
@@ -921,7 +1255,14 @@ void RB_CalcTurbulentTexCoords( const waveForm_t *wf, float *st )
 
 	now = ( wf->phase + tess.shaderTime * wf->frequency );
 
-	for ( i = 0; i < tess.numVertexes; i++, st += 2 )
+	i = 0;
+#if idsse2
+	if ( RB_SIMD ) {
+		i = RB_TurbulentTexCoordsSSE2( wf, now, st );
+		st += i * 2;
+	}
+#endif
+	for ( ; i < tess.numVertexes; i++, st += 2 )
 	{
 		float s = st[0];
 		float t = st[1];
@@ -938,7 +1279,14 @@ void RB_CalcScaleTexCoords( const float scale[2], float *st )
 {
 	int i;
 
-	for ( i = 0; i < tess.numVertexes; i++, st += 2 )
+	i = 0;
+#if idsse2
+	if ( RB_SIMD ) {
+		i = RB_ScaleTexCoordsSSE2( scale[0], scale[1], qfalse, st );
+		st += i * 2;
+	}
+#endif
+	for ( ; i < tess.numVertexes; i++, st += 2 )
 	{
 		st[0] *= scale[0];
 		st[1] *= scale[1];
@@ -962,7 +1310,14 @@ void RB_CalcScrollTexCoords( const float scrollSpeed[2], float *st )
 	adjustedScrollS = adjustedScrollS - floor( adjustedScrollS );
 	adjustedScrollT = adjustedScrollT - floor( adjustedScrollT );
 
-	for ( i = 0; i < tess.numVertexes; i++, st += 2 )
+	i = 0;
+#if idsse2
+	if ( RB_SIMD ) {
+		i = RB_ScaleTexCoordsSSE2( adjustedScrollS, adjustedScrollT, qtrue, st );
+		st += i * 2;
+	}
+#endif
+	for ( ; i < tess.numVertexes; i++, st += 2 )
 	{
 		st[0] += adjustedScrollS;
 		st[1] += adjustedScrollT;
@@ -976,7 +1331,14 @@ void RB_CalcTransformTexCoords( const texModInfo_t *tmi, float *st  )
 {
 	int i;
 
-	for ( i = 0; i < tess.numVertexes; i++, st += 2 )
+	i = 0;
+#if idsse2
+	if ( RB_SIMD ) {
+		i = RB_TransformTexCoordsSSE2( tmi, st );
+		st += i * 2;
+	}
+#endif
+	for ( ; i < tess.numVertexes; i++, st += 2 )
 	{
 		float s = st[0];
 		float t = st[1];
@@ -1203,3 +1565,246 @@ void RB_CalcDiffuseColor( unsigned char *colors )
 	}
 }
 
+
+/*
+====================================================================
+
+SHADE BENCH
+
+====================================================================
+*/
+
+static deformStage_t	benchDeform;
+static waveForm_t		benchWave;
+static texModInfo_t		benchTexMod;
+static float			benchST[SHADER_MAX_VERTEXES][2];
+
+static void RB_BenchDeformConstant( void ) {
+	benchDeform.deformationWave.frequency = 0;
+	RB_CalcDeformVertexes( &benchDeform );
+}
+
+static void RB_BenchDeformWave( void ) {
+	benchDeform.deformationWave.frequency = 0.5f;
+	RB_CalcDeformVertexes( &benchDeform );
+}
+
+static void RB_BenchEnvironment( void ) {
+	RB_CalcEnvironmentTexCoords( benchST[0] );
+}
+
+static void RB_BenchFog( void ) {
+	RB_CalcFogTexCoords( benchST[0] );
+}
+
+static void RB_BenchTurbulent( void ) {
+	RB_CalcTurbulentTexCoords( &benchWave, benchST[0] );
+}
+
+static void RB_BenchScroll( void ) {
+	RB_CalcScrollTexCoords( benchTexMod.scroll, benchST[0] );
+}
+
+static void RB_BenchRotate( void ) {
+	RB_CalcRotateTexCoords( 30, benchST[0] );
+}
+
+static void RB_BenchWaveColor( void ) {
+	RB_CalcWaveColor( &benchWave, tess.svars.colors[0] );
+}
+
+typedef struct {
+	char	*name;
+	void	(*run)( void );
+	float	tolerance;		// largest difference allowed from the scalar loop
+} shadeBenchKernel_t;
+
+static shadeBenchKernel_t	benchKernels[] = {
+	{ "deform constant", RB_BenchDeformConstant, 0 },
+	{ "deform wave", RB_BenchDeformWave, 0 },
+	{ "environment", RB_BenchEnvironment, 0.001f },
+	{ "fog", RB_BenchFog, 0.001f },
+	{ "turbulent", RB_BenchTurbulent, 0 },
+	{ "scroll", RB_BenchScroll, 0 },
+	{ "rotate", RB_BenchRotate, 0 },
+	{ "wave color", RB_BenchWaveColor, 0 }
+};
+
+/*
+================
+R_ShadeBenchReset
+
+Puts back the synthetic batch the kernels work on
+================
+*/
+static void R_ShadeBenchReset( const float *xyz, const float *normal ) {
+	int		i;
+
+	Com_Memcpy( tess.xyz, xyz, tess.numVertexes * sizeof( tess.xyz[0] ) );
+	Com_Memcpy( tess.normal, normal, tess.numVertexes * sizeof( tess.normal[0] ) );
+	for ( i = 0 ; i < tess.numVertexes ; i++ ) {
+		benchST[i][0] = xyz[i*4+0] * ( 1.0f / 256 );
+		benchST[i][1] = xyz[i*4+1] * ( 1.0f / 256 );
+	}
+	Com_Memset( tess.svars.colors, 0, tess.numVertexes * sizeof( tess.svars.colors[0] ) );
+}
+
+/*
+================
+R_ShadeBenchDiff
+
+Largest difference between two runs of a kernel, over everything it
+could have written
+================
+*/
+static float R_ShadeBenchDiff( const float *xyz, const float *st, const byte *colors ) {
+	int		i;
+	float	d, diff;
+
+	diff = 0;
+	for ( i = 0 ; i < tess.numVertexes * 4 ; i++ ) {
+		d = fabs( xyz[i] - tess.xyz[0][i] );
+		if ( d > diff ) {
+			diff = d;
+		}
+	}
+	for ( i = 0 ; i < tess.numVertexes * 2 ; i++ ) {
+		d = fabs( st[i] - benchST[0][i] );
+		if ( d > diff ) {
+			diff = d;
+		}
+	}
+	for ( i = 0 ; i < tess.numVertexes * 4 ; i++ ) {
+		d = abs( colors[i] - tess.svars.colors[0][i] );
+		if ( d > diff ) {
+			diff = d;
+		}
+	}
+
+	return diff;
+}
+
+/*
+================
+R_ShadeBench_f
+
+shadebench [iterations]
+
+Runs the per vertex tess kernels over a synthetic batch with the
+scalar loops and with r_simd, printing the time each took and the
+largest difference between them.  Fog is only run with a fogged
+map loaded.
+================
+*/
+void R_ShadeBench_f( void ) {
+	int					i, j, k;
+	int					iterations;
+	int					start, scalarMsec, simdMsec;
+	int					numVertexes, fogNum;
+	float				shaderTime;
+	float				diff;
+	float				*xyz, *normal, *refXYZ, *refST;
+	byte				*refColors;
+	unsigned			seed;
+	shadeBenchKernel_t	*kernel;
+
+	iterations = 1000;
+	if ( ri.Cmd_Argc() > 1 ) {
+		iterations = atoi( ri.Cmd_Argv( 1 ) );
+	}
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	// tess belongs to the back end
+	R_SyncRenderThread();
+
+	numVertexes = tess.numVertexes;
+	shaderTime = tess.shaderTime;
+	fogNum = tess.fogNum;
+
+	// an odd count, so the scalar loops finish some of every batch
+	tess.numVertexes = SHADER_MAX_VERTEXES - 1;
+	tess.shaderTime = 12.3f;
+	tess.fogNum = 1;
+
+	xyz = ri.Hunk_AllocateTempMemory( tess.numVertexes * 14 * sizeof( float ) + tess.numVertexes * 4 );
+	normal = xyz + tess.numVertexes * 4;
+	refXYZ = normal + tess.numVertexes * 4;
+	refST = refXYZ + tess.numVertexes * 4;
+	refColors = (byte *)( refST + tess.numVertexes * 2 );
+
+	seed = 0x1234;
+	for ( i = 0 ; i < tess.numVertexes ; i++ ) {
+		for ( j = 0 ; j < 3 ; j++ ) {
+			seed = seed * 1103515245 + 12345;
+			xyz[i*4+j] = (float)( ( seed >> 8 ) & 4095 ) - 2048;
+			seed = seed * 1103515245 + 12345;
+			normal[i*4+j] = (float)( ( seed >> 8 ) & 255 ) / 128 - 1;
+		}
+		xyz[i*4+3] = 0;
+		normal[i*4+3] = 0;
+		VectorNormalize( normal + i*4 );
+	}
+
+	Com_Memset( &benchDeform, 0, sizeof( benchDeform ) );
+	benchDeform.deformationSpread = 1.0f / 100;
+	benchDeform.deformationWave.func = GF_SIN;
+	benchDeform.deformationWave.amplitude = 4;
+	benchWave.func = GF_SIN;
+	benchWave.base = 0.5f;
+	benchWave.amplitude = 0.25f;
+	benchWave.phase = 0.1f;
+	benchWave.frequency = 0.3f;
+	benchTexMod.scroll[0] = 0.25f;
+	benchTexMod.scroll[1] = -0.1f;
+
+	ri.Printf( PRINT_ALL, "%i vertexes x %i%s:\n", tess.numVertexes, iterations,
+		idsse2 ? "" : ", no SSE2 in this build" );
+
+	for ( k = 0, kernel = benchKernels ; k < sizeof( benchKernels ) / sizeof( benchKernels[0] ) ; k++, kernel++ ) {
+		if ( kernel->run == RB_BenchFog && ( !tr.world || tr.world->numfogs < 2 ) ) {
+			ri.Printf( PRINT_ALL, "%16s: no fog in this map\n", kernel->name );
+			continue;
+		}
+
+		// one pass of each from the same input to compare
+		rb_scalarOnly = qtrue;
+		R_ShadeBenchReset( xyz, normal );
+		kernel->run();
+		Com_Memcpy( refXYZ, tess.xyz, tess.numVertexes * sizeof( tess.xyz[0] ) );
+		Com_Memcpy( refST, benchST, tess.numVertexes * sizeof( benchST[0] ) );
+		Com_Memcpy( refColors, tess.svars.colors, tess.numVertexes * sizeof( tess.svars.colors[0] ) );
+
+		rb_scalarOnly = qfalse;
+		R_ShadeBenchReset( xyz, normal );
+		kernel->run();
+		diff = R_ShadeBenchDiff( refXYZ, refST, refColors );
+
+		rb_scalarOnly = qtrue;
+		R_ShadeBenchReset( xyz, normal );
+		start = ri.Milliseconds();
+		for ( i = 0 ; i < iterations ; i++ ) {
+			kernel->run();
+		}
+		scalarMsec = ri.Milliseconds() - start;
+
+		rb_scalarOnly = qfalse;
+		R_ShadeBenchReset( xyz, normal );
+		start = ri.Milliseconds();
+		for ( i = 0 ; i < iterations ; i++ ) {
+			kernel->run();
+		}
+		simdMsec = ri.Milliseconds() - start;
+
+		ri.Printf( PRINT_ALL, "%16s: scalar %i msec, r_simd %i msec, max diff %g%s\n",
+			kernel->name, scalarMsec, simdMsec, diff, diff > kernel->tolerance ? " ^1MISMATCH" : "" );
+	}
+
+	rb_scalarOnly = qfalse;
+	ri.Hunk_FreeTempMemory( xyz );
+
+	tess.numVertexes = numVertexes;
+	tess.shaderTime = shaderTime;
+	tess.fogNum = fogNum;
+}
@@ -36,7 +36,17 @@ static	qboolean		deferLoad;
 static	shader_t*		hashTable[FILE_HASH_SIZE];
 
 #define MAX_SHADERTEXT_HASH		2048
-static char **shaderTextHashTable[MAX_SHADERTEXT_HASH];
+
+// every shader label in the scripts, grouped by hash, bucket i is
+// shaderTextIndex[shaderTextHashTable[i]] up to shaderTextHashTable[i+1]
+typedef struct {
+	int		name;		// label in s_shaderNames
+	int		text;		// body following the label in s_shaderText
+} shaderTextEntry_t;
+
+static char					*s_shaderNames;
+static shaderTextEntry_t	*shaderTextIndex;
+static int					shaderTextHashTable[MAX_SHADERTEXT_HASH+1];
 
 /*
 ================
@@ -2284,8 +2294,8 @@ static shader_t *FinishShader( void ) {
 ====================
 FindShaderInShaderText
 
-Scans the combined text description of all the shader files for
-the given shader name.
+Looks the shader name up in the index of the combined text
+description of all the shader files.
 
 return NULL if not found
 
@@ -2293,44 +2303,97 @@ If found, it will return a valid shader
 =====================
 */
 static char *FindShaderInShaderText( const char *shadername ) {
-
-	char *token, *p;
-
-	int i, hash;
+	int		i, hash;
 
 	hash = generateHashValue(shadername, MAX_SHADERTEXT_HASH);
 
-	for (i = 0; shaderTextHashTable[hash][i]; i++) {
-		p = shaderTextHashTable[hash][i];
-		token = COM_ParseExt(&p, qtrue);
-		if ( !Q_stricmp( token, shadername ) ) {
-			return p;
+	for ( i = shaderTextHashTable[hash]; i < shaderTextHashTable[hash+1]; i++ ) {
+		if ( !Q_stricmp( s_shaderNames + shaderTextIndex[i].name, shadername ) ) {
+			return s_shaderText + shaderTextIndex[i].text;
 		}
 	}
 
-	p = s_shaderText;
+	return NULL;
+}
+
+
+/*
+====================
+R_PrefetchShaderImages
 
-	if ( !p ) {
-		return NULL;
+Queues the images that R_FindShader will load for the named
+shader, with the parms ParseStage will pass, so they can be
+decoded together before any shader is parsed
+====================
+*/
+void R_PrefetchShaderImages( const char *name, qboolean mipRawImage ) {
+	char		strippedName[MAX_QPATH];
+	char		fileName[MAX_QPATH];
+	char		*text, *token;
+	int			depth, wrapClampMode, numAnimations;
+	qboolean	noMipMaps, noPicMip;
+
+	if ( !name[0] || r_imageThreads->integer <= 0 ) {
+		return;
+	}
+
+	COM_StripExtension( name, strippedName );
+	text = FindShaderInShaderText( strippedName );
+	if ( !text ) {
+		// the implicit shader for a lone image
+		Q_strncpyz( fileName, name, sizeof( fileName ) );
+		COM_DefaultExtension( fileName, sizeof( fileName ), ".tga" );
+		R_PrefetchImage( fileName, mipRawImage, mipRawImage, mipRawImage ? GL_REPEAT : GL_CLAMP );
+		return;
 	}
 
-	// look for label
+	noMipMaps = qfalse;
+	noPicMip = qfalse;
+	depth = 0;
 	while ( 1 ) {
-		token = COM_ParseExt( &p, qtrue );
-		if ( token[0] == 0 ) {
+		token = COM_ParseExt( &text, qtrue );
+		if ( !token[0] ) {
 			break;
 		}
-
-		if ( !Q_stricmp( token, shadername ) ) {
-			return p;
+		if ( token[0] == '{' ) {
+			depth++;
+			continue;
 		}
-		else {
-			// skip the definition
-			SkipBracedSection( &p );
+		if ( token[0] == '}' ) {
+			if ( --depth <= 0 ) {
+				break;
+			}
+			continue;
 		}
-	}
 
-	return NULL;
+		if ( depth == 1 ) {
+			if ( !Q_stricmp( token, "nomipmaps" ) ) {
+				noMipMaps = qtrue;
+				noPicMip = qtrue;
+			} else if ( !Q_stricmp( token, "nopicmip" ) ) {
+				noPicMip = qtrue;
+			}
+		} else if ( depth == 2 ) {
+			if ( !Q_stricmp( token, "map" ) || !Q_stricmp( token, "clampmap" ) ) {
+				wrapClampMode = Q_stricmp( token, "map" ) ? GL_CLAMP : GL_REPEAT;
+				token = COM_ParseExt( &text, qfalse );
+				if ( token[0] && token[0] != '$' ) {
+					R_PrefetchImage( token, !noMipMaps, !noPicMip, wrapClampMode );
+				}
+			} else if ( !Q_stricmp( token, "animMap" ) ) {
+				COM_ParseExt( &text, qfalse );		// frequency
+				for ( numAnimations = 0 ; ; numAnimations++ ) {
+					token = COM_ParseExt( &text, qfalse );
+					if ( !token[0] ) {
+						break;
+					}
+					if ( numAnimations < MAX_IMAGE_ANIMATIONS ) {
+						R_PrefetchImage( token, !noMipMaps, !noPicMip, GL_REPEAT );
+					}
+				}
+			}
+		}
+	}
 }
 
 
@@ -2834,70 +2897,215 @@ void	R_ShaderList_f (void) {
 
 
 /*
-====================
-ScanAndLoadShaderFiles
+=========================================================
 
-Finds and loads all .shader files, combining them into
-a single large text block that can be scanned for shader names
-=====================
+SHADER SCRIPT INDEX
+
+Every label in the combined shader text is indexed once when the
+scripts are loaded, so finding a shader is a hash lookup that never
+tokenizes the text.  The compressed text and the index are kept in
+shadercache/scripts.dat, keyed by the list of script files and the
+checksum of the pak each one is read from, or its contents if it is
+read from a directory.  When the key still
+matches, the scripts are never read, compressed or scanned.
+
+=========================================================
 */
-#define	MAX_SHADER_FILES	4096
-static void ScanAndLoadShaderFiles( void )
-{
-	char **shaderFiles;
-	char *buffers[MAX_SHADER_FILES];
-	char *p;
-	int numShaders;
-	int i;
-	char *oldp, *token, *hashMem;
-	int shaderTextHashTableSizes[MAX_SHADERTEXT_HASH], hash, size;
 
-	long sum = 0;
-	// scan for shader files
-	shaderFiles = ri.FS_ListFiles( "scripts", ".shader", &numShaders );
+#define	SHADER_CACHE_IDENT		(('X'<<24)+('D'<<16)+('I'<<8)+'S')
+#define	SHADER_CACHE_VERSION	1
+#define	SHADER_CACHE_FILE		"shadercache/scripts.dat"
+#define	SHADER_CACHE_KEY_LINE	(MAX_QPATH+32)
 
-	if ( !shaderFiles || !numShaders )
-	{
-		ri.Printf( PRINT_WARNING, "WARNING: no shader files found\n" );
-		return;
-	}
+typedef struct {
+	int		ident;
+	int		version;
+	int		keySize;		// the key, the hash table, the index, the labels
+	int		numEntries;		// and the text follow the header
+	int		namesSize;
+	int		textSize;
+	int		size;			// of the whole file
+} shaderCacheHeader_t;
 
-	if ( numShaders > MAX_SHADER_FILES ) {
-		numShaders = MAX_SHADER_FILES;
-	}
+typedef struct {
+	int		hash;
+	int		name;
+	int		text;
+} shaderLabel_t;
 
-	// load and parse shader files
-	for ( i = 0; i < numShaders; i++ )
-	{
-		char filename[MAX_QPATH];
+/*
+================
+R_ShaderScriptKey
 
+One line per script, keyed on where it is actually read from: its
+length and the unkeyed checksum of the pak, which holds across map
+loads, or a hash of the contents when a loose file comes first.
+There are few loose scripts and they are cheap to read.  Returns the
+length of the key.
+================
+*/
+static int R_ShaderScriptKey( char **shaderFiles, int numShaders, char *key, int keySize ) {
+	char		filename[MAX_QPATH];
+	char		*buffer;
+	char		*p;
+	int			checksum;
+	int			len;
+	int			i, j;
+	unsigned	hash;
+
+	p = key;
+	for ( i = 0; i < numShaders; i++ ) {
 		Com_sprintf( filename, sizeof( filename ), "scripts/%s", shaderFiles[i] );
-		ri.Printf( PRINT_ALL, "...loading '%s'\n", filename );
-		sum += ri.FS_ReadFile( filename, (void **)&buffers[i] );
-		if ( !buffers[i] ) {
-			ri.Error( ERR_DROP, "Couldn't load %s", filename );
+		// 0 means a loose script shadows the pak copy
+		if ( ri.FS_FilePakChecksum( filename, &checksum ) == 1 ) {
+			len = ri.FS_ReadFile( filename, NULL );
+			Com_sprintf( p, keySize - ( p - key ), "%s %i p%08x\n", filename, len, checksum );
+		} else {
+			len = ri.FS_ReadFile( filename, (void **)&buffer );
+			hash = 2166136261u;
+			for ( j = 0; j < len; j++ ) {
+				hash = ( hash ^ (byte)buffer[j] ) * 16777619u;
+			}
+			if ( buffer ) {
+				ri.FS_FreeFile( buffer );
+			}
+			Com_sprintf( p, keySize - ( p - key ), "%s %i f%08x\n", filename, len, hash );
 		}
+		p += strlen( p );
 	}
 
-	// build single large buffer
-	s_shaderText = ri.Hunk_Alloc( sum + numShaders*2, h_low );
+	return p - key;
+}
 
-	// free in reverse order, so the temp files are all dumped
-	for ( i = numShaders - 1; i >= 0 ; i-- ) {
-		strcat( s_shaderText, "\n" );
-		p = &s_shaderText[strlen(s_shaderText)];
-		strcat( s_shaderText, buffers[i] );
-		ri.FS_FreeFile( buffers[i] );
-		buffers[i] = p;
-		COM_Compress(p);
+/*
+================
+R_LoadShaderCache
+
+Returns qfalse on a miss or a stale / damaged cache file
+================
+*/
+static qboolean R_LoadShaderCache( const char *key, int keySize ) {
+	shaderCacheHeader_t	*cache;
+	shaderTextEntry_t	*entries;
+	int					*table;
+	char				*names, *text;
+	int					len;
+	int					i;
+	qboolean			valid;
+
+	len = ri.FS_ReadFile( SHADER_CACHE_FILE, (void **)&cache );
+	if ( !cache ) {
+		return qfalse;
 	}
 
-	// free up memory
-	ri.FS_FreeFileList( shaderFiles );
+	valid = qfalse;
+	if ( len >= sizeof( *cache ) && cache->ident == SHADER_CACHE_IDENT && cache->version == SHADER_CACHE_VERSION
+		&& cache->size == len && cache->keySize == keySize && !memcmp( cache + 1, key, keySize )
+		&& cache->numEntries >= 0 && cache->namesSize >= 0 && cache->textSize > 0
+		&& sizeof( *cache ) + keySize + sizeof( shaderTextHashTable ) + cache->numEntries * sizeof( *entries )
+			+ cache->namesSize + cache->textSize == len ) {
+		table = (int *)( (byte *)( cache + 1 ) + keySize );
+		entries = (shaderTextEntry_t *)( table + MAX_SHADERTEXT_HASH + 1 );
+		names = (char *)( entries + cache->numEntries );
+		text = names + cache->namesSize;
+
+		valid = ( table[0] == 0 && table[MAX_SHADERTEXT_HASH] == cache->numEntries
+			&& ( !cache->namesSize || !names[cache->namesSize-1] ) && !text[cache->textSize-1] );
+		for ( i = 0; valid && i < MAX_SHADERTEXT_HASH; i++ ) {
+			valid = ( table[i] <= table[i+1] );
+		}
+		for ( i = 0; valid && i < cache->numEntries; i++ ) {
+			valid = ( entries[i].name >= 0 && entries[i].name < cache->namesSize
+				&& entries[i].text >= 0 && entries[i].text < cache->textSize );
+		}
+
+		if ( valid ) {
+			shaderTextIndex = ri.Hunk_Alloc( cache->numEntries * sizeof( *entries ) + cache->namesSize + cache->textSize, h_low );
+			s_shaderNames = (char *)( shaderTextIndex + cache->numEntries );
+			s_shaderText = s_shaderNames + cache->namesSize;
+			Com_Memcpy( shaderTextIndex, entries, cache->numEntries * sizeof( *entries ) + cache->namesSize + cache->textSize );
+			Com_Memcpy( shaderTextHashTable, table, sizeof( shaderTextHashTable ) );
+		}
+	}
+
+	ri.FS_FreeFile( cache );
+	return valid;
+}
+
+/*
+================
+R_WriteShaderCache
+================
+*/
+static void R_WriteShaderCache( const char *key, int keySize, int namesSize, int textSize ) {
+	shaderCacheHeader_t	*cache;
+	byte				*p;
+	int					numEntries;
+
+	numEntries = shaderTextHashTable[MAX_SHADERTEXT_HASH];
+
+	cache = ri.Hunk_AllocateTempMemory( sizeof( *cache ) + keySize + sizeof( shaderTextHashTable )
+		+ numEntries * sizeof( *shaderTextIndex ) + namesSize + textSize );
+	cache->ident = SHADER_CACHE_IDENT;
+	cache->version = SHADER_CACHE_VERSION;
+	cache->keySize = keySize;
+	cache->numEntries = numEntries;
+	cache->namesSize = namesSize;
+	cache->textSize = textSize;
+
+	p = (byte *)( cache + 1 );
+	Com_Memcpy( p, key, keySize );
+	p += keySize;
+	Com_Memcpy( p, shaderTextHashTable, sizeof( shaderTextHashTable ) );
+	p += sizeof( shaderTextHashTable );
+	Com_Memcpy( p, shaderTextIndex, numEntries * sizeof( *shaderTextIndex ) );
+	p += numEntries * sizeof( *shaderTextIndex );
+	Com_Memcpy( p, s_shaderNames, namesSize );
+	p += namesSize;
+	Com_Memcpy( p, s_shaderText, textSize );
+	p += textSize;
+	cache->size = p - (byte *)cache;
+
+	ri.FS_WriteFile( SHADER_CACHE_FILE, cache, cache->size );
+	ri.Printf( PRINT_DEVELOPER, "wrote %s (%i bytes)\n", SHADER_CACHE_FILE, cache->size );
+
+	ri.Hunk_FreeTempMemory( cache );
+}
+
+/*
+================
+R_AddShaderLabel
+================
+*/
+static void R_AddShaderLabel( shaderLabel_t *labels, int *numLabels, char *names, int *namesSize, const char *token, const char *text ) {
+	if ( labels ) {
+		labels[*numLabels].hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
+		labels[*numLabels].name = *namesSize;
+		labels[*numLabels].text = text - s_shaderText;
+		strcpy( names + *namesSize, token );
+	}
+	(*numLabels)++;
+	*namesSize += strlen( token ) + 1;
+}
+
+/*
+================
+R_ScanShaderLabels
+
+Finds the labels in the order the text lookup always has, each
+file on its own and then the whole text in one run, so the same
+definition wins when a label is used more than once.  Counts them
+when labels is NULL.
+================
+*/
+static int R_ScanShaderLabels( char **buffers, int numShaders, shaderLabel_t *labels, char *names, int *namesSize ) {
+	char	*p, *token;
+	int		numLabels;
+	int		i;
+
+	numLabels = 0;
+	*namesSize = 0;
 
-	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
-	size = 0;
-	//
 	for ( i = 0; i < numShaders; i++ ) {
 		// pointer to the first shader file
 		p = buffers[i];
@@ -2908,9 +3116,8 @@ static void ScanAndLoadShaderFiles( void )
 				break;
 			}
 
-			hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
-			shaderTextHashTableSizes[hash]++;
-			size++;
+			R_AddShaderLabel( labels, &numLabels, names, namesSize, token, p );
+
 			SkipBracedSection(&p);
 			// if we passed the pointer to the next shader file
 			if ( i < numShaders - 1 ) {
@@ -2921,43 +3128,192 @@ static void ScanAndLoadShaderFiles( void )
 		}
 	}
 
-	size += MAX_SHADERTEXT_HASH;
+	p = s_shaderText;
+	while ( 1 ) {
+		token = COM_ParseExt( &p, qtrue );
+		if ( token[0] == 0 ) {
+			break;
+		}
 
-	hashMem = ri.Hunk_Alloc( size * sizeof(char *), h_low );
+		R_AddShaderLabel( labels, &numLabels, names, namesSize, token, p );
 
-	for (i = 0; i < MAX_SHADERTEXT_HASH; i++) {
-		shaderTextHashTable[i] = (char **) hashMem;
-		hashMem = ((char *) hashMem) + ((shaderTextHashTableSizes[i] + 1) * sizeof(char *));
+		SkipBracedSection( &p );
 	}
 
-	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
-	//
-	for ( i = 0; i < numShaders; i++ ) {
-		// pointer to the first shader file
-		p = buffers[i];
-		// look for label
-		while ( 1 ) {
-			oldp = p;
-			token = COM_ParseExt( &p, qtrue );
-			if ( token[0] == 0 ) {
-				break;
-			}
+	return numLabels;
+}
 
-			hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
-			shaderTextHashTable[hash][shaderTextHashTableSizes[hash]++] = oldp;
+/*
+================
+R_BuildShaderIndex
 
-			SkipBracedSection(&p);
-			// if we passed the pointer to the next shader file
-			if ( i < numShaders - 1 ) {
-				if ( p > buffers[i+1] ) {
+Groups the labels by hash and keeps only the first of each name,
+the later ones could never be found.  Returns the bytes of names.
+================
+*/
+static int R_BuildShaderIndex( char **buffers, int numShaders ) {
+	shaderLabel_t	*labels, *sorted;
+	char			*names;
+	int				counts[MAX_SHADERTEXT_HASH];
+	int				numLabels, numEntries;
+	int				namesSize, size;
+	int				first;
+	int				i, j, h;
+
+	numLabels = R_ScanShaderLabels( buffers, numShaders, NULL, NULL, &size );
+	labels = ri.Hunk_AllocateTempMemory( numLabels * sizeof( *labels ) );
+	names = ri.Hunk_AllocateTempMemory( size );
+	sorted = ri.Hunk_AllocateTempMemory( numLabels * sizeof( *sorted ) );
+	R_ScanShaderLabels( buffers, numShaders, labels, names, &size );
+
+	// stable counting sort by hash
+	Com_Memset( counts, 0, sizeof( counts ) );
+	for ( i = 0; i < numLabels; i++ ) {
+		counts[labels[i].hash]++;
+	}
+	shaderTextHashTable[0] = 0;
+	for ( h = 0; h < MAX_SHADERTEXT_HASH; h++ ) {
+		shaderTextHashTable[h+1] = shaderTextHashTable[h] + counts[h];
+		counts[h] = shaderTextHashTable[h];
+	}
+	for ( i = 0; i < numLabels; i++ ) {
+		sorted[counts[labels[i].hash]++] = labels[i];
+	}
+
+	// drop the repeats, compacting each bucket in place
+	numEntries = 0;
+	namesSize = 0;
+	for ( h = 0; h < MAX_SHADERTEXT_HASH; h++ ) {
+		first = numEntries;
+		for ( i = shaderTextHashTable[h]; i < shaderTextHashTable[h+1]; i++ ) {
+			for ( j = first; j < numEntries; j++ ) {
+				if ( !Q_stricmp( names + sorted[j].name, names + sorted[i].name ) ) {
 					break;
 				}
 			}
+			if ( j == numEntries ) {
+				namesSize += strlen( names + sorted[i].name ) + 1;
+				sorted[numEntries++] = sorted[i];
+			}
 		}
+		shaderTextHashTable[h] = first;
 	}
+	shaderTextHashTable[MAX_SHADERTEXT_HASH] = numEntries;
 
-	return;
+	shaderTextIndex = ri.Hunk_Alloc( numEntries * sizeof( *shaderTextIndex ) + namesSize, h_low );
+	s_shaderNames = (char *)( shaderTextIndex + numEntries );
+	size = 0;
+	for ( i = 0; i < numEntries; i++ ) {
+		shaderTextIndex[i].name = size;
+		shaderTextIndex[i].text = sorted[i].text;
+		strcpy( s_shaderNames + size, names + sorted[i].name );
+		size += strlen( names + sorted[i].name ) + 1;
+	}
+
+	ri.Hunk_FreeTempMemory( sorted );
+	ri.Hunk_FreeTempMemory( names );
+	ri.Hunk_FreeTempMemory( labels );
+
+	return namesSize;
+}
+
+/*
+====================
+ScanAndLoadShaderFiles
+
+Finds and loads all .shader files, combining them into
+a single large text block that can be scanned for shader names
+=====================
+*/
+#define	MAX_SHADER_FILES	4096
+static void ScanAndLoadShaderFiles( void )
+{
+	char **shaderFiles;
+	char *buffers[MAX_SHADER_FILES];
+	char *p, *key;
+	int numShaders;
+	int i;
+	int keySize, namesSize, textSize;
+	int start;
+	qboolean cached;
+
+	long sum = 0;
+
+	s_shaderText = NULL;
+	s_shaderNames = NULL;
+	shaderTextIndex = NULL;
+	Com_Memset( shaderTextHashTable, 0, sizeof( shaderTextHashTable ) );
+
+	start = ri.Milliseconds();
+
+	// scan for shader files
+	shaderFiles = ri.FS_ListFiles( "scripts", ".shader", &numShaders );
+
+	if ( !shaderFiles || !numShaders )
+	{
+		ri.Printf( PRINT_WARNING, "WARNING: no shader files found\n" );
+		return;
+	}
+
+	if ( numShaders > MAX_SHADER_FILES ) {
+		numShaders = MAX_SHADER_FILES;
+	}
+
+	key = NULL;
+	keySize = 0;
+	cached = qfalse;
+	if ( r_shaderCache->integer ) {
+		key = ri.Hunk_AllocateTempMemory( numShaders * SHADER_CACHE_KEY_LINE );
+		Com_Memset( key, 0, numShaders * SHADER_CACHE_KEY_LINE );
+		// padded so the table after the key in the cache file is aligned
+		keySize = ( R_ShaderScriptKey( shaderFiles, numShaders, key, numShaders * SHADER_CACHE_KEY_LINE ) + 3 ) & ~3;
+		cached = R_LoadShaderCache( key, keySize );
+	}
+
+	if ( !cached ) {
+		// load and parse shader files
+		for ( i = 0; i < numShaders; i++ )
+		{
+			char filename[MAX_QPATH];
+
+			Com_sprintf( filename, sizeof( filename ), "scripts/%s", shaderFiles[i] );
+			ri.Printf( PRINT_ALL, "...loading '%s'\n", filename );
+			sum += ri.FS_ReadFile( filename, (void **)&buffers[i] );
+			if ( !buffers[i] ) {
+				ri.Error( ERR_DROP, "Couldn't load %s", filename );
+			}
+		}
+
+		// build single large buffer
+		s_shaderText = ri.Hunk_Alloc( sum + numShaders*2, h_low );
+
+		// free in reverse order, so the temp files are all dumped
+		for ( i = numShaders - 1; i >= 0 ; i-- ) {
+			strcat( s_shaderText, "\n" );
+			p = &s_shaderText[strlen(s_shaderText)];
+			strcat( s_shaderText, buffers[i] );
+			ri.FS_FreeFile( buffers[i] );
+			buffers[i] = p;
+			COM_Compress(p);
+		}
+		textSize = strlen( s_shaderText ) + 1;
+
+		namesSize = R_BuildShaderIndex( buffers, numShaders );
+
+		if ( key ) {
+			R_WriteShaderCache( key, keySize, namesSize, textSize );
+		}
+	}
+
+	if ( key ) {
+		ri.Hunk_FreeTempMemory( key );
+	}
+
+	// free up memory
+	ri.FS_FreeFileList( shaderFiles );
 
+	ri.Printf( PRINT_ALL, "...%i shaders from %i files in %i msec%s\n", shaderTextHashTable[MAX_SHADERTEXT_HASH],
+		numShaders, ri.Milliseconds() - start, cached ? " (cached)" : "" );
 }
 
 
@@ -22,6 +22,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 // tr_surf.c
 #include "tr_local.h"
 
+#if idsse2
+#include <emmintrin.h>
+#endif
+
 /*
 
   THIS ENTIRE FILE IS BACK END
@@ -604,6 +608,200 @@ static void VectorArrayNormalize(vec4_t *normals, unsigned int count)
 
 
 
+/*
+====================================================================
+
+SSE2 MESH LERP
+
+Four vertexes at a time, in the same order of operations as the
+scalar loops.  The normal decode stays a table lookup per vertex,
+the lerp and the normalize are done on x, y and z columns.
+
+====================================================================
+*/
+
+static qboolean	lerpScalarOnly;			// set by animbench to time each path
+static qboolean	lerpNoFloatFrames;
+
+#if idsse2
+
+// VectorNormalizeFast on four normals in x, y and z columns
+static void SSE2_NormalizeColumns( __m128 *x, __m128 *y, __m128 *z ) {
+	__m128	len, ilength;
+
+	len = _mm_add_ps( _mm_add_ps( _mm_mul_ps( *x, *x ), _mm_mul_ps( *y, *y ) ), _mm_mul_ps( *z, *z ) );
+
+	// Q_rsqrt
+	ilength = _mm_castsi128_ps( _mm_sub_epi32( _mm_set1_epi32( 0x5f3759df ),
+		_mm_srli_epi32( _mm_castps_si128( len ), 1 ) ) );
+	ilength = _mm_mul_ps( ilength, _mm_sub_ps( _mm_set1_ps( 1.5f ),
+		_mm_mul_ps( _mm_mul_ps( _mm_mul_ps( len, _mm_set1_ps( 0.5f ) ), ilength ), ilength ) ) );
+
+	*x = _mm_mul_ps( *x, ilength );
+	*y = _mm_mul_ps( *y, ilength );
+	*z = _mm_mul_ps( *z, ilength );
+}
+
+// stores x, y and z columns as the first count of four vec4_t rows, w cleared
+static void SSE2_StoreRows( float *out, __m128 *x, __m128 *y, __m128 *z, int count ) {
+	__m128	r0, r1, r2, r3;
+	float	rows[16];
+
+	r0 = *x;
+	r1 = *y;
+	r2 = *z;
+	r3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+
+	if ( count == 4 ) {
+		_mm_storeu_ps( out, r0 );
+		_mm_storeu_ps( out + 4, r1 );
+		_mm_storeu_ps( out + 8, r2 );
+		_mm_storeu_ps( out + 12, r3 );
+		return;
+	}
+
+	_mm_storeu_ps( rows, r0 );
+	_mm_storeu_ps( rows + 4, r1 );
+	_mm_storeu_ps( rows + 8, r2 );
+	_mm_storeu_ps( rows + 12, r3 );
+	Com_Memcpy( out, rows, count * 4 * sizeof( float ) );
+}
+
+// one md3XyzNormal_t position as floats, the normal lands in w
+static __m128 SSE2_LoadMD3Xyz( const short *xyz ) {
+	__m128i	s;
+
+	s = _mm_loadl_epi64( (const __m128i *)xyz );
+	return _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( s, s ), 16 ) );
+}
+
+// the lat/long normals of four md3XyzNormal_t as columns
+static void SSE2_DecodeMD3Normals( const short *xyz, __m128 *x, __m128 *y, __m128 *z ) {
+	int			j;
+	unsigned	lat, lng;
+	float		nx[4], ny[4], nz[4];
+
+	for ( j = 0 ; j < 4 ; j++, xyz += 4 ) {
+		lat = ( ( xyz[3] >> 8 ) & 0xff ) * ( FUNCTABLE_SIZE / 256 );
+		lng = ( xyz[3] & 0xff ) * ( FUNCTABLE_SIZE / 256 );
+		nx[j] = tr.sinTable[(lat+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK] * tr.sinTable[lng];
+		ny[j] = tr.sinTable[lat] * tr.sinTable[lng];
+		nz[j] = tr.sinTable[(lng+(FUNCTABLE_SIZE/4))&FUNCTABLE_MASK];
+	}
+
+	*x = _mm_loadu_ps( nx );
+	*y = _mm_loadu_ps( ny );
+	*z = _mm_loadu_ps( nz );
+}
+
+/*
+** LerpMeshVertexesSSE2
+**
+** Returns the number of vertexes done, oldXyz is NULL for no lerp
+*/
+static int LerpMeshVertexesSSE2( const short *oldXyz, const short *newXyz, int numVerts,
+								float oldXyzScale, float newXyzScale,
+								float oldNormalScale, float newNormalScale,
+								float *outXyz, float *outNormal ) {
+	int		i, j;
+	int		count;
+	__m128	mask, v;
+	__m128	oldXyzVec, newXyzVec, oldNormalVec, newNormalVec;
+	__m128	x, y, z, ox, oy, oz;
+
+	count = numVerts & ~3;
+	mask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+	oldXyzVec = _mm_set1_ps( oldXyzScale );
+	newXyzVec = _mm_set1_ps( newXyzScale );
+	oldNormalVec = _mm_set1_ps( oldNormalScale );
+	newNormalVec = _mm_set1_ps( newNormalScale );
+
+	for ( i = 0 ; i < count ; i += 4, newXyz += 16, outXyz += 16, outNormal += 16 ) {
+		for ( j = 0 ; j < 4 ; j++ ) {
+			v = _mm_mul_ps( SSE2_LoadMD3Xyz( newXyz + j * 4 ), newXyzVec );
+			if ( oldXyz ) {
+				v = _mm_add_ps( _mm_mul_ps( SSE2_LoadMD3Xyz( oldXyz + j * 4 ), oldXyzVec ), v );
+			}
+			_mm_storeu_ps( outXyz + j * 4, _mm_and_ps( v, mask ) );
+		}
+
+		SSE2_DecodeMD3Normals( newXyz, &x, &y, &z );
+		if ( oldXyz ) {
+			SSE2_DecodeMD3Normals( oldXyz, &ox, &oy, &oz );
+			x = _mm_add_ps( _mm_mul_ps( ox, oldNormalVec ), _mm_mul_ps( x, newNormalVec ) );
+			y = _mm_add_ps( _mm_mul_ps( oy, oldNormalVec ), _mm_mul_ps( y, newNormalVec ) );
+			z = _mm_add_ps( _mm_mul_ps( oz, oldNormalVec ), _mm_mul_ps( z, newNormalVec ) );
+			SSE2_NormalizeColumns( &x, &y, &z );
+			oldXyz += 16;
+		}
+		SSE2_StoreRows( outNormal, &x, &y, &z, 4 );
+	}
+
+	return count;
+}
+
+/*
+** LerpMeshFloatFramesSSE2
+**
+** The same lerp from frames decoded by R_DecodeMD3Frames
+*/
+static void LerpMeshFloatFramesSSE2( const md3FloatSurface_t *fs, int oldframe, int frame,
+									float backlerp, float *outXyz, float *outNormal ) {
+	int			i, c, count;
+	const float	*oldFrame, *newFrame;
+	__m128		frontVec, backVec;
+	__m128		col[6];
+
+	newFrame = fs->frames + frame * 6 * fs->stride;
+	oldFrame = fs->frames + oldframe * 6 * fs->stride;
+	frontVec = _mm_set1_ps( 1.0f - backlerp );
+	backVec = _mm_set1_ps( backlerp );
+
+	// the columns are padded, only the stores need to stop at numVerts
+	for ( i = 0 ; i < fs->surf->numVerts ; i += 4, outXyz += 16, outNormal += 16 ) {
+		for ( c = 0 ; c < 6 ; c++ ) {
+			col[c] = _mm_loadu_ps( newFrame + c * fs->stride + i );
+			if ( backlerp ) {
+				col[c] = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( oldFrame + c * fs->stride + i ), backVec ),
+					_mm_mul_ps( col[c], frontVec ) );
+			}
+		}
+		if ( backlerp ) {
+			SSE2_NormalizeColumns( &col[3], &col[4], &col[5] );
+		}
+
+		count = fs->surf->numVerts - i;
+		if ( count > 4 ) {
+			count = 4;
+		}
+		SSE2_StoreRows( outXyz, &col[0], &col[1], &col[2], count );
+		SSE2_StoreRows( outNormal, &col[3], &col[4], &col[5], count );
+	}
+}
+
+/*
+** R_FloatFramesForSurface
+*/
+static md3FloatSurface_t *R_FloatFramesForSurface( md3Surface_t *surf ) {
+	int			i;
+	model_t		*mod;
+
+	mod = R_GetModelByHandle( backEnd.currentEntity->e.hModel );
+	if ( !mod->md3Float ) {
+		return NULL;
+	}
+	for ( i = 0 ; i < mod->md3[0]->numSurfaces ; i++ ) {
+		if ( mod->md3Float[i].surf == surf ) {
+			return &mod->md3Float[i];
+		}
+	}
+
+	return NULL;		// a lower LOD
+}
+
+#endif	// idsse2
+
 /*
 ** LerpMeshVertexes
 */
@@ -616,18 +814,49 @@ static void LerpMeshVertexes (md3Surface_t *surf, float backlerp)
 	int		vertNum;
 	unsigned lat, lng;
 	int		numVerts;
+	int		firstVert;
 
 	outXyz = tess.xyz[tess.numVertexes];
 	outNormal = tess.normal[tess.numVertexes];
 
 	newXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
 		+ (backEnd.currentEntity->e.frame * surf->numVerts * 4);
-	newNormals = newXyz + 3;
+	oldXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
+		+ (backEnd.currentEntity->e.oldframe * surf->numVerts * 4);
 
 	newXyzScale = MD3_XYZ_SCALE * (1.0 - backlerp);
 	newNormalScale = 1.0 - backlerp;
+	oldXyzScale = MD3_XYZ_SCALE * backlerp;
+	oldNormalScale = backlerp;
 
 	numVerts = surf->numVerts;
+	firstVert = 0;
+
+#if idsse2
+	if ( r_simd->integer && !lerpScalarOnly ) {
+		md3FloatSurface_t	*fs;
+
+		fs = lerpNoFloatFrames ? NULL : R_FloatFramesForSurface( surf );
+		if ( fs ) {
+			LerpMeshFloatFramesSSE2( fs, backEnd.currentEntity->e.oldframe, backEnd.currentEntity->e.frame,
+				backlerp, outXyz, outNormal );
+			return;
+		}
+
+		firstVert = LerpMeshVertexesSSE2( backlerp == 0 ? NULL : oldXyz, newXyz, numVerts,
+			oldXyzScale, newXyzScale, oldNormalScale, newNormalScale, outXyz, outNormal );
+
+		// the scalar loops below finish the rest
+		newXyz += firstVert * 4;
+		oldXyz += firstVert * 4;
+		outXyz += firstVert * 4;
+		outNormal += firstVert * 4;
+		numVerts -= firstVert;
+	}
+#endif
+
+	newNormals = newXyz + 3;
+	oldNormals = oldXyz + 3;
 
 	if ( backlerp == 0 ) {
 #if idppc_altivec
@@ -716,13 +945,6 @@ static void LerpMeshVertexes (md3Surface_t *surf, float backlerp)
 		//
 		// interpolate and copy the vertex and normal
 		//
-		oldXyz = (short *)((byte *)surf + surf->ofsXyzNormals)
-			+ (backEnd.currentEntity->e.oldframe * surf->numVerts * 4);
-		oldNormals = oldXyz + 3;
-
-		oldXyzScale = MD3_XYZ_SCALE * backlerp;
-		oldNormalScale = backlerp;
-
 		for (vertNum=0 ; vertNum < numVerts ; vertNum++,
 			oldXyz += 4, newXyz += 4, oldNormals += 4, newNormals += 4,
 			outXyz += 4, outNormal += 4) 
@@ -758,7 +980,9 @@ static void LerpMeshVertexes (md3Surface_t *surf, float backlerp)
 
 //			VectorNormalize (outNormal);
 		}
-    	VectorArrayNormalize((vec4_t *)tess.normal[tess.numVertexes], numVerts);
+		if ( numVerts ) {
+			VectorArrayNormalize((vec4_t *)tess.normal[tess.numVertexes + firstVert], numVerts);
+		}
    	}
 }
 
@@ -808,6 +1032,158 @@ void RB_SurfaceMesh(md3Surface_t *surface) {
 
 }
 
+/*
+=============
+R_AnimBenchPass
+
+Lerps every frame of every LOD 0 surface towards the next one
+=============
+*/
+static void R_AnimBenchPass( md3Header_t *header, trRefEntity_t *ent, float *xyz, float *normal ) {
+	int				i, j;
+	md3Surface_t	*surf;
+
+	for ( i = 0 ; i < header->numFrames ; i++ ) {
+		ent->e.frame = i;
+		ent->e.oldframe = ( i + 1 ) % header->numFrames;
+
+		surf = (md3Surface_t *)( (byte *)header + header->ofsSurfaces );
+		for ( j = 0 ; j < header->numSurfaces ; j++ ) {
+			LerpMeshVertexes( surf, 0.5f );
+			if ( xyz ) {
+				Com_Memcpy( xyz, tess.xyz, surf->numVerts * sizeof( tess.xyz[0] ) );
+				Com_Memcpy( normal, tess.normal, surf->numVerts * sizeof( tess.normal[0] ) );
+				xyz += surf->numVerts * 4;
+				normal += surf->numVerts * 4;
+			}
+			surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
+		}
+	}
+}
+
+/*
+=============
+R_AnimBench_f
+
+animbench <model> [iterations]
+
+Times LerpMeshVertexes over every frame of an md3 with the scalar
+loops, with r_simd, and from r_md3FloatFrames if the model was
+loaded with them, printing the largest difference from the scalar
+results.
+=============
+*/
+void R_AnimBench_f( void ) {
+	int				i, j, k;
+	int				iterations;
+	int				start, msec[3];
+	int				numVerts, numFloats;
+	int				numTessVertexes;
+	float			diff[3], d;
+	float			*xyz, *normal, *refXyz, *refNormal;
+	qhandle_t		hModel;
+	model_t			*mod;
+	md3Header_t		*header;
+	md3Surface_t	*surf;
+	trRefEntity_t	ent, *currentEntity;
+	static char		*pathNames[3] = { "scalar", "r_simd", "float frames" };
+
+	if ( ri.Cmd_Argc() < 2 ) {
+		ri.Printf( PRINT_ALL, "usage: animbench <model> [iterations]\n" );
+		return;
+	}
+	iterations = 20;
+	if ( ri.Cmd_Argc() > 2 ) {
+		iterations = atoi( ri.Cmd_Argv( 2 ) );
+	}
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	hModel = RE_RegisterModel( ri.Cmd_Argv( 1 ) );
+	mod = R_GetModelByHandle( hModel );
+	if ( !hModel || mod->type != MOD_MESH ) {
+		ri.Printf( PRINT_ALL, "%s is not an md3\n", ri.Cmd_Argv( 1 ) );
+		return;
+	}
+	header = mod->md3[0];
+
+	numVerts = 0;
+	surf = (md3Surface_t *)( (byte *)header + header->ofsSurfaces );
+	for ( i = 0 ; i < header->numSurfaces ; i++ ) {
+		numVerts += surf->numVerts;
+		surf = (md3Surface_t *)( (byte *)surf + surf->ofsEnd );
+	}
+	numFloats = numVerts * header->numFrames * 4;
+
+	// tess belongs to the back end
+	R_SyncRenderThread();
+
+	Com_Memset( &ent, 0, sizeof( ent ) );
+	ent.e.hModel = hModel;
+	currentEntity = backEnd.currentEntity;
+	backEnd.currentEntity = &ent;
+	numTessVertexes = tess.numVertexes;
+	tess.numVertexes = 0;
+
+	xyz = ri.Hunk_AllocateTempMemory( numFloats * 4 * sizeof( float ) );
+	normal = xyz + numFloats;
+	refXyz = normal + numFloats;
+	refNormal = refXyz + numFloats;
+
+	for ( k = 0 ; k < 3 ; k++ ) {
+		msec[k] = -1;
+		if ( k > 0 && ( !idsse2 || !r_simd->integer ) ) {
+			continue;
+		}
+		if ( k == 2 && !mod->md3Float ) {
+			continue;
+		}
+		lerpScalarOnly = ( k == 0 );
+		lerpNoFloatFrames = ( k != 2 );
+
+		R_AnimBenchPass( header, &ent, k ? xyz : refXyz, k ? normal : refNormal );
+		diff[k] = 0;
+		for ( j = 0 ; k && j < numFloats ; j++ ) {
+			if ( ( j & 3 ) == 3 ) {
+				continue;		// w isn't part of the result
+			}
+			d = fabs( xyz[j] - refXyz[j] );
+			if ( d > diff[k] ) {
+				diff[k] = d;
+			}
+			d = fabs( normal[j] - refNormal[j] );
+			if ( d > diff[k] ) {
+				diff[k] = d;
+			}
+		}
+
+		start = ri.Milliseconds();
+		for ( i = 0 ; i < iterations ; i++ ) {
+			R_AnimBenchPass( header, &ent, NULL, NULL );
+		}
+		msec[k] = ri.Milliseconds() - start;
+	}
+
+	lerpScalarOnly = qfalse;
+	lerpNoFloatFrames = qfalse;
+	backEnd.currentEntity = currentEntity;
+	tess.numVertexes = numTessVertexes;
+	ri.Hunk_FreeTempMemory( xyz );
+
+	ri.Printf( PRINT_ALL, "%s: %i surfaces, %i verts, %i frames x %i\n", mod->name,
+		header->numSurfaces, numVerts, header->numFrames, iterations );
+	for ( k = 0 ; k < 3 ; k++ ) {
+		if ( msec[k] < 0 ) {
+			ri.Printf( PRINT_ALL, "%14s: off\n", pathNames[k] );
+		} else if ( k == 0 ) {
+			ri.Printf( PRINT_ALL, "%14s: %i msec\n", pathNames[k], msec[k] );
+		} else {
+			ri.Printf( PRINT_ALL, "%14s: %i msec, max diff %g\n", pathNames[k], msec[k], diff[k] );
+		}
+	}
+}
+
 
 /*
 ==============
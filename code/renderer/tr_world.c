@@ -21,6 +21,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 #include "tr_local.h"
 
+#if idsse2
+#include <emmintrin.h>
+#endif
+
 
 
 /*
@@ -50,7 +54,7 @@ Returns true if the grid is completely culled away.
 Also sets the clipped hint bit in tess
 =================
 */
-static qboolean	R_CullGrid( srfGridMesh_t *cv ) {
+static qboolean	R_CullGrid( srfGridMesh_t *cv, frontEndCounters_t *pc ) {
 	int 	boxCull;
 	int 	sphereCull;
 
@@ -68,33 +72,33 @@ static qboolean	R_CullGrid( srfGridMesh_t *cv ) {
 	// check for trivial reject
 	if ( sphereCull == CULL_OUT )
 	{
-		tr.pc.c_sphere_cull_patch_out++;
+		pc->c_sphere_cull_patch_out++;
 		return qtrue;
 	}
 	// check bounding box if necessary
 	else if ( sphereCull == CULL_CLIP )
 	{
-		tr.pc.c_sphere_cull_patch_clip++;
+		pc->c_sphere_cull_patch_clip++;
 
 		boxCull = R_CullLocalBox( cv->meshBounds );
 
 		if ( boxCull == CULL_OUT ) 
 		{
-			tr.pc.c_box_cull_patch_out++;
+			pc->c_box_cull_patch_out++;
 			return qtrue;
 		}
 		else if ( boxCull == CULL_IN )
 		{
-			tr.pc.c_box_cull_patch_in++;
+			pc->c_box_cull_patch_in++;
 		}
 		else
 		{
-			tr.pc.c_box_cull_patch_clip++;
+			pc->c_box_cull_patch_clip++;
 		}
 	}
 	else
 	{
-		tr.pc.c_sphere_cull_patch_in++;
+		pc->c_sphere_cull_patch_in++;
 	}
 
 	return qfalse;
@@ -111,7 +115,7 @@ added to the sorting list.
 This will also allow mirrors on both sides of a model without recursion.
 ================
 */
-static qboolean	R_CullSurface( surfaceType_t *surface, shader_t *shader ) {
+static qboolean	R_CullSurface( surfaceType_t *surface, shader_t *shader, frontEndCounters_t *pc ) {
 	srfSurfaceFace_t *sface;
 	float			d;
 
@@ -120,7 +124,7 @@ static qboolean	R_CullSurface( surfaceType_t *surface, shader_t *shader ) {
 	}
 
 	if ( *surface == SF_GRID ) {
-		return R_CullGrid( (srfGridMesh_t *)surface );
+		return R_CullGrid( (srfGridMesh_t *)surface, pc );
 	}
 
 	if ( *surface == SF_TRIANGLES ) {
@@ -160,7 +164,7 @@ static qboolean	R_CullSurface( surfaceType_t *surface, shader_t *shader ) {
 }
 
 
-static int R_DlightFace( srfSurfaceFace_t *face, int dlightBits ) {
+static int R_DlightFace( srfSurfaceFace_t *face, int dlightBits, frontEndCounters_t *pc ) {
 	float		d;
 	int			i;
 	dlight_t	*dl;
@@ -178,14 +182,14 @@ static int R_DlightFace( srfSurfaceFace_t *face, int dlightBits ) {
 	}
 
 	if ( !dlightBits ) {
-		tr.pc.c_dlightSurfacesCulled++;
+		pc->c_dlightSurfacesCulled++;
 	}
 
 	face->dlightBits[ tr.smpFrame ] = dlightBits;
 	return dlightBits;
 }
 
-static int R_DlightGrid( srfGridMesh_t *grid, int dlightBits ) {
+static int R_DlightGrid( srfGridMesh_t *grid, int dlightBits, frontEndCounters_t *pc ) {
 	int			i;
 	dlight_t	*dl;
 
@@ -206,7 +210,7 @@ static int R_DlightGrid( srfGridMesh_t *grid, int dlightBits ) {
 	}
 
 	if ( !dlightBits ) {
-		tr.pc.c_dlightSurfacesCulled++;
+		pc->c_dlightSurfacesCulled++;
 	}
 
 	grid->dlightBits[ tr.smpFrame ] = dlightBits;
@@ -256,11 +260,11 @@ that is touched by one or more dlights, so try to throw out
 more dlights if possible.
 ====================
 */
-static int R_DlightSurface( msurface_t *surf, int dlightBits ) {
+static int R_DlightSurface( msurface_t *surf, int dlightBits, frontEndCounters_t *pc ) {
 	if ( *surf->data == SF_FACE ) {
-		dlightBits = R_DlightFace( (srfSurfaceFace_t *)surf->data, dlightBits );
+		dlightBits = R_DlightFace( (srfSurfaceFace_t *)surf->data, dlightBits, pc );
 	} else if ( *surf->data == SF_GRID ) {
-		dlightBits = R_DlightGrid( (srfGridMesh_t *)surf->data, dlightBits );
+		dlightBits = R_DlightGrid( (srfGridMesh_t *)surf->data, dlightBits, pc );
 	} else if ( *surf->data == SF_TRIANGLES ) {
 		dlightBits = R_DlightTrisurf( (srfTriangles_t *)surf->data, dlightBits );
 	} else {
@@ -268,7 +272,7 @@ static int R_DlightSurface( msurface_t *surf, int dlightBits ) {
 	}
 
 	if ( dlightBits ) {
-		tr.pc.c_dlightSurfaces++;
+		pc->c_dlightSurfaces++;
 	}
 
 	return dlightBits;
@@ -290,13 +294,13 @@ static void R_AddWorldSurface( msurface_t *surf, int dlightBits ) {
 	// FIXME: bmodel fog?
 
 	// try to cull before dlighting or adding
-	if ( R_CullSurface( surf->data, surf->shader ) ) {
+	if ( R_CullSurface( surf->data, surf->shader, &tr.pc ) ) {
 		return;
 	}
 
 	// check for dlighting
 	if ( dlightBits ) {
-		dlightBits = R_DlightSurface( surf, dlightBits );
+		dlightBits = R_DlightSurface( surf, dlightBits, &tr.pc );
 		dlightBits = ( dlightBits != 0 );
 	}
 
@@ -350,65 +354,107 @@ void R_AddBrushModelSurfaces ( trRefEntity_t *ent ) {
 
 /*
 ================
-R_RecursiveWorldNode
+R_CullWorldNode
+
+Returns qtrue if nothing under the node can be visible, otherwise
+clears the frustum planes that the node is entirely in front of.
 ================
 */
-static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits ) {
+static qboolean R_CullWorldNode( mnode_t *node, int *planeBits ) {
+	int		i, r;
 
-	do {
-		int			newDlights[2];
+	// if the node wasn't marked as potentially visible, exit
+	if (node->visframe != tr.visCount) {
+		return qtrue;
+	}
 
-		// if the node wasn't marked as potentially visible, exit
-		if (node->visframe != tr.visCount) {
-			return;
+	// if the bounding volume is outside the frustum, nothing
+	// inside can be visible OPTIMIZE: don't do this all the way to leafs?
+	if ( r_nocull->integer ) {
+		return qfalse;
+	}
+
+	for ( i = 0 ; i < 4 ; i++ ) {
+		if ( *planeBits & ( 1 << i ) ) {
+			r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[i]);
+			if (r == 2) {
+				return qtrue;					// culled
+			}
+			if ( r == 1 ) {
+				*planeBits &= ~( 1 << i );		// all descendants will also be in front
+			}
 		}
+	}
 
-		// if the bounding volume is outside the frustum, nothing
-		// inside can be visible OPTIMIZE: don't do this all the way to leafs?
+	return qfalse;
+}
 
-		if ( !r_nocull->integer ) {
-			int		r;
+/*
+================
+R_SplitNodeDlights
 
-			if ( planeBits & 1 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[0]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~1;			// all descendants will also be in front
-				}
-			}
+Determines which dlights are needed on each side of a decision node
+================
+*/
+static void R_SplitNodeDlights( mnode_t *node, int dlightBits, int newDlights[2] ) {
+	int			i;
+	dlight_t	*dl;
+	float		dist;
 
-			if ( planeBits & 2 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[1]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~2;			// all descendants will also be in front
-				}
-			}
+	newDlights[0] = 0;
+	newDlights[1] = 0;
+	if ( !dlightBits ) {
+		return;
+	}
 
-			if ( planeBits & 4 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[2]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~4;			// all descendants will also be in front
-				}
+	for ( i = 0 ; i < tr.refdef.num_dlights ; i++ ) {
+		if ( dlightBits & ( 1 << i ) ) {
+			dl = &tr.refdef.dlights[i];
+			dist = DotProduct( dl->origin, node->plane->normal ) - node->plane->dist;
+			
+			if ( dist > -dl->radius ) {
+				newDlights[0] |= ( 1 << i );
 			}
-
-			if ( planeBits & 8 ) {
-				r = BoxOnPlaneSide(node->mins, node->maxs, &tr.viewParms.frustum[3]);
-				if (r == 2) {
-					return;						// culled
-				}
-				if ( r == 1 ) {
-					planeBits &= ~8;			// all descendants will also be in front
-				}
+			if ( dist < dl->radius ) {
+				newDlights[1] |= ( 1 << i );
 			}
+		}
+	}
+}
+
+/*
+** worldJob_t
+**
+** A BSP subtree walked off the main thread.  The walk only collects
+** the visible leafs into its slice of tr.world->jobLeafs, everything
+** that touches shared surface state waits for R_GatherJobSurfaces.
+*/
+typedef struct {
+	mnode_t		*node;
+	int			planeBits;
+	int			dlightBits;
 
+	int			firstLeaf;
+	int			numLeafs;
+	vec3_t		visBounds[2];
+	frontEndCounters_t	pc;
+} worldJob_t;
+
+/*
+================
+R_RecursiveWorldNode
+
+With a job, visible leafs are queued on the job instead of having
+their surfaces added.
+================
+*/
+static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits, worldJob_t *job ) {
+
+	do {
+		int			newDlights[2];
+
+		if ( R_CullWorldNode( node, &planeBits ) ) {
+			return;
 		}
 
 		if ( node->contents != -1 ) {
@@ -417,39 +463,29 @@ static void R_RecursiveWorldNode( mnode_t *node, int planeBits, int dlightBits )
 
 		// node is just a decision point, so go down both sides
 		// since we don't care about sort orders, just go positive to negative
-
-		// determine which dlights are needed
-		newDlights[0] = 0;
-		newDlights[1] = 0;
-		if ( dlightBits ) {
-			int	i;
-
-			for ( i = 0 ; i < tr.refdef.num_dlights ; i++ ) {
-				dlight_t	*dl;
-				float		dist;
-
-				if ( dlightBits & ( 1 << i ) ) {
-					dl = &tr.refdef.dlights[i];
-					dist = DotProduct( dl->origin, node->plane->normal ) - node->plane->dist;
-					
-					if ( dist > -dl->radius ) {
-						newDlights[0] |= ( 1 << i );
-					}
-					if ( dist < dl->radius ) {
-						newDlights[1] |= ( 1 << i );
-					}
-				}
-			}
-		}
+		R_SplitNodeDlights( node, dlightBits, newDlights );
 
 		// recurse down the children, front side first
-		R_RecursiveWorldNode (node->children[0], planeBits, newDlights[0] );
+		R_RecursiveWorldNode (node->children[0], planeBits, newDlights[0], job );
 
 		// tail recurse
 		node = node->children[1];
 		dlightBits = newDlights[1];
 	} while ( 1 );
 
+	if ( job ) {
+		worldJobLeaf_t	*leaf;
+
+		job->pc.c_leafs++;
+		AddPointToBounds( node->mins, job->visBounds[0], job->visBounds[1] );
+		AddPointToBounds( node->maxs, job->visBounds[0], job->visBounds[1] );
+
+		leaf = &tr.world->jobLeafs[ job->firstLeaf + job->numLeafs++ ];
+		leaf->leaf = node;
+		leaf->dlightBits = dlightBits;
+		return;
+	}
+
 	{
 		// leaf node, so add mark surfaces
 		int			c;
@@ -637,6 +673,673 @@ static void R_MarkLeaves (void) {
 }
 
 
+/*
+=============================================================
+
+	FRONT END JOBS
+
+The world is added in four steps when r_frontEndThreads is set:
+subtrees of the BSP are walked as jobs, the leafs they found are
+merged in job order on the main thread to pick each surface once,
+the surfaces are culled, dlit and keyed as jobs, and the resulting
+draw surfaces are appended in order.  Entities, polys and portal
+subviews all go through the shared tr.or and tr.viewParms, so they
+stay on the main thread.
+
+=============================================================
+*/
+
+#define	MAX_WORLD_JOBS		64
+#define	WORLD_JOB_SURFACES	64		// smallest slice of surfaces worth a job
+
+typedef struct {
+	int			firstSurf;
+	int			numSurfs;
+
+	int			numDrawSurfs;
+	frontEndCounters_t	pc;
+} worldChunk_t;
+
+static worldJob_t	worldJobs[MAX_WORLD_JOBS];
+static int			numWorldJobs;
+static int			numWorldJobLeafs;
+static int			worldJobLeafTarget;
+
+static worldChunk_t	worldChunks[MAX_WORLD_JOBS];
+
+/*
+================
+R_AddFrontEndCounters
+================
+*/
+static void R_AddFrontEndCounters( frontEndCounters_t *to, const frontEndCounters_t *from ) {
+	int			i;
+	int			*t;
+	const int	*f;
+
+	t = (int *)to;
+	f = (const int *)from;
+	for ( i = 0 ; i < sizeof( *to ) / sizeof( int ) ; i++ ) {
+		t[i] += f[i];
+	}
+}
+
+/*
+================
+R_SplitWorldNode
+
+Walks down from the given node until the subtrees are small enough
+to be worth a job each.  Culling and dlight splitting are the same as
+R_RecursiveWorldNode, so the jobs start where it would have been.
+================
+*/
+static void R_SplitWorldNode( mnode_t *node, int planeBits, int dlightBits ) {
+	int			newDlights[2];
+	worldJob_t	*job;
+
+	if ( R_CullWorldNode( node, &planeBits ) ) {
+		return;
+	}
+
+	if ( node->contents == -1 && node->numLeafs > worldJobLeafTarget ) {
+		R_SplitNodeDlights( node, dlightBits, newDlights );
+		R_SplitWorldNode( node->children[0], planeBits, newDlights[0] );
+		R_SplitWorldNode( node->children[1], planeBits, newDlights[1] );
+		return;
+	}
+
+	if ( numWorldJobs == MAX_WORLD_JOBS ) {
+		// out of jobs, surfaces added here are skipped by the merge
+		R_RecursiveWorldNode( node, planeBits, dlightBits, NULL );
+		return;
+	}
+
+	job = &worldJobs[numWorldJobs++];
+	job->node = node;
+	job->planeBits = planeBits;
+	job->dlightBits = dlightBits;
+	job->firstLeaf = numWorldJobLeafs;
+	job->numLeafs = 0;
+	ClearBounds( job->visBounds[0], job->visBounds[1] );
+	Com_Memset( &job->pc, 0, sizeof( job->pc ) );
+
+	// subtrees don't share leafs, so the slices never overlap
+	numWorldJobLeafs += node->numLeafs;
+}
+
+/*
+================
+R_WorldNodeJob
+================
+*/
+static void R_WorldNodeJob( int index ) {
+	worldJob_t	*job;
+
+	job = &worldJobs[index];
+	R_RecursiveWorldNode( job->node, job->planeBits, job->dlightBits, job );
+}
+
+/*
+================
+R_GatherJobSurfaces
+
+Merges the node jobs and lists every surface of their leafs once,
+in the order the serial walk would have reached them.
+================
+*/
+static int R_GatherJobSurfaces( void ) {
+	int				i, j, c;
+	int				numSurfs;
+	worldJob_t		*job;
+	worldJobLeaf_t	*leaf;
+	worldJobSurf_t	*out;
+	msurface_t		*surf, **mark;
+
+	numSurfs = 0;
+	out = tr.world->jobSurfs;
+	for ( i = 0, job = worldJobs ; i < numWorldJobs ; i++, job++ ) {
+		R_AddFrontEndCounters( &tr.pc, &job->pc );
+		if ( !job->numLeafs ) {
+			continue;
+		}
+		AddPointToBounds( job->visBounds[0], tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+		AddPointToBounds( job->visBounds[1], tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+
+		for ( j = 0, leaf = tr.world->jobLeafs + job->firstLeaf ; j < job->numLeafs ; j++, leaf++ ) {
+			mark = leaf->leaf->firstmarksurface;
+			c = leaf->leaf->nummarksurfaces;
+			while ( c-- ) {
+				surf = *mark++;
+				if ( surf->viewCount == tr.viewCount ) {
+					continue;		// already in this view
+				}
+				surf->viewCount = tr.viewCount;
+
+				out->surf = surf;
+				out->dlightBits = leaf->dlightBits;
+				out++;
+				numSurfs++;
+			}
+		}
+	}
+
+	return numSurfs;
+}
+
+/*
+================
+R_WorldSurfaceJob
+
+R_AddWorldSurface for a slice of the gathered surfaces.  Each
+surface is only in one slice, so writing its dlightBits is safe.
+================
+*/
+static void R_WorldSurfaceJob( int index ) {
+	int				i;
+	int				dlightBits;
+	worldChunk_t	*chunk;
+	worldJobSurf_t	*in;
+	drawSurf_t		*out;
+	msurface_t		*surf;
+
+	chunk = &worldChunks[index];
+	chunk->numDrawSurfs = 0;
+	Com_Memset( &chunk->pc, 0, sizeof( chunk->pc ) );
+
+	in = tr.world->jobSurfs + chunk->firstSurf;
+	out = tr.world->jobDrawSurfs + chunk->firstSurf;
+	for ( i = 0 ; i < chunk->numSurfs ; i++, in++ ) {
+		surf = in->surf;
+
+		// try to cull before dlighting or adding
+		if ( R_CullSurface( surf->data, surf->shader, &chunk->pc ) ) {
+			continue;
+		}
+
+		// check for dlighting
+		dlightBits = in->dlightBits;
+		if ( dlightBits ) {
+			dlightBits = R_DlightSurface( surf, dlightBits, &chunk->pc );
+			dlightBits = ( dlightBits != 0 );
+		}
+
+		// same key as R_AddDrawSurf
+		out->sort = ( surf->shader->sortedIndex << QSORT_SHADERNUM_SHIFT )
+			| tr.shiftedEntityNum | ( surf->fogIndex << QSORT_FOGNUM_SHIFT ) | dlightBits;
+		out->surface = surf->data;
+		out++;
+		chunk->numDrawSurfs++;
+	}
+}
+
+/*
+================
+R_RunWorldSurfaceJobs
+
+Culls, dlights and keys the numSurfs gathered in tr.world->jobSurfs
+as jobs and appends the draw surfaces in order.
+================
+*/
+static void R_RunWorldSurfaceJobs( int numSurfs ) {
+	int				i, j;
+	int				numChunks;
+	int				index;
+	worldChunk_t	*chunk;
+	drawSurf_t		*in;
+
+	if ( !numSurfs ) {
+		return;
+	}
+
+	numChunks = ( numSurfs + WORLD_JOB_SURFACES - 1 ) / WORLD_JOB_SURFACES;
+	if ( numChunks > MAX_WORLD_JOBS ) {
+		numChunks = MAX_WORLD_JOBS;
+	}
+	for ( i = 0, chunk = worldChunks ; i < numChunks ; i++, chunk++ ) {
+		chunk->firstSurf = numSurfs * i / numChunks;
+		chunk->numSurfs = numSurfs * ( i + 1 ) / numChunks - chunk->firstSurf;
+	}
+
+	GLimp_RunFrontEndJobs( R_WorldSurfaceJob, numChunks, r_frontEndThreads->integer );
+
+	// append in the order the serial walk would have
+	for ( i = 0, chunk = worldChunks ; i < numChunks ; i++, chunk++ ) {
+		R_AddFrontEndCounters( &tr.pc, &chunk->pc );
+
+		in = tr.world->jobDrawSurfs + chunk->firstSurf;
+		for ( j = 0 ; j < chunk->numDrawSurfs ; j++, in++ ) {
+			// masked like R_AddDrawSurf, so overflow wraps around
+			index = tr.refdef.numDrawSurfs & DRAWSURF_MASK;
+			tr.refdef.drawSurfs[index] = *in;
+			tr.refdef.numDrawSurfs++;
+		}
+	}
+}
+
+/*
+================
+R_AddWorldSurfaceJobs
+================
+*/
+static void R_AddWorldSurfaceJobs( int dlightBits ) {
+	// split the tree into jobs of roughly equal leaf counts
+	numWorldJobs = 0;
+	numWorldJobLeafs = 0;
+	worldJobLeafTarget = tr.world->nodes->numLeafs / ( MAX_WORLD_JOBS / 2 );
+	R_SplitWorldNode( tr.world->nodes, 15, dlightBits );
+
+	GLimp_RunFrontEndJobs( R_WorldNodeJob, numWorldJobs, r_frontEndThreads->integer );
+
+	R_RunWorldSurfaceJobs( R_GatherJobSurfaces() );
+}
+
+
+/*
+=============================================================
+
+	VIS LISTS
+
+R_MarkLeaves only marks again when the view cluster or the areamask
+changes, but R_RecursiveWorldNode used to walk the marked tree and
+cull every node on every view.  Instead, each time the marks change,
+the marked leafs and the surfaces under them are listed once, in the
+order the walk would reach them, with their bounds kept as separate
+mins and maxs arrays.  A view then culls the two lists straight
+against the frustum.  The leafs give c_leafs and the z range exactly
+as the walk did, and the surfaces are culled by their own bounds
+rather than by the leafs they are in.
+
+=============================================================
+*/
+
+/*
+================
+R_AddVisListNode
+================
+*/
+static void R_AddVisListNode( mnode_t *node ) {
+	world_t		*w;
+	msurface_t	*surf, **mark;
+	int			i, j, c;
+
+	do {
+		if ( node->visframe != tr.visCount ) {
+			return;
+		}
+
+		if ( node->contents != -1 ) {
+			break;
+		}
+
+		R_AddVisListNode( node->children[0] );
+		node = node->children[1];
+	} while ( 1 );
+
+	w = tr.world;
+
+	i = w->numVisLeafs++;
+	w->visLeafs[i] = node;
+	for ( j = 0 ; j < 3 ; j++ ) {
+		w->visLeafBounds[j][i] = node->mins[j];
+		w->visLeafBounds[j+3][i] = node->maxs[j];
+	}
+
+	// a surface that spans several leafs is listed at the first
+	mark = node->firstmarksurface;
+	c = node->nummarksurfaces;
+	while ( c-- ) {
+		surf = *mark++;
+		if ( w->visSurfMarks[ surf - w->surfaces ] ) {
+			continue;
+		}
+		w->visSurfMarks[ surf - w->surfaces ] = 1;
+
+		i = w->numVisSurfs++;
+		w->visSurfs[i] = surf;
+		for ( j = 0 ; j < 3 ; j++ ) {
+			w->visSurfBounds[j][i] = surf->bounds[0][j];
+			w->visSurfBounds[j+3][i] = surf->bounds[1][j];
+		}
+	}
+}
+
+/*
+================
+R_BuildVisLists
+================
+*/
+static void R_BuildVisLists( void ) {
+	world_t		*w;
+
+	w = tr.world;
+	w->numVisLeafs = 0;
+	w->numVisSurfs = 0;
+	Com_Memset( w->visSurfMarks, 0, w->numsurfaces );
+
+	R_AddVisListNode( w->nodes );
+
+	w->visListCount = tr.visCount;
+}
+
+/*
+================
+R_CullVisList
+
+Writes the index of every box that isn't entirely behind one of the
+frustum planes, the test BoxOnPlaneSide makes for R_CullWorldNode.
+Returns the number written.
+================
+*/
+static int R_CullVisList( float * const bounds[6], int count, int *visible ) {
+	const float	*x[4], *y[4], *z[4];
+	cplane_t	*frust;
+	float		d;
+	int			numVisible;
+	int			i, j;
+
+	numVisible = 0;
+	if ( r_nocull->integer ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			visible[numVisible++] = i;
+		}
+		return numVisible;
+	}
+
+	// the corner furthest along each plane normal
+	for ( j = 0 ; j < 4 ; j++ ) {
+		frust = &tr.viewParms.frustum[j];
+		x[j] = bounds[ frust->normal[0] < 0 ? 0 : 3 ];
+		y[j] = bounds[ frust->normal[1] < 0 ? 1 : 4 ];
+		z[j] = bounds[ frust->normal[2] < 0 ? 2 : 5 ];
+	}
+
+	i = 0;
+#if idsse2
+	if ( r_simd->integer ) {
+		__m128	nx[4], ny[4], nz[4], dist[4];
+		__m128	in;
+		int		mask;
+
+		for ( j = 0 ; j < 4 ; j++ ) {
+			frust = &tr.viewParms.frustum[j];
+			nx[j] = _mm_set1_ps( frust->normal[0] );
+			ny[j] = _mm_set1_ps( frust->normal[1] );
+			nz[j] = _mm_set1_ps( frust->normal[2] );
+			dist[j] = _mm_set1_ps( frust->dist );
+		}
+
+		for ( ; i + 4 <= count ; i += 4 ) {
+			in = _mm_cmpge_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( x[0] + i ), nx[0] ),
+				_mm_mul_ps( _mm_loadu_ps( y[0] + i ), ny[0] ) ), _mm_mul_ps( _mm_loadu_ps( z[0] + i ), nz[0] ) ), dist[0] );
+			for ( j = 1 ; j < 4 ; j++ ) {
+				in = _mm_and_ps( in, _mm_cmpge_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( x[j] + i ), nx[j] ),
+					_mm_mul_ps( _mm_loadu_ps( y[j] + i ), ny[j] ) ), _mm_mul_ps( _mm_loadu_ps( z[j] + i ), nz[j] ) ), dist[j] ) );
+			}
+
+			mask = _mm_movemask_ps( in );
+			for ( j = 0 ; j < 4 ; j++ ) {
+				if ( mask & ( 1 << j ) ) {
+					visible[numVisible++] = i + j;
+				}
+			}
+		}
+	}
+#endif
+
+	for ( ; i < count ; i++ ) {
+		for ( j = 0 ; j < 4 ; j++ ) {
+			frust = &tr.viewParms.frustum[j];
+			d = x[j][i] * frust->normal[0] + y[j][i] * frust->normal[1] + z[j][i] * frust->normal[2];
+			if ( d < frust->dist ) {
+				break;
+			}
+		}
+		if ( j == 4 ) {
+			visible[numVisible++] = i;
+		}
+	}
+
+	return numVisible;
+}
+
+/*
+=============================================================
+
+	DLIGHT BINNING
+
+Each view bins its dlights once into slabs along each axis of the
+bounds of the visible leafs, so a vis list surface only has to test the
+lights found in the slabs its bounds cover on all three axes, once
+there are enough lights for that to beat testing them all.  Bounds
+off the edge are clamped to the edge slabs, which keeps the bins
+conservative, and the exact test still runs on what they give, so the
+bits come out as before.
+
+=============================================================
+*/
+
+#define	DLIGHT_SLABS	64		// slabs on each axis
+#define	DLIGHT_BIN_MIN	8		// fewer lights are cheaper to test directly
+
+typedef struct {
+	vec3_t	origin;
+	vec3_t	inverseSize;
+	int		slabs[3][DLIGHT_SLABS];
+} dlightSlabs_t;
+
+static dlightSlabs_t	dlightSlabs;
+
+/*
+================
+R_DlightSlabRange
+
+The slabs covered by mins to maxs on one axis, clamped to the edges
+================
+*/
+static void R_DlightSlabRange( int axis, float mins, float maxs, int *lo, int *hi ) {
+	float	scale, origin;
+
+	origin = dlightSlabs.origin[axis];
+	scale = dlightSlabs.inverseSize[axis];
+
+	if ( mins <= origin ) {
+		*lo = 0;
+	} else {
+		*lo = ( mins - origin ) * scale;
+		if ( *lo >= DLIGHT_SLABS ) {
+			*lo = DLIGHT_SLABS - 1;
+		}
+	}
+	if ( maxs <= origin ) {
+		*hi = 0;
+	} else {
+		*hi = ( maxs - origin ) * scale;
+		if ( *hi >= DLIGHT_SLABS ) {
+			*hi = DLIGHT_SLABS - 1;
+		}
+	}
+}
+
+/*
+================
+R_BinDlights
+
+Over tr.viewParms.visBounds, so the leafs must have been culled
+================
+*/
+static void R_BinDlights( int dlightBits ) {
+	dlight_t	*dl;
+	float		size;
+	int			lo, hi;
+	int			i, j, k;
+
+	Com_Memset( dlightSlabs.slabs, 0, sizeof( dlightSlabs.slabs ) );
+
+	for ( j = 0 ; j < 3 ; j++ ) {
+		dlightSlabs.origin[j] = tr.viewParms.visBounds[0][j];
+		size = ( tr.viewParms.visBounds[1][j] - tr.viewParms.visBounds[0][j] ) / DLIGHT_SLABS;
+		dlightSlabs.inverseSize[j] = size > 1.0f ? 1.0f / size : 1.0f;
+	}
+
+	for ( i = 0 ; i < tr.refdef.num_dlights ; i++ ) {
+		if ( ! ( dlightBits & ( 1 << i ) ) ) {
+			continue;
+		}
+		dl = &tr.refdef.dlights[i];
+
+		for ( j = 0 ; j < 3 ; j++ ) {
+			R_DlightSlabRange( j, dl->origin[j] - dl->radius, dl->origin[j] + dl->radius, &lo, &hi );
+			for ( k = lo ; k <= hi ; k++ ) {
+				dlightSlabs.slabs[j][k] |= 1 << i;
+			}
+		}
+	}
+}
+
+/*
+================
+R_DlightSlabBits
+
+The lights binned in the slabs covered by vis list surface i
+================
+*/
+static int R_DlightSlabBits( int i, int dlightBits ) {
+	float	**bounds;
+	int		lo, hi;
+	int		j, k, bits, axisBits;
+
+	bounds = tr.world->visSurfBounds;
+	bits = dlightBits;
+	for ( j = 0 ; j < 3 && bits ; j++ ) {
+		R_DlightSlabRange( j, bounds[j][i], bounds[j+3][i], &lo, &hi );
+		axisBits = 0;
+		for ( k = lo ; k <= hi ; k++ ) {
+			axisBits |= dlightSlabs.slabs[j][k];
+		}
+		bits &= axisBits;
+	}
+
+	return bits;
+}
+
+/*
+================
+R_DlightVisSurf
+
+The dlights whose radius reaches the bounds of vis list surface i
+================
+*/
+static int R_DlightVisSurf( int i, int dlightBits ) {
+	float	**bounds;
+	dlight_t	*dl;
+	int		j;
+
+	bounds = tr.world->visSurfBounds;
+	for ( j = 0 ; j < tr.refdef.num_dlights ; j++ ) {
+		if ( ! ( dlightBits & ( 1 << j ) ) ) {
+			continue;
+		}
+		dl = &tr.refdef.dlights[j];
+		if ( dl->origin[0] - dl->radius > bounds[3][i]
+			|| dl->origin[0] + dl->radius < bounds[0][i]
+			|| dl->origin[1] - dl->radius > bounds[4][i]
+			|| dl->origin[1] + dl->radius < bounds[1][i]
+			|| dl->origin[2] - dl->radius > bounds[5][i]
+			|| dl->origin[2] + dl->radius < bounds[2][i] ) {
+			dlightBits &= ~( 1 << j );
+		}
+	}
+
+	return dlightBits;
+}
+
+/*
+================
+R_GatherVisListSurfaces
+
+Culls the vis lists for this view and puts the surfaces that are
+left in tr.world->jobSurfs.  Returns the number of them.
+================
+*/
+static int R_GatherVisListSurfaces( int dlightBits ) {
+	world_t			*w;
+	worldJobSurf_t	*out;
+	mnode_t			*leaf;
+	int				numVisible;
+	int				i;
+	qboolean		binned;
+
+	w = tr.world;
+	if ( w->visListCount != tr.visCount ) {
+		R_BuildVisLists();
+	}
+
+	numVisible = R_CullVisList( w->visLeafBounds, w->numVisLeafs, w->visIndexes );
+	tr.pc.c_leafs += numVisible;
+	for ( i = 0 ; i < numVisible ; i++ ) {
+		// add to z buffer bounds
+		leaf = w->visLeafs[ w->visIndexes[i] ];
+		AddPointToBounds( leaf->mins, tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+		AddPointToBounds( leaf->maxs, tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+	}
+
+	binned = dlightBits && tr.refdef.num_dlights >= DLIGHT_BIN_MIN;
+	if ( binned ) {
+		R_BinDlights( dlightBits );
+	}
+
+	numVisible = R_CullVisList( w->visSurfBounds, w->numVisSurfs, w->visIndexes );
+	out = w->jobSurfs;
+	for ( i = 0 ; i < numVisible ; i++, out++ ) {
+		out->surf = w->visSurfs[ w->visIndexes[i] ];
+		out->dlightBits = 0;
+		if ( dlightBits ) {
+			out->dlightBits = binned ? R_DlightSlabBits( w->visIndexes[i], dlightBits ) : dlightBits;
+			if ( out->dlightBits ) {
+				out->dlightBits = R_DlightVisSurf( w->visIndexes[i], out->dlightBits );
+			}
+		}
+	}
+
+	return numVisible;
+}
+
+
+/*
+=============
+R_AddVisibleWorld
+
+Adds the world surfaces that survive culling from the leafs
+R_MarkLeaves marked
+=============
+*/
+static void R_AddVisibleWorld( qboolean visLists, int dlightBits ) {
+	worldJobSurf_t	*in;
+	int				numSurfs;
+
+	// clear out the visible min/max
+	ClearBounds( tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
+
+	if ( visLists ) {
+		numSurfs = R_GatherVisListSurfaces( dlightBits );
+		if ( r_frontEndThreads->integer > 0 ) {
+			R_RunWorldSurfaceJobs( numSurfs );
+			return;
+		}
+		for ( in = tr.world->jobSurfs ; numSurfs-- ; in++ ) {
+			R_AddWorldSurface( in->surf, in->dlightBits );
+		}
+		return;
+	}
+
+	// perform frustum culling and add all the potentially visible surfaces
+	if ( r_frontEndThreads->integer > 0 ) {
+		R_AddWorldSurfaceJobs( dlightBits );
+	} else {
+		R_RecursiveWorldNode( tr.world->nodes, 15, dlightBits, NULL );
+	}
+}
+
 /*
 =============
 R_AddWorldSurfaces
@@ -657,12 +1360,80 @@ void R_AddWorldSurfaces (void) {
 	// determine which leaves are in the PVS / areamask
 	R_MarkLeaves ();
 
-	// clear out the visible min/max
-	ClearBounds( tr.viewParms.visBounds[0], tr.viewParms.visBounds[1] );
-
-	// perform frustum culling and add all the potentially visible surfaces
 	if ( tr.refdef.num_dlights > 32 ) {
 		tr.refdef.num_dlights = 32 ;
 	}
-	R_RecursiveWorldNode( tr.world->nodes, 15, ( 1 << tr.refdef.num_dlights ) - 1 );
+	R_AddVisibleWorld( r_visLists->integer, ( 1 << tr.refdef.num_dlights ) - 1 );
+}
+
+/*
+=============
+R_WorldBench_f
+
+worldbench [iterations]
+
+Adds the world for the last view over and over, walking the BSP, from
+the vis lists, and from vis lists rebuilt every time, with the current
+r_frontEndThreads.  The draw surfaces are thrown away.
+=============
+*/
+void R_WorldBench_f( void ) {
+	static const char	*names[3] = { "bsp walk", "vis lists", "vis lists, rebuilt" };
+	orientationr_t		or;
+	vec3_t				visBounds[2];
+	int					iterations;
+	int					firstDrawSurf;
+	int					msec[3], numSurfs[3];
+	int					i, mode, start;
+
+	if ( !tr.world || !tr.refdef.drawSurfs || ( tr.refdef.rdflags & RDF_NOWORLDMODEL ) ) {
+		ri.Printf( PRINT_ALL, "worldbench needs a map and a rendered view of it\n" );
+		return;
+	}
+
+	iterations = 200;
+	if ( ri.Cmd_Argc() > 1 ) {
+		iterations = atoi( ri.Cmd_Argv( 1 ) );
+	}
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	R_SyncRenderThread();
+
+	// R_AddWorldSurfaces runs in the world orientation
+	or = tr.or;
+	tr.or = tr.viewParms.world;
+	VectorCopy( tr.viewParms.visBounds[0], visBounds[0] );
+	VectorCopy( tr.viewParms.visBounds[1], visBounds[1] );
+	tr.currentEntityNum = ENTITYNUM_WORLD;
+	tr.shiftedEntityNum = tr.currentEntityNum << QSORT_ENTITYNUM_SHIFT;
+	firstDrawSurf = tr.refdef.numDrawSurfs;
+
+	for ( mode = 0 ; mode < 3 ; mode++ ) {
+		start = ri.Milliseconds();
+		for ( i = 0 ; i < iterations ; i++ ) {
+			tr.viewCount++;
+			tr.refdef.numDrawSurfs = firstDrawSurf;
+			if ( mode == 2 ) {
+				tr.world->visListCount = tr.visCount - 1;
+			}
+			R_AddVisibleWorld( mode != 0, ( 1 << tr.refdef.num_dlights ) - 1 );
+		}
+		msec[mode] = ri.Milliseconds() - start;
+		numSurfs[mode] = tr.refdef.numDrawSurfs - firstDrawSurf;
+	}
+
+	tr.refdef.numDrawSurfs = firstDrawSurf;
+	tr.or = or;
+	VectorCopy( visBounds[0], tr.viewParms.visBounds[0] );
+	VectorCopy( visBounds[1], tr.viewParms.visBounds[1] );
+	Com_Memset( &tr.pc, 0, sizeof( tr.pc ) );
+
+	ri.Printf( PRINT_ALL, "cluster %i: %i leafs, %i surfaces in the vis lists\n",
+		tr.viewCluster, tr.world->numVisLeafs, tr.world->numVisSurfs );
+	for ( mode = 0 ; mode < 3 ; mode++ ) {
+		ri.Printf( PRINT_ALL, "%18s: %i msec for %i views, %i draw surfaces\n",
+			names[mode], msec[mode], iterations, numSurfs[mode] );
+	}
 }
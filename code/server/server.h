@@ -33,6 +33,17 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #define	MAX_ENT_CLUSTERS	16
 
+// what traces see of a linked entity, a relink that leaves all
+// of it alone keeps the trace cache
+typedef struct {
+	vec3_t		absmin, absmax;
+	vec3_t		origin, angles;		// a bmodel can turn inside the same abs box
+	vec3_t		mins, maxs;
+	int			contents;
+	int			ownerNum;
+	int			clip;				// bmodel, modelindex and SVF_CAPSULE
+} svLinkState_t;
+
 typedef struct svEntity_s {
 	struct worldSector_s *worldSector;
 	struct svEntity_s *nextEntityInWorldSector;
@@ -43,6 +54,9 @@ typedef struct svEntity_s {
 	int			lastCluster;		// if all the clusters don't fit in clusternums
 	int			areanum, areanum2;
 	int			snapshotCounter;	// used to prevent double adding from portal views
+	int			snapshotFrame;		// svs.snapshotFrame when snapshotState was copied
+	int			snapshotState;		// into svs.snapshotEntities[], shared by every client
+	svLinkState_t	linkState;		// when last linked
 } svEntity_t;
 
 typedef enum {
@@ -89,12 +103,14 @@ typedef struct {
 	byte			areabits[MAX_MAP_AREA_BYTES];		// portalarea visibility bits
 	playerState_t	ps;
 	int				num_entities;
-	int				first_entity;		// into the circular sv_packet_entities[]
+	unsigned		first_entity;		// into the circular svs.snapshotRefs[]
 										// the entities MUST be in increasing state number
 										// order, otherwise the delta compression will fail
+	unsigned		first_state;		// oldest svs.snapshotEntities[] slot the refs can use
 	int				messageSent;		// time the message was transmitted
 	int				messageAcked;		// time the message was acked
 	int				messageSize;		// used to rate drop packets
+	int				generation;			// svs.time the entities were copied, for the delta cache
 } clientSnapshot_t;
 
 typedef enum {
@@ -106,6 +122,10 @@ typedef enum {
 	CS_ACTIVE		// client is fully in game
 } clientState_t;
 
+// usercmds held for SV_RunQueuedUsercmds when sv_cmdQueue is set,
+// more than a frame's worth are merged into the last one
+#define	MAX_QUEUED_USERCMDS	64
+
 typedef struct netchan_buffer_s {
 	msg_t           msg;
 	byte            msgBuffer[MAX_MSGLEN];
@@ -156,6 +176,9 @@ typedef struct client_s {
 	int				ping;
 	int				rate;				// bytes / second
 	int				snapshotMsec;		// requests a snapshot every snapshotMsec unless rate choked
+	int				snapshotBudget;		// bytes of entity changes the last snapshot could use
+	int				snapshotDeferred;	// entities held back in the last snapshot
+	byte			snapshotDefers[MAX_GENTITIES];	// snapshots in a row each entity was held back
 	int				pureAuthentic;
 	qboolean  gotCP; // TTimo - additional flag to distinguish between a bad pure checksum, and no cp command at all
 	netchan_t		netchan;
@@ -165,6 +188,13 @@ typedef struct client_s {
 	// buffer them into this queue, and hand them out to netchan as needed
 	netchan_buffer_t *netchan_start_queue;
 	netchan_buffer_t **netchan_end_queue;
+
+	// usercmds waiting for the next server frame when sv_cmdQueue is set
+	usercmd_t		cmdQueue[MAX_QUEUED_USERCMDS];
+	int				cmdQueueCount;
+	int				cmdsExecuted;
+	int				cmdsCoalesced;		// merged into a later usercmd to stay within sv_cmdsPerFrame
+	int				cmdsDropped;		// still queued when the client left the game
 } client_t;
 
 //=============================================================================
@@ -199,9 +229,14 @@ typedef struct {
 	int			snapFlagServerBit;			// ^= SNAPFLAG_SERVERCOUNT every SV_SpawnServer()
 
 	client_t	*clients;					// [sv_maxclients->integer];
-	int			numSnapshotEntities;		// sv_maxclients->integer*PACKET_BACKUP*MAX_PACKET_ENTITIES
-	int			nextSnapshotEntities;		// next snapshotEntities to use
-	entityState_t	*snapshotEntities;		// [numSnapshotEntities]
+	int			numSnapshotEntities;
+	unsigned	nextSnapshotEntities;		// next snapshotEntities to use, wraps
+	entityState_t	*snapshotEntities;		// [numSnapshotEntities] one copy per entity per snapshot frame
+	int			numSnapshotRefs;			// sv_maxclients->integer*PACKET_BACKUP*MAX_PACKET_ENTITIES
+	unsigned	nextSnapshotRefs;			// next snapshotRefs to use, wraps
+	int			*snapshotRefs;				// [numSnapshotRefs] client frame entities, into snapshotEntities
+	int			snapshotFrame;				// bumped for every batch of snapshots built together
+	unsigned	snapshotFrameFirst;			// first snapshotEntities of the current snapshot frame
 	int			nextHeartbeatTime;
 	challenge_t	challenges[MAX_CHALLENGES];	// to prevent invalid IPs from connecting
 	netadr_t	redirectAddress;			// for rcon return messages
@@ -243,6 +278,11 @@ extern	cvar_t	*sv_pure;
 extern	cvar_t	*sv_floodProtect;
 extern	cvar_t	*sv_lanForceRate;
 extern	cvar_t	*sv_strictAuth;
+extern	cvar_t	*sv_cmdQueue;
+extern	cvar_t	*sv_cmdsPerFrame;
+extern	cvar_t	*sv_traceCache;
+extern	cvar_t	*sv_deltaCache;
+extern	cvar_t	*sv_snapshotBudget;
 
 //===========================================================
 
@@ -294,6 +334,7 @@ void SV_DropClient( client_t *drop, const char *reason );
 
 void SV_ExecuteClientCommand( client_t *cl, const char *s, qboolean clientOK );
 void SV_ClientThink (client_t *cl, usercmd_t *cmd);
+void SV_RunQueuedUsercmds( void );
 
 void SV_WriteDownloadToClient( client_t *cl , msg_t *msg );
 
@@ -301,6 +342,8 @@ void SV_WriteDownloadToClient( client_t *cl , msg_t *msg );
 // sv_ccmds.c
 //
 void SV_Heartbeat_f( void );
+void SV_RecordUsercmd( client_t *cl, usercmd_t *cmd );
+void SV_StopUsercmdRecording( void );
 
 //
 // sv_snapshot.c
@@ -311,6 +354,10 @@ void SV_WriteFrameToClient (client_t *client, msg_t *msg);
 void SV_SendMessageToClient( msg_t *msg, client_t *client );
 void SV_SendClientMessages( void );
 void SV_SendClientSnapshot( client_t *client );
+void SV_DeltaBench_f( void );
+void SV_SnapshotStats_f( void );
+entityState_t *SV_SnapshotEntity( clientSnapshot_t *frame, int index );
+qboolean SV_SnapshotEntitiesValid( clientSnapshot_t *frame );
 
 //
 // sv_game.c
@@ -365,6 +412,12 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent );
 
 
 void SV_SectorList_f( void );
+void SV_TraceCache_f( void );
+
+
+void SV_ClearTraceCache( void );
+// forgets every remembered SV_Trace result, called each game frame
+// and whenever an entity is linked or unlinked
 
 
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount );
@@ -588,6 +588,36 @@ static void SV_Status_f( void ) {
 	Com_Printf ("\n");
 }
 
+/*
+================
+SV_CmdQueue_f
+
+Reports how the usercmd queue has treated each client
+================
+*/
+static void SV_CmdQueue_f( void ) {
+	int			i;
+	client_t	*cl;
+
+	// make sure server is running
+	if ( !com_sv_running->integer ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	Com_Printf( "sv_cmdQueue %i, sv_cmdsPerFrame %i\n", sv_cmdQueue->integer, sv_cmdsPerFrame->integer );
+	Com_Printf( "num name            executed coalesced dropped\n" );
+	Com_Printf( "--- --------------- -------- --------- -------\n" );
+	for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+		if ( !cl->state || cl->netchan.remoteAddress.type == NA_BOT ) {
+			continue;
+		}
+		Com_Printf( "%3i %-15.15s %8i %9i %7i\n", i, cl->name,
+			cl->cmdsExecuted, cl->cmdsCoalesced, cl->cmdsDropped );
+	}
+	Com_Printf( "\n" );
+}
+
 /*
 ==================
 SV_ConSay_f
@@ -700,6 +730,335 @@ static void SV_KillServer_f( void ) {
 	SV_Shutdown( "killserver" );
 }
 
+/*
+===============================================================================
+
+USERCMD RECORDING AND GAME BENCHMARK
+
+"cmdrecord <name>" saves every usercmd executed for human clients, and
+"gamebench <name>" feeds them back to the game through stand-in clients,
+stepping GAME_RUN_FRAME with the recorded frame time as fast as possible.
+Bots already on the server keep running their own AI during playback.
+
+===============================================================================
+*/
+
+#define	BENCH_IDENT			(('C'<<24)+('B'<<16)+('3'<<8)+'Q')
+#define	BENCH_VERSION		1
+#define	BENCH_HEADER_SIZE	12		// ident, version, frame msec
+#define	BENCH_CMD_SIZE		32		// time, clientNum, serverTime, angles[3], buttons, 4 bytes
+#define	BENCH_MAX_FRAMES	72000	// an hour of 20hz frames
+
+static fileHandle_t	sv_cmdRecordFile;
+static int			sv_cmdRecordStartTime;
+
+/*
+==================
+SV_RecordUsercmd
+
+Called by SV_ClientThink for every usercmd the game will see
+==================
+*/
+void SV_RecordUsercmd( client_t *cl, usercmd_t *cmd ) {
+	int		data[BENCH_CMD_SIZE / 4];
+
+	if ( !sv_cmdRecordFile || cl->netchan.remoteAddress.type == NA_BOT ) {
+		return;
+	}
+
+	data[0] = LittleLong( svs.time - sv_cmdRecordStartTime );
+	data[1] = LittleLong( cl - svs.clients );
+	data[2] = LittleLong( cmd->serverTime - sv_cmdRecordStartTime );
+	data[3] = LittleLong( cmd->angles[0] );
+	data[4] = LittleLong( cmd->angles[1] );
+	data[5] = LittleLong( cmd->angles[2] );
+	data[6] = LittleLong( cmd->buttons );
+	((byte *)&data[7])[0] = cmd->weapon;
+	((byte *)&data[7])[1] = cmd->forwardmove;
+	((byte *)&data[7])[2] = cmd->rightmove;
+	((byte *)&data[7])[3] = cmd->upmove;
+
+	FS_Write( data, sizeof( data ), sv_cmdRecordFile );
+}
+
+/*
+==================
+SV_CmdRecord_f
+
+cmdrecord <name>
+==================
+*/
+static void SV_CmdRecord_f( void ) {
+	char	name[MAX_QPATH];
+	int		header[BENCH_HEADER_SIZE / 4];
+
+	if ( !com_sv_running->integer || sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "Usage: cmdrecord <name>\n" );
+		return;
+	}
+
+	if ( sv_cmdRecordFile ) {
+		Com_Printf( "Already recording usercmds.\n" );
+		return;
+	}
+
+	Com_sprintf( name, sizeof( name ), "benchmarks/%s.cmds", Cmd_Argv( 1 ) );
+	sv_cmdRecordFile = FS_FOpenFileWrite( name );
+	if ( !sv_cmdRecordFile ) {
+		Com_Printf( "ERROR: couldn't open %s.\n", name );
+		return;
+	}
+
+	header[0] = LittleLong( BENCH_IDENT );
+	header[1] = LittleLong( BENCH_VERSION );
+	header[2] = LittleLong( 1000 / sv_fps->integer );
+	FS_Write( header, sizeof( header ), sv_cmdRecordFile );
+
+	sv_cmdRecordStartTime = svs.time;
+	Com_Printf( "recording usercmds to %s.\n", name );
+}
+
+/*
+==================
+SV_StopUsercmdRecording
+
+Also called when the map changes or the server shuts down
+==================
+*/
+void SV_StopUsercmdRecording( void ) {
+	if ( !sv_cmdRecordFile ) {
+		return;
+	}
+
+	FS_FCloseFile( sv_cmdRecordFile );
+	sv_cmdRecordFile = 0;
+	Com_Printf( "Stopped usercmd recording after %i msec.\n", svs.time - sv_cmdRecordStartTime );
+}
+
+/*
+==================
+SV_CmdStop_f
+==================
+*/
+static void SV_CmdStop_f( void ) {
+	if ( !sv_cmdRecordFile ) {
+		Com_Printf( "Not recording usercmds.\n" );
+		return;
+	}
+
+	SV_StopUsercmdRecording();
+}
+
+/*
+==================
+SV_BenchConnectClient
+
+Connects a stand-in for a recorded client, returns -1 if no slot is free
+==================
+*/
+static int SV_BenchConnectClient( int recordedNum ) {
+	int			clientNum;
+	char		*denied;
+	usercmd_t	nullcmd;
+
+	clientNum = SV_BotAllocateClient();
+	if ( clientNum == -1 ) {
+		return -1;
+	}
+
+	SV_SetUserinfo( clientNum, va( "\\name\\replay%i\\ip\\localhost\\rate\\25000\\snaps\\20", recordedNum ) );
+
+	denied = (char *)VM_Call( gvm, GAME_CLIENT_CONNECT, clientNum, qtrue, qfalse );
+	if ( denied ) {
+		Com_Printf( "Game rejected replay client %i: %s\n", recordedNum, (char *)VM_ExplicitArgPtr( gvm, (int)denied ) );
+		SV_BotFreeClient( clientNum );
+		SV_SetUserinfo( clientNum, "" );
+		return -1;
+	}
+
+	Com_Memset( &nullcmd, 0, sizeof( nullcmd ) );
+	nullcmd.serverTime = svs.time;
+	SV_ClientEnterWorld( &svs.clients[clientNum], &nullcmd );
+
+	return clientNum;
+}
+
+/*
+==================
+SV_GameBench_f
+
+gamebench <name> [frames]
+
+Replays a usercmd recording against the running map without touching
+the network or snapshot code, then prints frames per second and the
+game's g_speeds breakdown.  The recording loops if more frames are asked
+for than it holds.
+==================
+*/
+static void SV_GameBench_f( void ) {
+	char		name[MAX_QPATH];
+	int			*header;
+	byte		*buffer, *data;
+	int			len, numCmds, cmdNum;
+	int			frameMsec, frame, numFrames, lastTime;
+	int			recordTime, benchStartTime, loopStartTime;
+	int			slots[MAX_CLIENTS];
+	int			i, clientNum, startTime, msec;
+	int			oldSpeeds;
+	usercmd_t	cmd;
+	client_t	*cl;
+
+	if ( !com_sv_running->integer || sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	if ( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: gamebench <name> [frames]\n" );
+		return;
+	}
+
+	if ( sv_cmdRecordFile ) {
+		Com_Printf( "Can't benchmark while recording usercmds.\n" );
+		return;
+	}
+
+	Com_sprintf( name, sizeof( name ), "benchmarks/%s.cmds", Cmd_Argv( 1 ) );
+	len = FS_ReadFile( name, (void **)&buffer );
+	if ( !buffer ) {
+		Com_Printf( "Couldn't read %s.\n", name );
+		return;
+	}
+
+	header = (int *)buffer;
+	numCmds = ( len - BENCH_HEADER_SIZE ) / BENCH_CMD_SIZE;
+	if ( len < BENCH_HEADER_SIZE || LittleLong( header[0] ) != BENCH_IDENT
+		|| LittleLong( header[1] ) != BENCH_VERSION || numCmds < 1 ) {
+		Com_Printf( "%s is not a version %i usercmd recording.\n", name, BENCH_VERSION );
+		FS_FreeFile( buffer );
+		return;
+	}
+	frameMsec = LittleLong( header[2] );
+	if ( frameMsec < 1 ) {
+		frameMsec = 50;
+	}
+	data = buffer + BENCH_HEADER_SIZE;
+
+	// the recording length decides the default benchmark length
+	lastTime = LittleLong( ((int *)( data + ( numCmds - 1 ) * BENCH_CMD_SIZE ))[0] );
+	numFrames = lastTime / frameMsec + 1;
+	if ( Cmd_Argc() > 2 ) {
+		numFrames = atoi( Cmd_Argv( 2 ) );
+		if ( numFrames < 1 || numFrames > BENCH_MAX_FRAMES ) {
+			Com_Printf( "Usage: gamebench <name> [frames], frames from 1 to %i\n", BENCH_MAX_FRAMES );
+			FS_FreeFile( buffer );
+			return;
+		}
+	}
+	if ( numFrames < 1 || numFrames > BENCH_MAX_FRAMES ) {
+		// a damaged recording's timestamps
+		numFrames = numFrames < 1 ? 1 : BENCH_MAX_FRAMES;
+	}
+
+	// connect a stand-in for every recorded client
+	for ( i = 0 ; i < MAX_CLIENTS ; i++ ) {
+		slots[i] = -1;
+	}
+	for ( cmdNum = 0 ; cmdNum < numCmds ; cmdNum++ ) {
+		clientNum = LittleLong( ((int *)( data + cmdNum * BENCH_CMD_SIZE ))[1] );
+		if ( clientNum < 0 || clientNum >= MAX_CLIENTS || slots[clientNum] != -1 ) {
+			continue;
+		}
+		slots[clientNum] = SV_BenchConnectClient( clientNum );
+		if ( slots[clientNum] == -1 ) {
+			Com_Printf( "No free client slot for recorded client %i.\n", clientNum );
+			slots[clientNum] = -2;
+		}
+	}
+
+	oldSpeeds = Cvar_VariableIntegerValue( "g_speeds" );
+	Cvar_Set( "g_speeds", "1" );
+	Cmd_ExecuteString( "gamespeeds clear" );
+
+	benchStartTime = svs.time;
+	loopStartTime = svs.time;
+	cmdNum = 0;
+	startTime = Sys_Milliseconds();
+	for ( frame = 0 ; frame < numFrames ; frame++ ) {
+		// feed everything that arrived before this frame in the recording
+		recordTime = svs.time - loopStartTime;
+		while ( cmdNum < numCmds ) {
+			int		*in;
+
+			in = (int *)( data + cmdNum * BENCH_CMD_SIZE );
+			if ( LittleLong( in[0] ) > recordTime ) {
+				break;
+			}
+			cmdNum++;
+
+			clientNum = LittleLong( in[1] );
+			if ( clientNum < 0 || clientNum >= MAX_CLIENTS || slots[clientNum] < 0 ) {
+				continue;
+			}
+			cmd.serverTime = LittleLong( in[2] ) + loopStartTime;
+			cmd.angles[0] = LittleLong( in[3] );
+			cmd.angles[1] = LittleLong( in[4] );
+			cmd.angles[2] = LittleLong( in[5] );
+			cmd.buttons = LittleLong( in[6] );
+			cmd.weapon = ((byte *)&in[7])[0];
+			cmd.forwardmove = ((byte *)&in[7])[1];
+			cmd.rightmove = ((byte *)&in[7])[2];
+			cmd.upmove = ((byte *)&in[7])[3];
+
+			SV_ClientThink( &svs.clients[slots[clientNum]], &cmd );
+		}
+
+		// start over when the recording runs out
+		if ( cmdNum == numCmds && recordTime >= lastTime ) {
+			cmdNum = 0;
+			loopStartTime = svs.time + frameMsec;
+		}
+
+		SV_BotFrame( svs.time );
+
+		svs.time += frameMsec;
+		SV_ClearTraceCache();
+		VM_Call( gvm, GAME_RUN_FRAME, svs.time );
+	}
+	msec = Sys_Milliseconds() - startTime;
+
+	// the server clock jumped ahead, so move the real clients with it
+	// or they would all time out on the next frame
+	for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+		if ( cl->state < CS_CONNECTED ) {
+			continue;
+		}
+		cl->lastPacketTime += svs.time - benchStartTime;
+		cl->nextSnapshotTime = svs.time;
+	}
+
+	if ( msec < 1 ) {
+		msec = 1;
+	}
+	Com_Printf( "%i frames (%i game msec) in %i msec, %.1f frames/sec\n",
+		numFrames, svs.time - benchStartTime, msec, numFrames * 1000.0f / msec );
+	Cmd_ExecuteString( "gamespeeds" );
+	Cvar_Set( "g_speeds", va( "%i", oldSpeeds ) );
+
+	for ( i = 0 ; i < MAX_CLIENTS ; i++ ) {
+		if ( slots[i] >= 0 && svs.clients[slots[i]].state == CS_ACTIVE ) {
+			SV_DropClient( &svs.clients[slots[i]], "benchmark finished" );
+		}
+	}
+
+	FS_FreeFile( buffer );
+}
+
 //===========================================================
 
 /*
@@ -721,11 +1080,15 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("banClient", SV_BanNum_f);
 	Cmd_AddCommand ("clientkick", SV_KickNum_f);
 	Cmd_AddCommand ("status", SV_Status_f);
+	Cmd_AddCommand ("cmdqueue", SV_CmdQueue_f);
 	Cmd_AddCommand ("serverinfo", SV_Serverinfo_f);
 	Cmd_AddCommand ("systeminfo", SV_Systeminfo_f);
 	Cmd_AddCommand ("dumpuser", SV_DumpUser_f);
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f);
 	Cmd_AddCommand ("sectorlist", SV_SectorList_f);
+	Cmd_AddCommand ("tracecache", SV_TraceCache_f);
+	Cmd_AddCommand ("deltabench", SV_DeltaBench_f);
+	Cmd_AddCommand ("snapshotstats", SV_SnapshotStats_f);
 	Cmd_AddCommand ("map", SV_Map_f);
 #ifndef PRE_RELEASE_DEMO
 	Cmd_AddCommand ("devmap", SV_Map_f);
@@ -733,6 +1096,9 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("spdevmap", SV_Map_f);
 #endif
 	Cmd_AddCommand ("killserver", SV_KillServer_f);
+	Cmd_AddCommand ("cmdrecord", SV_CmdRecord_f);
+	Cmd_AddCommand ("cmdstop", SV_CmdStop_f);
+	Cmd_AddCommand ("gamebench", SV_GameBench_f);
 	if( com_dedicated->integer ) {
 		Cmd_AddCommand ("say", SV_ConSay_f);
 	}
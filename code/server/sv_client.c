@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "server.h"
 
 static void SV_CloseDownload( client_t *cl );
+static void SV_ClearUsercmdQueue( client_t *cl );
 
 /*
 =================
@@ -498,6 +499,7 @@ void SV_DropClient( client_t *drop, const char *reason ) {
 
 	Com_DPrintf( "Going to CS_ZOMBIE for %s\n", drop->name );
 	drop->state = CS_ZOMBIE;		// become free in a few seconds
+	SV_ClearUsercmdQueue( drop );
 
 	if (drop->download)	{
 		FS_FCloseFile( drop->download );
@@ -629,6 +631,7 @@ void SV_ClientEnterWorld( client_t *client, usercmd_t *cmd ) {
 	client->deltaMessage = -1;
 	client->nextSnapshotTime = svs.time;	// generate a snapshot immediately
 	client->lastUsercmd = *cmd;
+	SV_ClearUsercmdQueue( client );
 
 	// call the game begin function
 	VM_Call( gvm, GAME_CLIENT_BEGIN, client - svs.clients );
@@ -1314,9 +1317,116 @@ void SV_ClientThink (client_t *cl, usercmd_t *cmd) {
 		return;		// may have been kicked during the last usercmd
 	}
 
+	SV_RecordUsercmd( cl, cmd );
+
 	VM_Call( gvm, GAME_CLIENT_THINK, cl - svs.clients );
 }
 
+/*
+===========================================================================
+
+USERCMD QUEUE
+
+With sv_cmdQueue set, usercmds are held until the start of the next server
+frame instead of each one running a Pmove as soon as its packet arrives.
+A client can then cost at most sv_cmdsPerFrame client thinks per frame, no
+matter how bursty its packets are.  Merging keeps the latest command and
+its serverTime, so Pmove still covers the whole interval, only in fewer,
+longer steps.
+
+===========================================================================
+*/
+
+/*
+==================
+SV_CoalesceUsercmd
+
+Folds an older usercmd into a newer one without losing button presses
+==================
+*/
+static void SV_CoalesceUsercmd( const usercmd_t *older, usercmd_t *newer ) {
+	newer->buttons |= older->buttons;
+	if ( !newer->upmove ) {
+		newer->upmove = older->upmove;
+	}
+}
+
+/*
+==================
+SV_QueueUsercmd
+==================
+*/
+static void SV_QueueUsercmd( client_t *cl, usercmd_t *cmd ) {
+	usercmd_t	*last;
+
+	if ( cl->cmdQueueCount == MAX_QUEUED_USERCMDS ) {
+		last = &cl->cmdQueue[ cl->cmdQueueCount - 1 ];
+		SV_CoalesceUsercmd( last, cmd );
+		*last = *cmd;
+		cl->cmdsCoalesced++;
+		return;
+	}
+
+	cl->cmdQueue[ cl->cmdQueueCount++ ] = *cmd;
+}
+
+/*
+==================
+SV_ClearUsercmdQueue
+==================
+*/
+static void SV_ClearUsercmdQueue( client_t *cl ) {
+	cl->cmdsDropped += cl->cmdQueueCount;
+	cl->cmdQueueCount = 0;
+}
+
+/*
+==================
+SV_RunQueuedUsercmds
+
+Called once before each server frame
+==================
+*/
+void SV_RunQueuedUsercmds( void ) {
+	int			i, j, first, budget;
+	client_t	*cl;
+
+	budget = sv_cmdsPerFrame->integer;
+	if ( budget < 1 ) {
+		budget = 1;
+	}
+
+	for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+		if ( !cl->cmdQueueCount ) {
+			continue;
+		}
+		if ( cl->state != CS_ACTIVE ) {
+			SV_ClearUsercmdQueue( cl );
+			continue;
+		}
+
+		// merge the oldest commands until the rest fit in the budget
+		first = cl->cmdQueueCount - budget;
+		if ( first < 0 ) {
+			first = 0;
+		}
+		for ( j = 1 ; j <= first ; j++ ) {
+			SV_CoalesceUsercmd( &cl->cmdQueue[ j - 1 ], &cl->cmdQueue[ j ] );
+		}
+		cl->cmdsCoalesced += first;
+
+		for ( j = first ; j < cl->cmdQueueCount ; j++ ) {
+			if ( cl->state != CS_ACTIVE ) {
+				break;		// kicked by an earlier usercmd
+			}
+			SV_ClientThink( cl, &cl->cmdQueue[ j ] );
+			cl->cmdsExecuted++;
+		}
+		cl->cmdsDropped += cl->cmdQueueCount - j;
+		cl->cmdQueueCount = 0;
+	}
+}
+
 /*
 ==================
 SV_UserMove
@@ -1421,7 +1531,19 @@ static void SV_UserMove( client_t *cl, msg_t *msg, qboolean delta ) {
 		if ( cmds[i].serverTime <= cl->lastUsercmd.serverTime ) {
 			continue;
 		}
+		if ( cl->cmdQueueCount ) {
+			if ( cmds[i].serverTime <= cl->cmdQueue[ cl->cmdQueueCount - 1 ].serverTime ) {
+				continue;
+			}
+			SV_QueueUsercmd( cl, &cmds[ i ] );
+			continue;
+		}
+		if ( sv_cmdQueue->integer ) {
+			SV_QueueUsercmd( cl, &cmds[ i ] );
+			continue;
+		}
 		SV_ClientThink (cl, &cmds[ i ]);
+		cl->cmdsExecuted++;
 	}
 }
 
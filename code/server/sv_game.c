@@ -153,19 +153,22 @@ Also checks portalareas so that doors block sight
 */
 qboolean SV_inPVS (const vec3_t p1, const vec3_t p2)
 {
-	int		leafnum;
+	vec3_t	points[2];
+	int		leafnums[2];
 	int		cluster;
 	int		area1, area2;
 	byte	*mask;
 
-	leafnum = CM_PointLeafnum (p1);
-	cluster = CM_LeafCluster (leafnum);
-	area1 = CM_LeafArea (leafnum);
+	VectorCopy (p1, points[0]);
+	VectorCopy (p2, points[1]);
+	CM_PointLeafnums (points, 2, leafnums);
+
+	cluster = CM_LeafCluster (leafnums[0]);
+	area1 = CM_LeafArea (leafnums[0]);
 	mask = CM_ClusterPVS (cluster);
 
-	leafnum = CM_PointLeafnum (p2);
-	cluster = CM_LeafCluster (leafnum);
-	area2 = CM_LeafArea (leafnum);
+	cluster = CM_LeafCluster (leafnums[1]);
+	area2 = CM_LeafArea (leafnums[1]);
 	if ( mask && (!(mask[cluster>>3] & (1<<(cluster&7)) ) ) )
 		return qfalse;
 	if (!CM_AreasConnected (area1, area2))
@@ -183,19 +186,22 @@ Does NOT check portalareas
 */
 qboolean SV_inPVSIgnorePortals( const vec3_t p1, const vec3_t p2)
 {
-	int		leafnum;
+	vec3_t	points[2];
+	int		leafnums[2];
 	int		cluster;
 	int		area1, area2;
 	byte	*mask;
 
-	leafnum = CM_PointLeafnum (p1);
-	cluster = CM_LeafCluster (leafnum);
-	area1 = CM_LeafArea (leafnum);
+	VectorCopy (p1, points[0]);
+	VectorCopy (p2, points[1]);
+	CM_PointLeafnums (points, 2, leafnums);
+
+	cluster = CM_LeafCluster (leafnums[0]);
+	area1 = CM_LeafArea (leafnums[0]);
 	mask = CM_ClusterPVS (cluster);
 
-	leafnum = CM_PointLeafnum (p2);
-	cluster = CM_LeafCluster (leafnum);
-	area2 = CM_LeafArea (leafnum);
+	cluster = CM_LeafCluster (leafnums[1]);
+	area2 = CM_LeafArea (leafnums[1]);
 
 	if ( mask && (!(mask[cluster>>3] & (1<<(cluster&7)) ) ) )
 		return qfalse;
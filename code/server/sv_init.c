@@ -224,10 +224,10 @@ void SV_Startup( void ) {
 
 	svs.clients = Z_Malloc (sizeof(client_t) * sv_maxclients->integer );
 	if ( com_dedicated->integer ) {
-		svs.numSnapshotEntities = sv_maxclients->integer * PACKET_BACKUP * 64;
+		svs.numSnapshotRefs = sv_maxclients->integer * PACKET_BACKUP * 64;
 	} else {
 		// we don't need nearly as many when playing locally
-		svs.numSnapshotEntities = sv_maxclients->integer * 4 * 64;
+		svs.numSnapshotRefs = sv_maxclients->integer * 4 * 64;
 	}
 	svs.initialized = qtrue;
 
@@ -294,13 +294,41 @@ void SV_ChangeMaxClients( void ) {
 	
 	// allocate new snapshot entities
 	if ( com_dedicated->integer ) {
-		svs.numSnapshotEntities = sv_maxclients->integer * PACKET_BACKUP * 64;
+		svs.numSnapshotRefs = sv_maxclients->integer * PACKET_BACKUP * 64;
 	} else {
 		// we don't need nearly as many when playing locally
-		svs.numSnapshotEntities = sv_maxclients->integer * 4 * 64;
+		svs.numSnapshotRefs = sv_maxclients->integer * 4 * 64;
 	}
 }
 
+/*
+================
+SV_AllocSnapshotEntities
+
+The rings are indexed with wrapping counters, so their sizes are powers
+of two.  The reference ring keeps the size the client count asks for,
+rounded up.  Entity states are shared by every client that sees them in
+a snapshot frame, so half as many still hold far more frames than one
+copy per client did.
+================
+*/
+static void SV_AllocSnapshotEntities( void ) {
+	int		count;
+
+	count = 2 * MAX_GENTITIES;		// at least two frames of every entity
+	while ( count < svs.numSnapshotRefs ) {
+		count <<= 1;
+	}
+	svs.numSnapshotRefs = count;
+	svs.numSnapshotEntities = count > 2 * MAX_GENTITIES ? count / 2 : count;
+
+	svs.snapshotEntities = Hunk_Alloc( sizeof(entityState_t)*svs.numSnapshotEntities, h_high );
+	svs.nextSnapshotEntities = 0;
+	svs.snapshotRefs = Hunk_Alloc( sizeof(int)*svs.numSnapshotRefs, h_high );
+	svs.nextSnapshotRefs = 0;
+	svs.snapshotFrameFirst = 0;
+}
+
 /*
 ================
 SV_ClearServer
@@ -351,6 +379,9 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	char		systemInfo[16384];
 	const char	*p;
 
+	// a usercmd recording only makes sense on the map it was made on
+	SV_StopUsercmdRecording();
+
 	// shut down the existing game if it is running
 	SV_ShutdownGameProgs();
 
@@ -370,7 +401,7 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	// clear collision map data
 	CM_ClearMap();
 
-	// init client structures and svs.numSnapshotEntities 
+	// init client structures and svs.numSnapshotRefs 
 	if ( !Cvar_VariableValue("sv_running") ) {
 		SV_Startup();
 	} else {
@@ -384,8 +415,7 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	FS_ClearPakReferences(0);
 
 	// allocate the snapshot entities on the hunk
-	svs.snapshotEntities = Hunk_Alloc( sizeof(entityState_t)*svs.numSnapshotEntities, h_high );
-	svs.nextSnapshotEntities = 0;
+	SV_AllocSnapshotEntities();
 
 	// toggle the server bit so clients can detect that a
 	// server has changed
@@ -611,6 +641,11 @@ void SV_Init (void) {
 	sv_mapChecksum = Cvar_Get ("sv_mapChecksum", "", CVAR_ROM);
 	sv_lanForceRate = Cvar_Get ("sv_lanForceRate", "1", CVAR_ARCHIVE );
 	sv_strictAuth = Cvar_Get ("sv_strictAuth", "1", CVAR_ARCHIVE );
+	sv_cmdQueue = Cvar_Get ("sv_cmdQueue", "0", CVAR_ARCHIVE );
+	sv_cmdsPerFrame = Cvar_Get ("sv_cmdsPerFrame", "8", CVAR_ARCHIVE );
+	sv_traceCache = Cvar_Get ("sv_traceCache", "0", CVAR_ARCHIVE );
+	sv_deltaCache = Cvar_Get ("sv_deltaCache", "1", CVAR_ARCHIVE );
+	sv_snapshotBudget = Cvar_Get ("sv_snapshotBudget", "0", CVAR_ARCHIVE );
 
 	// initialize bot cvars so they are listed and can be set before loading the botlib
 	SV_BotInitCvars();
@@ -667,6 +702,8 @@ void SV_Shutdown( char *finalmsg ) {
 
 	Com_Printf( "----- Server Shutdown -----\n" );
 
+	SV_StopUsercmdRecording();
+
 	if ( svs.clients && !com_errorEntered ) {
 		SV_FinalMessage( finalmsg );
 	}
@@ -52,6 +52,11 @@ cvar_t	*sv_pure;
 cvar_t	*sv_floodProtect;
 cvar_t	*sv_lanForceRate; // dedicated 1 (LAN) server forces local client rates to 99999 (bug #491)
 cvar_t	*sv_strictAuth;
+cvar_t	*sv_cmdQueue;			// run usercmds at the start of the server frame instead of on arrival
+cvar_t	*sv_cmdsPerFrame;		// most usercmds run for one client in a server frame
+cvar_t	*sv_traceCache;			// remember SV_Trace results until something is linked or the frame ends
+cvar_t	*sv_deltaCache;			// share encoded entity deltas between clients each frame
+cvar_t	*sv_snapshotBudget;		// rank snapshot entities and hold back changes the rate can't take
 
 /*
 =============================================================================
@@ -794,12 +799,6 @@ void SV_Frame( int msec ) {
 		Cbuf_AddText( "vstr nextmap\n" );
 		return;
 	}
-	// this can happen considerably earlier when lots of clients play and the map doesn't change
-	if ( svs.nextSnapshotEntities >= 0x7FFFFFFE - svs.numSnapshotEntities ) {
-		SV_Shutdown( "Restarting server due to numSnapshotEntities wrapping" );
-		Cbuf_AddText( "vstr nextmap\n" );
-		return;
-	}
 
 	if( sv.restartTime && svs.time >= sv.restartTime ) {
 		sv.restartTime = 0;
@@ -828,12 +827,18 @@ void SV_Frame( int msec ) {
 
 	if (com_dedicated->integer) SV_BotFrame( svs.time );
 
+	// run the usercmds that arrived since the last frame
+	if ( sv.timeResidual >= frameMsec ) {
+		SV_RunQueuedUsercmds();
+	}
+
 	// run the game simulation in chunks
 	while ( sv.timeResidual >= frameMsec ) {
 		sv.timeResidual -= frameMsec;
 		svs.time += frameMsec;
 
 		// let everything in the world think and move
+		SV_ClearTraceCache();
 		VM_Call( gvm, GAME_RUN_FRAME, svs.time );
 	}
 
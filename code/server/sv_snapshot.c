@@ -45,6 +45,164 @@ A normal server packet will look like:
 =============================================================================
 */
 
+/*
+=============================================================================
+
+SNAPSHOT ENTITIES
+
+Each snapshot frame copies an entity's state once, into the
+svs.snapshotEntities ring, and every client frame that includes it keeps
+the index of that copy in the svs.snapshotRefs ring.  Both rings are
+indexed with wrapping counters, a client frame can be delta'd from as
+long as neither ring has gone all the way around since it was built.
+=============================================================================
+*/
+
+static qboolean	sendingClientMessages;
+
+/*
+=============
+SV_BeginSnapshotFrame
+
+Entities may have changed since the last snapshots were built
+=============
+*/
+static void SV_BeginSnapshotFrame( void ) {
+	svs.snapshotFrame++;
+	svs.snapshotFrameFirst = svs.nextSnapshotEntities;
+}
+
+/*
+=============
+SV_SnapshotEntity
+=============
+*/
+entityState_t *SV_SnapshotEntity( clientSnapshot_t *frame, int index ) {
+	int		ref;
+
+	ref = svs.snapshotRefs[ ( frame->first_entity + index ) & ( svs.numSnapshotRefs - 1 ) ];
+	return &svs.snapshotEntities[ ref ];
+}
+
+/*
+=============
+SV_SnapshotEntitiesValid
+
+False if the frame's entities have rolled off either ring
+=============
+*/
+qboolean SV_SnapshotEntitiesValid( clientSnapshot_t *frame ) {
+	if ( svs.nextSnapshotRefs - frame->first_entity >= (unsigned)svs.numSnapshotRefs ) {
+		return qfalse;
+	}
+	if ( svs.nextSnapshotEntities - frame->first_state >= (unsigned)svs.numSnapshotEntities ) {
+		return qfalse;
+	}
+	return qtrue;
+}
+
+/*
+=============================================================================
+
+DELTA CACHE
+
+Clients that acknowledged the same frame delta most entities from the same
+state to the same state.  The bits of each entity delta are kept for the
+rest of the server frame and copied into the next client's message.  An
+entry is keyed on the entity and the generation of the frame the delta
+is from, and is only used if both states are still identical.
+=============================================================================
+*/
+
+#define	DELTA_CACHE_SIZE	1024		// must be a power of two
+#define	DELTA_CACHE_BYTES	0x10000
+
+typedef struct {
+	int				frame;			// deltaCache.frame the entry was made in
+	int				fromGeneration;	// -1 for a baseline
+	qboolean		force;
+	entityState_t	from, to;
+	int				offset;			// into deltaCache.bits
+	int				numBits;
+} deltaCacheEntry_t;
+
+static struct {
+	int					time;		// svs.time of the current frame
+	int					frame;
+	int					used;		// bytes of bits used this frame
+	qboolean			bypass;		// set while deltabench runs
+	deltaCacheEntry_t	entries[DELTA_CACHE_SIZE];
+	byte				bits[DELTA_CACHE_BYTES];
+
+	int					hits;
+	int					misses;
+} deltaCache;
+
+/*
+=============
+SV_WriteDeltaEntityCached
+
+Same as MSG_WriteDeltaEntity, using the delta cache
+=============
+*/
+static void SV_WriteDeltaEntityCached( msg_t *msg, entityState_t *from, int fromGeneration, 
+									   entityState_t *to, qboolean force ) {
+	static byte			scratchData[MAX_MSGLEN];
+	msg_t				scratch;
+	deltaCacheEntry_t	*entry;
+	unsigned			hash;
+	int					numBytes;
+
+	if ( !sv_deltaCache->integer || deltaCache.bypass ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	if ( deltaCache.time != svs.time || !deltaCache.frame ) {
+		deltaCache.time = svs.time;
+		deltaCache.frame++;
+		deltaCache.used = 0;
+	}
+
+	hash = to->number * 0x9E3779B1 ^ fromGeneration * 0x85EBCA6B ^ force;
+	entry = &deltaCache.entries[ ( hash ^ ( hash >> 16 ) ) & ( DELTA_CACHE_SIZE - 1 ) ];
+
+	if ( entry->frame == deltaCache.frame && entry->fromGeneration == fromGeneration 
+		&& entry->force == force && !memcmp( &entry->to, to, sizeof( *to ) ) 
+		&& !memcmp( &entry->from, from, sizeof( *from ) ) ) {
+		numBytes = ( entry->numBits + 7 ) >> 3;
+		if ( msg->maxsize - msg->cursize >= numBytes + 4 ) {
+			MSG_WriteBitString( msg, deltaCache.bits + entry->offset, entry->numBits );
+			deltaCache.hits++;
+			return;
+		}
+	}
+	deltaCache.misses++;
+
+	MSG_Init( &scratch, scratchData, sizeof( scratchData ) );
+	MSG_WriteDeltaEntity( &scratch, from, to, force );
+	numBytes = ( scratch.bit + 7 ) >> 3;
+
+	if ( deltaCache.used + numBytes <= DELTA_CACHE_BYTES ) {
+		entry->frame = deltaCache.frame;
+		entry->fromGeneration = fromGeneration;
+		entry->force = force;
+		entry->from = *from;
+		entry->to = *to;
+		entry->offset = deltaCache.used;
+		entry->numBits = scratch.bit;
+		Com_Memcpy( deltaCache.bits + deltaCache.used, scratchData, numBytes );
+		deltaCache.used += numBytes;
+	}
+
+	// let MSG_WriteDeltaEntity handle a message that is about to overflow
+	if ( msg->maxsize - msg->cursize < numBytes + 4 ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+	MSG_WriteBitString( msg, scratchData, scratch.bit );
+}
+
 /*
 =============
 SV_EmitPacketEntities
@@ -73,14 +231,14 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 		if ( newindex >= to->num_entities ) {
 			newnum = 9999;
 		} else {
-			newent = &svs.snapshotEntities[(to->first_entity+newindex) % svs.numSnapshotEntities];
+			newent = SV_SnapshotEntity( to, newindex );
 			newnum = newent->number;
 		}
 
 		if ( oldindex >= from_num_entities ) {
 			oldnum = 9999;
 		} else {
-			oldent = &svs.snapshotEntities[(from->first_entity+oldindex) % svs.numSnapshotEntities];
+			oldent = SV_SnapshotEntity( from, oldindex );
 			oldnum = oldent->number;
 		}
 
@@ -88,7 +246,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emited if the entity has not changed at all
-			MSG_WriteDeltaEntity (msg, oldent, newent, qfalse );
+			SV_WriteDeltaEntityCached( msg, oldent, from->generation, newent, qfalse );
 			oldindex++;
 			newindex++;
 			continue;
@@ -96,7 +254,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 		if ( newnum < oldnum ) {
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
+			SV_WriteDeltaEntityCached( msg, &sv.svEntities[newnum].baseline, -1, newent, qtrue );
 			newindex++;
 			continue;
 		}
@@ -112,6 +270,117 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 	MSG_WriteBits( msg, (MAX_GENTITIES-1), GENTITYNUM_BITS );	// end of packetentities
 }
 
+/*
+=============
+SV_DeltaBenchFrames
+
+Encodes the entities of every client frame that can still be delta
+compressed against the frame before it, returns the number of frames
+and a checksum of the encodings
+=============
+*/
+#define	DELTABENCH_PASSES	20
+
+static int SV_DeltaBenchFrames( msg_t *msg, int passes, unsigned *checksum ) {
+	client_t			*cl;
+	clientSnapshot_t	*frame, *oldframe;
+	int					i, seq, pass;
+	int					numFrames;
+
+	MSG_Init( msg, msg->data, msg->maxsize );
+	numFrames = 0;
+	*checksum = 0;
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+			if ( cl->state != CS_ACTIVE ) {
+				continue;
+			}
+			for ( seq = cl->netchan.outgoingSequence - 1 ; 
+				seq > cl->netchan.outgoingSequence - PACKET_BACKUP && seq > 1 ; seq-- ) {
+				frame = &cl->frames[ seq & PACKET_MASK ];
+				oldframe = &cl->frames[ ( seq - 1 ) & PACKET_MASK ];
+				if ( !SV_SnapshotEntitiesValid( oldframe ) ) {
+					break;
+				}
+				MSG_Clear( msg );
+				SV_EmitPacketEntities( oldframe, frame, msg );
+				numFrames++;
+
+				// only the last pass is checked
+				if ( pass == passes - 1 ) {
+					*checksum = *checksum * 31 + msg->bit + Com_BlockChecksum( msg->data, msg->cursize );
+				}
+			}
+		}
+	}
+	return numFrames;
+}
+
+/*
+=============
+SV_DeltaBench_f
+
+deltabench [passes]
+
+Compares the entity delta encoder against writing every field with
+MSG_WriteBits over the snapshots recorded for the connected clients
+=============
+*/
+void SV_DeltaBench_f( void ) {
+	static byte	genericData[MAX_MSGLEN], fastData[MAX_MSGLEN];
+	msg_t		generic, fast;
+	unsigned	genericSum, fastSum;
+	int			passes, numFrames;
+	int			start, genericMsec, fastMsec;
+	qboolean	oldGeneric;
+
+	if ( !com_sv_running->integer ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	passes = DELTABENCH_PASSES;
+	if ( Cmd_Argc() > 1 ) {
+		passes = atoi( Cmd_Argv( 1 ) );
+		if ( passes < 1 ) {
+			passes = 1;
+		}
+	}
+
+	Com_Printf( "delta cache: %i hits, %i misses\n", deltaCache.hits, deltaCache.misses );
+
+	oldGeneric = msg_genericDelta;
+	deltaCache.bypass = qtrue;
+
+	generic.data = genericData;
+	generic.maxsize = sizeof( genericData );
+	msg_genericDelta = qtrue;
+	start = Sys_Milliseconds();
+	numFrames = SV_DeltaBenchFrames( &generic, passes, &genericSum );
+	genericMsec = Sys_Milliseconds() - start;
+
+	fast.data = fastData;
+	fast.maxsize = sizeof( fastData );
+	msg_genericDelta = qfalse;
+	start = Sys_Milliseconds();
+	SV_DeltaBenchFrames( &fast, passes, &fastSum );
+	fastMsec = Sys_Milliseconds() - start;
+
+	msg_genericDelta = oldGeneric;
+	deltaCache.bypass = qfalse;
+
+	if ( !numFrames ) {
+		Com_Printf( "no client snapshots to encode\n" );
+		return;
+	}
+
+	Com_Printf( "%i frames encoded\n", numFrames );
+	Com_Printf( "MSG_WriteBits: %i msec, delta encoder: %i msec\n", genericMsec, fastMsec );
+	if ( genericSum != fastSum ) {
+		Com_Printf( S_COLOR_RED "encodings differ\n" );
+	}
+}
+
 
 
 /*
@@ -145,7 +414,7 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 		lastframe = client->netchan.outgoingSequence - client->deltaMessage;
 
 		// the snapshot's entities may still have rolled off the buffer, though
-		if ( oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
+		if ( !SV_SnapshotEntitiesValid( oldframe ) ) {
 			Com_DPrintf ("%s: Delta request from out of date entities.\n", client->name);
 			oldframe = NULL;
 			lastframe = 0;
@@ -420,6 +689,373 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 	}
 }
 
+/*
+=============================================================================
+
+SNAPSHOT SCHEDULING
+
+With sv_snapshotBudget set, a client on a limited rate gets the entities
+that matter most to it.  Entities are ranked by distance from the
+viewpoint, speed and how many snapshots they have been held back.  The
+budget is what the rate lets through in the time SV_RateMsec actually
+gave the last snapshot, but never less than SNAPSHOT_MIN_BUDGET, so a
+low rate doesn't choke every change on top of the rate delay.  When
+the changes would not fit in it, the least relevant entities are held
+back to the state they had in the newest snapshot already sent to the
+client, so they never go back in time, and catch up in a later snapshot.  That costs nothing once the client has
+acknowledged the newest snapshot, and otherwise only what it took to
+get there from the acknowledged one.  An entity is never held back on
+its first sighting, with a new event, to a state that is too old, or for
+more than MAX_SNAPSHOT_DEFER snapshots in a row.
+=============================================================================
+*/
+
+#define	HEADER_RATE_BYTES	48		// include our header, IP header, and some overhead
+#define	SNAPSHOT_BASE_BYTES	80		// playerstate, areabits and commands
+#define	SNAPSHOT_MIN_BUDGET	400		// a busy snapshot's worth of entity bytes
+#define	MAX_SNAPSHOT_DEFER	3
+#define	MAX_CLIENT_SNAPSHOT_ENTITIES	256		// MAX_ENTITIES_IN_SNAPSHOT on the client
+
+static float	*snapshotScores;		// for SV_QsortEntityScores
+
+static int SV_RateMsec( client_t *client, int messageSize );
+
+/*
+=======================
+SV_QsortEntityScores
+
+Sorts positions in an entity list by descending score
+=======================
+*/
+static int QDECL SV_QsortEntityScores( const void *a, const void *b ) {
+	float	sa, sb;
+
+	sa = snapshotScores[ *(int *)a ];
+	sb = snapshotScores[ *(int *)b ];
+	if ( sa > sb ) {
+		return -1;
+	}
+	if ( sa < sb ) {
+		return 1;
+	}
+	return *(int *)a - *(int *)b;
+}
+
+/*
+====================
+SV_ClientRate
+
+Bytes per second the client can take, after sv_maxRate
+====================
+*/
+static int SV_ClientRate( client_t *client ) {
+	int		rate;
+
+	rate = client->rate;
+	if ( sv_maxRate->integer ) {
+		if ( sv_maxRate->integer < 1000 ) {
+			Cvar_Set( "sv_MaxRate", "1000" );
+		}
+		if ( sv_maxRate->integer < rate ) {
+			rate = sv_maxRate->integer;
+		}
+	}
+	return rate;
+}
+
+/*
+=============
+SV_EntityRelevance
+=============
+*/
+static float SV_EntityRelevance( client_t *client, int entityNum, const vec3_t org ) {
+	sharedEntity_t	*ent;
+	vec3_t			delta;
+	float			score;
+
+	ent = SV_GentityNum( entityNum );
+	if ( ent->r.svFlags & ( SVF_BROADCAST | SVF_PORTAL ) ) {
+		return 1.0f;
+	}
+
+	VectorSubtract( ent->r.currentOrigin, org, delta );
+	score = 1.0f / ( VectorLength( delta ) + 64.0f );
+	score *= 1.0f + VectorLength( ent->s.pos.trDelta ) / 320.0f;
+	score *= 1 + client->snapshotDefers[entityNum];
+	return score;
+}
+
+/*
+=============
+SV_EstimateDeltaBytes
+
+Roughly what MSG_WriteDeltaEntity will write
+=============
+*/
+static int SV_EstimateDeltaBytes( const entityState_t *from, const entityState_t *to ) {
+	const int	*f, *t;
+	int			i, changed;
+
+	f = (const int *)from;
+	t = (const int *)to;
+	changed = 0;
+	for ( i = 0 ; i < sizeof( *to ) / 4 ; i++ ) {
+		if ( f[i] != t[i] ) {
+			changed++;
+		}
+	}
+	if ( !changed ) {
+		return 0;
+	}
+	return 3 + changed * 5 / 2;
+}
+
+/*
+=============
+SV_SnapshotDeltaFrame
+
+The frame SV_WriteSnapshotToClient will delta from, if its states
+can be referenced by one more snapshot
+=============
+*/
+static clientSnapshot_t *SV_SnapshotDeltaFrame( client_t *client ) {
+	clientSnapshot_t	*oldframe;
+
+	if ( client->deltaMessage <= 0 || client->state != CS_ACTIVE ) {
+		return NULL;
+	}
+	if ( client->netchan.outgoingSequence - client->deltaMessage >= (PACKET_BACKUP - 3) ) {
+		return NULL;
+	}
+	oldframe = &client->frames[ client->deltaMessage & PACKET_MASK ];
+	if ( !SV_SnapshotEntitiesValid( oldframe ) ) {
+		return NULL;
+	}
+	// the states must also survive the copies this snapshot makes
+	if ( svs.nextSnapshotEntities - oldframe->first_state 
+		>= (unsigned)( svs.numSnapshotEntities - MAX_SNAPSHOT_ENTITIES ) ) {
+		return NULL;
+	}
+	return oldframe;
+}
+
+/*
+=============
+SV_SnapshotStateAge
+
+How many states have been copied since the one at snapshotEntities
+index ref, which must still be in the ring
+=============
+*/
+static unsigned SV_SnapshotStateAge( int ref ) {
+	return ( svs.nextSnapshotEntities - ref ) & ( svs.numSnapshotEntities - 1 );
+}
+
+/*
+=============
+SV_ScheduleSnapshotEntities
+
+Keeps the most relevant entities if there are more than the client
+takes, and picks the entities whose changes are held back.  oldRefs
+is set to the snapshotEntities index to send instead of the current
+state, or -1.
+=============
+*/
+static void SV_ScheduleSnapshotEntities( client_t *client, const vec3_t org, 
+									snapshotEntityNumbers_t *eNums, int *oldRefs ) {
+	clientSnapshot_t	*oldframe, *lastframe;
+	entityState_t		*old, *newest;
+	sharedEntity_t		*ent;
+	float				scores[MAX_SNAPSHOT_ENTITIES];
+	int					costs[MAX_SNAPSHOT_ENTITIES];
+	int					order[MAX_SNAPSHOT_ENTITIES];
+	int					i, n, num, oldindex, lastindex;
+	int					budget, holdCost, ref;
+	int					sendMsec;
+
+	for ( i = 0 ; i < eNums->numSnapshotEntities ; i++ ) {
+		oldRefs[i] = -1;
+	}
+	client->snapshotDeferred = 0;
+	client->snapshotBudget = 0;
+
+	if ( !sv_snapshotBudget->integer ) {
+		return;
+	}
+
+	// bots read their snapshots directly
+	if ( client->gentity && client->gentity->r.svFlags & SVF_BOT ) {
+		return;
+	}
+
+	// local clients take everything every frame
+	if ( client->netchan.remoteAddress.type == NA_LOOPBACK || (sv_lanForceRate->integer && Sys_IsLANAddress (client->netchan.remoteAddress)) ) {
+		return;
+	}
+
+	for ( i = 0 ; i < eNums->numSnapshotEntities ; i++ ) {
+		scores[i] = SV_EntityRelevance( client, eNums->snapshotEntities[i], org );
+		order[i] = i;
+	}
+
+	// the client drops everything past its limit in entity order,
+	// so drop the least relevant here instead
+	if ( eNums->numSnapshotEntities > MAX_CLIENT_SNAPSHOT_ENTITIES ) {
+		snapshotScores = scores;
+		qsort( order, eNums->numSnapshotEntities, sizeof( order[0] ), SV_QsortEntityScores );
+		for ( i = 0 ; i < MAX_CLIENT_SNAPSHOT_ENTITIES ; i++ ) {
+			order[i] = eNums->snapshotEntities[ order[i] ];
+		}
+		eNums->numSnapshotEntities = MAX_CLIENT_SNAPSHOT_ENTITIES;
+		Com_Memcpy( eNums->snapshotEntities, order, MAX_CLIENT_SNAPSHOT_ENTITIES * sizeof( order[0] ) );
+		qsort( eNums->snapshotEntities, eNums->numSnapshotEntities, 
+			sizeof( eNums->snapshotEntities[0] ), SV_QsortEntityNumbers );
+		for ( i = 0 ; i < eNums->numSnapshotEntities ; i++ ) {
+			scores[i] = SV_EntityRelevance( client, eNums->snapshotEntities[i], org );
+			order[i] = i;
+		}
+	}
+
+	oldframe = SV_SnapshotDeltaFrame( client );
+	if ( !oldframe ) {
+		return;
+	}
+
+	// the newest snapshot sent, which the client may already have even
+	// if it hasn't been acknowledged, is the one to hold back to
+	lastframe = &client->frames[ ( client->netchan.outgoingSequence - 1 ) & PACKET_MASK ];
+	if ( !SV_SnapshotEntitiesValid( lastframe ) ) {
+		return;
+	}
+
+	// the client gets snapshots as often as the rate lets them through,
+	// never more often than it asked for
+	sendMsec = SV_RateMsec( client, lastframe->messageSize );
+	if ( sendMsec < client->snapshotMsec ) {
+		sendMsec = client->snapshotMsec;
+	}
+	budget = SV_ClientRate( client ) * sendMsec / 1000 - HEADER_RATE_BYTES - SNAPSHOT_BASE_BYTES;
+	if ( budget < SNAPSHOT_MIN_BUDGET ) {
+		budget = SNAPSHOT_MIN_BUDGET;
+	}
+	client->snapshotBudget = budget;
+
+	// what has to be sent, and what each change that could wait costs
+	n = 0;
+	oldindex = 0;
+	lastindex = 0;
+	for ( i = 0 ; i < eNums->numSnapshotEntities ; i++ ) {
+		num = eNums->snapshotEntities[i];
+		ent = SV_GentityNum( num );
+
+		old = NULL;
+		for ( ; oldindex < oldframe->num_entities ; oldindex++ ) {
+			old = SV_SnapshotEntity( oldframe, oldindex );
+			if ( old->number >= num ) {
+				break;
+			}
+		}
+		if ( oldindex == oldframe->num_entities || old->number != num ) {
+			// first sighting, delta'd from the baseline
+			budget -= SV_EstimateDeltaBytes( &sv.svEntities[num].baseline, &ent->s );
+			client->snapshotDefers[num] = 0;
+			continue;
+		}
+
+		costs[i] = SV_EstimateDeltaBytes( old, &ent->s );
+		if ( !costs[i] ) {
+			client->snapshotDefers[num] = 0;
+			continue;
+		}
+
+		newest = NULL;
+		for ( ; lastindex < lastframe->num_entities ; lastindex++ ) {
+			newest = SV_SnapshotEntity( lastframe, lastindex );
+			if ( newest->number >= num ) {
+				break;
+			}
+		}
+		if ( lastindex == lastframe->num_entities || newest->number != num ) {
+			// not in the newest snapshot, holding back would bring back
+			// a state from before it
+			budget -= costs[i];
+			client->snapshotDefers[num] = 0;
+			continue;
+		}
+		ref = svs.snapshotRefs[ ( lastframe->first_entity + lastindex ) & ( svs.numSnapshotRefs - 1 ) ];
+		holdCost = SV_EstimateDeltaBytes( old, newest );
+
+		if ( client->snapshotDefers[num] >= MAX_SNAPSHOT_DEFER || holdCost >= costs[i]
+			|| SV_SnapshotStateAge( ref ) >= (unsigned)svs.numSnapshotEntities / 2
+			|| newest->event != ent->s.event || newest->eventParm != ent->s.eventParm
+			|| newest->eType != ent->s.eType || newest->eFlags != ent->s.eFlags
+			|| newest->modelindex != ent->s.modelindex || newest->solid != ent->s.solid ) {
+			budget -= costs[i];
+			client->snapshotDefers[num] = 0;
+			continue;
+		}
+
+		// held back it costs what it takes to reach the newest state,
+		// sending it adds the rest
+		budget -= holdCost;
+		costs[i] -= holdCost;
+		oldRefs[i] = ref;
+		order[n++] = i;
+	}
+
+	// send the most relevant changes that fit
+	snapshotScores = scores;
+	qsort( order, n, sizeof( order[0] ), SV_QsortEntityScores );
+	for ( i = 0 ; i < n ; i++ ) {
+		num = eNums->snapshotEntities[ order[i] ];
+		if ( costs[ order[i] ] <= budget ) {
+			budget -= costs[ order[i] ];
+			oldRefs[ order[i] ] = -1;
+			client->snapshotDefers[num] = 0;
+		} else {
+			client->snapshotDefers[num]++;
+			client->snapshotDeferred++;
+		}
+	}
+}
+
+/*
+=============
+SV_SnapshotStats_f
+
+Bandwidth use of every client over the last second
+=============
+*/
+void SV_SnapshotStats_f( void ) {
+	client_t			*cl;
+	clientSnapshot_t	*frame;
+	int					i, j;
+	int					rate, bytes;
+
+	if ( !com_sv_running->integer ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	Com_Printf( "sv_snapshotBudget %i\n", sv_snapshotBudget->integer );
+	Com_Printf( "num    rate bytes/s  use budget held name\n" );
+	Com_Printf( "--- ------- ------- ---- ------ ---- ---------------\n" );
+	for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+		if ( cl->state != CS_ACTIVE ) {
+			continue;
+		}
+		rate = SV_ClientRate( cl );
+		bytes = 0;
+		for ( j = 0, frame = cl->frames ; j < PACKET_BACKUP ; j++, frame++ ) {
+			if ( frame->messageSent > 0 && svs.time - frame->messageSent < 1000 ) {
+				bytes += frame->messageSize + HEADER_RATE_BYTES;
+			}
+		}
+		Com_Printf( "%3i %7i %7i %3i%% %6i %4i %s\n", i, rate, bytes, 
+			rate ? bytes * 100 / rate : 0, cl->snapshotBudget, cl->snapshotDeferred, cl->name );
+	}
+}
+
 /*
 =============
 SV_BuildClientSnapshot
@@ -444,6 +1080,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	sharedEntity_t				*clent;
 	int							clientNum;
 	playerState_t				*ps;
+	int							oldRefs[MAX_SNAPSHOT_ENTITIES];
 
 	// bump the counter used to prevent double adding
 	sv.snapshotCounter++;
@@ -498,18 +1135,41 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		((int *)frame->areabits)[i] = ((int *)frame->areabits)[i] ^ -1;
 	}
 
-	// copy the entity states out
+	// rank the entities and hold back what the rate can't take
+	SV_ScheduleSnapshotEntities( client, org, &entityNumbers, oldRefs );
+
+	// the frame is only good while the oldest state it uses is in the ring
+	frame->first_state = svs.snapshotFrameFirst;
+	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
+		if ( oldRefs[i] >= 0 && SV_SnapshotStateAge( oldRefs[i] ) > svs.nextSnapshotEntities - frame->first_state ) {
+			frame->first_state = svs.nextSnapshotEntities - SV_SnapshotStateAge( oldRefs[i] );
+		}
+	}
+
+	// copy the entity states out, the first client to see an entity
+	// in this snapshot frame makes the copy the others refer to
 	frame->num_entities = 0;
-	frame->first_entity = svs.nextSnapshotEntities;
+	frame->first_entity = svs.nextSnapshotRefs;
+	frame->generation = svs.time;
 	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
-		ent = SV_GentityNum(entityNumbers.snapshotEntities[i]);
-		state = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
-		*state = ent->s;
-		svs.nextSnapshotEntities++;
-		// this should never hit, map should always be restarted first in SV_Frame
-		if ( svs.nextSnapshotEntities >= 0x7FFFFFFE ) {
-			Com_Error(ERR_FATAL, "svs.nextSnapshotEntities wrapped");
+		if ( oldRefs[i] >= 0 ) {
+			// held back to the newest state the client was sent
+			svs.snapshotRefs[ svs.nextSnapshotRefs & ( svs.numSnapshotRefs - 1 ) ] = oldRefs[i];
+			svs.nextSnapshotRefs++;
+			frame->num_entities++;
+			continue;
+		}
+		svEnt = &sv.svEntities[ entityNumbers.snapshotEntities[i] ];
+		if ( svEnt->snapshotFrame != svs.snapshotFrame ) {
+			ent = SV_GentityNum(entityNumbers.snapshotEntities[i]);
+			svEnt->snapshotFrame = svs.snapshotFrame;
+			svEnt->snapshotState = svs.nextSnapshotEntities & ( svs.numSnapshotEntities - 1 );
+			state = &svs.snapshotEntities[ svEnt->snapshotState ];
+			*state = ent->s;
+			svs.nextSnapshotEntities++;
 		}
+		svs.snapshotRefs[ svs.nextSnapshotRefs & ( svs.numSnapshotRefs - 1 ) ] = svEnt->snapshotState;
+		svs.nextSnapshotRefs++;
 		frame->num_entities++;
 	}
 }
@@ -523,7 +1183,6 @@ Return the number of msec a given size message is supposed
 to take to clear, based on the current rate
 ====================
 */
-#define	HEADER_RATE_BYTES	48		// include our header, IP header, and some overhead
 static int SV_RateMsec( client_t *client, int messageSize ) {
 	int		rate;
 	int		rateMsec;
@@ -532,15 +1191,7 @@ static int SV_RateMsec( client_t *client, int messageSize ) {
 	if ( messageSize > 1500 ) {
 		messageSize = 1500;
 	}
-	rate = client->rate;
-	if ( sv_maxRate->integer ) {
-		if ( sv_maxRate->integer < 1000 ) {
-			Cvar_Set( "sv_MaxRate", "1000" );
-		}
-		if ( sv_maxRate->integer < rate ) {
-			rate = sv_maxRate->integer;
-		}
-	}
+	rate = SV_ClientRate( client );
 	rateMsec = ( messageSize + HEADER_RATE_BYTES ) * 1000 / rate;
 
 	return rateMsec;
@@ -611,6 +1262,11 @@ void SV_SendClientSnapshot( client_t *client ) {
 	byte		msg_buf[MAX_MSGLEN];
 	msg_t		msg;
 
+	// snapshots sent on their own see entities as they are now
+	if ( !sendingClientMessages ) {
+		SV_BeginSnapshotFrame();
+	}
+
 	// build the snapshot
 	SV_BuildClientSnapshot( client );
 
@@ -656,6 +1312,10 @@ void SV_SendClientMessages( void ) {
 	int			i;
 	client_t	*c;
 
+	// every snapshot built this frame shares the entity copies
+	SV_BeginSnapshotFrame();
+	sendingClientMessages = qtrue;
+
 	// send a message to each connected client
 	for (i=0, c = svs.clients ; i < sv_maxclients->integer ; i++, c++) {
 		if (!c->state) {
@@ -678,5 +1338,7 @@ void SV_SendClientMessages( void ) {
 		// generate and send a new message
 		SV_SendClientSnapshot( c );
 	}
+
+	sendingClientMessages = qfalse;
 }
 
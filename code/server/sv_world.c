@@ -150,6 +150,7 @@ void SV_ClearWorld( void ) {
 
 	Com_Memset( sv_worldSectors, 0, sizeof(sv_worldSectors) );
 	sv_numworldSectors = 0;
+	SV_ClearTraceCache();
 
 	// get world map bounds
 	h = CM_InlineModel( 0 );
@@ -160,38 +161,75 @@ void SV_ClearWorld( void ) {
 
 /*
 ===============
-SV_UnlinkEntity
+SV_RemoveFromWorldSector
 
+Returns qfalse if the entity wasn't linked in anywhere
 ===============
 */
-void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
-	svEntity_t		*ent;
+static qboolean SV_RemoveFromWorldSector( svEntity_t *ent ) {
 	svEntity_t		*scan;
 	worldSector_t	*ws;
 
-	ent = SV_SvEntityForGentity( gEnt );
-
-	gEnt->r.linked = qfalse;
-
 	ws = ent->worldSector;
 	if ( !ws ) {
-		return;		// not linked in anywhere
+		return qfalse;
 	}
 	ent->worldSector = NULL;
 
 	if ( ws->entities == ent ) {
 		ws->entities = ent->nextEntityInWorldSector;
-		return;
+		return qtrue;
 	}
 
 	for ( scan = ws->entities ; scan ; scan = scan->nextEntityInWorldSector ) {
 		if ( scan->nextEntityInWorldSector == ent ) {
 			scan->nextEntityInWorldSector = ent->nextEntityInWorldSector;
-			return;
+			return qtrue;
 		}
 	}
 
 	Com_Printf( "WARNING: SV_UnlinkEntity: not found in worldSector\n" );
+	return qtrue;
+}
+
+/*
+===============
+SV_UnlinkEntity
+
+===============
+*/
+void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
+	svEntity_t		*ent;
+
+	ent = SV_SvEntityForGentity( gEnt );
+
+	gEnt->r.linked = qfalse;
+
+	if ( SV_RemoveFromWorldSector( ent ) ) {
+		SV_ClearTraceCache();
+	}
+}
+
+/*
+===============
+SV_GetLinkState
+===============
+*/
+static void SV_GetLinkState( const sharedEntity_t *gEnt, svLinkState_t *state ) {
+	Com_Memset( state, 0, sizeof( *state ) );
+	VectorCopy( gEnt->r.absmin, state->absmin );
+	VectorCopy( gEnt->r.absmax, state->absmax );
+	VectorCopy( gEnt->r.currentOrigin, state->origin );
+	VectorCopy( gEnt->r.currentAngles, state->angles );
+	VectorCopy( gEnt->r.mins, state->mins );
+	VectorCopy( gEnt->r.maxs, state->maxs );
+	state->contents = gEnt->r.contents;
+	state->ownerNum = gEnt->r.ownerNum;
+	if ( gEnt->r.bmodel ) {
+		state->clip = gEnt->s.modelindex + 1;
+	} else if ( gEnt->r.svFlags & SVF_CAPSULE ) {
+		state->clip = -1;
+	}
 }
 
 
@@ -212,12 +250,15 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	int			lastLeaf;
 	float		*origin, *angles;
 	svEntity_t	*ent;
+	svLinkState_t	state;
+	qboolean	wasLinked;
 
 	ent = SV_SvEntityForGentity( gEnt );
 
-	if ( ent->worldSector ) {
-		SV_UnlinkEntity( gEnt );	// unlink from old position
-	}
+	// unlink from old position, the trace cache is only cleared
+	// below if traces could see the entity any differently
+	gEnt->r.linked = qfalse;
+	wasLinked = SV_RemoveFromWorldSector( ent );
 
 	// encode the size into the entityState_t for client prediction
 	if ( gEnt->r.bmodel ) {
@@ -292,6 +333,9 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	// if none of the leafs were inside the map, the
 	// entity is outside the world and can be considered unlinked
 	if ( !num_leafs ) {
+		if ( wasLinked ) {
+			SV_ClearTraceCache();
+		}
 		return;
 	}
 
@@ -353,6 +397,12 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	node->entities = ent;
 
 	gEnt->r.linked = qtrue;
+
+	SV_GetLinkState( gEnt, &state );
+	if ( !wasLinked || memcmp( &state, &ent->linkState, sizeof( state ) ) ) {
+		ent->linkState = state;
+		SV_ClearTraceCache();
+	}
 }
 
 /*
@@ -591,23 +641,13 @@ void SV_ClipMoveToEntities( moveclip_t *clip ) {
 
 /*
 ==================
-SV_Trace
-
-Moves the given mins/maxs volume through the world from start to end.
-passEntityNum and entities owned by passEntityNum are explicitly not checked.
+SV_TraceUncached
 ==================
 */
-void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+static void SV_TraceUncached( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
 	moveclip_t	clip;
 	int			i;
 
-	if ( !mins ) {
-		mins = vec3_origin;
-	}
-	if ( !maxs ) {
-		maxs = vec3_origin;
-	}
-
 	Com_Memset ( &clip, 0, sizeof ( moveclip_t ) );
 
 	// clip to world
@@ -648,6 +688,145 @@ void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, c
 }
 
 
+/*
+===============================================================================
+
+TRACE CACHE
+
+The game tends to ask for the same trace several times in a frame, for
+missiles, bot visibility checks and so on.  With sv_traceCache set the
+results are remembered until the frame ends, an entity is linked or
+unlinked, or a relink changes its box, contents, owner or clip model.
+Game code that changes contents or owners without relinking the
+entity can see an old result for the rest of the frame, which is why
+the cache is optional.
+
+===============================================================================
+*/
+
+#define	TRACE_CACHE_SIZE	256		// must be a power of two
+
+typedef struct {
+	vec3_t		start;
+	vec3_t		end;
+	vec3_t		mins;
+	vec3_t		maxs;
+	int			passEntityNum;
+	int			contentmask;
+	int			capsule;
+} traceKey_t;
+
+typedef struct {
+	int			generation;			// traceGeneration when stored
+	traceKey_t	key;
+	trace_t		trace;
+} traceCacheEntry_t;
+
+static traceCacheEntry_t	traceCache[TRACE_CACHE_SIZE];
+static int					traceGeneration = 1;
+
+static struct {
+	int			hits;
+	int			misses;
+	int			clears;
+} traceCacheStats;
+
+/*
+===============
+SV_ClearTraceCache
+===============
+*/
+void SV_ClearTraceCache( void ) {
+	traceGeneration++;
+	traceCacheStats.clears++;
+}
+
+/*
+===============
+SV_HashTraceKey
+===============
+*/
+static int SV_HashTraceKey( const traceKey_t *key ) {
+	const int	*p;
+	unsigned	hash;
+	int			i;
+
+	p = (const int *)key;
+	hash = 0;
+	for ( i = 0 ; i < sizeof( *key ) / sizeof( int ) ; i++ ) {
+		hash = ( hash ^ p[i] ) * 16777619;
+	}
+	return ( hash ^ ( hash >> 16 ) ) & ( TRACE_CACHE_SIZE - 1 );
+}
+
+/*
+===============
+SV_TraceCache_f
+
+tracecache [clear]
+===============
+*/
+void SV_TraceCache_f( void ) {
+	int		total;
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "clear" ) ) {
+		Com_Memset( &traceCacheStats, 0, sizeof( traceCacheStats ) );
+		return;
+	}
+
+	total = traceCacheStats.hits + traceCacheStats.misses;
+	Com_Printf( "sv_traceCache %i\n", sv_traceCache->integer );
+	Com_Printf( "%i traces, %i hits (%.1f%%), %i clears\n", total, traceCacheStats.hits,
+		total ? 100.0f * traceCacheStats.hits / total : 0.0f, traceCacheStats.clears );
+}
+
+/*
+==================
+SV_Trace
+
+Moves the given mins/maxs volume through the world from start to end.
+passEntityNum and entities owned by passEntityNum are explicitly not checked.
+==================
+*/
+void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+	traceKey_t			key;
+	traceCacheEntry_t	*entry;
+
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	if ( !sv_traceCache->integer ) {
+		SV_TraceUncached( results, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+		return;
+	}
+
+	VectorCopy( start, key.start );
+	VectorCopy( end, key.end );
+	VectorCopy( mins, key.mins );
+	VectorCopy( maxs, key.maxs );
+	key.passEntityNum = passEntityNum;
+	key.contentmask = contentmask;
+	key.capsule = capsule;
+
+	entry = &traceCache[ SV_HashTraceKey( &key ) ];
+	if ( entry->generation == traceGeneration && !memcmp( &entry->key, &key, sizeof( key ) ) ) {
+		traceCacheStats.hits++;
+		*results = entry->trace;
+		return;
+	}
+	traceCacheStats.misses++;
+
+	SV_TraceUncached( &entry->trace, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+	entry->key = key;
+	entry->generation = traceGeneration;
+	*results = entry->trace;
+}
+
+
 
 /*
 =============
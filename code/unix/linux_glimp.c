@@ -1684,6 +1684,120 @@ void GLimp_WakeRenderer( void *data )
 	pthread_mutex_unlock( &smpMutex );
 }
 
+/*
+===========================================================
+
+Front end jobs
+
+A small pool of worker threads that the calling thread joins
+while it waits.  Jobs are handed out in index order.  The pool
+only grows, but only the first numThreads workers take part in
+a batch, so lowering the thread count does lower parallelism.
+
+===========================================================
+*/
+
+#define	MAX_FRONTEND_THREADS	16
+
+static pthread_mutex_t	jobMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	jobsQueuedEvent = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	jobsDoneEvent = PTHREAD_COND_INITIALIZER;
+
+static int		numJobThreads;
+static int		jobGeneration;
+static int		jobWorkers;		// workers taking part in this generation
+static void		(*jobFunction)( int index );
+static int		numJobs;
+static int		nextJob;
+static int		jobsPending;
+
+// call with jobMutex held, returns with it held
+static void GLimp_RunQueuedJobs( void )
+{
+	int		index;
+
+	while ( nextJob < numJobs ) {
+		index = nextJob++;
+
+		pthread_mutex_unlock( &jobMutex );
+		jobFunction( index );
+		pthread_mutex_lock( &jobMutex );
+
+		if ( --jobsPending == 0 ) {
+			pthread_cond_broadcast( &jobsDoneEvent );
+		}
+	}
+}
+
+static void *GLimp_JobThread( void *arg )
+{
+	int		generation;
+	int		worker;
+
+	worker = (int)(long)arg;
+
+	pthread_mutex_lock( &jobMutex );
+	generation = jobGeneration;
+	while ( 1 ) {
+		while ( generation == jobGeneration ) {
+			pthread_cond_wait( &jobsQueuedEvent, &jobMutex );
+		}
+		generation = jobGeneration;
+
+		if ( worker < jobWorkers ) {
+			GLimp_RunQueuedJobs();
+		}
+	}
+
+	return arg;
+}
+
+void GLimp_RunFrontEndJobs( void (*job)( int index ), int count, int numThreads )
+{
+	pthread_t	thread;
+	int			i, ret;
+
+	if ( numThreads > MAX_FRONTEND_THREADS ) {
+		numThreads = MAX_FRONTEND_THREADS;
+	}
+
+	// threads are never shut down, so only ever add to the pool
+	while ( numJobThreads < numThreads ) {
+		ret = pthread_create( &thread, NULL, GLimp_JobThread, (void *)(long)numJobThreads );
+		if ( ret ) {
+			ri.Printf( PRINT_ALL, "pthread_create returned %d: %s", ret, strerror( ret ) );
+			break;
+		}
+		pthread_detach( thread );
+		numJobThreads++;
+	}
+
+	if ( !numJobThreads || numThreads <= 0 || count <= 1 ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			job( i );
+		}
+		return;
+	}
+
+	pthread_mutex_lock( &jobMutex );
+	{
+		jobFunction = job;
+		numJobs = count;
+		nextJob = 0;
+		jobsPending = count;
+		jobWorkers = numThreads;
+		jobGeneration++;
+		pthread_cond_broadcast( &jobsQueuedEvent );
+
+		GLimp_RunQueuedJobs();
+
+		while ( jobsPending ) {
+			pthread_cond_wait( &jobsDoneEvent, &jobMutex );
+		}
+	}
+	pthread_mutex_unlock( &jobMutex );
+}
+
 #else
 
 void GLimp_RenderThreadWrapper( void *stub ) {}
@@ -1696,6 +1810,13 @@ void *GLimp_RendererSleep( void ) {
 }
 void GLimp_FrontEndSleep( void ) {}
 void GLimp_WakeRenderer( void *data ) {}
+void GLimp_RunFrontEndJobs( void (*job)( int index ), int count, int numThreads ) {
+	int		i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		job( i );
+	}
+}
 
 #endif
 
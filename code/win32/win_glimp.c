@@ -1656,3 +1656,18 @@ void GLimp_WakeRenderer( void *data ) {
 	WaitForSingleObject( renderActiveEvent, INFINITE );
 }
 
+/*
+=======================
+GLimp_RunFrontEndJobs
+
+No worker threads here, the jobs run in order on the calling thread
+=======================
+*/
+void GLimp_RunFrontEndJobs( void (*job)( int index ), int count, int numThreads ) {
+	int		i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		job( i );
+	}
+}
+